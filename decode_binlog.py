@@ -0,0 +1,122 @@
+"""
+Decode frequency counter binary logs (.fcb) to JSONL or CSV.
+
+The binary format is described in src/BinaryLog.h: a 32-byte header followed
+by fixed 32-byte little-endian records, zero-padded to whole 512-byte sectors.
+The JSONL output uses the same field names as the firmware's JSONL logs, so
+the result can be fed straight to plot.py (which also reads .fcb directly).
+"""
+import argparse
+import csv
+import json
+import struct
+import sys
+from datetime import datetime, timezone
+
+BINLOG_MAGIC = 0x424C4346
+HEADER = struct.Struct('<IHHII16x')
+RECORD = struct.Struct('<HBbIIIiiii')  # Version 1 had a u16 source; its high byte was always 0
+
+FLAG_RECORD = 0x0001
+FLAG_GPS_FIX = 0x0002
+FLAG_PPS_DATA = 0x0004
+FLAG_LOOP_MASK = 0x0018
+FLAG_QERR = 0x0020
+LOOP_SHIFT = 3
+
+GPS_SOURCES = ["Unknown", "GPS", "Galileo", "GLONASS", "GNSS", "BDS"]
+LOOP_STATES = ["OFF", "ACQUIRE", "TRACK", "HOLDOVER"]
+
+FIELDS = [
+    'gps_timestamp', 'gps_source', 'gps_lat', 'gps_lon', 'ticks', 'capture_ticks', 'qerr_ns',
+    'ticks_corrected', 'freq_hz', 'avg_freq_hz', 'ppm_instantaneous', 'ppm_average', 'oscillator_offset_ppm',
+    'loop_state',
+]
+
+
+def read_header(data):
+    if len(data) < HEADER.size:
+        raise ValueError("File too short for a binary log header")
+    magic, version, record_size, nominal_hz, created_unix = HEADER.unpack_from(data, 0)
+    if magic != BINLOG_MAGIC:
+        raise ValueError("Not a frequency counter binary log (bad magic)")
+    if record_size != RECORD.size:
+        raise ValueError(f"Unsupported record size {record_size} (version {version})")
+    return {'version': version, 'nominal_hz': nominal_hz, 'created_unix': created_unix}
+
+
+def iter_records(data):
+    """Yield one dict per record, using the JSONL field names."""
+    header = read_header(data)
+    nominal_hz = float(header['nominal_hz'])
+    tick_ns = 1e9 / nominal_hz
+    previous = None  # (capture_ticks, qerr_ns) of the last record with a qErr
+    for offset in range(HEADER.size, len(data) - RECORD.size + 1, RECORD.size):
+        (flags, source, qerr_ns, gps_unix, ticks, capture_ticks,
+         lat_e7, lon_e7, offset_cppb, avg_cppb) = RECORD.unpack_from(data, offset)
+        if not flags & FLAG_RECORD:
+            continue  # Sector padding
+        row = {
+            'gps_timestamp': datetime.fromtimestamp(gps_unix, timezone.utc).strftime('%Y-%m-%dT%H:%M:%SZ'),
+            'gps_source': GPS_SOURCES[source] if source < len(GPS_SOURCES) else GPS_SOURCES[0],
+        }
+        if flags & FLAG_GPS_FIX:
+            row['gps_lat'] = round(lat_e7 * 1e-7, 7)
+            row['gps_lon'] = round(lon_e7 * 1e-7, 7)
+        if flags & FLAG_PPS_DATA:
+            ppm_average = avg_cppb * 1e-5
+            row['ticks'] = ticks
+            row['capture_ticks'] = capture_ticks
+            row['freq_hz'] = float(ticks)
+            row['avg_freq_hz'] = nominal_hz * (1.0 + ppm_average * 1e-6)
+            row['ppm_instantaneous'] = (ticks - nominal_hz) / nominal_hz * 1e6
+            row['ppm_average'] = ppm_average
+            if flags & FLAG_QERR:
+                row['qerr_ns'] = qerr_ns
+                # Corrected only across consecutive captures, both with their qErr
+                if previous is not None and (previous[0] + ticks) & 0xFFFFFFFF == capture_ticks:
+                    row['ticks_corrected'] = ticks - (qerr_ns - previous[1]) / tick_ns
+                previous = (capture_ticks, qerr_ns)
+            else:
+                previous = None
+        row['oscillator_offset_ppm'] = offset_cppb * 1e-5
+        row['loop_state'] = LOOP_STATES[(flags & FLAG_LOOP_MASK) >> LOOP_SHIFT]
+        yield row
+
+
+def load_binlog(filepath):
+    with open(filepath, 'rb') as f:
+        return list(iter_records(f.read()))
+
+
+def is_binlog(filepath):
+    with open(filepath, 'rb') as f:
+        head = f.read(4)
+    return len(head) == 4 and struct.unpack('<I', head)[0] == BINLOG_MAGIC
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode frequency counter binary logs (.fcb)')
+    parser.add_argument('file', help='Binary log file')
+    parser.add_argument('-o', '--output', help='Output file (default: stdout)')
+    parser.add_argument('--csv', action='store_true', help='Write CSV instead of JSONL')
+    args = parser.parse_args()
+
+    rows = load_binlog(args.file)
+    out = open(args.output, 'w', newline='') if args.output else sys.stdout
+    try:
+        if args.csv:
+            writer = csv.DictWriter(out, fieldnames=FIELDS)
+            writer.writeheader()
+            writer.writerows(rows)
+        else:
+            for row in rows:
+                out.write(json.dumps(row) + '\n')
+    finally:
+        if args.output:
+            out.close()
+    print(f"Decoded {len(rows)} records from {args.file}", file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,102 @@
+#pragma once
+// Host-side stand-in for the Teensy Arduino core. Only what the firmware
+// modules compiled in [env:native] actually use is provided here.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#define F(s) (s)
+#define DMAMEM
+#define FASTRUN
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT 0
+
+// Simulated time, advanced by the simulator (or by delay()/delayMicroseconds())
+extern uint64_t native_time_us;
+
+inline uint32_t millis() { return (uint32_t)(native_time_us / 1000); }
+inline uint32_t micros() { return (uint32_t)native_time_us; }
+inline void delay(uint32_t ms) { native_time_us += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(uint32_t us) { native_time_us += us; }
+
+inline void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+inline uint8_t digitalReadFast(uint8_t pin) { return digitalRead(pin); }
+
+// Interrupt plumbing: the simulator calls native_raise_irq() after setting flags
+#define IRQ_GPT1 100
+#define IRQ_GPT2 101
+#define NATIVE_IRQ_COUNT 160
+void __disable_irq();
+void __enable_irq();
+void attachInterruptVector(int irq, void (*handler)());
+void NVIC_ENABLE_IRQ(int irq);
+void NVIC_DISABLE_IRQ(int irq);
+inline void NVIC_SET_PRIORITY(int, int) {}
+bool native_raise_irq(int irq);  // Runs the handler if enabled; returns true if it ran
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+  int printf(const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len > (int)sizeof(buffer) - 1) len = sizeof(buffer) - 1;
+    if (len > 0) write((const uint8_t*)buffer, (size_t)len);
+    return len;
+  }
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  size_t println(double v, int digits) { size_t n = print(v, digits); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+};
+
+// Serial goes to stdout unless silenced (the simulator silences it so that
+// driver chatter doesn't drown the scenario report).
+class NativeSerial : public Stream {
+public:
+  void begin(uint32_t) {}
+  void flush() { fflush(stdout); }
+  void set_quiet(bool q) { quiet = q; }
+  size_t write(uint8_t c) override {
+    if (!quiet) fputc(c, stdout);
+    return 1;
+  }
+  using Print::write;
+  explicit operator bool() const { return true; }
+
+private:
+  bool quiet = false;
+};
+
+extern NativeSerial Serial;
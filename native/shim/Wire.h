@@ -0,0 +1,47 @@
+#pragma once
+// Host-side TwoWire. Transactions are routed to NativeI2cDevice models
+// registered by the simulator; unknown addresses NAK like an empty bus.
+#include <Arduino.h>
+
+class NativeI2cDevice {
+public:
+  virtual ~NativeI2cDevice() {}
+  // Called with the bytes of one write transaction (after the address)
+  virtual void i2c_write(const uint8_t* data, size_t len) = 0;
+  // Fills `data` for a read transaction
+  virtual void i2c_read(uint8_t* data, size_t len) = 0;
+};
+
+class TwoWire : public Print {
+public:
+  static constexpr size_t BUFFER_LENGTH = 32;
+
+  void begin() {}
+  void setClock(uint32_t hz) { clock_hz = hz; }
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool send_stop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int available() { return (int)(rx_len - rx_pos); }
+  int read() { return rx_pos < rx_len ? rx_buffer[rx_pos++] : -1; }
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  // Simulator hooks
+  void attach_device(uint8_t address, NativeI2cDevice* device);
+  uint32_t transactions() const { return transaction_count; }
+  uint32_t bytes_transferred() const { return byte_count; }
+
+private:
+  NativeI2cDevice* devices[128] = {};
+  uint8_t tx_address = 0;
+  uint8_t tx_buffer[BUFFER_LENGTH] = {};
+  size_t tx_len = 0;
+  uint8_t rx_buffer[BUFFER_LENGTH] = {};
+  size_t rx_len = 0;
+  size_t rx_pos = 0;
+  uint32_t clock_hz = 100000;
+  uint32_t transaction_count = 0;
+  uint32_t byte_count = 0;
+};
+
+extern TwoWire Wire;
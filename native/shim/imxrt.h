@@ -0,0 +1,87 @@
+#pragma once
+// Host-side stand-in for the i.MX RT1062 register definitions. Registers are
+// plain variables owned by the simulator; status registers keep their
+// write-1-to-clear semantics so the firmware's flag handling runs unchanged.
+#include <stdint.h>
+
+class NativeW1cRegister {
+public:
+  NativeW1cRegister& operator=(uint32_t clear_mask) { value &= ~clear_mask; return *this; }
+  operator uint32_t() const { return value; }
+  void set(uint32_t mask) { value |= mask; }
+  uint32_t value = 0;
+};
+
+struct NativeGpt {
+  volatile uint32_t CR;
+  volatile uint32_t PR;
+  NativeW1cRegister SR;
+  volatile uint32_t IR;
+  volatile uint32_t OCR1;
+  volatile uint32_t OCR2;
+  volatile uint32_t OCR3;
+  volatile uint32_t ICR1;
+  volatile uint32_t ICR2;
+  volatile uint32_t CNT;
+};
+
+extern NativeGpt native_gpt2;
+
+#define GPT2_CR   (native_gpt2.CR)
+#define GPT2_PR   (native_gpt2.PR)
+#define GPT2_SR   (native_gpt2.SR)
+#define GPT2_IR   (native_gpt2.IR)
+#define GPT2_OCR1 (native_gpt2.OCR1)
+#define GPT2_OCR2 (native_gpt2.OCR2)
+#define GPT2_OCR3 (native_gpt2.OCR3)
+#define GPT2_ICR1 (native_gpt2.ICR1)
+#define GPT2_ICR2 (native_gpt2.ICR2)
+#define GPT2_CNT  (native_gpt2.CNT)
+
+#define GPT_CR_EN         ((uint32_t)(1 << 0))
+#define GPT_CR_ENMOD      ((uint32_t)(1 << 1))
+#define GPT_CR_CLKSRC(n)  ((uint32_t)(((n) & 0x7) << 6))
+#define GPT_CR_FRR        ((uint32_t)(1 << 9))
+#define GPT_CR_SWR        ((uint32_t)(1 << 15))
+#define GPT_CR_OM1(n)     ((uint32_t)(((n) & 0x7) << 20))
+#define GPT_CR_OM2(n)     ((uint32_t)(((n) & 0x7) << 23))
+#define GPT_CR_FO1        ((uint32_t)(1 << 29))
+
+#define GPT_SR_OF1  ((uint32_t)(1 << 0))
+#define GPT_SR_OF2  ((uint32_t)(1 << 1))
+#define GPT_SR_OF3  ((uint32_t)(1 << 2))
+#define GPT_SR_IF1  ((uint32_t)(1 << 3))
+#define GPT_SR_IF2  ((uint32_t)(1 << 4))
+#define GPT_SR_ROV  ((uint32_t)(1 << 5))
+
+#define GPT_IR_OF1IE  ((uint32_t)(1 << 0))
+#define GPT_IR_OF2IE  ((uint32_t)(1 << 1))
+#define GPT_IR_OF3IE  ((uint32_t)(1 << 2))
+#define GPT_IR_IF1IE  ((uint32_t)(1 << 3))
+#define GPT_IR_IF2IE  ((uint32_t)(1 << 4))
+#define GPT_IR_ROVIE  ((uint32_t)(1 << 5))
+
+// Clock/pad configuration registers are write-only sinks on the host
+extern volatile uint32_t native_ccm_cscmr1;
+extern volatile uint32_t native_ccm_ccgr0;
+extern volatile uint32_t native_iomuxc[16];
+
+#define CCM_CSCMR1                    native_ccm_cscmr1
+#define CCM_CSCMR1_PERCLK_CLK_SEL     ((uint32_t)(1 << 6))
+#define CCM_CSCMR1_PERCLK_PODF(n)     ((uint32_t)((n) & 0x3F))
+#define CCM_CCGR0                     native_ccm_ccgr0
+#define CCM_CCGR_ON                   3
+#define CCM_CCGR0_GPT2_BUS(n)         ((uint32_t)(((n) & 0x03) << 24))
+#define CCM_CCGR0_GPT2_SERIAL(n)      ((uint32_t)(((n) & 0x03) << 26))
+
+#define IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_02       native_iomuxc[0]
+#define IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_03       native_iomuxc[1]
+#define IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_04       native_iomuxc[2]
+#define IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_05       native_iomuxc[3]
+#define IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_02       native_iomuxc[4]
+#define IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_03       native_iomuxc[5]
+#define IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_04       native_iomuxc[6]
+#define IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_05       native_iomuxc[7]
+#define IOMUXC_GPT2_IPP_IND_CLKIN_SELECT_INPUT    native_iomuxc[8]
+#define IOMUXC_GPT2_IPP_IND_CAPIN1_SELECT_INPUT   native_iomuxc[9]
+#define IOMUXC_GPT2_IPP_IND_CAPIN2_SELECT_INPUT   native_iomuxc[10]
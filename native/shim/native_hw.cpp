@@ -0,0 +1,87 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "imxrt.h"
+
+uint64_t native_time_us = 0;
+NativeSerial Serial;
+TwoWire Wire;
+
+NativeGpt native_gpt2 = {};
+volatile uint32_t native_ccm_cscmr1 = 0;
+volatile uint32_t native_ccm_ccgr0 = 0;
+volatile uint32_t native_iomuxc[16] = {};
+
+static uint8_t pin_levels[64] = {};
+static void (*irq_vectors[NATIVE_IRQ_COUNT])() = {};
+static bool irq_enabled[NATIVE_IRQ_COUNT] = {};
+static int irq_disable_depth = 0;
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pin_levels)) pin_levels[pin] = value ? HIGH : LOW;
+}
+
+uint8_t digitalRead(uint8_t pin) {
+  return pin < sizeof(pin_levels) ? pin_levels[pin] : LOW;
+}
+
+// Interrupts are delivered synchronously by the simulator, so masking only
+// has to defer delivery, not guard against real concurrency.
+void __disable_irq() { irq_disable_depth = 1; }
+void __enable_irq() { irq_disable_depth = 0; }
+
+void attachInterruptVector(int irq, void (*handler)()) {
+  if (irq >= 0 && irq < NATIVE_IRQ_COUNT) irq_vectors[irq] = handler;
+}
+
+void NVIC_ENABLE_IRQ(int irq) {
+  if (irq >= 0 && irq < NATIVE_IRQ_COUNT) irq_enabled[irq] = true;
+}
+
+void NVIC_DISABLE_IRQ(int irq) {
+  if (irq >= 0 && irq < NATIVE_IRQ_COUNT) irq_enabled[irq] = false;
+}
+
+bool native_raise_irq(int irq) {
+  if (irq < 0 || irq >= NATIVE_IRQ_COUNT) return false;
+  if (!irq_enabled[irq] || !irq_vectors[irq] || irq_disable_depth) return false;
+  irq_vectors[irq]();
+  return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  tx_address = address & 0x7F;
+  tx_len = 0;
+}
+
+size_t TwoWire::write(uint8_t c) {
+  if (tx_len >= BUFFER_LENGTH) return 0;
+  tx_buffer[tx_len++] = c;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool send_stop) {
+  (void)send_stop;
+  transaction_count++;
+  byte_count += (uint32_t)tx_len + 1;
+  NativeI2cDevice* device = devices[tx_address];
+  if (!device) return 2;  // Address NAK
+  device->i2c_write(tx_buffer, tx_len);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+  transaction_count++;
+  rx_len = 0;
+  rx_pos = 0;
+  NativeI2cDevice* device = devices[address & 0x7F];
+  if (!device) return 0;
+  if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+  device->i2c_read(rx_buffer, quantity);
+  rx_len = quantity;
+  byte_count += (uint32_t)quantity + 1;
+  return quantity;
+}
+
+void TwoWire::attach_device(uint8_t address, NativeI2cDevice* device) {
+  devices[address & 0x7F] = device;
+}
@@ -0,0 +1,283 @@
+#include "PpsSimulator.h"
+#include <Arduino.h>
+#include "imxrt.h"
+#include "Gpt2FreqMeter.h"
+#include <math.h>
+
+static const double COUNTER_SPAN = 4294967296.0;  // 2^32
+static const double PPS_FRAME_OFFSET_S = 0.25;    // PPS rising edge position inside each simulated second
+static const int FLICKER_STAGES = 6;
+
+enum SimEvent {
+  EVENT_FRAME_END,
+  EVENT_PPS_RISE,
+  EVENT_PPS_FALL,
+  EVENT_PPS2_RISE,
+  EVENT_PPS2_FALL,
+  EVENT_COMPARE,
+  EVENT_ROLLOVER,
+  EVENT_LOOP,
+};
+
+PpsSimulator::PpsSimulator(const SimConfig& sim_config)
+    : config(sim_config), rng(sim_config.seed), gauss(0.0, 1.0), uniform(0.0, 1.0),
+      time_s(0.0), phase_ticks(0.0), frequency_hz(sim_config.oscillator.nominal_hz),
+      frequency_ppb(0.0), second_index(0), next_loop_s(0.0), pps_rise_s(-1.0),
+      pps_fall_s(-1.0), pps2_rise_s(-1.0), pps2_fall_s(-1.0), pps_time_s(-1.0), pps_error_ns(0.0), flicker_state{},
+      output_level(false), output_rise_s(-1.0), stats{} {
+  native_time_us = 0;
+  start_second();
+}
+
+void PpsSimulator::start_second() {
+  const OscillatorModel& osc = config.oscillator;
+  double n = (double)second_index;
+
+  double flicker = 0.0;
+  if (osc.flicker_fm_ppb > 0.0) {
+    // One AR(1) stage per decade of tau gives an approximately flat ADEV floor
+    for (int k = 0; k < FLICKER_STAGES; k++) {
+      double a = exp(-1.0 / pow(10.0, k));
+      flicker_state[k] = a * flicker_state[k] + sqrt(1.0 - a * a) * gauss(rng);
+      flicker += flicker_state[k];
+    }
+    flicker *= osc.flicker_fm_ppb / sqrt((double)FLICKER_STAGES);
+  }
+
+  frequency_ppb = osc.offset_ppb + osc.drift_ppb_per_day * (n / 86400.0) + flicker +
+                  osc.temperature_ppb_per_c * (temperature_c() - osc.temperature_c);
+  if (osc.white_fm_ppb > 0.0) {
+    frequency_ppb += osc.white_fm_ppb * gauss(rng);
+  }
+  if (control_source) {
+    frequency_ppb += control_source();
+  }
+  frequency_hz = osc.nominal_hz * (1.0 + frequency_ppb * 1e-9);
+
+  stats.pps_generated++;
+  if (!draw_pps(config.gps, pps_rise_s, pps_fall_s, pps_error_ns)) {
+    stats.pps_dropped++;
+  }
+  if (config.second_input) {
+    double error_ns;
+    draw_pps(config.gps2, pps2_rise_s, pps2_fall_s, error_ns);
+  }
+}
+
+// Edge times of one receiver's pulse in the current second; false if it is dropped
+bool PpsSimulator::draw_pps(const GpsPpsModel& gps, double& rise_s, double& fall_s, double& error_ns) {
+  double n = (double)second_index;
+  bool in_outage = gps.outage_length_s > 0 && second_index >= gps.outage_start_s &&
+                   second_index < (uint64_t)gps.outage_start_s + gps.outage_length_s;
+  bool dropped = in_outage || (gps.dropout_probability > 0.0 && uniform(rng) < gps.dropout_probability);
+
+  error_ns = gps.offset_ns + sawtooth_ns(gps, second_index);
+  if (gps.jitter_ns > 0.0) {
+    error_ns += gps.jitter_ns * gauss(rng);
+  }
+
+  if (dropped) {
+    rise_s = -1.0;
+    fall_s = -1.0;
+    return false;
+  }
+  rise_s = n + PPS_FRAME_OFFSET_S + error_ns * 1e-9;
+  fall_s = rise_s + gps.pulse_width_s;
+  return true;
+}
+
+double PpsSimulator::sawtooth_ns(const GpsPpsModel& gps, uint64_t second) {
+  double saw = (double)second * gps.sawtooth_rate;
+  return gps.sawtooth_ns * (2.0 * (saw - floor(saw)) - 1.0);
+}
+
+double PpsSimulator::pps_sawtooth_ns(uint64_t second) const {
+  return sawtooth_ns(config.gps, second);
+}
+
+double PpsSimulator::temperature_c() const {
+  const OscillatorModel& osc = config.oscillator;
+  return osc.temperature_c + osc.temperature_swing_c * sin(2.0 * M_PI * time_s / 86400.0);
+}
+
+double PpsSimulator::next_compare_time() const {
+  uint32_t cnt = (uint32_t)(uint64_t)phase_ticks;
+  uint32_t delta = GPT2_OCR1 - cnt;
+  // A compare only fires when the counter moves onto OCR1, so a target equal
+  // to the current count is a full wrap away
+  double span = delta == 0 ? COUNTER_SPAN : (double)delta;
+  double target = floor(phase_ticks) + span;
+  return time_s + (target - phase_ticks) / frequency_hz;
+}
+
+void PpsSimulator::advance_to(double t) {
+  if (t > time_s) {
+    phase_ticks += (t - time_s) * frequency_hz;
+    time_s = t;
+  }
+  native_time_us = (uint64_t)(time_s * 1e6);
+  GPT2_CNT = (uint32_t)(uint64_t)phase_ticks;
+}
+
+void PpsSimulator::deliver_interrupts() {
+  // The handler clears what it services; stop if it is masked or makes no progress
+  for (int i = 0; i < 4; i++) {
+    if ((GPT2_SR & GPT2_IR & 0x3F) == 0) break;
+    if (!native_raise_irq(IRQ_GPT2)) break;
+    stats.interrupts++;
+    apply_forced_compare();
+  }
+  apply_forced_compare();
+}
+
+void PpsSimulator::set_output_level(bool new_level) {
+  if (new_level != output_level) {
+    if (new_level) {
+      stats.output_rising_edges++;
+      output_rise_s = time_s;
+    } else {
+      stats.output_falling_edges++;
+    }
+    output_level = new_level;
+  }
+}
+
+static bool compare_action_level(bool level) {
+  uint32_t action = (GPT2_CR >> 20) & 0x7;
+  if (action == 1) return !level;
+  if (action == 2) return false;
+  if (action == 3) return true;
+  return level;
+}
+
+// FO1 drives the programmed compare action at once, without setting OF1
+void PpsSimulator::apply_forced_compare() {
+  if (GPT2_CR & GPT_CR_FO1) {
+    GPT2_CR &= ~GPT_CR_FO1;  // Self-clearing on the hardware
+    stats.forced_compares++;
+    set_output_level(compare_action_level(output_level));
+  }
+}
+
+void PpsSimulator::fire_pps() {
+  GPT2_ICR1 = GPT2_CNT;
+  GPT2_SR.set(GPT_SR_IF1);
+  deliver_interrupts();
+}
+
+void PpsSimulator::fire_pps2() {
+  GPT2_ICR2 = GPT2_CNT;
+  GPT2_SR.set(GPT_SR_IF2);
+  deliver_interrupts();
+}
+
+void PpsSimulator::fire_compare() {
+  GPT2_SR.set(GPT_SR_OF1);
+  set_output_level(compare_action_level(output_level));
+  deliver_interrupts();
+}
+
+void PpsSimulator::run_for(double seconds) {
+  double end_s = time_s + seconds;
+  while (time_s < end_s) {
+    bool running = (GPT2_CR & GPT_CR_EN) != 0;
+    uint32_t edge_mode = (GPT2_CR >> 16) & 0x3;
+    uint32_t edge2_mode = (GPT2_CR >> 18) & 0x3;
+
+    SimEvent event = EVENT_FRAME_END;
+    double event_s = (double)(second_index + 1);
+    double snap_phase = -1.0;
+
+    if (pps_rise_s >= time_s && pps_rise_s < event_s) {
+      event = EVENT_PPS_RISE;
+      event_s = pps_rise_s;
+    }
+    if (pps_fall_s >= time_s && pps_fall_s < event_s) {
+      event = EVENT_PPS_FALL;
+      event_s = pps_fall_s;
+    }
+    if (pps2_rise_s >= time_s && pps2_rise_s < event_s) {
+      event = EVENT_PPS2_RISE;
+      event_s = pps2_rise_s;
+    }
+    if (pps2_fall_s >= time_s && pps2_fall_s < event_s) {
+      event = EVENT_PPS2_FALL;
+      event_s = pps2_fall_s;
+    }
+    if (next_loop_s < event_s) {
+      event = EVENT_LOOP;
+      event_s = next_loop_s;
+    }
+    if (running) {
+      double compare_s = next_compare_time();
+      if (compare_s < event_s) {
+        event = EVENT_COMPARE;
+        event_s = compare_s;
+        uint32_t delta = GPT2_OCR1 - (uint32_t)(uint64_t)phase_ticks;
+        snap_phase = floor(phase_ticks) + (delta == 0 ? COUNTER_SPAN : (double)delta);
+      }
+      double wrap_phase = (floor(phase_ticks / COUNTER_SPAN) + 1.0) * COUNTER_SPAN;
+      double wrap_s = time_s + (wrap_phase - phase_ticks) / frequency_hz;
+      if (wrap_s < event_s) {
+        event = EVENT_ROLLOVER;
+        event_s = wrap_s;
+        snap_phase = wrap_phase;
+      }
+    }
+
+    if (event_s > end_s) {
+      advance_to(end_s);
+      break;
+    }
+    advance_to(event_s);
+    if (snap_phase >= 0.0 && phase_ticks < snap_phase) {
+      // Keep float rounding from leaving the counter one tick short of the event
+      phase_ticks = snap_phase;
+      GPT2_CNT = (uint32_t)(uint64_t)phase_ticks;
+    }
+
+    switch (event) {
+      case EVENT_FRAME_END:
+        second_index++;
+        start_second();
+        break;
+      case EVENT_PPS_RISE:
+        pps_rise_s = -1.0;
+        pps_time_s = time_s;
+        digitalWrite(15, HIGH);  // Pin level the firmware reads to tell the edges apart
+        if (running && (edge_mode & GPT_EDGE_RISING)) fire_pps();
+        break;
+      case EVENT_PPS_FALL:
+        pps_fall_s = -1.0;
+        digitalWrite(15, LOW);
+        if (running && (edge_mode & GPT_EDGE_FALLING)) fire_pps();
+        break;
+      case EVENT_PPS2_RISE:
+        pps2_rise_s = -1.0;
+        digitalWrite(40, HIGH);
+        if (running && (edge2_mode & GPT_EDGE_RISING)) fire_pps2();
+        break;
+      case EVENT_PPS2_FALL:
+        pps2_fall_s = -1.0;
+        digitalWrite(40, LOW);
+        if (running && (edge2_mode & GPT_EDGE_FALLING)) fire_pps2();
+        break;
+      case EVENT_COMPARE:
+        fire_compare();
+        break;
+      case EVENT_ROLLOVER:
+        stats.rollovers++;
+        GPT2_SR.set(GPT_SR_ROV);
+        deliver_interrupts();
+        break;
+      case EVENT_LOOP:
+        next_loop_s += config.loop_period_s;
+        stats.loop_calls++;
+        deliver_interrupts();  // Anything that was held off by __disable_irq()
+        if (loop_hook) loop_hook();
+        apply_forced_compare();
+        deliver_interrupts();
+        break;
+    }
+  }
+}
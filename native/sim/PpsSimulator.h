@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+#include <random>
+
+// Oscillator under test: the 10 MHz that clocks GPT2.
+struct OscillatorModel {
+  double nominal_hz = 10000000.0;
+  double offset_ppb = 0.0;         // Static frequency error
+  double drift_ppb_per_day = 0.0;  // Linear aging
+  double white_fm_ppb = 0.0;       // White FM, roughly ADEV(1 s)
+  double flicker_fm_ppb = 0.0;     // Flicker FM floor (sum of AR(1) stages, 1 s .. 1e5 s)
+  double temperature_c = 25.0;          // Mean board temperature
+  double temperature_swing_c = 0.0;     // Daily sinusoidal swing (amplitude)
+  double temperature_ppb_per_c = 0.0;   // Frequency sensitivity
+};
+
+// GPS receiver PPS: reference edges with receiver-side errors.
+struct GpsPpsModel {
+  double sawtooth_ns = 0.0;       // Peak quantization error (qErr) of the receiver
+  double sawtooth_rate = 0.0731;  // Cycles per second of the sawtooth beat
+  double jitter_ns = 0.0;         // Additional white edge jitter (rms)
+  double dropout_probability = 0.0;
+  uint32_t outage_start_s = 0;    // One long outage window (0 length = none)
+  uint32_t outage_length_s = 0;
+  double pulse_width_s = 0.1;     // High time, for falling-edge captures
+  double offset_ns = 0.0;         // Constant edge offset, e.g. antenna cable delay
+};
+
+struct SimConfig {
+  OscillatorModel oscillator;
+  GpsPpsModel gps;
+  GpsPpsModel gps2;               // Second receiver on capture 2 (pin 40)
+  bool second_input = false;
+  double loop_period_s = 0.01;  // How often the loop hook ("loop()") runs
+  uint64_t seed = 1;
+};
+
+struct SimCounters {
+  uint64_t pps_generated;
+  uint64_t pps_dropped;
+  uint64_t output_rising_edges;
+  uint64_t output_falling_edges;
+  uint64_t loop_calls;
+  uint64_t interrupts;
+  uint64_t rollovers;
+  uint64_t forced_compares;  // FO1 writes by the firmware
+};
+
+// Discrete-event simulator that drives the fake GPT2 registers.
+//
+// Time is advanced from event to event (PPS edges, compare matches, counter
+// rollovers, loop hook calls), so hours of simulated time run in seconds.
+// GPT2 flags are raised exactly as the hardware would and the GPT2 vector is
+// invoked whenever the firmware has enabled it.
+class PpsSimulator {
+public:
+  explicit PpsSimulator(const SimConfig& config);
+
+  // Extra frequency offset in ppb, e.g. the SiT5501 model's pull
+  void set_control_source(std::function<double()> source) { control_source = source; }
+  void set_loop_hook(std::function<void()> hook) { loop_hook = hook; }
+
+  void run_for(double seconds);
+
+  double now() const { return time_s; }
+  uint64_t counter() const { return (uint64_t)phase_ticks; }
+  double current_frequency_ppb() const { return frequency_ppb; }
+  double temperature_c() const;
+  double last_pps_error_ns() const { return pps_error_ns; }
+  // Sawtooth part of the primary receiver's pulse in a frame: what it reports as qErr
+  double pps_sawtooth_ns(uint64_t second) const;
+  uint64_t second() const { return second_index; }
+  bool output_high() const { return output_level; }
+  double last_output_rise_s() const { return output_rise_s; }
+  double last_pps_time_s() const { return pps_time_s; }
+  const SimCounters& counters() const { return stats; }
+
+private:
+  void start_second();
+  double next_compare_time() const;
+  void advance_to(double t);
+  bool draw_pps(const GpsPpsModel& gps, double& rise_s, double& fall_s, double& error_ns);
+  static double sawtooth_ns(const GpsPpsModel& gps, uint64_t second);
+  void fire_pps();
+  void fire_pps2();
+  void fire_compare();
+  void deliver_interrupts();
+  void apply_forced_compare();
+  void set_output_level(bool level);
+
+  SimConfig config;
+  std::mt19937_64 rng;
+  std::normal_distribution<double> gauss;
+  std::uniform_real_distribution<double> uniform;
+  std::function<double()> control_source;
+  std::function<void()> loop_hook;
+
+  double time_s;
+  double phase_ticks;        // Counter value as a real number (never wraps)
+  double frequency_hz;       // Frequency for the current one-second frame
+  double frequency_ppb;
+  uint64_t second_index;
+  double next_loop_s;
+  double pps_rise_s;         // Next PPS rising edge in this frame (<0 = none)
+  double pps_fall_s;
+  double pps2_rise_s;
+  double pps2_fall_s;
+  double pps_time_s;
+  double pps_error_ns;
+  double flicker_state[6];
+  bool output_level;
+  double output_rise_s;
+  SimCounters stats;
+};
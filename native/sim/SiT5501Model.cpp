@@ -0,0 +1,46 @@
+#include "SiT5501Model.h"
+
+static const double PULL_RANGES_PPM[16] = {
+  6.25, 10.0, 12.5, 25.0, 50.0, 80.0, 100.0, 125.0,
+  150.0, 200.0, 400.0, 600.0, 800.0, 1200.0, 1600.0, 3200.0,
+};
+
+SiT5501Model::SiT5501Model() : registers{0, 0, 0}, pointer(0), write_count(0) {}
+
+void SiT5501Model::i2c_write(const uint8_t* data, size_t len) {
+  if (len == 0) return;
+  pointer = data[0];
+  // Auto-increment: each following MSB/LSB pair lands in the next register
+  for (size_t i = 1; i + 1 < len; i += 2) {
+    if (pointer < 3) {
+      registers[pointer] = (uint16_t)((data[i] << 8) | data[i + 1]);
+      write_count++;
+    }
+    pointer++;
+  }
+}
+
+void SiT5501Model::i2c_read(uint8_t* data, size_t len) {
+  for (size_t i = 0; i + 1 < len; i += 2) {
+    uint16_t value = pointer < 3 ? registers[pointer] : 0;
+    data[i] = (uint8_t)(value >> 8);
+    data[i + 1] = (uint8_t)(value & 0xFF);
+    pointer++;
+  }
+}
+
+int32_t SiT5501Model::control_word() const {
+  uint32_t raw = ((uint32_t)(registers[1] & 0x3FF) << 16) | registers[0];
+  if (raw & (1u << 25)) {
+    raw |= 0xFC000000u;  // Sign-extend the 26-bit field
+  }
+  return (int32_t)raw;
+}
+
+double SiT5501Model::pull_range_ppm() const {
+  return PULL_RANGES_PPM[registers[2] & 0xF];
+}
+
+double SiT5501Model::pull_ppb() const {
+  return (double)control_word() / (double)((1 << 25) - 1) * pull_range_ppm() * 1000.0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <Wire.h>
+
+// Register-level model of the SiT5501 on the simulated I2C bus.
+//
+// Follows the datasheet layout: register 0 holds DFC[15:0], register 1
+// holds DFC[25:16] in bits 9:0 and output enable in bit 10, register 2
+// selects the pull range. The 26-bit control word is two's complement.
+class SiT5501Model : public NativeI2cDevice {
+public:
+  SiT5501Model();
+
+  void i2c_write(const uint8_t* data, size_t len) override;
+  void i2c_read(uint8_t* data, size_t len) override;
+
+  int32_t control_word() const;
+  double pull_range_ppm() const;
+  double pull_ppb() const;  // Frequency offset the current registers produce
+  bool output_enabled() const { return (registers[1] & (1u << 10)) != 0; }
+  uint32_t register_writes() const { return write_count; }
+
+private:
+  uint16_t registers[3];
+  uint8_t pointer;
+  uint32_t write_count;
+};
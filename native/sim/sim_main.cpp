@@ -0,0 +1,1395 @@
+// Accelerated PPS simulator for the frequency counter firmware.
+//
+// Runs the firmware modules from src/ against the register/I2C shims, a
+// modelled oscillator and a modelled GPS receiver. Scenarios by area:
+//
+//   capture     GPT2 driver in ISR and polled mode, dropouts, edge analysis, second input
+//   measurement averaging windows, sample filter, ADEV/TDEV, regression, long gates, GPS sawtooth
+//   output      fractional-N synthesizer, 1 PPS alignment
+//   oscillator  SiT5501 steering, disciplining and holdover, drift model
+//   runtime     loop profiler, task scheduler
+//   host        telemetry framing, console queries, settings journal
+//
+// Each scenario checks its expected outcome; the process exits non-zero if any fails.
+//
+//   pio run -e native -t exec                  run every scenario
+//   .pio/build/native/program <name> [...]     run selected scenarios
+#include <Arduino.h>
+#include <Wire.h>
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <vector>
+#include "Gpt2FreqMeter.h"
+#include "FrequencyStats.h"
+#include "StabilityEngine.h"
+#include "PhaseRegression.h"
+#include "GateCounter.h"
+#include "EdgeAnalyzer.h"
+#include "PpsComparator.h"
+#include "PpsSampleFilter.h"
+#include "Disciplining.h"
+#include "DriftModel.h"
+#include "PpsAligner.h"
+#include "Profiler.h"
+#include "TaskScheduler.h"
+#include "Telemetry.h"
+#include "ScpiParser.h"
+#include "SettingsStore.h"
+#include "UbxParser.h"
+#include "SawtoothCorrector.h"
+#include "SiT5501.h"
+#include "PpsSimulator.h"
+#include "SiT5501Model.h"
+
+static const double REF_HZ = 10000000.0;
+
+// The capture consumer of main.ino without its sample filter: drain the queue
+// and turn consecutive timestamps into periods. main.ino passes edges through
+// PpsSampleFilter (median/MAD of recent periods: off-grid edges dropped,
+// missed edges bridged); here every period outside 1% of nominal, the
+// filter's rule before it has history, is rejected and breaks continuity, so
+// the driver scenarios see every lost edge. glitch_repair and sawtooth_qerr
+// run the filter itself.
+struct CaptureConsumer {
+  FrequencyStats stats{10000000};
+  StabilityEngine stability{10000000, 1e-7, 1.0};
+  PhaseRegression regression{10000000, 1e-7, 1.0};
+  GateCounter gate{10000000};
+  uint32_t gates_closed = 0;
+  int64_t gate_error_sum = 0;  // Over all closed gates, exact
+  uint64_t gate_tick_sum = 0;
+  uint32_t gate_seconds_sum = 0;
+  bool have_prev = false;
+  uint32_t prev_ticks = 0;
+  uint32_t accepted = 0;
+  uint32_t rejected = 0;
+  std::vector<uint32_t>* periods = nullptr;  // Every accepted period, when set
+
+  void poll() {
+    gpt2_poll_capture();
+    Gpt2CaptureEvent event;
+    while (gpt2_pop_capture(event)) {
+      if (event.channel != 0) continue;
+      if (gate.add_edge(event.timestamp64)) {
+        GateResult result;
+        gate.get_result(result);
+        gates_closed++;
+        gate_error_sum += result.error_ticks;
+        gate_tick_sum += result.ticks;
+        gate_seconds_sum += result.seconds;
+      }
+      if (have_prev) {
+        uint32_t ticks = event.timestamp - prev_ticks;
+        if (ticks < REF_HZ * 0.99 || ticks > REF_HZ * 1.01) {
+          rejected++;
+          stability.mark_gap();
+          regression.mark_gap();
+        } else {
+          stats.add_sample(ticks);
+          stability.add_period(ticks);
+          regression.add_period(ticks);
+          accepted++;
+          if (periods) periods->push_back(ticks);
+        }
+      }
+      prev_ticks = event.timestamp;
+      have_prev = true;
+    }
+  }
+
+  double mean_ppb() const { return stats.get_ppb_error(REF_HZ); }
+};
+
+struct ScenarioResult {
+  bool passed;
+  char detail[192];
+};
+
+static void start_firmware(bool use_interrupts) {
+  gpt2_begin_dual_mode(1, GPT_EDGE_RISING, true);
+  gpt2_reset_counters();
+  gpt2_enable_interrupts(use_interrupts);
+}
+
+static void run_capture_scenario(const SimConfig& config, bool use_interrupts, double hours,
+                                 CaptureConsumer& consumer) {
+  PpsSimulator sim(config);
+  start_firmware(use_interrupts);
+  sim.set_loop_hook([&]() { consumer.poll(); });
+  sim.run_for(hours * 3600.0);
+}
+
+// A 2.5 s loop() stall between every pass, serviced from the ISR: no edge may be lost.
+static ScenarioResult scenario_isr_slow_loop() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 150.0;
+  config.oscillator.white_fm_ppb = 0.5;
+  config.loop_period_s = 2.5;
+  CaptureConsumer consumer;
+  ScenarioResult result = {};
+  // A restart with captures still queued first: the ring is cleared and must
+  // not show up as a sequence gap afterwards
+  CaptureConsumer before_restart;
+  SimConfig warmup = config;
+  warmup.loop_period_s = 5.0;
+  run_capture_scenario(warmup, true, 0.01, before_restart);
+  run_capture_scenario(config, true, 2.0, consumer);
+  Gpt2EventCounters counters;
+  gpt2_get_counters(counters);
+  double error = consumer.mean_ppb() - 150.0;
+  result.passed = counters.dropped_edges == 0 && consumer.rejected == 0 && fabs(error) < 1.0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu accepted, %lu rejected, %lu dropped, mean error %.3f ppb",
+           (unsigned long)consumer.accepted, (unsigned long)consumer.rejected,
+           (unsigned long)counters.dropped_edges, error);
+  return result;
+}
+
+// The same stall with polling only: captures get overwritten and periods span two seconds.
+static ScenarioResult scenario_polled_slow_loop() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 150.0;
+  config.loop_period_s = 2.5;
+  CaptureConsumer consumer;
+  ScenarioResult result = {};
+  run_capture_scenario(config, false, 0.5, consumer);
+  result.passed = consumer.rejected > 0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu accepted, %lu rejected (edges lost to the slow loop, as expected)",
+           (unsigned long)consumer.accepted, (unsigned long)consumer.rejected);
+  return result;
+}
+
+// Random PPS dropouts plus a one-minute outage must not bias the average.
+static ScenarioResult scenario_gps_dropouts() {
+  SimConfig config;
+  config.oscillator.offset_ppb = -420.0;
+  config.oscillator.white_fm_ppb = 1.0;
+  config.gps.sawtooth_ns = 15.0;
+  config.gps.dropout_probability = 0.02;
+  config.gps.outage_start_s = 1800;
+  config.gps.outage_length_s = 60;
+  CaptureConsumer consumer;
+  ScenarioResult result = {};
+  run_capture_scenario(config, true, 2.0, consumer);
+  double error = consumer.mean_ppb() + 420.0;
+  result.passed = consumer.accepted > 6500 && fabs(error) < 2.0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu accepted, %lu rejected around gaps, mean error %.3f ppb",
+           (unsigned long)consumer.accepted, (unsigned long)consumer.rejected, error);
+  return result;
+}
+
+// Measure, correct through the SiT5501 driver over the fake I2C bus, re-measure.
+static ScenarioResult scenario_sit5501_steer() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 1800.0;
+  config.oscillator.white_fm_ppb = 0.5;
+  SiT5501Model model;
+  Wire.attach_device(0x60, &model);
+  SiT5501 oscillator(0x60);
+  oscillator.begin();
+  oscillator.setOutputEnable(true);
+
+  PpsSimulator sim(config);
+  sim.set_control_source([&]() { return model.pull_ppb(); });
+  start_firmware(true);
+  CaptureConsumer consumer;
+  sim.set_loop_hook([&]() { consumer.poll(); });
+  sim.run_for(600.0);
+  double measured_ppb = consumer.mean_ppb();
+
+  oscillator.setFrequencyOffsetPPM(-measured_ppb / 1000.0);
+  sim.run_for(2.0);  // Let the new control word take effect
+  consumer.stats.reset();
+  sim.run_for(1800.0);
+  double residual = consumer.mean_ppb();
+
+  ScenarioResult result = {};
+  result.passed = fabs(residual) < 2.0 && oscillator.isPresent();
+  snprintf(result.detail, sizeof(result.detail),
+           "measured %.2f ppb, applied %.2f ppb, residual %.3f ppb",
+           measured_ppb, model.pull_ppb(), residual);
+  Wire.attach_device(0x60, nullptr);
+  return result;
+}
+
+// A full simulated day with aging and flicker noise.
+static ScenarioResult scenario_day_with_drift() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 35.0;
+  config.oscillator.drift_ppb_per_day = 8.0;
+  config.oscillator.white_fm_ppb = 0.3;
+  config.oscillator.flicker_fm_ppb = 0.05;
+  config.gps.sawtooth_ns = 10.0;
+  config.loop_period_s = 0.1;
+  CaptureConsumer consumer;
+  ScenarioResult result = {};
+  run_capture_scenario(config, true, 24.0, consumer);
+  double expected = 35.0 + 8.0 * 0.5;  // Average over the day
+  double error = consumer.mean_ppb() - expected;
+  result.passed = consumer.accepted >= 86398 && fabs(error) < 1.0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu accepted, mean %.3f ppb (expected %.1f)",
+           (unsigned long)consumer.accepted, consumer.mean_ppb(), expected);
+  return result;
+}
+
+// Sliding windows against a brute-force recomputation over the recorded periods,
+// with enough drift that the windows disagree: the longest lags the shortest by
+// half its length of drift. Runs long enough for the 10000-period ring to wrap.
+static ScenarioResult scenario_frequency_windows() {
+  SimConfig config;
+  config.oscillator.offset_ppb = -60.0;
+  config.oscillator.drift_ppb_per_day = 1500.0;
+  config.oscillator.white_fm_ppb = 2.0;
+  config.gps.sawtooth_ns = 10.0;
+  config.gps.dropout_probability = 0.01;
+  CaptureConsumer consumer;
+  std::vector<uint32_t> periods;
+  consumer.periods = &periods;
+  ScenarioResult result = {};
+  run_capture_scenario(config, true, 4.0, consumer);
+
+  bool exact = true;
+  double window_ppb[FrequencyStats::WINDOWS] = {};
+  for (uint8_t k = 0; k < FrequencyStats::WINDOWS; k++) {
+    FrequencyWindowStats window;
+    if (!consumer.stats.get_window(k, window)) {
+      exact = false;
+      continue;
+    }
+    size_t n = periods.size() < window.length ? periods.size() : window.length;
+    int64_t sum = 0;
+    uint32_t lo = 0xFFFFFFFF, hi = 0;
+    for (size_t i = periods.size() - n; i < periods.size(); i++) {
+      sum += (int64_t)periods[i] - 10000000;
+      if (periods[i] < lo) lo = periods[i];
+      if (periods[i] > hi) hi = periods[i];
+    }
+    double mean = (double)sum / n;
+    double m2 = 0.0;
+    for (size_t i = periods.size() - n; i < periods.size(); i++) {
+      double d = ((double)periods[i] - 10000000) - mean;
+      m2 += d * d;
+    }
+    double std_ticks = sqrt(m2 / (n - 1));
+    exact = exact && window.samples == n && window.min_ticks == lo && window.max_ticks == hi &&
+            fabs(window.mean_ticks - (10000000 + mean)) < 1e-9 && fabs(window.std_ticks - std_ticks) < 1e-9;
+    window_ppb[k] = (window.mean_ticks - REF_HZ) * 100.0;
+  }
+  int64_t total = 0;
+  for (uint32_t ticks : periods) total += (int64_t)ticks - 10000000;
+  double total_ppb = (double)total / periods.size() * 100.0;
+  exact = exact && consumer.stats.get_count() == periods.size() && fabs(consumer.mean_ppb() - total_ppb) < 1e-9;
+
+  double lag = window_ppb[0] - window_ppb[FrequencyStats::WINDOWS - 1];
+  double expected_lag = 1500.0 / 86400.0 * (10000 - 10) / 2.0;
+  result.passed = exact && fabs(lag - expected_lag) < 10.0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu periods, windows %.1f/%.1f/%.1f/%.1f ppb, lag %.1f ppb (expected %.1f), %s",
+           (unsigned long)periods.size(), window_ppb[0], window_ppb[1], window_ppb[2], window_ppb[3], lag,
+           expected_lag, exact ? "exact" : "MISMATCH");
+  return result;
+}
+
+// A synthetic edge stream with every kind of glitch: extra edges inside the
+// second, single and triple missed edges, pulses 4 us late, a 30 s outage and
+// a 5 ppm frequency step. No period handed on may carry a glitch, every
+// glitch must be classified, and only the outage and the step may restart.
+static ScenarioResult scenario_glitch_repair() {
+  PpsSampleFilter filter(10000000);
+  std::mt19937_64 rng(7);
+  std::normal_distribution<double> jitter(0.0, 0.4);  // Ticks
+  std::uniform_real_distribution<double> within(0.05, 0.95);
+
+  const double step_at = 2500.0;
+  uint32_t extras = 0, missing = 0, late = 0, leaks = 0;
+  double sum_before = 0.0, sum_after = 0.0;
+  uint32_t count_before = 0, count_after = 0;
+  double edge = 1000.0;
+  for (uint32_t second = 1; second < 3600; second++) {
+    double period = second <= step_at ? 10000003.0 : 10000053.0;  // Ending at this second's edge
+    edge += period;
+    bool outage = second >= 2000 && second < 2030;
+    if (outage || second % 131 == 0 || (second >= 1500 && second < 1503)) {
+      if (!outage) missing++;
+      continue;
+    }
+    if (second % 211 == 0) {
+      late++;
+    }
+    std::vector<double> edges = {edge + jitter(rng) + (second % 211 == 0 ? 40.0 : 0.0)};  // Late pulse
+    if (second % 97 == 0) {
+      edges.push_back(edge + within(rng) * 10000000.0);  // Noise or a double trigger
+      extras++;
+    }
+    for (double e : edges) {
+      PpsSample sample = filter.add_edge((uint64_t)llround(e));
+      for (uint32_t k = 0; k < sample.periods; k++) {
+        double ticks = PpsSampleFilter::period_ticks(sample, k);
+        if (fabs(ticks - period) > 3.0) leaks++;
+        if (second <= step_at) {
+          sum_before += ticks;
+          count_before++;
+        } else {
+          sum_after += ticks;
+          count_after++;
+        }
+      }
+    }
+  }
+
+  const PpsFilterStats& stats = filter.get_stats();
+  double before = sum_before / count_before - 10000003.0;
+  double after = sum_after / count_after - 10000053.0;
+  ScenarioResult result = {};
+  result.passed = leaks == 0 && stats.restarts == 2 && stats.merged >= extras - 2 &&
+                  stats.missed_edges >= missing + late && stats.rejected >= extras + late &&
+                  fabs(before) < 0.05 && fabs(after) < 0.05;
+  snprintf(result.detail, sizeof(result.detail),
+           "merged %lu/%lu extra, bridged %lu/%lu missed+late, %lu restarts, %lu leaks, mean %+.3f/%+.3f",
+           (unsigned long)stats.merged, (unsigned long)extras, (unsigned long)stats.missed_edges,
+           (unsigned long)(missing + late), (unsigned long)stats.restarts, (unsigned long)leaks, before, after);
+  return result;
+}
+
+// GPS edge jitter plus 100 ns tick quantization is white PM: ADEV(1 s) should be
+// sqrt(3) * sigma_x and fall as 1/tau, even across dropouts.
+static ScenarioResult scenario_stability_white_pm() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 150.0;
+  config.gps.jitter_ns = 50.0;
+  config.gps.dropout_probability = 0.001;
+  CaptureConsumer consumer;
+  ScenarioResult result = {};
+  run_capture_scenario(config, true, 6.0, consumer);
+  double sigma_x = sqrt(50e-9 * 50e-9 + 100e-9 * 100e-9 / 12.0);
+  double expected = sqrt(3.0) * sigma_x;
+  StabilityPoint tau1 = {}, tau64 = {};
+  bool have = consumer.stability.get_point(0, tau1) && consumer.stability.get_point(6, tau64);
+  double ratio1 = tau1.adev / expected;
+  double ratio64 = tau64.adev * tau64.tau / expected;
+  result.passed = have && fabs(ratio1 - 1.0) < 0.05 && fabs(ratio64 - 1.0) < 0.2 &&
+                  consumer.stability.get_gap_count() == consumer.rejected;
+  snprintf(result.detail, sizeof(result.detail),
+           "ADEV(1s) %.3e (expected %.3e), ADEV(64s)*64 %.3e (N=%lu), %lu gaps",
+           tau1.adev, expected, tau64.adev * tau64.tau, (unsigned long)tau64.adev_count,
+           (unsigned long)consumer.stability.get_gap_count());
+  return result;
+}
+
+// Ten minutes, 3.7 ppb off: the 60 s least-squares fit must resolve the offset
+// to about 1 ppb, where a 60-period average is still quantized to ~1.7 ppb.
+static ScenarioResult scenario_regression_fit() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 3.7;
+  config.oscillator.white_fm_ppb = 0.1;
+  config.gps.sawtooth_ns = 15.0;
+  CaptureConsumer consumer;
+  ScenarioResult result = {};
+  run_capture_scenario(config, true, 600.0 / 3600.0, consumer);
+  RegressionFit fit60 = {}, fit300 = {};
+  bool have = consumer.regression.get_fit(1, fit60) && consumer.regression.get_fit(2, fit300);
+  double error60 = fit60.frequency * 1e9 - 3.7;
+  double error300 = fit300.frequency * 1e9 - 3.7;
+  result.passed = have && fit60.samples == 60 && fabs(error60) < 1.0 && fit60.frequency_sigma * 1e9 < 1.0 &&
+                  fabs(error300) < 0.2 && fabs(error300) < 4.0 * fit300.frequency_sigma * 1e9 + 0.05;
+  snprintf(result.detail, sizeof(result.detail),
+           "fit(60) %.3f +- %.3f ppb, fit(300) %.3f +- %.3f ppb, resid %.1f ns (true 3.700)",
+           fit60.frequency * 1e9, fit60.frequency_sigma * 1e9, fit300.frequency * 1e9,
+           fit300.frequency_sigma * 1e9, fit300.residual_rms_ns);
+  return result;
+}
+
+// 1000 s gates over four hours with dropouts: every gate crosses two or three
+// counter wraps, and the exact counts must add up to the simulated offset.
+static ScenarioResult scenario_long_gate() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 123.4;
+  config.gps.sawtooth_ns = 15.0;
+  config.gps.dropout_probability = 0.01;
+  CaptureConsumer consumer;
+  consumer.gate.set_gate(1000);
+  ScenarioResult result = {};
+  run_capture_scenario(config, true, 4.0, consumer);
+  GateResult last = {};
+  bool have = consumer.gate.get_result(last);
+  double mean_ppb = (double)consumer.gate_error_sum * 1e9 / ((double)consumer.gate_seconds_sum * REF_HZ);
+  double last_ppb = GateCounter::result_ppb(last, 10000000);
+  result.passed = have && consumer.gates_closed >= 13 && last.seconds >= 1000 && last.seconds <= 1001 &&
+                  fabs(last_ppb - 123.4) < 0.2 && fabs(mean_ppb - 123.4) < 0.05 &&
+                  consumer.gate_tick_sum == (uint64_t)consumer.gate_seconds_sum * 10000000ull +
+                                                (uint64_t)consumer.gate_error_sum;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu gates, last %lu s (%lu edges) %.3f ppb, mean %.4f ppb (true 123.4), %lu ignored",
+           (unsigned long)consumer.gates_closed, (unsigned long)last.seconds, (unsigned long)last.edges,
+           last_ppb, mean_ppb, (unsigned long)consumer.gate.get_rejected_edges());
+  return result;
+}
+
+// Fractional-N output: 1234.567 Hz is not a whole number of ticks, yet the
+// edge count over 100 s must match exactly. Then 20 kHz with a 1 ms polled
+// loop: late edges are forced or skipped, never lost off the grid.
+static ScenarioResult scenario_output_synth() {
+  SimConfig config;
+  CaptureConsumer consumer;
+  PpsSimulator sim(config);
+  start_firmware(true);
+  sim.set_loop_hook([&]() { consumer.poll(); });
+  sim.run_for(1.0);
+  gpt2_set_output_frequency_mhz(1234567);
+  uint64_t rises_before = sim.counters().output_rising_edges;
+  sim.run_for(100.0);
+  double rises = (double)(sim.counters().output_rising_edges - rises_before);
+  double expected = 1234.567 * 100.0;
+  Gpt2OutputStats fine = {};
+  gpt2_get_output_stats(fine);
+
+  // From the ISR the rate stops at the interrupt ceiling, and there it is clean
+  bool refused = !gpt2_set_output_frequency_mhz(GPT2_OUTPUT_MAX_HZ * 1000);
+  gpt2_set_output_frequency_mhz(GPT2_OUTPUT_MAX_IRQ_HZ * 1000);
+  sim.run_for(1.0);
+  rises_before = sim.counters().output_rising_edges;
+  sim.run_for(10.0);
+  double ceiling_rises = (double)(sim.counters().output_rising_edges - rises_before);
+  Gpt2OutputStats ceiling = {};
+  gpt2_get_output_stats(ceiling);
+
+  SimConfig slow_config;
+  slow_config.loop_period_s = 0.001;
+  PpsSimulator slow(slow_config);
+  start_firmware(false);
+  slow.set_loop_hook([&]() { consumer.poll(); });
+  slow.run_for(0.5);
+  gpt2_set_output_frequency_mhz(20000000);
+  slow.run_for(2.0);
+  Gpt2OutputStats coarse = {};
+  gpt2_get_output_stats(coarse);
+  double grid_edges = 2.0 * 20000.0 * 2.0;
+  double accounted = (double)(coarse.edges + coarse.missed_edges);
+  // A polled rate above the ceiling comes down to it when interrupts are enabled
+  gpt2_set_output_frequency_mhz(200000000);
+  gpt2_enable_interrupts(true);
+  bool fell_back = gpt2_get_output_frequency_mhz() == GPT2_OUTPUT_MAX_IRQ_HZ * 1000;
+
+  ScenarioResult result = {};
+  result.passed = fabs(rises - expected) <= 1.0 && fine.forced_edges == 0 && fine.missed_edges == 0 &&
+                  fine.quantization_ns > 0 && fabs(accounted - grid_edges) <= 4.0 &&
+                  coarse.forced_edges + coarse.missed_edges > 0 && refused && fell_back &&
+                  fabs(ceiling_rises - GPT2_OUTPUT_MAX_IRQ_HZ * 10.0) <= 1.0 &&
+                  ceiling.forced_edges == 0 && ceiling.missed_edges == 0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%.0f rises (expected %.1f), quantization %lu ns; %.0f/s at the ISR ceiling, %lu late; "
+           "20 kHz polled: %lu forced, %lu missed, worst %lu ns late",
+           rises, expected, (unsigned long)fine.quantization_ns, ceiling_rises / 10.0,
+           (unsigned long)(ceiling.forced_edges + ceiling.missed_edges), (unsigned long)coarse.forced_edges,
+           (unsigned long)coarse.missed_edges, (unsigned long)coarse.max_late_ns);
+  start_firmware(true);
+  return result;
+}
+
+// 1 PPS output started at an arbitrary phase, 40 ppb off: a step, then
+// bounded slews must bring the output rise to 150 ns ahead of the GPS edge
+// and keep it there while the oscillator walks away.
+static ScenarioResult scenario_pps_align() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 40.0;
+  config.oscillator.white_fm_ppb = 0.3;
+  config.gps.sawtooth_ns = 15.0;
+  CaptureConsumer consumer;
+  PpsAligner aligner(10000000, 100.0);
+  aligner.set_offset_ns(-150);
+  aligner.set_enabled(true);
+  PpsSimulator sim(config);
+  start_firmware(true);
+
+  // Mirrors align_pps_output() in main.ino
+  double last_rise_s = -1.0;
+  double lead_sum_ns = 0.0, lead_worst_ns = 0.0;
+  uint32_t lead_count = 0;
+  bool measuring = false;
+  sim.set_loop_hook([&]() {
+    uint32_t before_accepted = consumer.accepted;
+    consumer.poll();
+    if (consumer.accepted != before_accepted) {
+      uint32_t rise;
+      int32_t pending;
+      gpt2_get_output_phase(rise, pending);
+      int32_t shift = aligner.add_edge(consumer.prev_ticks, rise, pending);
+      if (shift != 0) {
+        gpt2_slew_output(shift);
+      }
+    }
+    if (sim.last_output_rise_s() != last_rise_s && sim.last_pps_time_s() >= 0.0) {
+      last_rise_s = sim.last_output_rise_s();
+      double d = last_rise_s - sim.last_pps_time_s();
+      double d_ns = (d - floor(d + 0.5)) * 1e9;
+      if (measuring) {
+        lead_sum_ns += d_ns;
+        lead_count++;
+        if (fabs(d_ns + 150.0) > lead_worst_ns) lead_worst_ns = fabs(d_ns + 150.0);
+      }
+    }
+  });
+
+  sim.run_for(120.0);
+  bool aligned_early = aligner.get_state() == PPS_ALIGN_ALIGNED;
+  measuring = true;
+  sim.run_for(1800.0);
+  double mean_ns = lead_count ? lead_sum_ns / lead_count : 0.0;
+
+  ScenarioResult result = {};
+  result.passed = aligned_early && aligner.get_state() == PPS_ALIGN_ALIGNED && aligner.get_steps() >= 1 &&
+                  fabs(mean_ns + 150.0) < 20.0 && lead_worst_ns < 300.0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%s, %lu steps, %lu corrections, output %+.1f ns from GPS (want -150), worst %.0f ns off",
+           PpsAligner::state_name(aligner.get_state()), (unsigned long)aligner.get_steps(),
+           (unsigned long)aligner.get_corrections(), mean_ns, lead_worst_ns);
+  return result;
+}
+
+// Loop profile over ten minutes of 10 ms passes: a 20 ms stall inside the
+// nested MTP stage every 1000 passes must be blamed on MTP, not on the SD
+// service around it, and every timed pass must land in the histograms.
+// The stages spin on the host clock, so the stall is made long enough that
+// the host descheduling this process for a few ms cannot outweigh it.
+static ScenarioResult scenario_profiler() {
+  SimConfig config;
+  CaptureConsumer consumer;
+  PpsSimulator sim(config);
+  start_firmware(true);
+  profiler_begin();
+  uint32_t passes = 0;
+  auto spin_us = [](uint32_t us) {
+    uint32_t start = profiler_cycles();
+    while (profiler_cycles() - start < us * profiler_cycles_per_us()) {
+    }
+  };
+  sim.set_loop_hook([&]() {
+    profiler_loop_start();
+    profiler_enter(PROFILE_GPT2_POLL);
+    consumer.poll();
+    profiler_exit();
+    profiler_enter(PROFILE_SD_SERVICE);
+    spin_us(5);
+    profiler_enter(PROFILE_MTP);
+    spin_us(++passes % 1000 == 0 ? 20000 : 1);
+    profiler_exit();
+    profiler_exit();
+    profiler_loop_end();
+  });
+  sim.run_for(600.0);
+
+  ProfileStageStats loop = {}, sd = {}, mtp = {};
+  profiler_get_loop(loop);
+  profiler_get_stage(PROFILE_SD_SERVICE, sd);
+  profiler_get_stage(PROFILE_MTP, mtp);
+  ProfileWorstLoop worst = {};
+  bool have_worst = profiler_get_worst_loop(worst);
+  uint32_t histogram_total = 0;
+  for (uint8_t b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+    histogram_total += mtp.histogram[b];
+  }
+  double us = profiler_cycles_per_us();
+  ScenarioResult result = {};
+  result.passed = have_worst && worst.stage == PROFILE_MTP && loop.count == passes && mtp.count == passes &&
+                  histogram_total == passes && mtp.max_cycles >= 20000 * us && sd.max_cycles >= mtp.max_cycles &&
+                  worst.stage_cycles[PROFILE_SD_SERVICE] < 10000 * us && profiler_get_overflows() == 0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu passes, worst %.0f us in %s, mtp mean %.1f us max %.0f us, sd_service own %.1f us",
+           (unsigned long)loop.count, worst.cycles / us, profiler_stage_name(worst.stage),
+           (double)mtp.total_cycles / mtp.count / us, mtp.max_cycles / us,
+           worst.stage_cycles[PROFILE_SD_SERVICE] / us);
+  return result;
+}
+
+// Scheduler on the simulated clock (tasks burn time with delayMicroseconds):
+// a 20 ms stall every half second in a low-priority task must cost the
+// display deadlines and show as overruns, while the every-pass capture task
+// is still serviced between any two tasks.
+static uint32_t s_sched_capture_runs = 0;
+static uint32_t s_sched_last_capture_us = 0;
+static uint32_t s_sched_max_capture_gap_us = 0;
+static uint32_t s_sched_slow_runs = 0;
+
+static void sched_capture() {
+  uint32_t now = micros();
+  if (s_sched_capture_runs++ > 0 && now - s_sched_last_capture_us > s_sched_max_capture_gap_us) {
+    s_sched_max_capture_gap_us = now - s_sched_last_capture_us;
+  }
+  s_sched_last_capture_us = now;
+  delayMicroseconds(5);
+}
+static void sched_console() { delayMicroseconds(100); }
+static void sched_display() { delayMicroseconds(200); }
+static void sched_slow() { delayMicroseconds(++s_sched_slow_runs % 10 == 0 ? 20000 : 300); }
+
+static ScenarioResult scenario_scheduler() {
+  TaskScheduler scheduler;
+  scheduler.add_task("capture", sched_capture, 0, 0, 50);
+  scheduler.add_task("console", sched_console, 20000, 2, 1000);
+  scheduler.add_task("mtp", sched_slow, 50000, 3, 10000);
+  scheduler.add_task("display", sched_display, 1000, 3, 500);
+  uint64_t end_us = native_time_us + 10000000;
+  while (native_time_us < end_us) {
+    scheduler.run();
+    delayMicroseconds(1);  // yield()
+  }
+  TaskStats console = {}, slow = {}, display = {};
+  scheduler.get_stats(1, console);
+  scheduler.get_stats(2, slow);
+  scheduler.get_stats(3, display);
+
+  ScenarioResult result = {};
+  result.passed = slow.runs >= 200 && slow.runs <= 201 && slow.overruns == 20 && console.runs >= 495 && console.deadline_misses == 0 &&
+                  display.deadline_misses >= 20 && display.overruns == 0 &&
+                  s_sched_max_capture_gap_us <= 20000 + 500 && scheduler.get_idle_passes() > 0;
+  snprintf(result.detail, sizeof(result.detail),
+           "capture %lu runs, max gap %lu us; mtp %lu runs %lu overruns; display %lu misses; console %lu runs",
+           (unsigned long)s_sched_capture_runs, (unsigned long)s_sched_max_capture_gap_us,
+           (unsigned long)slow.runs, (unsigned long)slow.overruns, (unsigned long)display.deadline_misses,
+           (unsigned long)console.runs);
+  return result;
+}
+
+// Power up 1.8 ppm off with aging, discipline through the SiT5501 driver, ride
+// out a 15-minute GPS outage in holdover and re-lock afterwards.
+static ScenarioResult scenario_discipline_holdover() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 1800.0;
+  config.oscillator.drift_ppb_per_day = 20.0;
+  config.oscillator.white_fm_ppb = 0.3;
+  config.oscillator.flicker_fm_ppb = 0.05;
+  config.gps.sawtooth_ns = 15.0;
+  config.gps.dropout_probability = 0.002;
+  config.gps.outage_start_s = 3 * 3600;
+  config.gps.outage_length_s = 900;
+  SiT5501Model model;
+  Wire.attach_device(0x60, &model);
+  SiT5501 oscillator(0x60);
+  oscillator.begin();
+  oscillator.setOutputEnable(true);
+
+  PpsSimulator sim(config);
+  sim.set_control_source([&]() { return model.pull_ppb(); });
+  start_firmware(true);
+
+  // Mirrors main.ino: accepted periods feed the loop, rejected ones break phase
+  DiscipliningLoop loop(10000000, 100.0);
+  CaptureConsumer consumer;
+  double first_lock_s = -1.0;
+  uint32_t applied = 0;
+  loop.start(0.0, millis());
+  sim.set_loop_hook([&]() {
+    uint32_t before_accepted = consumer.accepted;
+    uint32_t before_rejected = consumer.rejected;
+    bool have_prev = consumer.have_prev;
+    uint32_t prev_ticks = consumer.prev_ticks;
+    consumer.poll();
+    bool changed = false;
+    if (consumer.rejected != before_rejected) {
+      loop.mark_gap();
+    } else if (consumer.accepted != before_accepted && have_prev) {
+      changed = loop.add_period(consumer.prev_ticks - prev_ticks, millis());
+    }
+    changed |= loop.service(millis());
+    if (changed) {
+      oscillator.updateFrequencyOffsetPPM(loop.get_control_ppb() / 1000.0);
+      applied++;
+    }
+    if (first_lock_s < 0.0 && loop.get_state() == DISCIPLINE_TRACK) {
+      first_lock_s = sim.now();
+    }
+  });
+
+  sim.run_for(3600.0);
+  consumer.stats.reset();
+  sim.run_for(2.0 * 3600.0 - 60.0);  // Up to one minute before the outage
+  double locked_ppb = consumer.mean_ppb();
+  double locked_rms_ns = loop.get_phase_rms_ns();
+  sim.run_for(120.0);
+  bool in_holdover = loop.get_state() == DISCIPLINE_HOLDOVER;
+  sim.run_for(900.0 + 1800.0);  // Rest of the outage, then 30 minutes to re-lock
+  bool relocked = loop.get_state() == DISCIPLINE_TRACK;
+
+  // Fast path: at most two words per update, never more than the loop asked for
+  SiT5501UpdateStats stats;
+  oscillator.getUpdateStats(stats);
+  bool lean = stats.updates + stats.unchanged <= applied && stats.words_written <= 2 * applied &&
+              stats.errors == 0 && stats.verify_failures == 0 && stats.verifies > 0;
+
+  ScenarioResult result = {};
+  result.passed = first_lock_s > 0.0 && first_lock_s < 600.0 && fabs(locked_ppb) < 0.5 &&
+                  locked_rms_ns < 150.0 && in_holdover && relocked && loop.get_holdover_count() >= 1 && lean;
+  snprintf(result.detail, sizeof(result.detail),
+           "locked after %.0f s, mean %.3f ppb, phase rms %.0f ns, %lu holdovers, %s at end, "
+           "%lu updates, %lu I2C words, %lu read-backs",
+           first_lock_s, locked_ppb, locked_rms_ns, (unsigned long)loop.get_holdover_count(),
+           DiscipliningLoop::state_name(loop.get_state()), (unsigned long)applied,
+           (unsigned long)stats.words_written, (unsigned long)stats.verifies);
+  Wire.attach_device(0x60, nullptr);
+  return result;
+}
+
+// Three days of tracking an aging oscillator with a daily temperature swing,
+// then an 8-hour GPS outage: the holdover time error with the drift model's
+// feed-forward against the loop's own drift extrapolation, mirroring main.ino
+// (hourly points in TRACK, feed-forward every 10 s)
+struct HoldoverRun {
+  double time_error_ns;       // Accumulated over the outage
+  double end_error_ppb;       // Frequency error when the PPS returns
+  DriftFit fit;
+  bool fitted;
+  DriftPredictionStats predictions;
+};
+
+static HoldoverRun run_drift_holdover(bool use_model) {
+  SimConfig config;
+  config.oscillator.offset_ppb = 800.0;
+  config.oscillator.drift_ppb_per_day = 30.0;
+  config.oscillator.white_fm_ppb = 0.3;
+  config.oscillator.flicker_fm_ppb = 0.05;
+  config.oscillator.temperature_swing_c = 4.0;
+  config.oscillator.temperature_ppb_per_c = 1.5;
+  config.gps.sawtooth_ns = 15.0;
+  config.gps.outage_start_s = 72 * 3600;
+  config.gps.outage_length_s = 8 * 3600;
+  config.loop_period_s = 0.05;
+  config.seed = 24;
+
+  double control_ppb = 0.0;
+  PpsSimulator sim(config);
+  sim.set_control_source([&]() { return control_ppb; });
+  start_firmware(true);
+
+  DiscipliningLoop loop(10000000, 100.0);
+  DriftModel model;
+  CaptureConsumer consumer;
+  HoldoverRun run = {};
+  double last_point_s = 0.0;
+  double last_feed_forward_s = 0.0;
+  double last_hook_s = 0.0;
+  const double outage_start = config.gps.outage_start_s + 1.0;
+  const double outage_end = outage_start + config.gps.outage_length_s;
+  loop.start(0.0, millis());
+  sim.set_loop_hook([&]() {
+    double now = sim.now();
+    uint32_t unix_time = 1700000000u + (uint32_t)now;
+    uint32_t before_accepted = consumer.accepted;
+    uint32_t before_rejected = consumer.rejected;
+    bool have_prev = consumer.have_prev;
+    uint32_t prev_ticks = consumer.prev_ticks;
+    consumer.poll();
+    if (consumer.rejected != before_rejected) {
+      loop.mark_gap();
+    } else if (consumer.accepted != before_accepted && have_prev) {
+      loop.add_period(consumer.prev_ticks - prev_ticks, millis());
+    }
+    loop.service(millis());
+    if (loop.get_state() == DISCIPLINE_TRACK && now - last_point_s >= 3600.0) {
+      last_point_s = now;
+      model.add_point(unix_time, loop.get_frequency_ppb(), (float)sim.temperature_c());
+    }
+    if (use_model && now - last_feed_forward_s >= 10.0) {
+      last_feed_forward_s = now;
+      double predicted;
+      double sigma;
+      loop.set_feed_forward(model.predict(unix_time, (float)sim.temperature_c(), predicted, sigma) ? predicted : NAN);
+    }
+    control_ppb = loop.get_control_ppb();
+    if (now > outage_start && now <= outage_end) {
+      run.time_error_ns += sim.current_frequency_ppb() * (now - last_hook_s);
+      run.end_error_ppb = sim.current_frequency_ppb();
+    }
+    last_hook_s = now;
+  });
+  sim.run_for(outage_end + 10.0);
+  run.fitted = model.has_fit();
+  run.fit = model.get_fit();
+  run.predictions = model.get_prediction_stats();
+  return run;
+}
+
+static ScenarioResult scenario_drift_model() {
+  HoldoverRun plain = run_drift_holdover(false);
+  HoldoverRun modelled = run_drift_holdover(true);
+  const DriftFit& fit = modelled.fit;
+  // The loop steers against the oscillator: the fitted control runs the other way
+  bool aging_ok = fabs(fit.aging_ppb_per_day + 30.0) < 3.0 * fit.aging_sigma_ppb_per_day + 1.0;
+  bool tempco_ok = fabs(fit.temperature_ppb_per_c + 1.5) < 0.3;
+
+  ScenarioResult result = {};
+  result.passed = modelled.fitted && aging_ok && tempco_ok &&
+                  fabs(modelled.time_error_ns) * 5.0 < fabs(plain.time_error_ns) &&
+                  modelled.predictions.count > 30 && modelled.predictions.rms_error_ppb < 1.0;
+  snprintf(result.detail, sizeof(result.detail),
+           "aging %.2f+-%.2f ppb/d, tempco %.2f ppb/C; 8 h holdover %.0f ns (drift only %.0f ns); "
+           "prediction rms %.2f ppb",
+           fit.aging_ppb_per_day, fit.aging_sigma_ppb_per_day, fit.temperature_ppb_per_c,
+           modelled.time_error_ns, plain.time_error_ns, modelled.predictions.rms_error_ppb);
+  return result;
+}
+
+// Both edges of a 100 ms pulse with 20 ns rms receiver jitter, 50 ppb fast:
+// the edges must come back with their polarity, the pulse width must be
+// exact, the period jitter must match the model (edge jitter and 100 ns
+// quantization, both twice per period) and the TIE must ramp at 50 ppb.
+// A five-second GPS outage is bridged on the grid. Polled with a slow loop,
+// edges are lost but none is tagged with the wrong polarity.
+static ScenarioResult scenario_edge_analysis() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 50.0;
+  config.gps.jitter_ns = 20.0;
+  config.gps.pulse_width_s = 0.1;
+  config.gps.outage_start_s = 300;
+  config.gps.outage_length_s = 5;
+  PpsSimulator sim(config);
+  start_firmware(true);
+  gpt2_set_capture_edge(GPT_EDGE_BOTH);
+  EdgeAnalyzer analyzer(10000000);
+  uint32_t rising_seen = 0;
+  uint32_t falling_seen = 0;
+  sim.set_loop_hook([&]() {
+    gpt2_poll_capture();
+    Gpt2CaptureEvent event;
+    while (gpt2_pop_capture(event)) {
+      bool rising = event.edge == GPT_EDGE_RISING;
+      rising ? rising_seen++ : falling_seen++;
+      analyzer.add_edge(event.timestamp64, rising);
+    }
+  });
+  sim.run_for(1200.0);
+
+  const EdgeStreamStats& rise = analyzer.get_stream(true);
+  const EdgeStreamStats& fall = analyzer.get_stream(false);
+  PulseWidthStats pulse = {};
+  analyzer.get_pulse_width(pulse);
+  uint32_t histogram_total = 0;
+  for (uint8_t b = 0; b < EdgeAnalyzer::JITTER_BINS; b++) {
+    histogram_total += analyzer.get_histogram(true)[b];
+  }
+  // Expected period jitter: sqrt(2 * (20^2 + 100^2 / 12)) ns
+  double expected_ns = sqrt(2.0 * (20.0 * 20.0 + 100.0 * 100.0 / 12.0));
+  double jitter_ns = rise.jitter_rms_ticks * 100.0;
+  double tie_ppb = rise.tie_ticks * 100.0 / (sim.now() - 1.0);
+
+  // Polled with loop() slower than the pulse: edges are lost, but the ones
+  // captured still carry their own polarity, so every pulse width is exact
+  SimConfig polled_config = config;
+  polled_config.loop_period_s = 0.37;
+  polled_config.gps.outage_length_s = 0;
+  PpsSimulator polled(polled_config);
+  start_firmware(false);
+  gpt2_set_capture_edge(GPT_EDGE_BOTH);
+  EdgeAnalyzer polled_analyzer(10000000);
+  polled.set_loop_hook([&]() {
+    gpt2_poll_capture();
+    Gpt2CaptureEvent event;
+    while (gpt2_pop_capture(event)) {
+      polled_analyzer.add_edge(event.timestamp64, event.edge == GPT_EDGE_RISING);
+    }
+  });
+  polled.run_for(300.0);
+  PulseWidthStats polled_pulse = {};
+  bool polled_widths = polled_analyzer.get_pulse_width(polled_pulse) &&
+                       polled_pulse.min_ticks >= 999990 && polled_pulse.max_ticks <= 1000010;
+  start_firmware(true);
+  gpt2_set_capture_edge(GPT_EDGE_RISING);
+
+  ScenarioResult result = {};
+  result.passed = rising_seen == falling_seen && rise.missed == 5 && fall.missed == 5 && rise.spurious == 0 &&
+                  rise.tie_restarts == 0 && analyzer.get_out_of_turn() == 0 && histogram_total == rise.periods &&
+                  fabs(pulse.mean_ticks - 1000000.0) < 1.0 && fabs(jitter_ns - expected_ns) < 0.1 * expected_ns &&
+                  fabs(tie_ppb - 50.0) < 2.0 && polled_widths && polled_analyzer.get_stream(true).missed > 0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu rising / %lu falling, %lu missed, pulse %.2f ticks, jitter %.1f ns rms (model %.1f), "
+           "TIE slope %.1f ppb; polled %lu pulses exact",
+           (unsigned long)rising_seen, (unsigned long)falling_seen, (unsigned long)rise.missed,
+           pulse.mean_ticks, jitter_ns, expected_ns, tie_ppb, (unsigned long)polled_pulse.count);
+  return result;
+}
+
+// Two receivers on the two capture channels for an hour, the second 250 ns
+// late (cable) with dropouts, both with 30 ns of white jitter (enough to make
+// the tick truncation of the two edges independent), on an oscillator 100 ppb
+// fast with white FM. Both inputs must read the oscillator offset, the phase
+// difference must come out at 250 ns with the oscillator noise cancelled, and
+// ADEV(1 s) of the difference must match white PM of the measured rms.
+static ScenarioResult scenario_two_inputs() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 100.0;
+  config.oscillator.white_fm_ppb = 20.0;
+  config.gps.jitter_ns = 30.0;
+  config.second_input = true;
+  config.gps2.offset_ns = 250.0;
+  config.gps2.jitter_ns = 30.0;
+  config.gps2.dropout_probability = 0.002;
+  PpsSimulator sim(config);
+  start_firmware(true);
+  gpt2_set_capture2_edge(GPT_EDGE_RISING);
+  PpsComparator comparator(10000000);
+  sim.set_loop_hook([&]() {
+    Gpt2CaptureEvent event;
+    while (gpt2_pop_capture(event)) {
+      comparator.add_edge(event.channel, event.timestamp64);
+    }
+  });
+  sim.run_for(3600.0);
+  gpt2_set_capture2_edge(GPT_EDGE_DISABLED);
+
+  double ppb0 = 0.0, ppb1 = 0.0;
+  comparator.get_input_ppb(0, ppb0);
+  comparator.get_input_ppb(1, ppb1);
+  const PpsPhaseStats& phase = comparator.get_phase();
+  StabilityPoint point = {};
+  comparator.get_stability().get_point(0, point);
+  // White PM: ADEV(tau0)^2 = 3 * var(x) / tau0^2
+  double expected_adev = sqrt(3.0) * phase.rms_ticks * 1e-7;
+  const PpsInputStats& input1 = comparator.get_input(1);
+
+  ScenarioResult result = {};
+  result.passed = fabs(ppb0 - 100.0) < 1.0 && fabs(ppb1 - 100.0) < 1.0 && fabs(phase.mean_ticks * 100.0 - 250.0) < 3.0 &&
+                  phase.rms_ticks * 100.0 < 80.0 && phase.pairs + input1.rejected + 5 >= 3599 &&
+                  phase.unpaired > 0 && comparator.get_stability().get_gap_count() > 0 &&
+                  fabs(point.adev / expected_adev - 1.0) < 0.15;
+  snprintf(result.detail, sizeof(result.detail),
+           "inputs %.2f / %.2f ppb, phase %+.1f ns (%.1f rms), %lu pairs, %lu unpaired, ADEV(1s) %.2e (white PM %.2e)",
+           ppb0, ppb1, phase.mean_ticks * 100.0, phase.rms_ticks * 100.0, (unsigned long)phase.pairs,
+           (unsigned long)phase.unpaired, point.adev, expected_adev);
+  return result;
+}
+
+static SawtoothCorrector* s_sawtooth = nullptr;
+
+static void sawtooth_ubx_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t length) {
+  UbxTimePulse pulse;
+  if (msg_class == UBX_CLASS_TIM && msg_id == UBX_TIM_TP && ubx_decode_time_pulse(payload, length, pulse)) {
+    s_sawtooth->add_report(pulse.tow_ms, pulse.qerr_ps, (pulse.flags & UBX_TP_FLAG_QERR_INVALID) == 0);
+  }
+}
+
+// A receiver with a +-20 ns sawtooth beating every ~14 s, reporting each
+// pulse's qErr in UBX-TIM-TP between NMEA sentences, as main.ino wires it:
+// UbxParser in front of the NMEA bytes, PpsSampleFilter edges into the
+// SawtoothCorrector, raw and corrected intervals into two StabilityEngines.
+// Some reports are lost, corrupted or parsed only after their pulse, one is
+// flagged invalid, edges drop out, and the time of week wraps mid-run.
+// The corrected ADEV must match an ideal series that takes the simulator's
+// true sawtooth off every edge, and sit below the raw one. With 100 ns ticks
+// the counter's own quantization dominates, so the gain is modest.
+static ScenarioResult scenario_sawtooth_qerr() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 120.0;
+  config.gps.sawtooth_ns = 20.0;
+  config.gps.jitter_ns = 2.0;
+  config.gps.dropout_probability = 0.002;
+  PpsSimulator sim(config);
+  start_firmware(true);
+
+  SawtoothCorrector corrector(10000000);
+  s_sawtooth = &corrector;
+  UbxParser ubx(sawtooth_ubx_frame);
+  PpsSampleFilter filter(10000000);
+  StabilityEngine raw(10000000, 1e-7, 1.0);
+  StabilityEngine clean(1000000000, 1e-9, 1.0);
+  StabilityEngine ideal(1000000000, 1e-9, 1.0);
+  int64_t residue_ps = 0;
+  int64_t ideal_residue_ps = 0;
+  int64_t ideal_previous_ps = 0;
+  std::mt19937_64 rng(25);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  const char* nmea = "$GNRMC,120000.00,A,4807.038,N,01131.000,E,0.02,,010125,,,A*6C\r\n";
+  uint64_t nmea_sent = 0, nmea_passed = 0;
+  uint32_t lost = 0, corrupted = 0, late = 0;
+  const uint32_t tow_start = SawtoothCorrector::WEEK_MS - 1800000;  // Wraps after 30 min
+  uint64_t reported = 0;      // Next pulse (frame) to report
+  uint64_t late_frame = 0;    // Held back past its pulse, 0 = none
+  bool invalid_sent = false;
+
+  auto send_report = [&](uint64_t frame, bool corrupt) {
+    uint8_t payload[16] = {};
+    uint32_t tow = (uint32_t)((tow_start + frame * 1000) % SawtoothCorrector::WEEK_MS);
+    int32_t qerr = (int32_t)llround(sim.pps_sawtooth_ns(frame) * 1000.0);
+    memcpy(payload, &tow, 4);
+    memcpy(payload + 8, &qerr, 4);
+    if (!invalid_sent && frame == 5000) {
+      payload[14] = UBX_TP_FLAG_QERR_INVALID;
+      invalid_sent = true;
+    }
+    uint8_t frame_bytes[24];
+    size_t size = ubx_build_frame(UBX_CLASS_TIM, UBX_TIM_TP, payload, sizeof(payload), frame_bytes, sizeof(frame_bytes));
+    if (corrupt) frame_bytes[10] ^= 0x40;
+    for (size_t i = 0; i < size; i++) ubx.encode(frame_bytes[i]);
+  };
+  // As main.ino: whole ns per second that add up to the exact total
+  auto add_interval = [](StabilityEngine& engine, int64_t& residue, int64_t interval_ps, uint32_t periods) {
+    residue += interval_ps;
+    int64_t total_ns = residue / 1000;
+    residue -= total_ns * 1000;
+    for (uint32_t k = 0; k < periods; k++) {
+      engine.add_period((uint32_t)(total_ns / periods + (k < (uint32_t)(total_ns % periods) ? 1 : 0)));
+    }
+  };
+
+  sim.set_loop_hook([&]() {
+    // Receiver output: after pulse n (at n + 0.25 s), NMEA then TIM-TP for pulse n + 1
+    double frame_time = sim.now() - (double)sim.second();
+    if (late_frame != 0 && frame_time >= 0.3 && sim.second() == late_frame) {
+      send_report(late_frame, false);
+      late_frame = 0;
+    }
+    if (frame_time >= 0.6 && reported <= sim.second()) {
+      for (const char* p = nmea; *p; p++) {
+        nmea_sent++;
+        if (!ubx.encode((uint8_t)*p)) nmea_passed++;
+      }
+      uint64_t frame = sim.second() + 1;
+      double draw = uniform(rng);
+      if (draw < 0.01) {
+        lost++;
+      } else if (draw < 0.015) {
+        corrupted++;
+        send_report(frame, true);
+      } else if (draw < 0.05) {
+        late++;
+        late_frame = frame;  // Parsed only after the pulse it describes
+      } else {
+        send_report(frame, false);
+      }
+      reported = sim.second() + 1;
+    }
+
+    gpt2_poll_capture();
+    Gpt2CaptureEvent event;
+    while (gpt2_pop_capture(event)) {
+      if (event.channel != 0) continue;
+      PpsSample sample = filter.add_edge(event.timestamp64);
+      if (sample.type == PPS_SAMPLE_REJECTED) continue;
+      corrector.add_edge(event.timestamp64, sample.periods);
+      if (sample.type == PPS_SAMPLE_RESTART) {
+        raw.mark_gap();
+        clean.mark_gap();
+        ideal.mark_gap();
+      }
+      for (uint32_t k = 0; k < sample.periods; k++) {
+        raw.add_period(PpsSampleFilter::period_ticks(sample, k));
+      }
+      // Polled within the frame of its pulse
+      int64_t ideal_ps = (int64_t)event.timestamp64 * 100000 - llround(sim.pps_sawtooth_ns(sim.second()) * 1000.0);
+      if (sample.periods > 0) {
+        add_interval(ideal, ideal_residue_ps, ideal_ps - ideal_previous_ps, sample.periods);
+      }
+      ideal_previous_ps = ideal_ps;
+    }
+    SawtoothInterval interval;
+    while (corrector.pop(interval)) add_interval(clean, residue_ps, interval.corrected_ps, interval.periods);
+  });
+  sim.run_for(4.0 * 3600.0);
+  s_sawtooth = nullptr;
+
+  const SawtoothStats& stats = corrector.get_stats();
+  const UbxParserStats& ubx_stats = ubx.get_stats();
+  StabilityPoint clean1 = {}, ideal1 = {};
+  clean.get_point(0, clean1);
+  ideal.get_point(0, ideal1);
+  // Up to tau 256 s: corrected = ideal, and never worse than raw
+  double best_gain = 0.0, worst_gain = 1e9, ideal_error = 0.0;
+  for (uint8_t k = 0; k < 9; k++) {
+    StabilityPoint r = {}, c = {}, i = {};
+    if (!raw.get_point(k, r) || !clean.get_point(k, c) || !ideal.get_point(k, i)) continue;
+    double gain = r.adev / c.adev;
+    if (gain > best_gain) best_gain = gain;
+    if (gain < worst_gain) worst_gain = gain;
+    if (fabs(c.adev / i.adev - 1.0) > ideal_error) ideal_error = fabs(c.adev / i.adev - 1.0);
+  }
+  uint32_t missing_reports = lost + corrupted + 1;  // + the invalid one
+  ScenarioResult result = {};
+  result.passed = nmea_passed == nmea_sent && ubx_stats.checksum_errors == corrupted &&
+                  stats.locks == 1 && stats.lock_losses == 0 && stats.edges > 14300 &&
+                  stats.unmatched <= missing_reports + 2 && stats.invalid == 1 &&
+                  ideal_error < 0.03 && worst_gain > 0.98 && best_gain > 1.1;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu/%lu edges matched (%lu lost, %lu bad, %lu late), ADEV(1s) %.2e (ideal %.2e, off %.1f%%), "
+           "raw %.2f-%.2fx",
+           (unsigned long)stats.matched, (unsigned long)stats.edges, (unsigned long)lost, (unsigned long)corrupted,
+           (unsigned long)late, clean1.adev, ideal1.adev, ideal_error * 100.0, worst_gain, best_gain);
+  return result;
+}
+
+// Telemetry link: every capture of a ten-minute run goes through the encoder
+// ring into a byte stream with one corrupted byte. The receiver must resync
+// on the next delimiter and recover every other capture bit-exact, reporting
+// the damaged frame once as a bad frame and once as a sequence gap.
+static ScenarioResult scenario_telemetry() {
+  SimConfig config;
+  config.oscillator.offset_ppb = 150.0;
+  PpsSimulator sim(config);
+  start_firmware(true);
+  TelemetryEncoder encoder;
+  std::vector<uint8_t> stream;
+  std::vector<uint64_t> sent;
+  TelemetryHello hello = {TELEM_MAGIC, 10000000};
+  encoder.send(TELEM_HELLO, &hello, sizeof(hello), millis());
+  sim.set_loop_hook([&]() {
+    gpt2_poll_capture();
+    Gpt2CaptureEvent event;
+    while (gpt2_pop_capture(event)) {
+      TelemetryCapture capture = {event.timestamp64, event.sequence, event.edge, event.channel};
+      if (encoder.send(TELEM_CAPTURE, &capture, sizeof(capture), millis())) {
+        sent.push_back(event.timestamp64);
+      }
+    }
+    uint8_t chunk[512];
+    size_t n;
+    while ((n = encoder.drain(chunk, sizeof(chunk))) > 0) {
+      stream.insert(stream.end(), chunk, chunk + n);
+    }
+  });
+  sim.run_for(600.0);
+
+  size_t corrupt_at = stream.size() / 2;
+  while (stream[corrupt_at] == 0x00) corrupt_at++;  // Damage a frame, not a delimiter
+  stream[corrupt_at] ^= 0x5A;
+  TelemetryDecoder decoder;
+  std::vector<uint64_t> received;
+  bool hello_ok = false;
+  for (uint8_t byte : stream) {
+    if (!decoder.push(byte)) continue;
+    if (decoder.header().type == TELEM_HELLO) {
+      TelemetryHello h;
+      memcpy(&h, decoder.body(), sizeof(h));
+      hello_ok = h.magic == TELEM_MAGIC;
+    } else if (decoder.header().type == TELEM_CAPTURE && decoder.body_length() == sizeof(TelemetryCapture)) {
+      TelemetryCapture capture;
+      memcpy(&capture, decoder.body(), sizeof(capture));
+      received.push_back(capture.timestamp);
+    }
+  }
+  size_t matched = 0;
+  for (size_t i = 0, j = 0; i < sent.size() && j < received.size(); i++) {
+    if (sent[i] == received[j]) {
+      matched++;
+      j++;
+    }
+  }
+  uint32_t bad = decoder.get_crc_errors() + decoder.get_framing_errors();
+
+  ScenarioResult result = {};
+  result.passed = hello_ok && sent.size() >= 599 && received.size() + 1 == sent.size() &&
+                  matched == received.size() && bad == 1 && decoder.get_lost_frames() == 1 &&
+                  encoder.get_dropped() == 0;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu captures sent in %lu bytes, %lu received, %lu bad frame, %lu lost",
+           (unsigned long)sent.size(), (unsigned long)stream.size(), (unsigned long)received.size(),
+           (unsigned long)bad, (unsigned long)decoder.get_lost_frames());
+  return result;
+}
+
+// Splitting and matching of machine query lines, as the console sees them
+static ScenarioResult scenario_console_protocol() {
+  static const char* const PATTERNS[] = {"*IDN", "MEASure:FREQuency", "MEASure:WINDows", "GPS", "SYSTem:HEALth"};
+  const char* line = " :meas:freq?; *idn? ;;:MEASURE:WIND?;:GPS;:MEASU:FREQ?;:syst:health?;:bad\"x?;:MEAS?";
+  const int expected[] = {1, 0, 2, 3, -1, 4, -1, -1};
+  const bool expected_query[] = {true, true, true, false, true, true, true, true};
+  const size_t expected_count = sizeof(expected) / sizeof(expected[0]);
+
+  ScpiLine commands(line);
+  ScpiCommand command;
+  size_t count = 0;
+  size_t mismatches = 0;
+  while (commands.next(command)) {
+    int match = -1;
+    for (int i = 0; i < (int)(sizeof(PATTERNS) / sizeof(PATTERNS[0])); i++) {
+      if (scpi_match(PATTERNS[i], command)) {
+        match = i;
+        break;
+      }
+    }
+    if (count >= expected_count || match != expected[count] || command.query != expected_query[count]) {
+      mismatches++;
+    }
+    count++;
+  }
+
+  ScpiLine with_args(":OUTP:FREQ 1000 ;");
+  bool args_ok = with_args.next(command) && !command.query && command.args_length == 4 &&
+                 strncmp(command.args, "1000", 4) == 0 && !with_args.next(command);
+
+  ScenarioResult result = {};
+  result.passed = count == expected_count && mismatches == 0 && args_ok;
+  snprintf(result.detail, sizeof(result.detail), "%lu commands, %lu mismatched, arguments %s",
+           (unsigned long)count, (unsigned long)mismatches, args_ok ? "ok" : "wrong");
+  return result;
+}
+
+// Emulated EEPROM for the settings store: a power cut after a given number of
+// byte writes, and byte writes counted per 68-byte slice (one flash sector
+// each on the Teensy 4.1)
+static const uint16_t EEPROM_BYTES = 4284;
+static const uint16_t EEPROM_SLICE = 68;
+static uint8_t s_eeprom[EEPROM_BYTES];
+static uint32_t s_eeprom_slice_writes[EEPROM_BYTES / EEPROM_SLICE];
+static int64_t s_eeprom_write_budget = -1;  // < 0: no power cut pending
+
+static uint8_t eeprom_read(uint16_t address) { return s_eeprom[address]; }
+
+static void eeprom_write(uint16_t address, uint8_t value) {
+  if (s_eeprom_write_budget == 0) return;
+  if (s_eeprom_write_budget > 0) s_eeprom_write_budget--;
+  if (s_eeprom[address] != value) {  // EEPROM.update
+    s_eeprom[address] = value;
+    s_eeprom_slice_writes[address / EEPROM_SLICE]++;
+  }
+}
+
+static uint32_t busiest_slice() {
+  uint32_t most = 0;
+  for (uint32_t writes : s_eeprom_slice_writes) most = writes > most ? writes : most;
+  return most;
+}
+
+// A year of hourly offset saves with calibration records, reboots, power cuts
+// in the middle of writes, and the same saves as the old fixed struct for wear
+static ScenarioResult scenario_settings_store() {
+  // A snapshot that could not be written is tried again, not taken as stored
+  memset(s_eeprom, 0xFF, sizeof(s_eeprom));
+  uint8_t duty = 20;
+  SettingsStore tiny(eeprom_read, eeprom_write, 48);  // 24-byte banks: no room for it
+  tiny.begin();
+  tiny.set_field(2, &duty, sizeof(duty));
+  bool retried = !tiny.commit() && !tiny.commit() && tiny.get_stats().unchanged == 0;
+
+  memset(s_eeprom, 0xFF, sizeof(s_eeprom));
+  memset(s_eeprom_slice_writes, 0, sizeof(s_eeprom_slice_writes));
+  std::mt19937_64 rng(23);
+  const int HOURS = 8760;
+
+  SettingsStore* store = new SettingsStore(eeprom_read, eeprom_write, EEPROM_BYTES);
+  bool blank = !store->begin();
+  store->set_field(2, &duty, sizeof(duty));
+  store->set_field(99, &duty, sizeof(duty));  // A tag this firmware does not know
+  bool unchanged_skipped = store->commit() && !store->commit();
+
+  double saved = 0.0;              // Newest committed offset
+  int32_t last_cal = INT32_MIN;    // Newest calibration that completed
+  uint32_t reboots = 0;
+  uint32_t cuts = 0;
+  uint32_t wrong = 0;
+  uint32_t in_place_writes = 0;    // Fixed struct: bytes changed, all in the slice at address 0
+  double struct_offset = 0.0;
+  for (int hour = 1; hour <= HOURS; hour++) {
+    double offset = 1.2345 + 0.01 * sin(hour / 24.0) + (double)(rng() % 1000) * 1e-9;
+    bool cut = hour % 97 == 0;
+    if (cut) {
+      s_eeprom_write_budget = (int64_t)(rng() % 60);
+      cuts++;
+    }
+    store->set_field(1, &offset, sizeof(offset));
+    bool committed = store->commit();
+    SettingsCalibration entry = {(uint32_t)(1700000000 + hour * 3600), (int32_t)(offset * 1e5), 1, 2, 0};
+    bool added = store->add_calibration(entry);
+    if (!cut) {
+      saved = offset;
+      last_cal = entry.offset_cppb;
+      wrong += committed && added ? 0 : 1;
+    }
+
+    uint8_t old_bytes[8];
+    uint8_t new_bytes[8];
+    memcpy(old_bytes, &struct_offset, 8);
+    memcpy(new_bytes, &offset, 8);
+    for (int i = 0; i < 8; i++) in_place_writes += old_bytes[i] != new_bytes[i];
+    in_place_writes += 2;  // Checksum
+    struct_offset = offset;
+
+    if (cut || hour % 500 == 0) {
+      s_eeprom_write_budget = -1;
+      delete store;
+      store = new SettingsStore(eeprom_read, eeprom_write, EEPROM_BYTES);
+      reboots++;
+      double loaded = NAN;
+      uint8_t loaded_duty = 0;
+      SettingsCalibration newest = {};
+      bool ok = store->begin() && store->get_field(1, &loaded, sizeof(loaded)) &&
+                store->get_field(2, &loaded_duty, sizeof(loaded_duty)) && loaded_duty == 20 &&
+                store->get_calibration(store->get_calibration_count() - 1, newest);
+      if (cut) {
+        // Either the write landed or nothing did; on this firmware both are fine
+        ok = ok && (loaded == offset || loaded == saved) &&
+             (newest.offset_cppb == entry.offset_cppb || newest.offset_cppb == last_cal);
+        if (ok && loaded == offset) saved = offset;
+        if (ok && newest.offset_cppb == entry.offset_cppb) last_cal = entry.offset_cppb;
+      } else {
+        ok = ok && loaded == saved && newest.offset_cppb == last_cal;
+      }
+      wrong += ok ? 0 : 1;
+    }
+  }
+  SettingsStoreStats stats = store->get_stats();
+  uint32_t journal_slice = busiest_slice();
+  bool history_full = store->get_calibration_count() == SettingsStore::HISTORY;
+  delete store;
+
+  ScenarioResult result = {};
+  result.passed = blank && unchanged_skipped && retried && wrong == 0 && history_full && stats.compactions > 0 &&
+                  journal_slice * 10 < in_place_writes;
+  snprintf(result.detail, sizeof(result.detail),
+           "%lu reboots, %lu cut, %lu bad; busiest slice %lu writes vs %lu in place",
+           (unsigned long)reboots, (unsigned long)cuts, (unsigned long)wrong,
+           (unsigned long)journal_slice, (unsigned long)in_place_writes);
+  return result;
+}
+
+struct Scenario {
+  const char* name;
+  ScenarioResult (*run)();
+};
+
+static const Scenario SCENARIOS[] = {
+  {"isr_slow_loop", scenario_isr_slow_loop},
+  {"polled_slow_loop", scenario_polled_slow_loop},
+  {"gps_dropouts", scenario_gps_dropouts},
+  {"sit5501_steer", scenario_sit5501_steer},
+  {"day_with_drift", scenario_day_with_drift},
+  {"frequency_windows", scenario_frequency_windows},
+  {"glitch_repair", scenario_glitch_repair},
+  {"stability_white_pm", scenario_stability_white_pm},
+  {"regression_fit", scenario_regression_fit},
+  {"long_gate", scenario_long_gate},
+  {"output_synth", scenario_output_synth},
+  {"pps_align", scenario_pps_align},
+  {"profiler", scenario_profiler},
+  {"scheduler", scenario_scheduler},
+  {"discipline_holdover", scenario_discipline_holdover},
+  {"drift_model", scenario_drift_model},
+  {"telemetry", scenario_telemetry},
+  {"edge_analysis", scenario_edge_analysis},
+  {"two_inputs", scenario_two_inputs},
+  {"sawtooth_qerr", scenario_sawtooth_qerr},
+  {"console_protocol", scenario_console_protocol},
+  {"settings_store", scenario_settings_store},
+};
+
+static bool selected(const char* name, int argc, char** argv) {
+  if (argc <= 1) return true;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv) {
+  Serial.set_quiet(true);
+  int failures = 0;
+  for (const Scenario& scenario : SCENARIOS) {
+    if (!selected(scenario.name, argc, argv)) continue;
+    auto start = std::chrono::steady_clock::now();
+    ScenarioResult result = scenario.run();
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[%s] %-18s %s (%.2f s)\n", result.passed ? "PASS" : "FAIL", scenario.name, result.detail, wall_s);
+    if (!result.passed) failures++;
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -34,11 +34,18 @@ def plot_allan_deviation(df):
 import numpy as np
 import plotly.graph_objects as go
 import allantools
+from decode_binlog import is_binlog, load_binlog
 
 def plot_allan_deviation(df):
-    ppm_col = 'ppm_instantaneous'
-    ppb = np.array(df[ppm_col]) * 1000
-    (tau, adev, adev_err, n) = allantools.oadev(ppb, rate=1.0, data_type="freq")
+    stability = df.attrs.get('stability')
+    if stability is not None:
+        # Precomputed by tools/loganalyzer
+        tau = np.asarray(stability['tau_s'], dtype=float)
+        adev = np.asarray(stability['adev_ppb'], dtype=float)
+    else:
+        ppm_col = 'ppm_instantaneous'
+        ppb = np.array(df[ppm_col]) * 1000
+        (tau, adev, adev_err, n) = allantools.oadev(ppb, rate=1.0, data_type="freq")
 
     fig = go.Figure()
 
@@ -102,6 +109,15 @@ def load_log_file(filepath):
     if not os.path.exists(filepath):
         raise FileNotFoundError(f"Log file not found: {filepath}")
     
+    # Output directory of tools/loganalyzer (already filtered to +-1 tick)
+    if os.path.isdir(filepath):
+        return load_analysis_dir(filepath)
+    
+    # Binary logs (.fcb) are decoded to the same columns as the JSONL logs
+    if is_binlog(filepath):
+        df = pd.DataFrame(load_binlog(filepath))
+        return df[(df['ticks'] >= 9_999_999) & (df['ticks'] <= 10_000_001)]
+    
     # Read first few lines to determine format
     with open(filepath, 'r') as f:
         first_line = f.readline().strip()
@@ -135,6 +151,32 @@ def load_json_log(filepath):
     df = df[(df['ticks'] >= 9_999_999) & (df['ticks'] <= 10_000_001)]
     return df
 
+def load_analysis_dir(dirpath):
+    """Load the columns written by tools/loganalyzer (memory-mapped .npy files)."""
+    def column(name):
+        path = os.path.join(dirpath, name + '.npy')
+        return np.load(path, mmap_mode='r') if os.path.exists(path) else None
+
+    ppb = column('ppb')
+    if ppb is None:
+        raise ValueError(f"Not a loganalyzer output directory: {dirpath}")
+    time_unix = np.asarray(column('time_unix'))
+    df = pd.DataFrame({
+        'timestamp': pd.to_datetime(np.where(time_unix >= 0, time_unix, np.nan), unit='s'),  # -1: no GPS time
+        'ticks': column('ticks'),
+        'ppm_instantaneous': ppb / 1000,
+        'oscillator_offset_ppm': column('offset_ppm'),
+        'gps_lat': column('gps_lat'),
+        'gps_lon': column('gps_lon'),
+    })
+    filtered = column('ppb_filtered')
+    if filtered is not None:
+        df['ppb_filtered'] = filtered
+    stability_path = os.path.join(dirpath, 'stability.csv')
+    if os.path.exists(stability_path):
+        df.attrs['stability'] = pd.read_csv(stability_path)
+    return df
+
 def load_multiple_files(filepaths):
     """Load and combine multiple log files."""
     all_data = []
@@ -159,6 +201,9 @@ def load_multiple_files(filepaths):
     
     # Combine all dataframes
     combined_df = pd.concat(all_data, ignore_index=True)
+    # Precomputed results of one loganalyzer run do not apply to the combination
+    combined_df = combined_df.drop(columns=['ppb_filtered'], errors='ignore')
+    combined_df.attrs = {}
     
     # Sort by timestamp if available
     if 'gps_timestamp' in combined_df.columns:
@@ -352,7 +397,10 @@ def plot_ppm_analysis(df, show_filtered=True, cutoff_freq=0.1):
     
     # Add filtered data if requested and we have enough data
     if show_filtered and len(ppb_error) > 10:
-        ppb_error_filtered = apply_lowpass_filter(ppb_error, cutoff_freq=cutoff_freq)
+        if 'ppb_filtered' in df.columns:
+            ppb_error_filtered = df['ppb_filtered']  # Filtered by tools/loganalyzer (its --cutoff)
+        else:
+            ppb_error_filtered = apply_lowpass_filter(ppb_error, cutoff_freq=cutoff_freq)
         fig.add_trace(go.Scatter(
             x=x_data,
             y=ppb_error_filtered, 
@@ -494,7 +542,7 @@ def create_combined_html(freq_fig, allan_fig, map_fig=None, output_file='frequen
 
 def main():
     parser = argparse.ArgumentParser(description='Plot frequency counter log files')
-    parser.add_argument('files', nargs='+', help='JSONL log files to plot')
+    parser.add_argument('files', nargs='+', help='JSONL or binary (.fcb) log files, or tools/loganalyzer output directories, to plot')
     parser.add_argument('--cutoff', type=float, default=0.001, help='Filter cutoff frequency (default: 0.001)')
     parser.add_argument('--no-filter', action='store_true', help='Disable filtering')
     parser.add_argument('--output', default='frequency_analysis.html', help='Output HTML file (default: frequency_analysis.html)')
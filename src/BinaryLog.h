@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Compact binary log format (.fcb files).
+//
+// A 32-byte header followed by fixed 32-byte little-endian records, so
+// sixteen records fill one 512-byte SD sector and no record ever straddles
+// a sector boundary. All-zero records are sector padding and are skipped
+// by readers. decode_binlog.py converts these files to JSONL/CSV.
+//
+// Version 2 split the 16-bit gps_source into the source index and the
+// receiver's qErr; the high byte was always zero in version 1, so readers
+// take the low byte for either version.
+
+static const uint32_t BINLOG_MAGIC = 0x424C4346;  // "FCLB"
+static const uint16_t BINLOG_VERSION = 2;
+static const size_t BINLOG_SECTOR_SIZE = 512;
+
+struct BinaryLogHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t nominal_hz;     // Timebase the tick counts refer to
+  uint32_t created_unix;   // GPS time the file was opened
+  uint8_t reserved[16];
+} __attribute__((packed));
+
+enum BinaryLogFlags : uint16_t {
+  BINLOG_FLAG_RECORD   = 0x0001,  // Set on every real record (clear = padding)
+  BINLOG_FLAG_GPS_FIX  = 0x0002,  // lat/lon are valid
+  BINLOG_FLAG_PPS_DATA = 0x0004,  // ticks/capture_ticks/ppm_average are valid
+  BINLOG_FLAG_LOOP_MASK = 0x0018,  // GPSDO loop state (DisciplineState) in bits 3-4
+  BINLOG_FLAG_QERR     = 0x0020,  // qerr_ns is valid (UBX-TIM-TP of the capture closing ticks)
+};
+
+static const uint8_t BINLOG_LOOP_SHIFT = 3;
+
+inline uint16_t binlog_loop_flags(uint8_t loop_state) {
+  return (uint16_t)((loop_state << BINLOG_LOOP_SHIFT) & BINLOG_FLAG_LOOP_MASK);
+}
+
+struct BinaryLogRecord {
+  uint16_t flags;
+  uint8_t gps_source;        // Index into rmc_source_map
+  int8_t qerr_ns;            // Receiver quantization error of capture_ticks, ns (saturated)
+  uint32_t gps_unix;         // GPS UTC time, seconds since 1970
+  uint32_t ticks;            // Ticks in the PPS interval (= Hz for a 1 s gate)
+  uint32_t capture_ticks;    // Raw GPT2 capture timestamp closing the interval
+  int32_t lat_e7;            // Degrees * 1e7
+  int32_t lon_e7;
+  int32_t osc_offset_cppb;   // Oscillator offset, 0.01 ppb units
+  int32_t ppm_average_cppb;  // Average error over the last 1000 periods, 0.01 ppb units
+} __attribute__((packed));
+
+static_assert(sizeof(BinaryLogHeader) == 32, "BinaryLogHeader must stay 32 bytes");
+static_assert(sizeof(BinaryLogRecord) == 32, "BinaryLogRecord must stay 32 bytes");
+static_assert(BINLOG_SECTOR_SIZE % sizeof(BinaryLogRecord) == 0, "records must tile a sector");
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm)
+inline int32_t binlog_days_from_civil(int32_t y, uint32_t m, uint32_t d) {
+  y -= m <= 2;
+  const int32_t era = (y >= 0 ? y : y - 399) / 400;
+  const uint32_t yoe = (uint32_t)(y - era * 400);
+  const uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+inline uint32_t binlog_unix_time(int32_t year, uint32_t month, uint32_t day,
+                                 uint32_t hour, uint32_t minute, uint32_t second) {
+  return (uint32_t)binlog_days_from_civil(year, month, day) * 86400u + hour * 3600u + minute * 60u + second;
+}
+
+// qErr in ps to the record's saturated whole ns; consecutive records give the
+// corrected interval: ticks - (qerr_ns - previous qerr_ns) / tick_ns
+inline int8_t binlog_qerr_ns(int32_t qerr_ps) {
+  int32_t ns = (qerr_ps < 0 ? qerr_ps - 500 : qerr_ps + 500) / 1000;
+  if (ns > 127) return 127;
+  if (ns < -128) return -128;
+  return (int8_t)ns;
+}
+
+// Scale a value to a saturated int32 fixed-point field
+inline int32_t binlog_fixed(double value, double scale) {
+  double scaled = value * scale;
+  if (!(scaled == scaled)) return 0;  // NaN
+  if (scaled > 2147483647.0) return 2147483647;
+  if (scaled < -2147483648.0) return (int32_t)0x80000000;
+  return (int32_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
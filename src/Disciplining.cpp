@@ -0,0 +1,227 @@
+#include "Disciplining.h"
+#include <math.h>
+
+static const double LOOP_DAMPING = 0.707;
+static const double PHASE_RMS_ALPHA = 1.0 / 60.0;
+static const uint32_t DRIFT_INTERVAL_MS = 600000;       // Integrator sampled every 10 min in TRACK
+static const uint32_t HOLDOVER_UPDATE_MS = 10000;       // Extrapolated control re-applied every 10 s
+static const uint8_t DRIFT_MIN_SAMPLES = 3;
+
+DiscipliningLoop::DiscipliningLoop(uint32_t nominal_ticks, double tick_length_ns)
+    : cfg(default_config()), nominal(nominal_ticks), tick_ns(tick_length_ns),
+      state(DISCIPLINE_OFF), state_since_ms(0), last_period_ms(0), phase_valid(false),
+      phase_ticks(0), phase_ns(0.0), phase_ms2(0.0), integrator_ppb(0.0), control_ppb(0.0),
+      frequency_valid(false), fll_periods(0), in_lock_periods(0),
+      drift_sample_ms(0), drift_sample_ppb(0.0), drift_ppb_per_s(0.0), drift_valid(false),
+      drift_samples(0), holdover_base_ppb(0.0), last_holdover_update_ms(0), holdover_from(DISCIPLINE_OFF),
+      feed_forward_valid(false), feed_forward_ppb(0.0), feed_forward_total_ppb(0.0),
+      lock_count(0), holdover_count(0) {
+}
+
+DisciplineConfig DiscipliningLoop::default_config() {
+  DisciplineConfig config;
+  config.acquire_time_constant_s = 30;
+  config.track_time_constant_s = 600;
+  config.frequency_lock_periods = 16;
+  config.lock_threshold_ns = 250.0;
+  config.lock_periods = 60;
+  config.unlock_threshold_ns = 3000.0;
+  config.holdover_after_ms = 5000;  // Rides out two consecutive missed pulses
+  config.reacquire_after_s = 600;
+  config.limit_ppb = 6250.0;
+  return config;
+}
+
+void DiscipliningLoop::set_config(const DisciplineConfig& config) {
+  cfg = config;
+}
+
+void DiscipliningLoop::set_track_time_constant(uint32_t seconds) {
+  if (seconds < 10) seconds = 10;
+  if (seconds > 100000) seconds = 100000;
+  cfg.track_time_constant_s = seconds;
+}
+
+const char* DiscipliningLoop::state_name(DisciplineState s) {
+  switch (s) {
+    case DISCIPLINE_OFF: return "OFF";
+    case DISCIPLINE_ACQUIRE: return "ACQUIRE";
+    case DISCIPLINE_TRACK: return "TRACK";
+    case DISCIPLINE_HOLDOVER: return "HOLDOVER";
+  }
+  return "?";
+}
+
+double DiscipliningLoop::clamp(double ppb) const {
+  if (ppb > cfg.limit_ppb) return cfg.limit_ppb;
+  if (ppb < -cfg.limit_ppb) return -cfg.limit_ppb;
+  return ppb;
+}
+
+void DiscipliningLoop::enter(DisciplineState next, uint32_t now_ms) {
+  state = next;
+  state_since_ms = now_ms;
+  in_lock_periods = 0;
+}
+
+void DiscipliningLoop::start(double initial_ppb, uint32_t now_ms) {
+  integrator_ppb = clamp(initial_ppb);
+  control_ppb = integrator_ppb;
+  frequency_valid = false;
+  fll_periods = 0;
+  phase_valid = false;
+  phase_ns = 0.0;
+  phase_ms2 = 0.0;
+  drift_valid = false;
+  drift_samples = 0;
+  drift_ppb_per_s = 0.0;
+  feed_forward_valid = false;
+  feed_forward_total_ppb = 0.0;
+  last_period_ms = now_ms;
+  enter(DISCIPLINE_ACQUIRE, now_ms);
+}
+
+void DiscipliningLoop::stop() {
+  state = DISCIPLINE_OFF;
+}
+
+void DiscipliningLoop::mark_gap() {
+  // The next period starts a new phase reference; the learned frequency stays
+  phase_valid = false;
+  if (state == DISCIPLINE_ACQUIRE && !frequency_valid) {
+    fll_periods = 0;
+  }
+}
+
+bool DiscipliningLoop::add_period(uint32_t ticks, uint32_t now_ms) {
+  if (state == DISCIPLINE_OFF) {
+    return false;
+  }
+  last_period_ms = now_ms;
+
+  if (state == DISCIPLINE_HOLDOVER) {
+    // The phase reference did not survive the outage; a long one re-acquires
+    uint32_t held_s = (now_ms - state_since_ms) / 1000;
+    bool resume = holdover_from == DISCIPLINE_TRACK && held_s <= cfg.reacquire_after_s;
+    phase_valid = false;
+    enter(resume ? DISCIPLINE_TRACK : DISCIPLINE_ACQUIRE, now_ms);
+  }
+
+  if (!phase_valid) {
+    phase_ticks = 0;
+    phase_valid = true;
+  }
+  phase_ticks += (int64_t)ticks - (int64_t)nominal;
+  phase_ns = (double)phase_ticks * tick_ns;
+  phase_ms2 += PHASE_RMS_ALPHA * (phase_ns * phase_ns - phase_ms2);
+
+  if (state == DISCIPLINE_ACQUIRE && !frequency_valid) {
+    // Frequency-lock step: mean error over the first periods (ns per s = ppb)
+    fll_periods++;
+    if (fll_periods < cfg.frequency_lock_periods) {
+      return false;
+    }
+    integrator_ppb = clamp(integrator_ppb - phase_ns / fll_periods);
+    control_ppb = integrator_ppb;
+    frequency_valid = true;
+    phase_valid = false;  // Phase accumulated so far belongs to the old frequency
+    return true;
+  }
+
+  // Type-2 PI loop: natural frequency 1/tau, damping LOOP_DAMPING
+  DisciplineState before = state;
+  double tau = (double)(state == DISCIPLINE_TRACK ? cfg.track_time_constant_s : cfg.acquire_time_constant_s);
+  integrator_ppb = clamp(integrator_ppb - phase_ns / (tau * tau));
+  control_ppb = clamp(integrator_ppb - 2.0 * LOOP_DAMPING / tau * phase_ns);
+
+  double abs_phase = fabs(phase_ns);
+  if (state == DISCIPLINE_ACQUIRE) {
+    in_lock_periods = abs_phase < cfg.lock_threshold_ns ? in_lock_periods + 1 : 0;
+    if (in_lock_periods >= cfg.lock_periods) {
+      enter(DISCIPLINE_TRACK, now_ms);
+      lock_count++;
+      drift_sample_ms = now_ms;
+      drift_sample_ppb = integrator_ppb;
+    }
+  } else if (state == DISCIPLINE_TRACK) {
+    if (abs_phase > cfg.unlock_threshold_ns) {
+      enter(DISCIPLINE_ACQUIRE, now_ms);
+    } else {
+      update_drift(now_ms);
+    }
+  }
+
+  if (state != before) {
+    // Bumpless gain change: keep the applied control, re-base the integrator
+    double new_tau = (double)(state == DISCIPLINE_TRACK ? cfg.track_time_constant_s : cfg.acquire_time_constant_s);
+    integrator_ppb = clamp(control_ppb + 2.0 * LOOP_DAMPING / new_tau * phase_ns);
+  }
+  return true;
+}
+
+void DiscipliningLoop::update_drift(uint32_t now_ms) {
+  uint32_t elapsed_ms = now_ms - drift_sample_ms;
+  if (elapsed_ms < DRIFT_INTERVAL_MS) {
+    return;
+  }
+  double slope = (integrator_ppb - drift_sample_ppb) / (elapsed_ms / 1000.0);
+  if (drift_samples == 0) {
+    drift_ppb_per_s = slope;
+  } else {
+    drift_ppb_per_s += 0.25 * (slope - drift_ppb_per_s);
+  }
+  if (drift_samples < 255) drift_samples++;
+  drift_valid = drift_samples >= DRIFT_MIN_SAMPLES;
+  drift_sample_ms = now_ms;
+  drift_sample_ppb = integrator_ppb;
+}
+
+bool DiscipliningLoop::service(uint32_t now_ms) {
+  if (state == DISCIPLINE_ACQUIRE || state == DISCIPLINE_TRACK) {
+    if ((int32_t)(now_ms - last_period_ms) <= (int32_t)cfg.holdover_after_ms) {
+      return false;
+    }
+    // PPS lost: hold the learned frequency, without the phase correction
+    holdover_base_ppb = integrator_ppb;
+    control_ppb = integrator_ppb;
+    phase_valid = false;
+    last_holdover_update_ms = now_ms;
+    holdover_count++;
+    holdover_from = state;
+    enter(DISCIPLINE_HOLDOVER, now_ms);
+    return true;
+  }
+
+  if (state == DISCIPLINE_HOLDOVER && drift_valid && !feed_forward_valid &&
+      now_ms - last_holdover_update_ms >= HOLDOVER_UPDATE_MS) {
+    double held_s = (now_ms - state_since_ms) / 1000.0;
+    control_ppb = clamp(holdover_base_ppb + drift_ppb_per_s * held_s);
+    integrator_ppb = control_ppb;
+    last_holdover_update_ms = now_ms;
+    return true;
+  }
+  return false;
+}
+
+bool DiscipliningLoop::set_feed_forward(double predicted_ppb) {
+  if (isnan(predicted_ppb)) {
+    feed_forward_valid = false;
+    return false;
+  }
+  double step = feed_forward_valid ? predicted_ppb - feed_forward_ppb : 0.0;
+  feed_forward_ppb = predicted_ppb;
+  feed_forward_valid = true;
+  // While acquiring the loop is still finding the frequency; the model only
+  // re-bases so its next change starts from here
+  if (step == 0.0 || (state != DISCIPLINE_TRACK && state != DISCIPLINE_HOLDOVER)) {
+    return false;
+  }
+  integrator_ppb = clamp(integrator_ppb + step);
+  control_ppb = clamp(control_ppb + step);
+  feed_forward_total_ppb += step;
+  return true;
+}
+
+double DiscipliningLoop::get_phase_rms_ns() const {
+  return sqrt(phase_ms2);
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+
+// GPSDO disciplining loop for the oscillator that clocks GPT2.
+//
+// Every accepted PPS period adds (ticks - nominal) to an exact integer phase
+// error. A type-2 PI loop on that phase steers the oscillator's frequency
+// control, so both the frequency and the accumulated time error go to zero:
+//
+//   ACQUIRE   - optional frequency-lock step (mean error over the first few
+//               periods, applied at once), then a fast PI loop
+//   TRACK     - low-bandwidth PI loop once the phase error has stayed small
+//   HOLDOVER  - PPS lost: the proportional term is dropped and the learned
+//               frequency is held, extrapolated with the drift seen in TRACK
+//
+// An external model of the oscillator (DriftModel: aging, temperature) can
+// feed forward: each change of its predicted control is added straight to the
+// integrator in TRACK and HOLDOVER. The PI loop then only corrects what the
+// model misses (no phase lag behind a steady aging ramp), and holdover
+// follows the model instead of the drift extrapolation.
+//
+// The loop only computes the control value; the caller applies it (and
+// decides how often) through the SiT5501 driver. Control values are ppb,
+// positive meaning a higher oscillator frequency.
+
+enum DisciplineState : uint8_t {
+  DISCIPLINE_OFF = 0,       // Free-running at a fixed (manual) offset
+  DISCIPLINE_ACQUIRE = 1,
+  DISCIPLINE_TRACK = 2,
+  DISCIPLINE_HOLDOVER = 3,
+};
+
+struct DisciplineConfig {
+  uint32_t acquire_time_constant_s;  // PI loop time constant while acquiring
+  uint32_t track_time_constant_s;    // ... and once locked
+  uint16_t frequency_lock_periods;   // Periods averaged for the initial frequency step
+  double lock_threshold_ns;          // |phase error| below this ...
+  uint16_t lock_periods;             // ... for this many periods -> TRACK
+  double unlock_threshold_ns;        // |phase error| above this in TRACK -> ACQUIRE
+  uint32_t holdover_after_ms;        // No accepted period for this long -> HOLDOVER
+  uint32_t reacquire_after_s;        // Holdover longer than this re-enters ACQUIRE
+  double limit_ppb;                  // Control range (the oscillator's pull range)
+};
+
+class DiscipliningLoop {
+public:
+  DiscipliningLoop(uint32_t nominal_ticks, double tick_ns);
+
+  static DisciplineConfig default_config();
+  void set_config(const DisciplineConfig& config);
+  const DisciplineConfig& get_config() const { return cfg; }
+
+  // Starts (or restarts) acquisition from `initial_ppb`, e.g. the saved offset
+  void start(double initial_ppb, uint32_t now_ms);
+  void stop();  // DISCIPLINE_OFF: control stays where it is
+  void set_track_time_constant(uint32_t seconds);
+
+  // Each returns true when the control value changed and should be applied
+  bool add_period(uint32_t ticks, uint32_t now_ms);
+  void mark_gap();  // Phase continuity lost (missed or spurious edge)
+  bool service(uint32_t now_ms);  // Holdover entry and extrapolation
+  bool set_feed_forward(double predicted_ppb);  // NAN: no model (back to the drift extrapolation)
+
+  DisciplineState get_state() const { return state; }
+  static const char* state_name(DisciplineState state);
+  double get_control_ppb() const { return control_ppb; }
+  double get_frequency_ppb() const { return integrator_ppb; }  // Learned offset, no P term
+  double get_phase_error_ns() const { return phase_ns; }
+  double get_phase_rms_ns() const;      // Lock quality: ~60 s RMS of the phase error
+  double get_drift_ppb_per_day() const { return drift_valid ? drift_ppb_per_s * 86400.0 : 0.0; }
+  uint32_t get_state_seconds(uint32_t now_ms) const { return (now_ms - state_since_ms) / 1000; }
+  uint32_t get_lock_count() const { return lock_count; }
+  uint32_t get_holdover_count() const { return holdover_count; }
+  bool has_feed_forward() const { return feed_forward_valid; }
+  double get_feed_forward_ppb() const { return feed_forward_total_ppb; }  // Added by the model since start
+
+private:
+  void enter(DisciplineState next, uint32_t now_ms);
+  double clamp(double ppb) const;
+  void update_drift(uint32_t now_ms);
+
+  DisciplineConfig cfg;
+  uint32_t nominal;
+  double tick_ns;
+
+  DisciplineState state;
+  uint32_t state_since_ms;
+  uint32_t last_period_ms;
+  bool phase_valid;
+  int64_t phase_ticks;      // Exact phase error since the last re-zero
+  double phase_ns;
+  double phase_ms2;         // EMA of phase error squared, ns^2
+  double integrator_ppb;
+  double control_ppb;
+
+  bool frequency_valid;     // integrator_ppb holds a measured frequency
+  uint16_t fll_periods;
+  uint16_t in_lock_periods;
+
+  // Drift learned in TRACK, used to extrapolate in HOLDOVER
+  uint32_t drift_sample_ms;
+  double drift_sample_ppb;
+  double drift_ppb_per_s;
+  bool drift_valid;
+  uint8_t drift_samples;
+  double holdover_base_ppb;
+  uint32_t last_holdover_update_ms;
+  DisciplineState holdover_from;  // Resumed after a short outage if it was TRACK
+
+  bool feed_forward_valid;
+  double feed_forward_ppb;        // Last model prediction
+  double feed_forward_total_ppb;
+
+  uint32_t lock_count;
+  uint32_t holdover_count;
+};
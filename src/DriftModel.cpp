@@ -0,0 +1,175 @@
+#include "DriftModel.h"
+#include <math.h>
+#include <string.h>
+
+DriftModel::DriftModel() {
+  reset();
+}
+
+void DriftModel::reset() {
+  head = 0;
+  count = 0;
+  memset(&fit, 0, sizeof(fit));
+  fit_valid = false;
+  fit_restored = false;
+  memset(&prediction, 0, sizeof(prediction));
+  error_squares = 0.0;
+}
+
+void DriftModel::restore(const DriftFit& saved) {
+  if (saved.points < MIN_POINTS || isnan(saved.reference_ppb) || isnan(saved.aging_ppb_per_day)) {
+    return;
+  }
+  fit = saved;
+  fit_valid = true;
+  fit_restored = true;
+}
+
+bool DriftModel::predict(uint32_t unix_time, float temperature_c, double& ppb, double& sigma_ppb) const {
+  if (!fit_valid) {
+    return false;
+  }
+  double days = ((double)unix_time - (double)fit.reference_time) / 86400.0;
+  double aging_error = fit.aging_sigma_ppb_per_day * days;
+  ppb = fit.reference_ppb + fit.aging_ppb_per_day * days;
+  double variance = (double)fit.reference_sigma_ppb * fit.reference_sigma_ppb + aging_error * aging_error +
+                    (double)fit.residual_ppb * fit.residual_ppb;
+  if (fit.temperature_ppb_per_c != 0.0f && !isnan(temperature_c)) {
+    double delta = temperature_c - fit.reference_temp_c;
+    double temperature_error = fit.temperature_sigma_ppb_per_c * delta;
+    ppb += fit.temperature_ppb_per_c * delta;
+    variance += temperature_error * temperature_error;
+  }
+  sigma_ppb = sqrt(variance);
+  return true;
+}
+
+void DriftModel::add_point(uint32_t unix_time, double control_ppb, float temperature_c) {
+  double predicted;
+  double sigma;
+  if (predict(unix_time, temperature_c, predicted, sigma)) {
+    double error = control_ppb - predicted;
+    prediction.count++;
+    prediction.last_error_ppb = error;
+    error_squares += error * error;
+    prediction.rms_error_ppb = sqrt(error_squares / prediction.count);
+    if (fabs(error) > prediction.max_error_ppb) {
+      prediction.max_error_ppb = fabs(error);
+    }
+  }
+
+  points[(head + count) % CAPACITY] = {unix_time, (float)control_ppb, temperature_c};
+  if (count < CAPACITY) {
+    count++;
+  } else {
+    head = (uint16_t)((head + 1) % CAPACITY);
+  }
+  refit();
+}
+
+void DriftModel::refit() {
+  if (count < MIN_POINTS) {
+    return;
+  }
+  // Centre on the mean time and temperature; times relative to the oldest point
+  const Point& first = points[head];
+  uint32_t oldest = first.time;
+  uint32_t newest = first.time;
+  double sum_t = 0.0;
+  double sum_y = 0.0;
+  double sum_temp = 0.0;
+  float temp_min = first.temperature;
+  float temp_max = first.temperature;
+  bool have_temperature = true;
+  for (uint16_t i = 0; i < count; i++) {
+    const Point& p = points[(head + i) % CAPACITY];
+    if (p.time < oldest) oldest = p.time;
+    if (p.time > newest) newest = p.time;
+    sum_t += (double)(int32_t)(p.time - first.time);
+    sum_y += p.ppb;
+    if (isnan(p.temperature)) {
+      have_temperature = false;
+    } else {
+      sum_temp += p.temperature;
+      if (p.temperature < temp_min) temp_min = p.temperature;
+      if (p.temperature > temp_max) temp_max = p.temperature;
+    }
+  }
+  if (newest - oldest < MIN_SPAN_S) {
+    return;
+  }
+  double mean_t = sum_t / count;
+  double mean_y = sum_y / count;
+  double mean_temp = have_temperature ? sum_temp / count : 0.0;
+
+  double sxx = 0.0, sxz = 0.0, szz = 0.0, sxy = 0.0, szy = 0.0;
+  for (uint16_t i = 0; i < count; i++) {
+    const Point& p = points[(head + i) % CAPACITY];
+    double x = ((double)(int32_t)(p.time - first.time) - mean_t) / 86400.0;
+    double z = have_temperature ? p.temperature - mean_temp : 0.0;
+    double y = p.ppb - mean_y;
+    sxx += x * x;
+    sxz += x * z;
+    szz += z * z;
+    sxy += x * y;
+    szy += z * y;
+  }
+  if (sxx <= 0.0) {
+    return;
+  }
+
+  // Aging and temperature together when the temperature moved enough to tell
+  // them apart, then the aging line alone if the coefficient is not significant
+  double aging = sxy / sxx;
+  double tempco = 0.0;
+  double aging_variance_factor = 1.0 / sxx;
+  double tempco_variance_factor = 0.0;
+  uint8_t parameters = 2;
+  if (have_temperature && temp_max - temp_min >= MIN_TEMPERATURE_SPAN && count > MIN_POINTS) {
+    double det = sxx * szz - sxz * sxz;
+    if (det > 1e-12 * sxx * szz) {
+      double b = (sxy * szz - szy * sxz) / det;
+      double c = (szy * sxx - sxy * sxz) / det;
+      double ssr = 0.0;
+      for (uint16_t i = 0; i < count; i++) {
+        const Point& p = points[(head + i) % CAPACITY];
+        double x = ((double)(int32_t)(p.time - first.time) - mean_t) / 86400.0;
+        double r = (p.ppb - mean_y) - b * x - c * (p.temperature - mean_temp);
+        ssr += r * r;
+      }
+      double variance = ssr / (count - 3);
+      double c_sigma = sqrt(variance * sxx / det);
+      if (fabs(c) > 3.0 * c_sigma) {
+        aging = b;
+        tempco = c;
+        aging_variance_factor = szz / det;
+        tempco_variance_factor = sxx / det;
+        parameters = 3;
+      }
+    }
+  }
+
+  double ssr = 0.0;
+  for (uint16_t i = 0; i < count; i++) {
+    const Point& p = points[(head + i) % CAPACITY];
+    double x = ((double)(int32_t)(p.time - first.time) - mean_t) / 86400.0;
+    double z = parameters == 3 ? p.temperature - mean_temp : 0.0;
+    double r = (p.ppb - mean_y) - aging * x - tempco * z;
+    ssr += r * r;
+  }
+  double variance = ssr / (count - parameters);
+
+  fit.reference_time = first.time + (uint32_t)(mean_t + 0.5);
+  fit.reference_ppb = (float)mean_y;
+  fit.reference_sigma_ppb = (float)sqrt(variance / count);
+  fit.aging_ppb_per_day = (float)aging;
+  fit.aging_sigma_ppb_per_day = (float)sqrt(variance * aging_variance_factor);
+  fit.temperature_ppb_per_c = (float)tempco;
+  fit.temperature_sigma_ppb_per_c = (float)sqrt(variance * tempco_variance_factor);
+  fit.reference_temp_c = (float)mean_temp;
+  fit.residual_ppb = (float)sqrt(variance);
+  fit.points = count;
+  fit.span_hours = (uint16_t)((newest - oldest) / 3600);
+  fit_valid = true;
+  fit_restored = false;
+}
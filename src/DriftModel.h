@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+
+// Aging and temperature model of the oscillator, from the control values the
+// disciplining loop settles on.
+//
+// Once an hour in TRACK the caller adds the learned control (ppb, GPS time,
+// temperature). An ordinary least-squares fit over up to CAPACITY points
+//
+//   control = reference + aging * (t - t_ref) + tempco * (T - T_ref)
+//
+// centred on the mean time and temperature (so the reference and the slopes
+// are uncorrelated and each has its own standard error) gives the aging rate
+// with its uncertainty. The temperature term is only kept when the points
+// span at least MIN_TEMPERATURE_SPAN and the coefficient is significant
+// (three standard errors); otherwise the plain aging line is used. Each new
+// point is first compared with the prediction of the fit made without it,
+// which is the error the feed-forward would have left.
+//
+// The fit is summarised in a DriftFit that the caller can save and restore,
+// so predictions continue across a reboot (before enough new points exist).
+// Prediction sigma: reference, slope and residual terms in quadrature.
+
+struct DriftFit {
+  uint32_t reference_time;            // Unix seconds, mean time of the fitted points
+  float reference_ppb;                // Control at reference_time and reference_temp_c
+  float reference_sigma_ppb;
+  float aging_ppb_per_day;
+  float aging_sigma_ppb_per_day;
+  float temperature_ppb_per_c;        // 0 when temperature is not in the fit
+  float temperature_sigma_ppb_per_c;
+  float reference_temp_c;
+  float residual_ppb;                 // RMS of what the fit does not explain
+  uint16_t points;
+  uint16_t span_hours;
+} __attribute__((packed));
+
+struct DriftPredictionStats {
+  uint32_t count;             // Points that had a prediction before they were added
+  double last_error_ppb;      // Actual - predicted
+  double rms_error_ppb;
+  double max_error_ppb;       // Largest |actual - predicted|
+};
+
+class DriftModel {
+public:
+  static const uint16_t CAPACITY = 168;               // One week of hourly points
+  static const uint16_t MIN_POINTS = 6;
+  static const uint32_t MIN_SPAN_S = 4 * 3600;
+  static constexpr float MIN_TEMPERATURE_SPAN = 1.0f;  // Degrees C, max - min
+
+  DriftModel();
+
+  void reset();                                    // Points, fit and statistics
+  void restore(const DriftFit& saved);             // Used until the points give their own fit
+  void add_point(uint32_t unix_time, double control_ppb, float temperature_c);  // NAN: no sensor
+
+  bool has_fit() const { return fit_valid; }
+  const DriftFit& get_fit() const { return fit; }
+  bool is_restored() const { return fit_valid && fit_restored; }
+  bool predict(uint32_t unix_time, float temperature_c, double& ppb, double& sigma_ppb) const;
+
+  uint16_t get_point_count() const { return count; }
+  const DriftPredictionStats& get_prediction_stats() const { return prediction; }
+
+private:
+  struct Point {
+    uint32_t time;
+    float ppb;
+    float temperature;
+  };
+
+  void refit();
+
+  Point points[CAPACITY];
+  uint16_t head;
+  uint16_t count;
+  DriftFit fit;
+  bool fit_valid;
+  bool fit_restored;
+  DriftPredictionStats prediction;
+  double error_squares;
+};
@@ -0,0 +1,168 @@
+#include "EdgeAnalyzer.h"
+#include <math.h>
+#include <string.h>
+
+static const uint8_t MAX_CONSECUTIVE_SPURIOUS = 3;
+
+EdgeAnalyzer::EdgeAnalyzer(uint32_t nominal_ticks) : nominal(nominal_ticks) {
+  reset();
+}
+
+void EdgeAnalyzer::reset_stream(Stream& stream) {
+  memset(&stream, 0, sizeof(stream));
+  stream.stats.min_ticks = 0xFFFFFFFF;
+}
+
+void EdgeAnalyzer::reset() {
+  reset_stream(rising);
+  reset_stream(falling);
+  have_last = false;
+  last_rising = false;
+  seen_rising = false;
+  seen_falling = false;
+  last_rise = 0;
+  have_rise = false;
+  out_of_turn = 0;
+  memset(&pulse, 0, sizeof(pulse));
+  pulse.min_ticks = 0xFFFFFFFF;
+  pulse_m2 = 0.0;
+}
+
+void EdgeAnalyzer::add_edge(uint64_t timestamp, bool is_rising) {
+  if (is_rising) {
+    seen_rising = true;
+  } else {
+    seen_falling = true;
+  }
+  // Only meaningful once both polarities are being captured
+  if (have_last && last_rising == is_rising && seen_rising && seen_falling) {
+    out_of_turn++;
+  }
+
+  if (is_rising) {
+    last_rise = timestamp;
+    have_rise = true;
+  } else if (have_rise) {
+    uint64_t width = timestamp - last_rise;
+    have_rise = false;
+    if (width < nominal) {
+      uint32_t ticks = (uint32_t)width;
+      pulse.count++;
+      pulse.last_ticks = ticks;
+      if (ticks < pulse.min_ticks) pulse.min_ticks = ticks;
+      if (ticks > pulse.max_ticks) pulse.max_ticks = ticks;
+      double delta = ticks - pulse.mean_ticks;
+      pulse.mean_ticks += delta / pulse.count;
+      pulse_m2 += delta * (ticks - pulse.mean_ticks);
+      pulse.rms_ticks = pulse.count > 1 ? sqrt(pulse_m2 / (pulse.count - 1)) : 0.0;
+    }
+  }
+  have_last = true;
+  last_rising = is_rising;
+
+  add_to_stream(is_rising ? rising : falling, timestamp);
+}
+
+void EdgeAnalyzer::add_period(Stream& stream, uint32_t ticks) {
+  EdgeStreamStats& stats = stream.stats;
+  stats.periods++;
+  if (ticks < stats.min_ticks) stats.min_ticks = ticks;
+  if (ticks > stats.max_ticks) stats.max_ticks = ticks;
+  double delta = ticks - stats.mean_ticks;
+  stats.mean_ticks += delta / stats.periods;
+  stream.m2 += delta * (ticks - stats.mean_ticks);
+  stats.jitter_rms_ticks = stats.periods > 1 ? sqrt(stream.m2 / (stats.periods - 1)) : 0.0;
+
+  int32_t deviation = (int32_t)((int64_t)ticks - (int64_t)llround(stats.mean_ticks));
+  if (deviation < -JITTER_HALF_RANGE) deviation = -JITTER_HALF_RANGE;
+  if (deviation > JITTER_HALF_RANGE) deviation = JITTER_HALF_RANGE;
+  stream.histogram[deviation + JITTER_HALF_RANGE]++;
+}
+
+static void push_tie(int32_t* ring, uint8_t& head, uint8_t& count, uint8_t size, int64_t tie) {
+  int32_t value = tie > INT32_MAX ? INT32_MAX : tie < INT32_MIN ? INT32_MIN : (int32_t)tie;
+  ring[head] = value;
+  head = (uint8_t)((head + 1) % size);
+  if (count < size) count++;
+}
+
+void EdgeAnalyzer::add_to_stream(Stream& stream, uint64_t timestamp) {
+  EdgeStreamStats& stats = stream.stats;
+  stats.edges++;
+  if (stream.started) {
+    uint64_t interval = timestamp - stream.last_edge;
+    uint64_t seconds = (interval + nominal / 2) / nominal;
+    int64_t offset = (int64_t)interval - (int64_t)(seconds * nominal);
+    if (seconds == 0 || offset > (int64_t)(nominal / 100) || offset < -(int64_t)(nominal / 100)) {
+      stats.spurious++;
+      if (++stream.rejects < MAX_CONSECUTIVE_SPURIOUS) {
+        return;
+      }
+      stats.tie_restarts++;  // The grid itself may have started on a spurious edge
+      stream.started = false;
+    } else if (seconds > MAX_GAP_SECONDS) {
+      stats.tie_restarts++;  // Too long to bridge: start a new grid
+      stream.started = false;
+    } else {
+      stream.rejects = 0;
+      if (seconds == 1) {
+        add_period(stream, (uint32_t)interval);
+      } else {
+        stats.missed += (uint32_t)(seconds - 1);
+      }
+      stream.seconds += seconds;
+      stream.last_edge = timestamp;
+      stats.tie_ticks = (int64_t)(timestamp - stream.origin) - (int64_t)(stream.seconds * nominal);
+      push_tie(stream.tie, stream.tie_head, stream.tie_count, TIE_HISTORY, stats.tie_ticks);
+      return;
+    }
+  }
+
+  stream.started = true;
+  stream.rejects = 0;
+  stream.origin = timestamp;
+  stream.last_edge = timestamp;
+  stream.seconds = 0;
+  stream.tie_head = 0;
+  stream.tie_count = 0;  // A new grid: earlier TIE values are not comparable
+  stats.tie_ticks = 0;
+  push_tie(stream.tie, stream.tie_head, stream.tie_count, TIE_HISTORY, 0);
+}
+
+const EdgeStreamStats& EdgeAnalyzer::get_stream(bool rising_edges) const {
+  return rising_edges ? rising.stats : falling.stats;
+}
+
+const uint32_t* EdgeAnalyzer::get_histogram(bool rising_edges) const {
+  return rising_edges ? rising.histogram : falling.histogram;
+}
+
+uint8_t EdgeAnalyzer::get_tie_history(bool rising_edges, int32_t* out, uint8_t max) const {
+  const Stream& stream = rising_edges ? rising : falling;
+  uint8_t n = stream.tie_count < max ? stream.tie_count : max;
+  // The newest n, oldest first
+  uint8_t start = (uint8_t)((stream.tie_head + TIE_HISTORY - n) % TIE_HISTORY);
+  for (uint8_t i = 0; i < n; i++) {
+    out[i] = stream.tie[(start + i) % TIE_HISTORY];
+  }
+  return n;
+}
+
+int64_t EdgeAnalyzer::get_tie_peak_to_peak(bool rising_edges) const {
+  const Stream& stream = rising_edges ? rising : falling;
+  if (stream.tie_count == 0) {
+    return 0;
+  }
+  int32_t lo = stream.tie[0];
+  int32_t hi = stream.tie[0];
+  for (uint8_t i = 1; i < stream.tie_count; i++) {
+    if (stream.tie[i] < lo) lo = stream.tie[i];
+    if (stream.tie[i] > hi) hi = stream.tie[i];
+  }
+  return (int64_t)hi - lo;
+}
+
+bool EdgeAnalyzer::get_pulse_width(PulseWidthStats& stats) const {
+  stats = pulse;
+  return pulse.count > 0;
+}
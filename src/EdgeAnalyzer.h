@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+
+// Edge-quality analysis of the PPS input: a cable or receiver check without a scope.
+//
+// Rising and falling captures are kept as separate streams. For each one the
+// interval between consecutive edges gives a period, collected into running
+// statistics and a jitter histogram in whole-tick bins around the mean
+// period. Each edge is also placed on the nominal one-second grid (missed
+// edges are bridged by rounding to whole seconds, as in GateCounter), and its
+// accumulated time interval error TIE = elapsed - seconds * nominal is kept
+// as a short series. TIE is measured against the local oscillator, so a
+// constant frequency offset shows as a steady slope; receiver problems show
+// as steps and wander on top of it. With both edges captured, the high time
+// of each pulse and edges arriving out of turn are recorded too.
+
+struct EdgeStreamStats {
+  uint32_t edges;
+  uint32_t periods;         // Intervals of one second (within 1%)
+  uint32_t missed;          // Edges missing from intervals of several seconds
+  uint32_t spurious;        // Edges off the one-second grid, ignored
+  uint32_t tie_restarts;    // Grid restarted after a gap of more than MAX_GAP_SECONDS
+  double mean_ticks;        // Mean period
+  double jitter_rms_ticks;  // Standard deviation of the period
+  uint32_t min_ticks;
+  uint32_t max_ticks;
+  int64_t tie_ticks;        // Latest accumulated TIE
+};
+
+struct PulseWidthStats {
+  uint32_t count;
+  uint32_t last_ticks;      // High time, rising to falling edge
+  uint32_t min_ticks;
+  uint32_t max_ticks;
+  double mean_ticks;
+  double rms_ticks;         // Standard deviation
+};
+
+class EdgeAnalyzer {
+public:
+  static const uint8_t JITTER_BINS = 33;         // period - round(mean) = -16 .. +16; the ends take the rest
+  static const int32_t JITTER_HALF_RANGE = 16;
+  static const uint8_t TIE_HISTORY = 64;         // Edges of TIE series kept per stream
+  static const uint32_t MAX_GAP_SECONDS = 60;
+
+  explicit EdgeAnalyzer(uint32_t nominal_ticks);
+
+  void reset();  // Timebase or edge selection changed
+  void add_edge(uint64_t timestamp, bool rising);
+
+  bool has_data() const { return rising.stats.periods > 0 || falling.stats.periods > 0; }
+  const EdgeStreamStats& get_stream(bool rising_edges) const;
+  const uint32_t* get_histogram(bool rising_edges) const;
+  // Copies up to `max` TIE values (ticks, oldest first); returns the count
+  uint8_t get_tie_history(bool rising_edges, int32_t* out, uint8_t max) const;
+  int64_t get_tie_peak_to_peak(bool rising_edges) const;  // Over the kept series (since any restart)
+  bool get_pulse_width(PulseWidthStats& stats) const;
+  uint32_t get_out_of_turn() const { return out_of_turn; }  // Same polarity twice in a row
+  uint32_t get_nominal() const { return nominal; }
+
+private:
+  struct Stream {
+    EdgeStreamStats stats;
+    uint32_t histogram[JITTER_BINS];
+    int32_t tie[TIE_HISTORY];
+    uint8_t tie_head;
+    uint8_t tie_count;
+    bool started;
+    uint8_t rejects;        // Consecutive spurious edges
+    uint64_t origin;        // Grid origin for TIE
+    uint64_t last_edge;
+    uint64_t seconds;       // Grid position of last_edge
+    double m2;              // Welford sum of squares of the period
+  };
+
+  void reset_stream(Stream& stream);
+  void add_to_stream(Stream& stream, uint64_t timestamp);
+  void add_period(Stream& stream, uint32_t ticks);
+
+  uint32_t nominal;
+  Stream rising;
+  Stream falling;
+
+  bool have_last;
+  bool last_rising;
+  bool seen_rising;
+  bool seen_falling;
+  uint64_t last_rise;
+  bool have_rise;
+  uint32_t out_of_turn;
+  PulseWidthStats pulse;
+  double pulse_m2;
+};
@@ -0,0 +1,131 @@
+#include "FrequencyStats.h"
+#include <math.h>
+
+const uint32_t FrequencyStats::WINDOW_LENGTHS[WINDOWS] = {10, 100, 1000, 10000};
+
+FrequencyStats::FrequencyStats(uint32_t nominal_ticks) : nominal(nominal_ticks) {
+  reset();
+}
+
+void FrequencyStats::reset() {
+  count = 0;
+  total_sum = 0;
+  total_squares = 0;
+  head = 0;
+  uint16_t offset = 0;
+  for (uint8_t k = 0; k < WINDOWS; k++) {
+    Window& window = windows[k];
+    window.length = WINDOW_LENGTHS[k];
+    window.samples = 0;
+    window.sum = 0;
+    window.sum_squares = 0;
+    window.minimum = {offset, 0, 0};
+    window.maximum = {(uint16_t)(offset + QUEUE_SLOTS), 0, 0};
+    offset += window.length;
+  }
+}
+
+uint16_t FrequencyStats::queue_back(const Window& window, const Queue& queue) const {
+  return queue_slots[queue.offset + (queue.head + queue.size - 1) % window.length];
+}
+
+void FrequencyStats::queue_push(const Window& window, Queue& queue, uint16_t position) {
+  queue_slots[queue.offset + (queue.head + queue.size) % window.length] = position;
+  queue.size++;
+}
+
+void FrequencyStats::update_window(Window& window, uint16_t position, int32_t deviation) {
+  if (window.samples == window.length) {
+    // The period `length` positions back leaves (for the longest window that
+    // is the slot about to be overwritten, still holding the old value)
+    uint16_t leaving = (uint16_t)((position + HISTORY - window.length) % HISTORY);
+    int32_t old = history[leaving];
+    window.sum -= old;
+    window.sum_squares -= (int64_t)old * old;
+    if (queue_slots[window.minimum.offset + window.minimum.head] == leaving) {
+      window.minimum.head = (uint16_t)((window.minimum.head + 1) % window.length);
+      window.minimum.size--;
+    }
+    if (queue_slots[window.maximum.offset + window.maximum.head] == leaving) {
+      window.maximum.head = (uint16_t)((window.maximum.head + 1) % window.length);
+      window.maximum.size--;
+    }
+  } else {
+    window.samples++;
+  }
+  window.sum += deviation;
+  window.sum_squares += (int64_t)deviation * deviation;
+
+  while (window.minimum.size > 0 && history[queue_back(window, window.minimum)] >= deviation) {
+    window.minimum.size--;
+  }
+  queue_push(window, window.minimum, position);
+  while (window.maximum.size > 0 && history[queue_back(window, window.maximum)] <= deviation) {
+    window.maximum.size--;
+  }
+  queue_push(window, window.maximum, position);
+}
+
+bool FrequencyStats::add_sample(uint32_t ticks) {
+  int64_t offset = (int64_t)ticks - nominal;
+  if (offset > (int64_t)(nominal / 100) || offset < -(int64_t)(nominal / 100)) {
+    return false;
+  }
+  int32_t deviation = (int32_t)offset;
+  count++;
+  total_sum += deviation;
+  total_squares += (int64_t)deviation * deviation;
+
+  // Queue entries never point at `head` (it is older than any window but the
+  // longest, which has just dropped it), so it is written after the updates
+  for (uint8_t k = 0; k < WINDOWS; k++) {
+    update_window(windows[k], head, deviation);
+  }
+  history[head] = deviation;
+  head = (uint16_t)((head + 1) % HISTORY);
+  return true;
+}
+
+double FrequencyStats::get_mean() const {
+  return count ? nominal + (double)total_sum / count : 0.0;
+}
+
+double FrequencyStats::get_std_dev() const {
+  if (count < 2) {
+    return 0.0;
+  }
+  double mean = (double)total_sum / count;
+  double variance = ((double)total_squares - mean * (double)total_sum) / (count - 1);
+  return variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+double FrequencyStats::get_ppm_error(double reference_hz) const {
+  if (!has_samples()) return 0.0;
+  // Deviation kept apart from nominal so no precision is lost to the large offset
+  return ((nominal - reference_hz) + (double)total_sum / count) / reference_hz * 1e6;
+}
+
+bool FrequencyStats::get_window(uint8_t index, FrequencyWindowStats& stats) const {
+  if (index >= WINDOWS || windows[index].samples == 0) {
+    return false;
+  }
+  const Window& window = windows[index];
+  int64_t n = window.samples;
+  stats.length = window.length;
+  stats.samples = window.samples;
+  stats.mean_ticks = nominal + (double)window.sum / n;
+  // n * sum(d^2) - sum(d)^2 is exact; only the final division rounds
+  int64_t spread = n * window.sum_squares - window.sum * window.sum;
+  stats.std_ticks = n > 1 ? sqrt((double)spread / ((double)n * (n - 1))) : 0.0;
+  stats.min_ticks = nominal + history[queue_slots[window.minimum.offset + window.minimum.head]];
+  stats.max_ticks = nominal + history[queue_slots[window.maximum.offset + window.maximum.head]];
+  return true;
+}
+
+double FrequencyStats::get_window_ppm_error(uint8_t index, double reference_hz) const {
+  if (index >= WINDOWS || windows[index].samples == 0) {
+    return 0.0;
+  }
+  const Window& window = windows[index];
+  return ((nominal - reference_hz) + (double)window.sum / window.samples) / reference_hz * 1e6;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+
+// Frequency statistics of the accepted PPS periods, exact and windowed.
+//
+// Each period is stored as its integer deviation from nominal. Totals since
+// reset() are int64 sums of the deviation and its square, so the long-run
+// mean never drifts from rounding no matter how many weeks it covers. On top
+// of that, several sliding windows (the last 10, 100, 1000 and 10000
+// periods) are kept at once over one shared history ring: each keeps its own
+// exact int64 sums, updated in O(1) as a period enters and the one WINDOW
+// periods old leaves, and monotonic queues of ring positions for its minimum
+// and maximum (amortised O(1)). Windows count periods, not seconds, so a
+// dropped edge just makes a window reach a little further back.
+//
+// Periods more than 1% off nominal are refused, as elsewhere; that bound also
+// keeps n * sum(d^2) and sum(d)^2 of the largest window inside int64, so the
+// window variance is computed from exact integers too.
+
+struct FrequencyWindowStats {
+  uint32_t length;      // Window, periods
+  uint32_t samples;     // Periods in it so far (= length once full)
+  double mean_ticks;
+  double std_ticks;     // Sample standard deviation
+  uint32_t min_ticks;
+  uint32_t max_ticks;
+};
+
+class FrequencyStats {
+public:
+  static const uint8_t WINDOWS = 4;
+  static const uint32_t WINDOW_LENGTHS[WINDOWS];  // 10, 100, 1000, 10000
+  static const uint8_t AVERAGE_WINDOW = 2;        // The "avg" shown and logged: last 1000 periods
+  static const uint32_t HISTORY = 10000;          // The longest window
+
+  explicit FrequencyStats(uint32_t nominal_ticks);
+
+  void reset();
+  bool add_sample(uint32_t ticks);  // false: more than 1% off nominal, ignored
+
+  // Since reset()
+  uint32_t get_count() const { return count; }
+  bool has_samples() const { return count > 0; }
+  double get_mean() const;          // Ticks (= Hz for a one-second period)
+  double get_std_dev() const;
+  double get_ppm_error(double reference_hz) const;
+  double get_ppb_error(double reference_hz) const { return get_ppm_error(reference_hz) * 1000.0; }
+
+  // Sliding windows, 0 .. WINDOWS-1 (shortest first); false until a period arrives
+  bool get_window(uint8_t index, FrequencyWindowStats& stats) const;
+  double get_window_ppm_error(uint8_t index, double reference_hz) const;
+
+  uint32_t get_nominal() const { return nominal; }
+
+private:
+  struct Queue {          // Ring positions, oldest first, in a slice of queue_slots
+    uint16_t offset;
+    uint16_t head;
+    uint16_t size;
+  };
+
+  struct Window {
+    uint32_t length;
+    uint32_t samples;
+    int64_t sum;          // Of deviations from nominal, exact
+    int64_t sum_squares;
+    Queue minimum;        // Non-decreasing values: the front is the window minimum
+    Queue maximum;        // Non-increasing values: the front is the window maximum
+  };
+
+  static const uint32_t QUEUE_SLOTS = 10 + 100 + 1000 + 10000;  // Sum of WINDOW_LENGTHS
+
+  uint16_t queue_back(const Window& window, const Queue& queue) const;
+  void queue_push(const Window& window, Queue& queue, uint16_t position);
+  void update_window(Window& window, uint16_t position, int32_t deviation);
+
+  uint32_t nominal;
+  uint32_t count;
+  int64_t total_sum;
+  int64_t total_squares;
+  Window windows[WINDOWS];
+  uint16_t head;                 // Next history position
+  int32_t history[HISTORY];      // Deviations from nominal
+  uint16_t queue_slots[2 * QUEUE_SLOTS];
+};
@@ -0,0 +1,97 @@
+#include "GateCounter.h"
+
+GateCounter::GateCounter(uint32_t nominal_ticks)
+    : nominal(nominal_ticks), gate_seconds(1) {
+  reset();
+  rejected_edges = 0;
+  restarts = 0;
+}
+
+bool GateCounter::set_gate(uint32_t seconds) {
+  if (seconds < 1 || seconds > MAX_GATE_SECONDS) {
+    return false;
+  }
+  gate_seconds = seconds;
+  reset();
+  return true;
+}
+
+void GateCounter::reset() {
+  open = false;
+  open_timestamp = 0;
+  last_edge = 0;
+  elapsed_seconds = 0;
+  edges = 0;
+  consecutive_rejects = 0;
+  last = GateResult();
+  have_result = false;
+  completed = 0;
+}
+
+void GateCounter::open_at(uint64_t timestamp) {
+  open = true;
+  open_timestamp = timestamp;
+  last_edge = timestamp;
+  elapsed_seconds = 0;
+  edges = 0;
+  consecutive_rejects = 0;
+}
+
+bool GateCounter::add_edge(uint64_t timestamp) {
+  if (!open) {
+    open_at(timestamp);
+    return false;
+  }
+
+  uint64_t delta = timestamp - last_edge;
+  uint64_t seconds = (delta + nominal / 2) / nominal;
+  int64_t off_grid = (int64_t)(delta - seconds * nominal);
+  if (off_grid < 0) off_grid = -off_grid;
+  if (seconds == 0 || (uint64_t)off_grid > nominal / 100) {
+    rejected_edges++;  // Glitch or a second edge in the same second
+    if (++consecutive_rejects >= MAX_CONSECUTIVE_REJECTS) {
+      restarts++;  // The opening edge itself was probably the glitch
+      open_at(timestamp);
+    }
+    return false;
+  }
+  consecutive_rejects = 0;
+  if (seconds > MAX_GAP_SECONDS) {
+    restarts++;
+    open_at(timestamp);
+    return false;
+  }
+
+  last_edge = timestamp;
+  elapsed_seconds += (uint32_t)seconds;
+  edges++;
+  if (elapsed_seconds < gate_seconds) {
+    return false;
+  }
+
+  last.seconds = elapsed_seconds;
+  last.edges = edges;
+  last.ticks = timestamp - open_timestamp;
+  last.error_ticks = (int64_t)last.ticks - (int64_t)elapsed_seconds * (int64_t)nominal;
+  last.index = ++completed;
+  have_result = true;
+  open_at(timestamp);
+  return true;
+}
+
+bool GateCounter::get_result(GateResult& result) const {
+  if (!have_result) {
+    return false;
+  }
+  result = last;
+  return true;
+}
+
+double GateCounter::result_ppb(const GateResult& result, uint32_t nominal_ticks) {
+  // One division of two exact integers
+  return (double)result.error_ticks * 1e9 / ((double)result.seconds * (double)nominal_ticks);
+}
+
+double GateCounter::get_result_ppb() const {
+  return have_result ? result_ppb(last, nominal) : 0.0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+
+// Long-gate frequency measurement on the 64-bit extended GPT2 timebase.
+//
+// A gate opens on a PPS edge and closes on the first edge at least
+// `gate_seconds` later; the tick count between the two edges is exact, so a
+// 1000 s gate resolves 0.1 ppb with no averaging or rounding. Gates run back
+// to back (the closing edge opens the next one).
+//
+// Each edge is placed on the PPS grid by rounding its distance from the
+// previous edge to whole seconds, so missed edges inside a gate only reduce
+// `edges`, never the accuracy. An edge more than 1% off the grid is treated
+// as spurious and ignored (three in a row re-open the gate, in case the
+// opening edge was the spurious one). A gap longer than MAX_GAP_SECONDS
+// restarts the gate, since the grid can no longer be trusted across it.
+
+struct GateResult {
+  uint32_t seconds;      // Gate length on the PPS grid
+  uint32_t edges;        // Edges seen after the opening one (< seconds if some were missed)
+  uint64_t ticks;        // Exact count between the opening and closing edge
+  int64_t error_ticks;   // ticks - seconds * nominal
+  uint32_t index;        // Gates completed since the last restart, from 1
+};
+
+class GateCounter {
+public:
+  static const uint32_t MAX_GATE_SECONDS = 100000;
+  static const uint32_t MAX_GAP_SECONDS = 60;
+  static const uint8_t MAX_CONSECUTIVE_REJECTS = 3;
+
+  explicit GateCounter(uint32_t nominal_ticks);
+
+  // 1 .. MAX_GATE_SECONDS; restarts at the next edge
+  bool set_gate(uint32_t seconds);
+  uint32_t get_gate() const { return gate_seconds; }
+  void reset();  // Timebase restarted: forget the open gate and the last result
+
+  // Returns true when this edge closed a gate (the result is then available)
+  bool add_edge(uint64_t timestamp);
+
+  bool get_result(GateResult& result) const;
+  static double result_ppb(const GateResult& result, uint32_t nominal_ticks);
+  double get_result_ppb() const;
+  bool is_open() const { return open; }
+  uint32_t get_elapsed_seconds() const { return elapsed_seconds; }
+  uint32_t get_rejected_edges() const { return rejected_edges; }
+  uint32_t get_restarts() const { return restarts; }
+
+private:
+  void open_at(uint64_t timestamp);
+
+  uint32_t nominal;
+  uint32_t gate_seconds;
+
+  bool open;
+  uint64_t open_timestamp;
+  uint64_t last_edge;
+  uint32_t elapsed_seconds;
+  uint32_t edges;
+  uint8_t consecutive_rejects;
+
+  GateResult last;
+  bool have_result;
+  uint32_t completed;
+  uint32_t rejected_edges;
+  uint32_t restarts;
+};
@@ -0,0 +1,94 @@
+#include "GpsLink.h"
+
+static const size_t CORE_RX_BUFFER = 64;  // Serial1's own buffer in the Teensy 4 core
+
+DMAMEM static uint8_t s_rx_memory[GPS_LINK_RX_BUFFER];
+static GpsLinkStats s_stats = {};
+static bool s_passthrough = true;
+
+#if defined(__IMXRT1062__)
+// LPUART STAT flags that clear on writing 1; the rest of STAT is configuration
+static const uint32_t LPUART_STAT_W1C = LPUART_STAT_LBKDIF | LPUART_STAT_RXEDGIF | LPUART_STAT_IDLE |
+                                        LPUART_STAT_OR | LPUART_STAT_NF | LPUART_STAT_FE |
+                                        LPUART_STAT_PF | LPUART_STAT_MA1F | LPUART_STAT_MA2F;
+#endif
+
+void gps_link_begin(uint32_t baud) {
+  Serial1.addMemoryForRead(s_rx_memory, sizeof(s_rx_memory));
+  Serial1.begin(baud);
+  s_stats.baud = baud;
+}
+
+static void check_rx_losses(size_t waiting) {
+#if defined(__IMXRT1062__)
+  // Serial1 is LPUART6; a set OR flag means the FIFO overflowed before the ISR ran
+  uint32_t stat = LPUART6_STAT;
+  if (stat & LPUART_STAT_OR) {
+    s_stats.rx_overruns++;
+    LPUART6_STAT = (stat & ~LPUART_STAT_W1C) | LPUART_STAT_OR;
+  }
+#endif
+  if (waiting >= CORE_RX_BUFFER + GPS_LINK_RX_BUFFER - 1) {
+    s_stats.rx_buffer_full++;  // Further bytes were dropped by the core
+  }
+  if (waiting > s_stats.rx_max_backlog) {
+    s_stats.rx_max_backlog = waiting;
+  }
+}
+
+size_t gps_link_read(uint8_t* block, size_t capacity) {
+  int available = Serial1.available();
+  if (available <= 0) {
+    return 0;
+  }
+  check_rx_losses((size_t)available);
+
+  size_t count = (size_t)available < capacity ? (size_t)available : capacity;
+  count = Serial1.readBytes((char*)block, count);  // All already buffered: no timeout
+  s_stats.rx_bytes += count;
+  s_stats.rx_blocks++;
+
+  if (!s_passthrough) {
+    return count;
+  }
+  // One USB write per block, never more than fits without waiting
+  size_t room = SerialUSB1 ? (size_t)SerialUSB1.availableForWrite() : 0;
+  size_t forward = count < room ? count : room;
+  if (forward > 0) {
+    SerialUSB1.write(block, forward);
+    s_stats.forwarded_bytes += forward;
+  }
+  s_stats.forward_dropped += count - forward;
+  return count;
+}
+
+size_t gps_link_write(const uint8_t* data, size_t length) {
+  int room = Serial1.availableForWrite();
+  size_t count = room > 0 ? ((size_t)room < length ? (size_t)room : length) : 0;
+  if (count > 0) {
+    Serial1.write(data, count);
+  }
+  return count;
+}
+
+void gps_link_forward_host() {
+  uint8_t block[GPS_LINK_BLOCK];
+  int available = SerialUSB1.available();
+  int room = Serial1.availableForWrite();
+  size_t count = (size_t)(available < room ? available : room);
+  if (count == 0) {
+    return;
+  }
+  if (count > sizeof(block)) count = sizeof(block);
+  count = SerialUSB1.readBytes((char*)block, count);
+  Serial1.write(block, count);
+  s_stats.host_bytes += count;
+}
+
+void gps_link_set_passthrough(bool enable) {
+  s_passthrough = enable;
+}
+
+void gps_link_get_stats(GpsLinkStats& stats) {
+  stats = s_stats;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+
+// GPS receiver link on Serial1, with passthrough to the host on SerialUSB1.
+//
+// Bytes move in blocks: everything waiting in the UART is read at once,
+// forwarded to the host in a single USB write and handed back for NMEA
+// parsing, and host-to-receiver traffic goes the same way. The UART receive
+// buffer is enlarged to GPS_LINK_RX_BUFFER bytes (filled by the core's
+// interrupt handler), enough for ~90 ms at 115200 baud.
+//
+// Nothing here blocks: passthrough bytes the host is not reading (or that
+// do not fit the USB buffer) are dropped and counted, and the hardware
+// overrun flag and a full receive buffer are counted as receive losses.
+
+static const size_t GPS_LINK_RX_BUFFER = 1024;  // Added to the core's 64-byte buffer
+static const size_t GPS_LINK_BLOCK = 256;
+
+struct GpsLinkStats {
+  uint32_t baud;
+  uint32_t rx_bytes;           // From the receiver
+  uint32_t rx_blocks;
+  uint32_t rx_overruns;        // UART overrun flag: bytes lost in hardware
+  uint32_t rx_buffer_full;     // Services that found the receive buffer full
+  uint32_t rx_max_backlog;     // Most bytes waiting at one service
+  uint32_t forwarded_bytes;    // Receiver -> host
+  uint32_t forward_dropped;    // Host not reading, or USB buffer full
+  uint32_t host_bytes;         // Host -> receiver
+};
+
+void gps_link_begin(uint32_t baud);
+
+// Reads up to `capacity` bytes from the receiver and forwards them to the
+// host. Returns the bytes to parse (0 when nothing was waiting).
+size_t gps_link_read(uint8_t* block, size_t capacity);
+
+// Firmware -> receiver (configuration messages), as much as the UART transmit
+// buffer takes without blocking; returns the bytes written
+size_t gps_link_write(const uint8_t* data, size_t length);
+
+// Host -> receiver, as much as the UART transmit buffer takes without blocking
+void gps_link_forward_host();
+
+// Receiver -> host passthrough on SerialUSB1 (on by default; off while the port carries telemetry)
+void gps_link_set_passthrough(bool enable);
+
+void gps_link_get_stats(GpsLinkStats& stats);
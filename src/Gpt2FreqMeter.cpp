@@ -1,20 +1,56 @@
 #include <Arduino.h>
 #include "imxrt.h"
 #include "Gpt2FreqMeter.h"
+#include "SpscRing.h"
+#include "pins.h"
 
 // Input capture variables (for GPS PPS when available)
 static volatile uint32_t last_cap = 0, prev_cap = 0;
 static volatile bool capture_available = false;
 
+// Capture queue between the service routine (producer) and loop() (consumer)
+static SpscRing<Gpt2CaptureEvent, 64> capture_ring;
+static volatile uint32_t capture_sequence = 0;
+static uint32_t expected_sequence = 0;  // Consumer side only
+static volatile Gpt2EventCounters event_counters = {};
+static volatile GptCaptureEdge current_capture_edge = GPT_EDGE_RISING;
+static volatile GptCaptureEdge current_capture2_edge = GPT_EDGE_DISABLED;
+static volatile bool irq_mode = false;
+
+// Upper 32 bits of the extended timebase, advanced on every ROV
+static volatile uint32_t rollover_epoch = 0;
+
 // System state
 static volatile bool gpt2_running = false;
-static uint32_t compare_target_ticks = 10000000;
-static bool compare_high = true;
-static bool gpt2_output_high = false;
-static uint8_t duty_cycle_percent = 20;  // Default 20% duty cycle
+static volatile uint32_t compare_target_ticks = 10000000;
+static volatile bool compare_high = true;  // Level the scheduled compare will drive
+static volatile bool gpt2_output_high = false;
+static volatile uint8_t duty_cycle_percent = 20;  // Default 20% duty cycle
+
+// Output synthesizer: rising edges on the exact grid k * (q + r/den) ticks,
+// den = requested frequency in mHz. Each period is q ticks, plus one when
+// the fractional accumulator carries, so any frequency is exact on average.
+static const uint64_t TIMEBASE_MILLITICKS = 10000000ull * 1000ull;  // 10 MHz, in tick*mHz
+static volatile uint32_t output_mhz = 1000;
+static volatile uint32_t period_whole = 10000000;   // q
+static volatile uint32_t period_frac = 0;           // r
+static volatile uint32_t frac_acc = 0;              // 0 .. den-1
+static volatile uint32_t high_ticks = 2000000;
+static volatile uint32_t period_start = 0;          // Rising edge of the current period
+static volatile int32_t pending_slew = 0;           // One-shot shift of the next rising edge
+static volatile uint32_t forced_edges = 0;
+static volatile uint32_t missed_edges = 0;
+static volatile uint32_t max_late_ticks = 0;
+static volatile uint32_t output_edges = 0;
+
+static void gpt2_service();
+static void gpt2_isr();
+static void output_configure(uint32_t millihertz);
+static void output_schedule_next();
 
 void gpt2_begin_dual_mode(uint32_t output_freq_hz, GptCaptureEdge capture_edge, bool use_external_clock) {
-  (void)output_freq_hz;  // Fixed 1 PPS output
+  bool restore_irq = irq_mode;
+  gpt2_enable_interrupts(false);
   // Configure clock source
   if (use_external_clock) {
     // Use external clock input on pin 14
@@ -38,11 +74,18 @@ void gpt2_begin_dual_mode(uint32_t output_freq_hz, GptCaptureEdge capture_edge,
   }
 
   // Configure pin 15 for input capture (GPS PPS)
-  IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_03 = 8;  // ALT8 for GPT2_CAPTURE1
+  // SION keeps the pad readable through GPIO, which tells the edges apart in dual-edge mode
+  IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_03 = (1 << 4) | 8;  // SION=1, ALT8 for GPT2_CAPTURE1
   IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_03 = 0x1030;
   IOMUXC_GPT2_IPP_IND_CAPIN1_SELECT_INPUT =
     (IOMUXC_GPT2_IPP_IND_CAPIN1_SELECT_INPUT & ~0x3u) | 1u;
 
+  // Configure pin 40 for the second input capture (second PPS source) - GPIO_AD_B1_04
+  IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_04 = (1 << 4) | 8;  // SION=1, ALT8 for GPT2_CAPTURE2
+  IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_04 = 0x1030;
+  IOMUXC_GPT2_IPP_IND_CAPIN2_SELECT_INPUT =
+    (IOMUXC_GPT2_IPP_IND_CAPIN2_SELECT_INPUT & ~0x3u) | 1u;
+
   // Configure pin 41 for output compare (1 PPS output) - GPIO_AD_B1_05
   IOMUXC_SW_MUX_CTL_PAD_GPIO_AD_B1_05 = 8;  // ALT8 for GPT2_COMPARE1
   IOMUXC_SW_PAD_CTL_PAD_GPIO_AD_B1_05 = 0x1030;
@@ -71,6 +114,8 @@ void gpt2_begin_dual_mode(uint32_t output_freq_hz, GptCaptureEdge capture_edge,
   // Configure input capture edge detection
   GPT2_CR &= ~(((uint32_t)3 << 16) | ((uint32_t)3 << 18));
   GPT2_CR |= ((uint32_t)(capture_edge & 0x3) << 16);
+  GPT2_CR |= ((uint32_t)(current_capture2_edge & 0x3) << 18);  // Kept across restarts
+  current_capture_edge = capture_edge;
 
   // Configure output compare actions
   GPT2_CR &= ~GPT_CR_OM1(0x7);
@@ -78,26 +123,83 @@ void gpt2_begin_dual_mode(uint32_t output_freq_hz, GptCaptureEdge capture_edge,
 
   // Initialize compare schedule for configurable duty cycle
   // Start with LOW period first to get correct polarity
-  uint32_t high_ticks = (10000000UL * duty_cycle_percent) / 100;
-  uint32_t low_ticks = 10000000UL - high_ticks;
-  compare_target_ticks = low_ticks;
+  if (output_freq_hz < GPT2_OUTPUT_MIN_HZ) output_freq_hz = GPT2_OUTPUT_MIN_HZ;
+  uint32_t max_hz = restore_irq ? GPT2_OUTPUT_MAX_IRQ_HZ : GPT2_OUTPUT_MAX_HZ;
+  if (output_freq_hz > max_hz) output_freq_hz = max_hz;
+  output_configure(output_freq_hz * 1000);
+  pending_slew = 0;
+  period_start = period_whole - high_ticks;
+  compare_target_ticks = period_start;
   compare_high = true;  // Next transition will be to HIGH
   GPT2_OCR1 = compare_target_ticks;
   gpt2_output_high = false;
+  forced_edges = 0;
+  missed_edges = 0;
+  max_late_ticks = 0;
+  output_edges = 0;
 
   // Clear status flags
   GPT2_SR = 0x3F;
-  GPT2_IR = 0;  // No IRQs, use polling
+  GPT2_IR = 0;  // Polling until gpt2_enable_interrupts() is called
+
+  // The counter restarts from zero, so previous captures are meaningless
+  last_cap = 0;
+  prev_cap = 0;
+  capture_available = false;
+  capture_ring.clear();
+  expected_sequence = capture_sequence;  // What was cleared is not a gap
+  rollover_epoch = 0;
 
   // Start the timer
   GPT2_CR |= GPT_CR_EN;
   gpt2_running = true;
+
+  if (restore_irq) {
+    gpt2_enable_interrupts(true);
+  }
+}
+
+void gpt2_enable_interrupts(bool enable) {
+  if (enable) {
+    GPT2_SR = GPT_SR_IF1 | GPT_SR_IF2 | GPT_SR_OF1 | GPT_SR_ROV;  // Don't fire on stale flags
+    attachInterruptVector(IRQ_GPT2, gpt2_isr);
+    NVIC_SET_PRIORITY(IRQ_GPT2, 16);  // Above USB/serial so edges are never late
+    irq_mode = true;
+    if (output_mhz > GPT2_OUTPUT_MAX_IRQ_HZ * 1000) {
+      gpt2_set_output_frequency_mhz(GPT2_OUTPUT_MAX_IRQ_HZ * 1000);  // Two interrupts per period
+    }
+    GPT2_IR = GPT_IR_IF1IE | GPT_IR_IF2IE | GPT_IR_OF1IE | GPT_IR_ROVIE;
+    NVIC_ENABLE_IRQ(IRQ_GPT2);
+  } else {
+    NVIC_DISABLE_IRQ(IRQ_GPT2);
+    GPT2_IR = 0;
+    irq_mode = false;
+  }
+}
+
+bool gpt2_interrupts_enabled() {
+  return irq_mode;
 }
 
 void gpt2_set_capture_edge(GptCaptureEdge edge) {
   // Update input capture edge detection
   GPT2_CR &= ~(((uint32_t)3 << 16));
   GPT2_CR |= ((uint32_t)(edge & 0x3) << 16);
+  current_capture_edge = edge;
+}
+
+GptCaptureEdge gpt2_get_capture_edge() {
+  return current_capture_edge;
+}
+
+void gpt2_set_capture2_edge(GptCaptureEdge edge) {
+  GPT2_CR &= ~(((uint32_t)3 << 18));
+  GPT2_CR |= ((uint32_t)(edge & 0x3) << 18);
+  current_capture2_edge = edge;
+}
+
+GptCaptureEdge gpt2_get_capture2_edge() {
+  return current_capture2_edge;
 }
 
 bool gpt2_capture_available() { 
@@ -111,47 +213,292 @@ uint32_t gpt2_read_capture() {
 }
 
 void gpt2_set_compare_target(uint32_t ticks) {
+  __disable_irq();
   compare_target_ticks = ticks;
   GPT2_OCR1 = compare_target_ticks;
+  __enable_irq();
 }
 
 uint32_t gpt2_get_last_capture() {
   return last_cap;
 }
 
+// A count in the lower half read while ROV is still pending belongs to the next epoch
+static inline uint64_t extend_timestamp(uint32_t epoch, bool rollover_pending, uint32_t ticks) {
+  if (rollover_pending && ticks < 0x80000000u) {
+    epoch++;
+  }
+  return ((uint64_t)epoch << 32) | ticks;
+}
+
+uint64_t gpt2_now64() {
+  __disable_irq();
+  uint32_t cnt = GPT2_CNT;
+  bool pending = (GPT2_SR & GPT_SR_ROV) != 0;
+  uint64_t now = extend_timestamp(rollover_epoch, pending, cnt);
+  __enable_irq();
+  return now;
+}
+
+uint32_t gpt2_get_rollover_epoch() {
+  return rollover_epoch;
+}
+
+bool gpt2_pop_capture(Gpt2CaptureEvent& event) {
+  if (!capture_ring.pop(event)) {
+    return false;
+  }
+  if (event.sequence != expected_sequence) {
+    event_counters.dropped_edges += event.sequence - expected_sequence;
+  }
+  expected_sequence = event.sequence + 1;
+  return true;
+}
+
+void gpt2_get_counters(Gpt2EventCounters& counters) {
+  __disable_irq();
+  counters.captures = event_counters.captures;
+  counters.compares = event_counters.compares;
+  counters.rollovers = event_counters.rollovers;
+  counters.ring_overruns = event_counters.ring_overruns;
+  counters.dropped_edges = event_counters.dropped_edges;
+  counters.late_compares = event_counters.late_compares;
+  counters.max_queued = event_counters.max_queued;
+  __enable_irq();
+}
+
+void gpt2_reset_counters() {
+  __disable_irq();
+  event_counters.captures = 0;
+  event_counters.compares = 0;
+  event_counters.rollovers = 0;
+  event_counters.ring_overruns = 0;
+  event_counters.dropped_edges = 0;
+  event_counters.late_compares = 0;
+  event_counters.max_queued = 0;
+  __enable_irq();
+}
+
 void gpt2_poll_capture() {
+  if (irq_mode) {
+    return;  // The ISR owns the status flags
+  }
+  gpt2_service();
+}
+
+static void gpt2_isr() {
+  gpt2_service();
+#if defined(__IMXRT1062__)
+  asm volatile("dsb");  // Make sure the flag clears land before the ISR returns
+#endif
+}
+
+static void queue_capture(uint8_t channel, uint32_t cap, uint32_t epoch, bool rollover) {
+  Gpt2CaptureEvent event;
+  event.timestamp = cap;
+  event.timestamp64 = extend_timestamp(epoch, rollover, cap);
+  event.sequence = capture_sequence++;
+  event.channel = channel;
+  GptCaptureEdge edge = channel == 0 ? current_capture_edge : current_capture2_edge;
+  if (edge == GPT_EDGE_BOTH) {
+    // The pin shows the level left by the newest edge, and the capture register
+    // holds the newest edge, so the two agree however late the service runs.
+    // Polled, an edge that arrives before the service reads the previous one
+    // overwrites it: a slow loop() loses edges (not their polarity), which
+    // is why dual-edge analysis wants interrupt servicing.
+    uint8_t pin = channel == 0 ? GPT2_CAPTURE_PIN : GPT2_CAPTURE2_PIN;
+    edge = digitalReadFast(pin) ? GPT_EDGE_RISING : GPT_EDGE_FALLING;
+  }
+  event.edge = (uint8_t)edge;
+  event_counters.captures++;
+  if (!capture_ring.push(event)) {
+    event_counters.ring_overruns++;
+  }
+  uint32_t queued = capture_ring.size();
+  if (queued > event_counters.max_queued) {
+    event_counters.max_queued = queued;
+  }
+}
+
+// Shared by the ISR and the polled path: drains IF1/IF2/OF1/ROV exactly once each.
+// A capture and a rollover flagged together are ordered by the captured count.
+static void gpt2_service() {
   uint32_t sr = GPT2_SR;
+  uint32_t epoch = rollover_epoch;
+  bool rollover = (sr & GPT_SR_ROV) != 0;
+  if (rollover) {
+    GPT2_SR = GPT_SR_ROV;
+    rollover_epoch = epoch + 1;
+    event_counters.rollovers++;
+  }
   if (sr & GPT_SR_IF1) {
     uint32_t cap = GPT2_ICR1;
     GPT2_SR = GPT_SR_IF1;  // clear IF1
     prev_cap = last_cap;
     last_cap = cap;
     capture_available = (prev_cap != 0);
+    queue_capture(0, cap, epoch, rollover);
+  }
+  if (sr & GPT_SR_IF2) {
+    uint32_t cap = GPT2_ICR2;
+    GPT2_SR = GPT_SR_IF2;  // clear IF2
+    queue_capture(1, cap, epoch, rollover);
   }
   if (sr & GPT_SR_OF1) {
     GPT2_SR = GPT_SR_OF1;  // clear compare flag
+    event_counters.compares++;
+    gpt2_output_high = compare_high;
+    output_edges++;
+    output_schedule_next();
+  }
+}
+
+// Period and high time for `millihertz`; caller holds off the service routine
+static void output_configure(uint32_t millihertz) {
+  output_mhz = millihertz;
+  period_whole = (uint32_t)(TIMEBASE_MILLITICKS / millihertz);
+  period_frac = (uint32_t)(TIMEBASE_MILLITICKS % millihertz);
+  frac_acc = 0;
+  uint32_t high = (uint32_t)(((uint64_t)period_whole * duty_cycle_percent + 50) / 100);
+  if (high < 1) high = 1;
+  if (high > period_whole - 1) high = period_whole - 1;
+  high_ticks = high;
+}
+
+static inline void output_advance_period() {
+  uint32_t next = period_whole;
+  frac_acc += period_frac;
+  if (frac_acc >= output_mhz) {
+    frac_acc -= output_mhz;
+    next++;
+  }
+  period_start += next + (uint32_t)pending_slew;
+  pending_slew = 0;
+}
 
-    // Toggle action and schedule next target for configurable duty cycle
-    compare_high = !compare_high;
-    uint32_t action_bits = compare_high ? 0x3 : 0x2; // set or clear output
-    
-    // Calculate intervals based on duty cycle percentage
-    // Note: Timer starts HIGH, so we need to swap the logic
-    uint32_t high_ticks = (10000000UL * duty_cycle_percent) / 100;
-    uint32_t low_ticks = 10000000UL - high_ticks;
-    uint32_t next_interval = compare_high ? low_ticks : high_ticks;
-    
-    // Handle potential overflow by wrapping around (timer hardware handles this correctly)
-    uint32_t next_target = compare_target_ticks + next_interval;
-    if (next_target < compare_target_ticks) {
-      // Overflow occurred - this is expected and handled by hardware
+// Schedules the edge after the one that just fired. An edge whose target the
+// counter has already reached is forced immediately (FO1) and its lateness
+// recorded as jitter; if servicing fell more than a period behind, whole
+// periods are skipped so the output stays on its grid.
+static void output_schedule_next() {
+  for (uint8_t attempt = 0; attempt < 4; attempt++) {
+    bool rising = !compare_high;
+    if (rising) {
+      output_advance_period();
     }
-    compare_target_ticks = next_target;
-    
-    GPT2_CR = (GPT2_CR & ~GPT_CR_OM1(0x7)) | GPT_CR_OM1(action_bits);
-    GPT2_OCR1 = compare_target_ticks;
-    gpt2_output_high = compare_high;
+    uint32_t target = rising ? period_start : period_start + high_ticks;
+
+    int32_t late = (int32_t)(GPT2_CNT - target);
+    if (late > (int32_t)period_whole) {
+      // Too far behind to catch up edge by edge: realign on the grid
+      uint32_t periods = (uint32_t)late / period_whole;
+      uint64_t carry = (uint64_t)frac_acc + (uint64_t)period_frac * periods;
+      period_start += periods * period_whole + (uint32_t)(carry / output_mhz);
+      frac_acc = (uint32_t)(carry % output_mhz);
+      missed_edges += 2 * periods;
+      event_counters.late_compares++;
+      target = rising ? period_start : period_start + high_ticks;
+    }
+
+    compare_high = rising;
+    compare_target_ticks = target;
+    GPT2_CR = (GPT2_CR & ~GPT_CR_OM1(0x7)) | GPT_CR_OM1(rising ? 0x3 : 0x2);  // set or clear output
+    GPT2_OCR1 = target;
+
+    late = (int32_t)(GPT2_CNT - target);
+    if (late < 0) {
+      return;  // The compare will fire
+    }
+    // The counter got there first: drive the edge now and move on to the next one
+    GPT2_CR |= GPT_CR_FO1;
+    GPT2_SR = GPT_SR_OF1;  // In case the match fired as well
+    gpt2_output_high = rising;
+    output_edges++;
+    forced_edges++;
+    event_counters.late_compares++;
+    if ((uint32_t)late > max_late_ticks) {
+      max_late_ticks = (uint32_t)late;
+    }
+  }
+}
+
+bool gpt2_set_output_frequency_mhz(uint32_t millihertz) {
+  if (millihertz < GPT2_OUTPUT_MIN_HZ * 1000 || millihertz > gpt2_get_output_max_hz() * 1000) {
+    return false;
+  }
+  __disable_irq();
+  output_configure(millihertz);
+  pending_slew = 0;
+  // Restart the grid shortly after now with a rising edge
+  period_start = GPT2_CNT + 1000;
+  compare_high = true;
+  compare_target_ticks = period_start;
+  GPT2_CR = (GPT2_CR & ~GPT_CR_OM1(0x7)) | GPT_CR_OM1(0x3);
+  GPT2_OCR1 = period_start;
+  forced_edges = 0;
+  missed_edges = 0;
+  max_late_ticks = 0;
+  output_edges = 0;
+  __enable_irq();
+  return true;
+}
+
+void gpt2_slew_output(int32_t ticks) {
+  // Applied after a falling edge: an earlier rise must stay clear of it
+  __disable_irq();
+  int32_t limit = (int32_t)(period_whole / 4);
+  int32_t low_limit = (int32_t)((period_whole - high_ticks) / 2);
+  if (low_limit < limit) limit = low_limit;
+  int32_t total = pending_slew + ticks;
+  if (total > limit) total = limit;
+  if (total < -limit) total = -limit;
+  pending_slew = total;
+  __enable_irq();
+}
+
+uint32_t gpt2_get_output_max_hz() {
+  return irq_mode ? GPT2_OUTPUT_MAX_IRQ_HZ : GPT2_OUTPUT_MAX_HZ;
+}
+
+uint32_t gpt2_get_output_frequency_mhz() {
+  return output_mhz;
+}
+
+void gpt2_get_output_phase(uint32_t& rise_ticks, int32_t& slew_pending) {
+  __disable_irq();
+  rise_ticks = period_start;
+  slew_pending = pending_slew;
+  __enable_irq();
+}
+
+static uint32_t gcd32(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
   }
+  return a;
+}
+
+void gpt2_get_output_stats(Gpt2OutputStats& stats) {
+  __disable_irq();
+  stats.requested_mhz = output_mhz;
+  stats.period_ticks = period_whole;
+  stats.period_frac = period_frac;
+  stats.high_ticks = high_ticks;
+  stats.edges = output_edges;
+  stats.forced_edges = forced_edges;
+  stats.missed_edges = missed_edges;
+  stats.max_late_ns = max_late_ticks * 100;
+  __enable_irq();
+
+  // Exact average of the grid, less any edges skipped to keep up
+  double exact_hz = output_mhz / 1000.0;
+  uint32_t total = stats.edges + stats.missed_edges;
+  stats.achieved_hz = total ? exact_hz * stats.edges / total : exact_hz;
+  // Rounding onto whole ticks moves an edge by at most (den - gcd) / den of a tick
+  uint32_t g = period_frac ? gcd32(output_mhz, period_frac) : output_mhz;
+  stats.quantization_ns = (uint32_t)(100.0 * (double)(output_mhz - g) / output_mhz + 0.5);
 }
 
 void gpt2_stop() {
@@ -170,7 +517,13 @@ bool gpt2_is_output_high() {
 void gpt2_set_duty_cycle(uint8_t percent) {
   if (percent > 80) percent = 80;
   if (percent < 20) percent = 20;
+  __disable_irq();
   duty_cycle_percent = percent;
+  uint32_t high = (uint32_t)(((uint64_t)period_whole * percent + 50) / 100);
+  if (high < 1) high = 1;
+  if (high > period_whole - 1) high = period_whole - 1;
+  high_ticks = high;  // Takes effect from the next scheduled edge
+  __enable_irq();
 }
 
 uint8_t gpt2_get_duty_cycle() {
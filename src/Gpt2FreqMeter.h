@@ -9,17 +9,92 @@ enum GptCaptureEdge {
   GPT_EDGE_BOTH     = 3,
 };
 
+// One input capture event, produced by the GPT2 service routine (ISR or poll)
+// and consumed by the main loop through gpt2_pop_capture().
+struct Gpt2CaptureEvent {
+  uint32_t timestamp;   // Raw GPT2_ICR1 value (10 MHz ticks, wraps every ~429 s)
+  uint64_t timestamp64; // Same edge on the 64-bit extended timebase (never wraps)
+  uint32_t sequence;    // Incremented for every capture; a gap means edges were dropped
+  uint8_t edge;         // GptCaptureEdge of this edge (RISING or FALLING, read from the pin in BOTH mode;
+                        // polled, edges closer together than the loop() period are lost)
+  uint8_t channel;      // 0 = capture 1 (pin 15, GPS PPS), 1 = capture 2 (pin 40, second PPS)
+};
+
+struct Gpt2EventCounters {
+  uint32_t captures;       // Capture events seen by the service routine
+  uint32_t compares;       // Output compare events serviced
+  uint32_t rollovers;      // Counter rollovers (ROV)
+  uint32_t ring_overruns;  // Captures dropped because the ring was full
+  uint32_t dropped_edges;  // Sequence gaps seen by gpt2_pop_capture(): every capture the
+                           // consumer never got, ring_overruns included
+  uint32_t late_compares;  // Compare re-armed after its target had already passed
+  uint32_t max_queued;     // High-water mark of the capture ring
+};
+
+// Output synthesizer on compare channel 1 (pin 41)
+static const uint32_t GPT2_OUTPUT_MIN_HZ = 1;
+static const uint32_t GPT2_OUTPUT_MAX_HZ = 1000000;  // Polled: edges forced late or skipped as loop() allows
+// Every period takes two compare services. From the ISR each costs about
+// 0.5 us (entry, exit and a handful of GPT2 register accesses on the 150 MHz
+// peripheral bus): 50 kHz is 100k interrupts/s, roughly 5% of the CPU, while
+// 1 MHz would be 2M/s and starve loop() and the captures. An estimate, not
+// a bench measurement.
+static const uint32_t GPT2_OUTPUT_MAX_IRQ_HZ = 50000;
+
+struct Gpt2OutputStats {
+  uint32_t requested_mhz;    // Requested frequency, millihertz
+  double achieved_hz;        // Exact grid average, less any skipped edges
+  uint32_t period_ticks;     // Whole ticks per period ...
+  uint32_t period_frac;      // ... plus period_frac / requested_mhz, dithered
+  uint32_t high_ticks;       // Duty cycle as programmed
+  uint32_t edges;            // Output edges driven (compare or forced)
+  uint32_t forced_edges;     // Edges driven late through FO1
+  uint32_t missed_edges;     // Edges skipped because servicing fell a period behind
+  uint32_t max_late_ns;      // Worst lateness of a forced edge
+  uint32_t quantization_ns;  // Worst edge offset from the ideal grid due to 100 ns ticks
+};
+
 // GPT2 Functions (Output Compare Always Active)
 void gpt2_begin_dual_mode(uint32_t output_freq_hz = 1, GptCaptureEdge capture_edge = GPT_EDGE_RISING, bool use_external_clock = false);
 void gpt2_set_capture_edge(GptCaptureEdge edge);
+GptCaptureEdge gpt2_get_capture_edge();
+// Second capture channel, same counter (disabled by default; kept across gpt2_begin_dual_mode())
+void gpt2_set_capture2_edge(GptCaptureEdge edge);
+GptCaptureEdge gpt2_get_capture2_edge();
 void gpt2_set_compare_target(uint32_t ticks);
+// Changes the output frequency without restarting the counter (1 Hz .. gpt2_get_output_max_hz())
+bool gpt2_set_output_frequency_mhz(uint32_t millihertz);
+uint32_t gpt2_get_output_max_hz();  // For the current servicing mode
+void gpt2_get_output_stats(Gpt2OutputStats& stats);
+uint32_t gpt2_get_output_frequency_mhz();
+// Phase control: shift the next rising edge by `ticks` (one-shot, bounded to a quarter
+// period), and read a rising edge of the grid (past or scheduled) with any shift not yet applied
+void gpt2_slew_output(int32_t ticks);
+void gpt2_get_output_phase(uint32_t& rise_ticks, int32_t& slew_pending);
 uint32_t gpt2_get_last_capture();
 
+// 64-bit extended timebase: GPT2_CNT with the rollover count (ROV) as the
+// upper word, starting from zero at gpt2_begin_dual_mode(). ROV must be
+// serviced at least every ~214 s (always true in interrupt mode).
+uint64_t gpt2_now64();
+uint32_t gpt2_get_rollover_epoch();
+
 // Input Capture Functions (for GPS PPS when available)
 bool gpt2_capture_available();
 uint32_t gpt2_read_capture();
 void gpt2_poll_capture();
 
+// Interrupt-driven servicing of IF1/OF1/ROV. When enabled, gpt2_poll_capture()
+// becomes a no-op and captures are queued from the ISR. An output above
+// GPT2_OUTPUT_MAX_IRQ_HZ is brought down to it.
+void gpt2_enable_interrupts(bool enable);
+bool gpt2_interrupts_enabled();
+
+// Capture queue (filled in both polled and interrupt mode)
+bool gpt2_pop_capture(Gpt2CaptureEvent& event);
+void gpt2_get_counters(Gpt2EventCounters& counters);
+void gpt2_reset_counters();
+
 // System Control
 void gpt2_stop();
 bool gpt2_is_running();
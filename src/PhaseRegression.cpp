@@ -0,0 +1,127 @@
+#include "PhaseRegression.h"
+#include <math.h>
+
+static const uint16_t DEFAULT_WINDOWS[] = {10, 60, 300, 1000};
+
+PhaseRegression::PhaseRegression(uint32_t nominal_ticks, double tick_seconds, double tau0_seconds)
+    : nominal(nominal_ticks), tick_s(tick_seconds), tau0(tau0_seconds), window_count(0) {
+  set_windows(DEFAULT_WINDOWS, sizeof(DEFAULT_WINDOWS) / sizeof(DEFAULT_WINDOWS[0]));
+  gap_count = 0;
+}
+
+bool PhaseRegression::set_windows(const uint16_t* lengths, uint8_t count) {
+  if (count == 0 || count > MAX_WINDOWS) {
+    return false;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    if (lengths[i] < 3 || lengths[i] > MAX_WINDOW_SAMPLES) {
+      return false;
+    }
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    windows[i].length = lengths[i];
+  }
+  window_count = count;
+  reset();
+  return true;
+}
+
+void PhaseRegression::reset() {
+  for (uint8_t i = 0; i < window_count; i++) {
+    windows[i].n = 0;
+    windows[i].sum_x = 0;
+    windows[i].sum_ux = 0;
+    windows[i].sum_xx = 0;
+  }
+  head = 0;
+  phase_ticks = 0;
+  base = 0;
+  segment_started = false;
+}
+
+void PhaseRegression::mark_gap() {
+  // A line cannot be fitted across a lost edge: start every window again
+  reset();
+  gap_count++;
+}
+
+void PhaseRegression::rebase(int64_t new_base) {
+  int64_t delta = new_base - base;
+  for (uint8_t i = 0; i < window_count; i++) {
+    Window& w = windows[i];
+    int64_t n = w.n;
+    w.sum_xx += n * delta * delta - 2 * delta * w.sum_x;
+    w.sum_ux -= n * (n - 1) / 2 * delta;
+    w.sum_x -= n * delta;
+  }
+  base = new_base;
+}
+
+void PhaseRegression::add_period(uint32_t ticks) {
+  if (!segment_started) {
+    segment_started = true;
+    add_phase(0);  // Phase origin: the edge opening this period
+  }
+  phase_ticks += (int64_t)ticks - (int64_t)nominal;
+  add_phase(phase_ticks);
+}
+
+void PhaseRegression::add_phase(int64_t phase) {
+  rebase(phase);  // The new sample is 0 relative to the new base
+
+  for (uint8_t i = 0; i < window_count; i++) {
+    Window& w = windows[i];
+    if (w.n == w.length) {
+      // Drop the oldest sample; every remaining index moves down by one
+      uint16_t slot = (uint16_t)((head + MAX_WINDOW_SAMPLES - w.length) % MAX_WINDOW_SAMPLES);
+      int64_t oldest = ring[slot] - base;
+      w.sum_x -= oldest;
+      w.sum_xx -= oldest * oldest;
+      w.sum_ux -= w.sum_x;
+      w.n--;
+    }
+    w.n++;  // Newest sample at u = n - 1 contributes 0 to every sum
+  }
+
+  ring[head] = phase;
+  head = (uint16_t)((head + 1) % MAX_WINDOW_SAMPLES);
+}
+
+bool PhaseRegression::get_fit(uint8_t index, RegressionFit& fit) const {
+  if (index >= window_count) {
+    return false;
+  }
+  const Window& w = windows[index];
+  fit.window = w.length;
+  fit.samples = w.n;
+  if (w.n < 3) {
+    return false;
+  }
+
+  // slope = (N Sum(ux) - Sum(u) Sum(x)) / (N Sum(u^2) - Sum(u)^2), numerator exact in int64
+  int64_t n = w.n;
+  int64_t numerator = n * w.sum_ux - n * (n - 1) / 2 * w.sum_x;
+  double nd = (double)n;
+  double suu = nd * (nd * nd - 1.0) / 12.0;  // Sum((u - mean u)^2)
+  double slope = (double)numerator / (nd * suu);
+
+  double mean_x = (double)w.sum_x / nd;
+  double sxx = (double)w.sum_xx - (double)w.sum_x * mean_x;  // Centred, small: no cancellation issue
+  double sse = sxx - slope * slope * suu;
+  if (sse < 0.0) sse = 0.0;
+
+  fit.frequency = slope * tick_s / tau0;
+  fit.frequency_sigma = sqrt(sse / (nd - 2.0) / suu) * tick_s / tau0;
+  fit.phase_ticks = (double)base + mean_x + slope * (nd - 1.0) / 2.0;
+  fit.residual_rms_ns = sqrt(sse / nd) * tick_s * 1e9;
+  return true;
+}
+
+bool PhaseRegression::get_best_fit(RegressionFit& fit) const {
+  for (int8_t i = (int8_t)window_count - 1; i >= 0; i--) {
+    if (get_fit((uint8_t)i, fit)) {
+      return true;
+    }
+  }
+  return false;
+}
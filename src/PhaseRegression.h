@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+
+// Least-squares frequency and phase estimator over sliding windows of PPS
+// capture timestamps.
+//
+// A single period is quantised to +-1 tick (100 ppb at 10 MHz), and the
+// mean of N periods only improves as 1/N because it depends on the first
+// and last timestamp alone. Fitting a line through all N timestamps uses
+// every edge: with white timestamp noise sigma the slope error falls as
+// sqrt(12) * sigma / N^1.5, so a one-minute window already reaches the
+// 1 ppb class.
+//
+// Each accepted period extends an exact int64 phase x (accumulated ticks
+// minus nominal) stored in a ring shared by all windows. Every window keeps
+// integer running sums of x, u*x and x^2 (u = sample index within the
+// window), updated in O(1) as samples enter and leave. The sums are kept
+// relative to the newest phase, so they stay small and exact however far
+// the oscillator is off. A gap (missed or rejected edge) restarts all
+// windows, as in StabilityEngine.
+
+struct RegressionFit {
+  uint16_t window;      // Configured window length, samples
+  uint16_t samples;     // Samples currently in the window (fit valid from 3)
+  double frequency;     // Fractional frequency error (slope), e.g. 1e-9 = 1 ppb
+  double frequency_sigma;  // 1-sigma standard error of the slope
+  double phase_ticks;   // Fitted phase at the newest edge, ticks since the segment start
+  double residual_rms_ns;  // RMS of the timestamps about the fitted line
+};
+
+class PhaseRegression {
+public:
+  static const uint8_t MAX_WINDOWS = 4;
+  static const uint16_t MAX_WINDOW_SAMPLES = 1024;
+
+  PhaseRegression(uint32_t nominal_ticks, double tick_seconds, double tau0_seconds);
+
+  void reset();
+  void add_period(uint32_t ticks);
+  void mark_gap();
+
+  // Window lengths in samples (3..MAX_WINDOW_SAMPLES), shortest first; restarts the fits
+  bool set_windows(const uint16_t* lengths, uint8_t count);
+  uint8_t get_window_count() const { return window_count; }
+
+  bool get_fit(uint8_t index, RegressionFit& fit) const;
+  // Longest window with a valid fit; false until three samples are in
+  bool get_best_fit(RegressionFit& fit) const;
+  uint32_t get_gap_count() const { return gap_count; }
+
+private:
+  struct Window {
+    uint16_t length;
+    uint16_t n;
+    int64_t sum_x;    // All sums relative to `base`
+    int64_t sum_ux;
+    int64_t sum_xx;
+  };
+
+  void add_phase(int64_t phase);
+  void rebase(int64_t new_base);
+
+  uint32_t nominal;
+  double tick_s;
+  double tau0;
+
+  int64_t ring[MAX_WINDOW_SAMPLES];  // Segment phase, ticks
+  uint16_t head;        // Next slot to write
+  int64_t phase_ticks;
+  int64_t base;         // Phase the window sums are relative to (the newest sample)
+  bool segment_started;
+
+  Window windows[MAX_WINDOWS];
+  uint8_t window_count;
+  uint32_t gap_count;
+};
@@ -0,0 +1,110 @@
+#include "PpsAligner.h"
+#include <math.h>
+
+// PI loop on the per-second error: critically damped (double pole at 0.875),
+// so a one-tick capture jitter moves the output by a quarter tick at most
+static const double PROPORTIONAL_GAIN = 1.0 / 4.0;
+static const double INTEGRAL_GAIN = 1.0 / 64.0;    // Learns the drift (ticks per second)
+static const double FILTER_ALPHA = 1.0 / 8.0;      // Smoothed error, for the state and display
+static const double CAPTURE_LAG_TICKS = 0.5;       // The capture holds the last whole tick before the edge
+static const double ALIGNED_TICKS = 1.5;           // |filtered error| within this ...
+static const uint16_t ALIGNED_EDGES = 10;          // ... for this many edges -> ALIGNED
+
+PpsAligner::PpsAligner(uint32_t nominal_ticks, double tick_length_ns)
+    : nominal(nominal_ticks), tick_ns(tick_length_ns), enabled(false), offset_ns(0),
+      max_slew_ns(DEFAULT_MAX_SLEW_NS), jam_threshold_ns(1000000), jam_allowed(true), have_error(false),
+      error_ns(0.0), filtered_ticks(0.0), integral_ticks(0.0), remainder_ticks(0.0), aligned_edges(0), steps(0), corrections(0) {
+}
+
+void PpsAligner::set_enabled(bool enable) {
+  if (enable && !enabled) {
+    mark_restart();
+  }
+  enabled = enable;
+}
+
+void PpsAligner::set_offset_ns(int32_t offset) {
+  offset_ns = offset;
+  aligned_edges = 0;
+}
+
+void PpsAligner::set_max_slew_ns(uint32_t ns_per_second) {
+  if (ns_per_second < (uint32_t)tick_ns) ns_per_second = (uint32_t)tick_ns;
+  max_slew_ns = ns_per_second;
+}
+
+void PpsAligner::mark_restart() {
+  jam_allowed = true;
+  have_error = false;
+  filtered_ticks = 0.0;
+  integral_ticks = 0.0;
+  remainder_ticks = 0.0;
+  aligned_edges = 0;
+}
+
+int32_t PpsAligner::add_edge(uint32_t capture_ticks, uint32_t rise_ticks, int32_t pending_ticks) {
+  // Output rise minus the wanted position, as seen once the pending shift lands
+  double offset_ticks = offset_ns / tick_ns;
+  int32_t raw = (int32_t)(rise_ticks - capture_ticks) + pending_ticks;
+  int32_t period = (int32_t)nominal;
+  raw %= period;
+  if (raw > period / 2) raw -= period;
+  if (raw < -period / 2) raw += period;
+  double error_ticks = raw - CAPTURE_LAG_TICKS - offset_ticks;
+  if (error_ticks > period / 2) error_ticks -= period;
+  if (error_ticks < -period / 2) error_ticks += period;
+
+  error_ns = (error_ticks - pending_ticks) * tick_ns;  // What this edge actually saw
+  have_error = true;
+  if (!enabled) {
+    return 0;
+  }
+
+  if (jam_allowed) {
+    // A step larger than the output allows is finished over the next edges
+    if (fabs(error_ticks) * tick_ns > jam_threshold_ns) {
+      steps++;
+      filtered_ticks = 0.0;
+      aligned_edges = 0;
+      return -(int32_t)lround(error_ticks);
+    }
+    jam_allowed = false;
+    filtered_ticks = error_ticks;
+  } else {
+    filtered_ticks += FILTER_ALPHA * (error_ticks - filtered_ticks);
+  }
+  aligned_edges = fabs(filtered_ticks) <= ALIGNED_TICKS ? aligned_edges + 1 : 0;
+
+  double max_ticks = max_slew_ns / tick_ns;
+  integral_ticks += INTEGRAL_GAIN * error_ticks;
+  if (integral_ticks > max_ticks) integral_ticks = max_ticks;
+  if (integral_ticks < -max_ticks) integral_ticks = -max_ticks;
+  double wanted = -(PROPORTIONAL_GAIN * error_ticks + integral_ticks);
+  if (wanted > max_ticks) wanted = max_ticks;
+  if (wanted < -max_ticks) wanted = -max_ticks;
+
+  // Whole ticks only: the fraction is carried, so the average shift is exact
+  wanted += remainder_ticks;
+  int32_t shift = (int32_t)lround(wanted);
+  remainder_ticks = wanted - shift;
+  if (shift != 0) {
+    corrections++;
+  }
+  return shift;
+}
+
+PpsAlignState PpsAligner::get_state() const {
+  if (!enabled) {
+    return PPS_ALIGN_OFF;
+  }
+  return aligned_edges >= ALIGNED_EDGES ? PPS_ALIGN_ALIGNED : PPS_ALIGN_SLEWING;
+}
+
+const char* PpsAligner::state_name(PpsAlignState state) {
+  switch (state) {
+    case PPS_ALIGN_OFF: return "OFF";
+    case PPS_ALIGN_SLEWING: return "SLEWING";
+    case PPS_ALIGN_ALIGNED: return "ALIGNED";
+  }
+  return "?";
+}
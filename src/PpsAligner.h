@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+
+// Phase-aligns the generated 1 PPS (GPT2 compare) to the GPS PPS (GPT2 capture).
+//
+// Both edges live on the same GPT2 counter, so the phase error is simply the
+// output grid's rising edge minus (capture + offset), reduced to +-half a
+// period. The error is smoothed (the capture is quantised to one tick and the
+// receiver adds its sawtooth) by a PI loop that shifts the next output period
+// in whole ticks, at most max_slew_ns per second. After enabling, or after the
+// counter restarts, a first error above jam_threshold_ns is stepped out
+// instead of being slewed for hours (over a few edges when it is larger than
+// one output period can be shifted).
+//
+// offset_ns places the output rising edge relative to the captured GPS edge:
+// a negative value makes the output lead the capture, e.g. to compensate
+// antenna cable and receiver delay.
+
+enum PpsAlignState : uint8_t {
+  PPS_ALIGN_OFF = 0,
+  PPS_ALIGN_SLEWING = 1,   // Correcting, error above the aligned threshold
+  PPS_ALIGN_ALIGNED = 2,
+};
+
+class PpsAligner {
+public:
+  static const uint32_t DEFAULT_MAX_SLEW_NS = 10000;
+
+  PpsAligner(uint32_t nominal_ticks, double tick_ns);
+
+  void set_enabled(bool enable);
+  bool is_enabled() const { return enabled; }
+  void set_offset_ns(int32_t offset);
+  int32_t get_offset_ns() const { return offset_ns; }
+  void set_max_slew_ns(uint32_t ns_per_second);
+  uint32_t get_max_slew_ns() const { return max_slew_ns; }
+  void set_jam_threshold_ns(uint32_t ns) { jam_threshold_ns = ns; }
+
+  // Counter restarted: the output grid and the captures start over
+  void mark_restart();
+
+  // One accepted GPS edge. `rise_ticks` is any rising edge of the output grid
+  // and `pending_ticks` a shift already requested but not yet applied.
+  // Returns the shift (ticks) to request for the next output period.
+  int32_t add_edge(uint32_t capture_ticks, uint32_t rise_ticks, int32_t pending_ticks);
+
+  PpsAlignState get_state() const;
+  static const char* state_name(PpsAlignState state);
+  bool has_measurement() const { return have_error; }
+  double get_phase_error_ns() const { return error_ns; }          // Last measured
+  double get_filtered_error_ns() const { return filtered_ticks * tick_ns; }
+  uint32_t get_steps() const { return steps; }
+  uint32_t get_corrections() const { return corrections; }
+
+private:
+  uint32_t nominal;
+  double tick_ns;
+  bool enabled;
+  int32_t offset_ns;
+  uint32_t max_slew_ns;
+  uint32_t jam_threshold_ns;
+
+  bool jam_allowed;
+  bool have_error;
+  double error_ns;
+  double filtered_ticks;
+  double integral_ticks;    // Drift learned by the PI loop
+  double remainder_ticks;   // Sub-tick part of the shifts not yet issued
+  uint16_t aligned_edges;   // Consecutive edges within the aligned threshold
+  uint32_t steps;
+  uint32_t corrections;
+};
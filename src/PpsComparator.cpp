@@ -0,0 +1,98 @@
+#include "PpsComparator.h"
+#include <math.h>
+#include <string.h>
+
+PpsComparator::PpsComparator(uint32_t nominal_ticks)
+    : nominal(nominal_ticks), stability(nominal_ticks, 1e-7, 1.0) {
+  reset();
+}
+
+void PpsComparator::reset() {
+  memset(inputs, 0, sizeof(inputs));
+  memset(&phase, 0, sizeof(phase));
+  phase_m2 = 0.0;
+  have_pair = false;
+  last_difference = 0;
+  last_pair_edge = 0;
+  stability.reset();
+}
+
+void PpsComparator::add_edge(uint8_t input, uint64_t timestamp) {
+  if (input >= MAX_INPUTS) {
+    return;
+  }
+  Input& in = inputs[input];
+  PpsInputStats& stats = in.stats;
+  stats.edges++;
+  if (in.have_edge) {
+    if (!in.paired) {
+      phase.unpaired++;
+    }
+    uint64_t interval = timestamp - in.last_edge;
+    if (interval >= nominal - nominal / 100 && interval <= nominal + nominal / 100) {
+      uint32_t ticks = (uint32_t)interval;
+      stats.periods++;
+      stats.last_ticks = ticks;
+      double delta = ticks - stats.mean_ticks;
+      stats.mean_ticks += delta / stats.periods;
+      in.m2 += delta * (ticks - stats.mean_ticks);
+      stats.rms_ticks = stats.periods > 1 ? sqrt(in.m2 / (stats.periods - 1)) : 0.0;
+    } else {
+      stats.rejected++;
+    }
+  }
+  in.last_edge = timestamp;
+  in.have_edge = true;
+  in.paired = false;
+
+  // Pair with the other input's latest edge if it is within half a second
+  Input& other = inputs[input ^ 1];
+  if (!other.have_edge || other.paired) {
+    return;
+  }
+  int64_t difference = (int64_t)(inputs[1].last_edge - inputs[0].last_edge);
+  if (difference >= (int64_t)(nominal / 2) || difference <= -(int64_t)(nominal / 2)) {
+    return;
+  }
+  in.paired = true;
+  other.paired = true;
+  add_pair(difference, inputs[0].last_edge);
+}
+
+void PpsComparator::add_pair(int64_t difference, uint64_t reference_edge) {
+  phase.pairs++;
+  phase.last_ticks = difference;
+  if (phase.pairs == 1 || difference < phase.min_ticks) phase.min_ticks = difference;
+  if (phase.pairs == 1 || difference > phase.max_ticks) phase.max_ticks = difference;
+  double delta = difference - phase.mean_ticks;
+  phase.mean_ticks += delta / phase.pairs;
+  phase_m2 += delta * (difference - phase.mean_ticks);
+  phase.rms_ticks = phase.pairs > 1 ? sqrt(phase_m2 / (phase.pairs - 1)) : 0.0;
+
+  // Consecutive seconds feed the stability estimate; anything else is a gap
+  if (have_pair) {
+    uint64_t interval = reference_edge - last_pair_edge;
+    if (interval >= nominal - nominal / 100 && interval <= nominal + nominal / 100) {
+      int64_t step = difference - last_difference;
+      stability.add_period((uint32_t)((int64_t)nominal + step));
+    } else {
+      stability.mark_gap();
+    }
+  }
+  have_pair = true;
+  last_difference = difference;
+  last_pair_edge = reference_edge;
+}
+
+const PpsInputStats& PpsComparator::get_input(uint8_t input) const {
+  return inputs[input < MAX_INPUTS ? input : 0].stats;
+}
+
+bool PpsComparator::get_input_ppb(uint8_t input, double& ppb) const {
+  const PpsInputStats& stats = get_input(input);
+  if (stats.periods == 0) {
+    return false;
+  }
+  ppb = (stats.mean_ticks - nominal) / nominal * 1e9;
+  return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include "StabilityEngine.h"
+
+// Side-by-side comparison of PPS inputs timestamped on the one GPT2 counter.
+//
+// Every input gets its own period statistics, so its frequency is measured
+// against the local oscillator exactly as the main input is. Edges of two
+// inputs within half a second of each other are paired, and the difference
+// (input 1 - input 0) is the phase between the two sources, free of any
+// oscillator error because both edges share one timebase. Its stability is
+// estimated by feeding the second-to-second change of that difference into a
+// StabilityEngine, whose phase then is the difference itself: ADEV/TDEV of
+// one receiver against the other. A second without a pair breaks continuity.
+
+struct PpsInputStats {
+  uint32_t edges;
+  uint32_t periods;        // Intervals within 1% of one second
+  uint32_t rejected;       // Other intervals: missed or spurious edges
+  uint32_t last_ticks;     // Latest accepted period
+  double mean_ticks;
+  double rms_ticks;        // Standard deviation of the period
+};
+
+struct PpsPhaseStats {
+  uint32_t pairs;
+  uint32_t unpaired;       // Edges with no partner on the other input
+  int64_t last_ticks;      // input 1 - input 0 (positive: input 1 later)
+  int64_t min_ticks;
+  int64_t max_ticks;
+  double mean_ticks;
+  double rms_ticks;        // Standard deviation of the difference
+};
+
+class PpsComparator {
+public:
+  static const uint8_t MAX_INPUTS = 2;  // GPT2 has two capture channels
+
+  explicit PpsComparator(uint32_t nominal_ticks);
+
+  void reset();
+  void add_edge(uint8_t input, uint64_t timestamp);
+
+  const PpsInputStats& get_input(uint8_t input) const;
+  bool get_input_ppb(uint8_t input, double& ppb) const;  // Mean frequency vs the oscillator
+  const PpsPhaseStats& get_phase() const { return phase; }
+  const StabilityEngine& get_stability() const { return stability; }
+
+private:
+  struct Input {
+    PpsInputStats stats;
+    double m2;
+    uint64_t last_edge;
+    bool have_edge;
+    bool paired;          // last_edge already has a partner
+  };
+
+  void add_pair(int64_t difference, uint64_t reference_edge);
+
+  uint32_t nominal;
+  Input inputs[MAX_INPUTS];
+  PpsPhaseStats phase;
+  double phase_m2;
+  bool have_pair;
+  int64_t last_difference;
+  uint64_t last_pair_edge;  // Input 0 edge of the previous pair
+  StabilityEngine stability;
+};
@@ -0,0 +1,140 @@
+#include "PpsSampleFilter.h"
+#include <string.h>
+
+PpsSampleFilter::PpsSampleFilter(uint32_t nominal_ticks) : nominal(nominal_ticks) {
+  reset();
+}
+
+void PpsSampleFilter::reset() {
+  memset(&stats, 0, sizeof(stats));
+  have_anchor = false;
+  anchor = 0;
+  rejects = 0;
+  history_head = 0;
+  history_count = 0;
+  update_expected();
+}
+
+void PpsSampleFilter::restart(uint64_t timestamp, bool clear_history) {
+  stats.restarts++;
+  anchor = timestamp;
+  rejects = 0;
+  if (clear_history) {
+    history_head = 0;
+    history_count = 0;
+    update_expected();
+  }
+}
+
+// Insertion sort: at most HISTORY values, once per accepted second
+static void sort_values(int32_t* values, uint8_t count) {
+  for (uint8_t i = 1; i < count; i++) {
+    int32_t v = values[i];
+    uint8_t j = i;
+    for (; j > 0 && values[j - 1] > v; j--) {
+      values[j] = values[j - 1];
+    }
+    values[j] = v;
+  }
+}
+
+static int32_t sorted_median(const int32_t* values, uint8_t count) {
+  if (count % 2) {
+    return values[count / 2];
+  }
+  int64_t sum = (int64_t)values[count / 2 - 1] + values[count / 2];
+  return (int32_t)(sum >= 0 ? sum / 2 : (sum - 1) / 2);
+}
+
+void PpsSampleFilter::update_expected() {
+  if (history_count < MIN_HISTORY) {
+    expected = nominal;
+    tolerance = nominal / 100;
+    stats.median_ticks = 0;
+    stats.mad_ticks = 0;
+    stats.tolerance_ticks = tolerance;
+    return;
+  }
+  int32_t values[HISTORY];
+  memcpy(values, history, history_count * sizeof(int32_t));
+  sort_values(values, history_count);
+  int32_t median = sorted_median(values, history_count);
+  for (uint8_t i = 0; i < history_count; i++) {
+    int32_t d = history[i] - median;
+    values[i] = d < 0 ? -d : d;
+  }
+  sort_values(values, history_count);
+  uint32_t mad = (uint32_t)sorted_median(values, history_count);
+
+  expected = (uint32_t)((int64_t)nominal + median);
+  tolerance = mad * MAD_SCALE_TENTHS / 10;
+  if (tolerance < MIN_TOLERANCE) tolerance = MIN_TOLERANCE;
+  if (tolerance > nominal / 100) tolerance = nominal / 100;
+  stats.median_ticks = median;
+  stats.mad_ticks = mad;
+  stats.tolerance_ticks = tolerance;
+}
+
+PpsSample PpsSampleFilter::add_edge(uint64_t timestamp) {
+  PpsSample sample = {PPS_SAMPLE_FIRST, 0, 0, 0};
+  stats.edges++;
+  if (!have_anchor) {
+    have_anchor = true;
+    anchor = timestamp;
+    return sample;
+  }
+
+  uint64_t interval = timestamp - anchor;
+  uint64_t n = (interval + expected / 2) / expected;
+  sample.interval = interval;
+  sample.error = (int64_t)interval - (int64_t)(n ? n : 1) * expected;
+
+  if (n > MAX_BRIDGE) {
+    // An outage: too long to bridge with confidence; the grid survives it
+    sample.type = PPS_SAMPLE_RESTART;
+    restart(timestamp, false);
+    return sample;
+  }
+  int64_t limit = (int64_t)tolerance * (int64_t)n;
+  if (n == 0 || sample.error > limit || sample.error < -limit) {
+    stats.rejected++;
+    if (++rejects >= MAX_REJECTS) {
+      sample.type = PPS_SAMPLE_RESTART;
+      restart(timestamp, true);
+    } else {
+      sample.type = PPS_SAMPLE_REJECTED;
+    }
+    return sample;
+  }
+
+  sample.periods = (uint32_t)n;
+  if (n > 1) {
+    sample.type = PPS_SAMPLE_SPLIT;
+    stats.split++;
+    stats.missed_edges += (uint32_t)(n - 1);
+  } else if (rejects > 0) {
+    sample.type = PPS_SAMPLE_MERGED;
+    stats.merged++;
+  } else {
+    sample.type = PPS_SAMPLE_ACCEPTED;
+    stats.accepted++;
+  }
+  anchor = timestamp;
+  rejects = 0;
+
+  int64_t mean = ((int64_t)interval + (int64_t)n / 2) / (int64_t)n;
+  history[history_head] = (int32_t)(mean - nominal);
+  history_head = (uint8_t)((history_head + 1) % HISTORY);
+  if (history_count < HISTORY) history_count++;
+  update_expected();
+  return sample;
+}
+
+uint32_t PpsSampleFilter::period_ticks(const PpsSample& sample, uint32_t k) {
+  if (sample.periods == 0) {
+    return 0;
+  }
+  uint64_t base = sample.interval / sample.periods;
+  uint32_t extra = (uint32_t)(sample.interval % sample.periods);
+  return (uint32_t)(base + (k < extra ? 1 : 0));
+}
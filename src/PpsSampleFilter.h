@@ -0,0 +1,89 @@
+#pragma once
+#include <stdint.h>
+
+// Outlier rejection and glitch repair between the PPS captures and the
+// period consumers (FrequencyStats, StabilityEngine, PhaseRegression,
+// DiscipliningLoop).
+//
+// The expected period and its spread come from the median and MAD (median
+// absolute deviation) of the last HISTORY accepted periods, so one wild value
+// cannot pull them. Each edge is measured against the last good edge (the
+// anchor): an interval within tolerance of n expected periods is accepted
+// (n = 1) or, for n = 2..MAX_BRIDGE, is a run of missed edges and is split
+// into n periods that add up to it exactly. Any other edge is off the grid:
+// an extra edge (noise, a double trigger) or a pulse too late or too early to
+// trust. It is dropped without moving the anchor, so the next good edge
+// closes the interval as if it had never been there, and that interval is
+// counted as merged.
+//
+// Until MIN_HISTORY periods are known, and after a restart, the old rule
+// applies: within 1% of nominal. MAX_REJECTS off-grid edges in a row mean the
+// grid itself has moved (a frequency step or a glitch taken as anchor), and
+// an interval longer than MAX_BRIDGE periods is an outage; both restart from
+// the current edge, and the caller must break phase continuity (mark_gap).
+
+enum PpsSampleClass : uint8_t {
+  PPS_SAMPLE_FIRST = 0,   // First edge: anchor only
+  PPS_SAMPLE_ACCEPTED,    // One clean period
+  PPS_SAMPLE_MERGED,      // One period, after dropping off-grid edges inside it
+  PPS_SAMPLE_SPLIT,       // Missed edges bridged: `periods` periods
+  PPS_SAMPLE_REJECTED,    // Off the grid, dropped; nothing to process
+  PPS_SAMPLE_RESTART,     // Continuity lost; nothing to process, anchor moved here
+};
+
+struct PpsSample {
+  PpsSampleClass type;
+  uint32_t periods;       // Periods to process (0, 1 or the bridged count)
+  uint64_t interval;      // Ticks since the previous anchor
+  int64_t error;          // interval - periods * expected (or vs. one period when rejected)
+};
+
+struct PpsFilterStats {
+  uint32_t edges;
+  uint32_t accepted;      // Clean intervals
+  uint32_t merged;        // Intervals closed after dropping edges inside them
+  uint32_t split;         // Intervals bridged over missed edges
+  uint32_t missed_edges;  // Edges filled in by those splits
+  uint32_t rejected;      // Edges dropped as off the grid
+  uint32_t restarts;
+  int32_t median_ticks;   // Expected period - nominal
+  uint32_t mad_ticks;
+  uint32_t tolerance_ticks;
+};
+
+class PpsSampleFilter {
+public:
+  static const uint8_t HISTORY = 15;          // Periods behind the median/MAD
+  static const uint8_t MIN_HISTORY = 5;
+  static const uint32_t MIN_TOLERANCE = 10;   // Ticks (1 us): tick quantization plus receiver jitter
+  static const uint8_t MAD_SCALE_TENTHS = 74; // 5 sigma: 5 * 1.4826 * MAD
+  static const uint8_t MAX_BRIDGE = 10;       // Seconds of missed edges repaired
+  static const uint8_t MAX_REJECTS = 3;
+
+  explicit PpsSampleFilter(uint32_t nominal_ticks);
+
+  void reset();
+  PpsSample add_edge(uint64_t timestamp);
+
+  // Period k (0-based) of a sample: the interval split into `periods` whole
+  // ticks that sum to it exactly
+  static uint32_t period_ticks(const PpsSample& sample, uint32_t k);
+
+  const PpsFilterStats& get_stats() const { return stats; }
+  uint32_t get_nominal() const { return nominal; }
+
+private:
+  void update_expected();
+  void restart(uint64_t timestamp, bool clear_history);
+
+  uint32_t nominal;
+  PpsFilterStats stats;
+  bool have_anchor;
+  uint64_t anchor;
+  uint8_t rejects;         // Off-grid edges since the anchor
+  int32_t history[HISTORY];  // Accepted periods - nominal
+  uint8_t history_head;
+  uint8_t history_count;
+  uint32_t expected;       // Median period
+  uint32_t tolerance;
+};
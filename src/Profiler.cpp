@@ -0,0 +1,173 @@
+#include "Profiler.h"
+#include <Arduino.h>
+#include <string.h>
+#if !defined(__IMXRT1062__)
+#include <chrono>
+#endif
+
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+  "serial", "gpt2_poll", "pps", "discipline", "nmea", "log_record", "sd_service", "mtp", "display",
+  "telemetry",
+};
+
+struct ProfileFrame {
+  uint8_t stage;
+  uint32_t start;
+  uint32_t nested;  // Cycles spent in stages nested inside this one
+};
+
+static ProfileStageStats s_stages[PROFILE_STAGE_COUNT];
+static ProfileStageStats s_loop;
+static ProfileWorstLoop s_worst;
+static bool s_have_worst = false;
+static uint32_t s_iteration_cycles[PROFILE_STAGE_COUNT];  // Exclusive, current iteration
+static ProfileFrame s_stack[PROFILE_MAX_DEPTH];
+static uint8_t s_depth = 0;
+static uint8_t s_skipped = 0;     // Enters past the stack depth still to be matched by exits
+static uint32_t s_overflows = 0;
+static uint32_t s_loop_start = 0;
+static bool s_in_loop = false;
+static uint32_t s_iterations = 0;
+
+uint32_t profiler_cycles() {
+#if defined(__IMXRT1062__)
+  return ARM_DWT_CYCCNT;
+#else
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint32_t profiler_cycles_per_us() {
+#if defined(__IMXRT1062__)
+  return F_CPU_ACTUAL / 1000000;
+#else
+  return 1000;
+#endif
+}
+
+static void clear_stats(ProfileStageStats& stats) {
+  memset(&stats, 0, sizeof(stats));
+  stats.min_cycles = 0xFFFFFFFF;
+}
+
+void profiler_reset() {
+  for (uint8_t i = 0; i < PROFILE_STAGE_COUNT; i++) {
+    clear_stats(s_stages[i]);
+  }
+  clear_stats(s_loop);
+  memset(&s_worst, 0, sizeof(s_worst));
+  s_have_worst = false;
+  s_overflows = 0;
+  s_iterations = 0;
+  // An iteration in progress keeps running; it is simply not counted as the worst
+  memset(s_iteration_cycles, 0, sizeof(s_iteration_cycles));
+  s_in_loop = false;
+}
+
+void profiler_begin() {
+#if defined(__IMXRT1062__)
+  // The core normally starts it already; make sure it runs
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+  s_depth = 0;
+  s_skipped = 0;
+  profiler_reset();
+}
+
+static void record(ProfileStageStats& stats, uint32_t cycles) {
+  stats.count++;
+  stats.total_cycles += cycles;
+  if (cycles < stats.min_cycles) stats.min_cycles = cycles;
+  if (cycles > stats.max_cycles) stats.max_cycles = cycles;
+  uint8_t bucket = cycles == 0 ? 0 : (uint8_t)(31 - __builtin_clz(cycles));
+  stats.histogram[bucket]++;
+}
+
+void profiler_loop_start() {
+  memset(s_iteration_cycles, 0, sizeof(s_iteration_cycles));
+  s_loop_start = profiler_cycles();
+  s_in_loop = true;
+}
+
+void profiler_loop_end() {
+  uint32_t cycles = profiler_cycles() - s_loop_start;
+  if (!s_in_loop) {
+    return;  // Reset mid-iteration
+  }
+  s_in_loop = false;
+  s_iterations++;
+  record(s_loop, cycles);
+  if (s_have_worst && cycles <= s_worst.cycles) {
+    return;
+  }
+
+  uint8_t culprit = 0;
+  for (uint8_t i = 1; i < PROFILE_STAGE_COUNT; i++) {
+    if (s_iteration_cycles[i] > s_iteration_cycles[culprit]) {
+      culprit = i;
+    }
+  }
+  s_worst.cycles = cycles;
+  s_worst.iteration = s_iterations;
+  s_worst.at_ms = millis();
+  s_worst.stage = culprit;
+  memcpy(s_worst.stage_cycles, s_iteration_cycles, sizeof(s_iteration_cycles));
+  s_have_worst = true;
+}
+
+void profiler_enter(ProfileStage stage) {
+  if (s_depth >= PROFILE_MAX_DEPTH || s_skipped > 0) {
+    s_skipped++;
+    s_overflows++;
+    return;
+  }
+  ProfileFrame& frame = s_stack[s_depth++];
+  frame.stage = stage;
+  frame.nested = 0;
+  frame.start = profiler_cycles();
+}
+
+void profiler_exit() {
+  uint32_t now = profiler_cycles();
+  if (s_skipped > 0) {
+    s_skipped--;
+    return;
+  }
+  if (s_depth == 0) {
+    return;  // Unbalanced exit
+  }
+  ProfileFrame& frame = s_stack[--s_depth];
+  uint32_t cycles = now - frame.start;
+  record(s_stages[frame.stage], cycles);
+  s_iteration_cycles[frame.stage] += cycles - frame.nested;
+  if (s_depth > 0) {
+    s_stack[s_depth - 1].nested += cycles;
+  }
+}
+
+const char* profiler_stage_name(uint8_t stage) {
+  return stage < PROFILE_STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+void profiler_get_stage(uint8_t stage, ProfileStageStats& stats) {
+  if (stage >= PROFILE_STAGE_COUNT) {
+    clear_stats(stats);
+    return;
+  }
+  stats = s_stages[stage];
+}
+
+void profiler_get_loop(ProfileStageStats& stats) {
+  stats = s_loop;
+}
+
+bool profiler_get_worst_loop(ProfileWorstLoop& worst) {
+  worst = s_worst;
+  return s_have_worst;
+}
+
+uint32_t profiler_get_overflows() {
+  return s_overflows;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+// Cycle-accurate profiler for the stages of loop().
+//
+// Timestamps come from the Cortex-M7 DWT cycle counter (one count per CPU
+// cycle, a single load), or from std::chrono in host builds where a "cycle"
+// is one nanosecond. Each stage keeps count/min/max/total and a log2
+// histogram (bucket b holds durations of 2^b .. 2^(b+1)-1 cycles), all
+// inclusive of nested stages. Per loop iteration the time is also attributed
+// exclusively (a nested stage is taken out of its parent), and the slowest
+// iteration is kept with that breakdown and the stage that dominated it.
+//
+// Stages nest up to PROFILE_MAX_DEPTH deep. Only call from loop() context:
+// the ISR is not profiled and the state is not interrupt-safe.
+
+enum ProfileStage : uint8_t {
+  PROFILE_SERIAL_COMMANDS = 0,
+  PROFILE_GPT2_POLL,
+  PROFILE_PPS_PROCESSING,
+  PROFILE_DISCIPLINE,
+  PROFILE_NMEA,
+  PROFILE_LOG_RECORD,      // Formatting and queueing a log record (inside NMEA)
+  PROFILE_SD_SERVICE,
+  PROFILE_MTP,             // MTP.loop()
+  PROFILE_DISPLAY,
+  PROFILE_TELEMETRY,
+  PROFILE_STAGE_COUNT
+};
+
+static const uint8_t PROFILE_HISTOGRAM_BUCKETS = 32;
+static const uint8_t PROFILE_MAX_DEPTH = 4;
+
+struct ProfileStageStats {
+  uint32_t count;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint32_t histogram[PROFILE_HISTOGRAM_BUCKETS];
+};
+
+struct ProfileWorstLoop {
+  uint32_t cycles;          // Whole iteration, loop start to loop end
+  uint32_t iteration;       // Loop iterations since the last reset
+  uint32_t at_ms;
+  uint8_t stage;            // Stage with the most exclusive time in it
+  uint32_t stage_cycles[PROFILE_STAGE_COUNT];  // Exclusive, per stage
+};
+
+void profiler_begin();                 // Starts the cycle counter and clears everything
+void profiler_reset();
+uint32_t profiler_cycles();
+uint32_t profiler_cycles_per_us();
+
+void profiler_loop_start();
+void profiler_loop_end();
+void profiler_enter(ProfileStage stage);
+void profiler_exit();
+
+const char* profiler_stage_name(uint8_t stage);
+void profiler_get_stage(uint8_t stage, ProfileStageStats& stats);
+void profiler_get_loop(ProfileStageStats& stats);   // Whole iterations
+bool profiler_get_worst_loop(ProfileWorstLoop& worst);
+uint32_t profiler_get_overflows();     // Enters beyond PROFILE_MAX_DEPTH (not timed)
+
+// Times the enclosing block, including early returns
+class ProfileScope {
+public:
+  explicit ProfileScope(ProfileStage stage) { profiler_enter(stage); }
+  ~ProfileScope() { profiler_exit(); }
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,172 @@
+#include "SawtoothCorrector.h"
+#include <string.h>
+
+static const uint32_t NO_TOW = 0xFFFFFFFF;
+
+SawtoothCorrector::SawtoothCorrector(uint32_t nominal_ticks)
+    : tick_ps((uint32_t)(1000000000000ULL / nominal_ticks)) {
+  reset();
+}
+
+void SawtoothCorrector::reset() {
+  for (uint8_t i = 0; i < REPORTS; i++) {
+    reports[i].tow_ms = NO_TOW;
+    reports[i].used = false;
+  }
+  report_next = 0;
+  edge_count = 0;
+  locked = false;
+  last_tow = 0;
+  mismatches = 0;
+  has_pending = false;
+  has_previous = false;
+  bridged_periods = 0;
+  queue_head = 0;
+  queue_count = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+const SawtoothCorrector::Report* SawtoothCorrector::find_report(uint32_t tow_ms) const {
+  for (uint8_t i = 0; i < REPORTS; i++) {
+    if (reports[i].tow_ms == tow_ms) {
+      return &reports[i];
+    }
+  }
+  return nullptr;
+}
+
+void SawtoothCorrector::add_report(uint32_t tow_ms, int32_t qerr_ps, bool valid) {
+  stats.reports++;
+  if (!valid) {
+    stats.invalid++;
+  } else {
+    if (stats.reports - stats.invalid == 1 || qerr_ps < stats.min_qerr_ps) stats.min_qerr_ps = qerr_ps;
+    if (stats.reports - stats.invalid == 1 || qerr_ps > stats.max_qerr_ps) stats.max_qerr_ps = qerr_ps;
+    stats.last_qerr_ps = qerr_ps;
+  }
+  tow_ms %= WEEK_MS;
+
+  Report& report = reports[report_next];
+  report_next = (uint8_t)((report_next + 1) % REPORTS);
+  report.tow_ms = tow_ms;
+  report.qerr_ps = qerr_ps;
+  report.edge = edge_count;
+  report.valid = valid;
+  report.used = false;
+
+  if (locked) {
+    // One of the next few pulses, or the one still waiting for its report
+    uint32_t ahead = (tow_ms + WEEK_MS - last_tow) % WEEK_MS;
+    bool late = ahead == 0 && has_pending && pending.timed;
+    if (late || (ahead % 1000 == 0 && ahead >= 1000 && ahead <= 3000)) {
+      mismatches = 0;
+    } else if (++mismatches >= MAX_MISMATCHES) {
+      locked = false;
+      mismatches = 0;
+      stats.lock_losses++;
+    }
+  }
+  if (has_pending && pending.timed && pending.tow_ms == tow_ms) {
+    resolve(&report);
+  }
+}
+
+void SawtoothCorrector::add_edge(uint64_t timestamp, uint32_t periods) {
+  stats.edges++;
+  if (has_pending) {
+    resolve(pending.timed ? find_report(pending.tow_ms) : nullptr);  // Its report never came
+  }
+  if (periods == 0) {
+    locked = false;  // A new chain: TOW unknown
+  }
+
+  if (locked) {
+    last_tow = (uint32_t)((last_tow + (uint64_t)periods * 1000) % WEEK_MS);
+  } else {
+    // TIM-TP comes ahead of its pulse: the report that arrived since the last edge is this one's
+    for (uint8_t k = 1; k <= REPORTS; k++) {
+      const Report& report = reports[(report_next + REPORTS - k) % REPORTS];  // Newest first
+      if (report.tow_ms != NO_TOW && report.edge == edge_count) {
+        last_tow = report.tow_ms;
+        locked = true;
+        mismatches = 0;
+        stats.locks++;
+        break;
+      }
+    }
+  }
+  edge_count++;
+
+  pending.timestamp = timestamp;
+  pending.tow_ms = locked ? last_tow : 0;
+  pending.periods = periods;
+  pending.timed = locked;
+  has_pending = true;
+  const Report* report = locked ? find_report(last_tow) : nullptr;
+  if (report != nullptr || !locked) {
+    resolve(report);
+  }
+}
+
+void SawtoothCorrector::resolve(const Report* report) {
+  bool matched = report != nullptr && report->valid && !report->used;
+  int32_t qerr_ps = matched ? report->qerr_ps : 0;
+  if (matched) {
+    reports[report - reports].used = true;
+    stats.matched++;
+  } else {
+    stats.unmatched++;
+  }
+  has_pending = false;
+  if (pending.periods == 0) {
+    has_previous = false;  // Starts a chain
+  }
+  uint32_t periods = bridged_periods + pending.periods;
+
+  if (has_previous && !matched && previous_matched && periods < MAX_BRIDGE) {
+    // Not an anchor: the next matched edge closes one corrected interval over
+    // both, so a lost report costs no step in the corrected phase
+    bridged_periods = periods;
+    stats.bridged++;
+    return;
+  }
+
+  if (has_previous) {
+    SawtoothInterval interval;
+    interval.tow_ms = pending.tow_ms;
+    interval.periods = periods;
+    interval.timestamp = pending.timestamp;
+    interval.ticks = pending.timestamp - previous_timestamp;
+    interval.corrected_ps = (int64_t)(interval.ticks * tick_ps);
+    interval.qerr_ps = qerr_ps;
+    interval.corrected = matched && previous_matched;
+    if (interval.corrected) {
+      // Each capture is late by its qErr
+      interval.corrected_ps -= (int64_t)qerr_ps - previous_qerr_ps;
+      stats.corrected++;
+    }
+    if (queue_count == QUEUE) {
+      queue_head = (uint8_t)((queue_head + 1) % QUEUE);  // Oldest goes
+      queue_count--;
+      stats.overflows++;
+    }
+    queue[(queue_head + queue_count) % QUEUE] = interval;
+    queue_count++;
+  }
+
+  previous_timestamp = pending.timestamp;
+  previous_qerr_ps = qerr_ps;
+  previous_matched = matched;
+  has_previous = true;
+  bridged_periods = 0;
+}
+
+bool SawtoothCorrector::pop(SawtoothInterval& interval) {
+  if (queue_count == 0) {
+    return false;
+  }
+  interval = queue[queue_head];
+  queue_head = (uint8_t)((queue_head + 1) % QUEUE);
+  queue_count--;
+  return true;
+}
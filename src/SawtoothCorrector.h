@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+
+// Removes the GPS receiver's PPS quantization error (the sawtooth) from the
+// capture timestamps.
+//
+// A receiver can only put its PPS edge on a tick of its own clock, so each
+// pulse is off the true second by up to half a receiver clock period (about
+// +-10-20 ns). u-blox receivers report that error ahead of the pulse, as qErr
+// in UBX-TIM-TP together with the pulse's GPS time of week. Taking it off the
+// matching capture leaves the oscillator's own phase:
+//
+//   corrected interval = raw interval - (qErr at its end - qErr at its start)
+//
+// Reports are matched to edges by time of week. Each edge from
+// PpsSampleFilter is given a TOW: the previous edge's plus one second per
+// period it closes. The first edge of a chain (periods 0: the first edge, or
+// a restart) takes the TOW of the report received since the edge before it,
+// since TIM-TP describes the next pulse. Reports wait in a short ring for
+// their edge, and an edge whose report has not been parsed yet waits for it
+// until the next edge, so a message read a little late still applies.
+//
+// An edge left without a report (lost, corrupted, flagged invalid) is
+// bridged like a missed PPS edge: the interval runs from the last matched
+// edge to the next one, corrected at both ends, so the corrected phase takes
+// no step there. Only when there is no matched edge to bridge from (no
+// reports, no lock, or MAX_BRIDGE seconds without one) do intervals come out
+// raw, with corrected false.
+//
+// While locked, each report should be for one of the next few seconds; three
+// in a row that are not drop the lock and the next edge takes its TOW afresh.
+// Intervals come out in order through pop(), in picoseconds (exact integers,
+// as the raw ticks are).
+
+struct SawtoothInterval {
+  uint32_t tow_ms;        // GPS time of week of the closing edge (0 when not locked)
+  uint32_t periods;       // Seconds in the interval (>1: missed edges or reports bridged)
+  uint64_t timestamp;     // Capture closing the interval (extended timebase)
+  uint64_t ticks;         // Raw, between the two captures
+  int64_t corrected_ps;   // Raw in ps minus the change of qErr; the raw length when not corrected
+  int32_t qerr_ps;        // Of the closing edge (0 when unmatched)
+  bool corrected;
+};
+
+struct SawtoothStats {
+  uint32_t reports;       // TIM-TP messages received
+  uint32_t invalid;       // ... flagged qErr invalid by the receiver
+  uint32_t edges;
+  uint32_t matched;       // Edges with their qErr
+  uint32_t unmatched;     // Edges without a usable report
+  uint32_t bridged;       // ... spanned by a corrected interval instead
+  uint32_t corrected;     // Intervals with both ends matched
+  uint32_t locks;         // TOW (re)acquisitions
+  uint32_t lock_losses;
+  uint32_t overflows;     // Intervals dropped because nobody popped them
+  int32_t last_qerr_ps;
+  int32_t min_qerr_ps;    // Since the last reset
+  int32_t max_qerr_ps;
+};
+
+class SawtoothCorrector {
+public:
+  static const uint8_t REPORTS = 8;          // Reports waiting for their edge
+  static const uint8_t QUEUE = 8;            // Intervals waiting for pop()
+  static const uint8_t MAX_MISMATCHES = 3;
+  static const uint8_t MAX_BRIDGE = 10;      // Seconds a corrected interval may span
+  static const uint32_t WEEK_MS = 604800000;
+
+  explicit SawtoothCorrector(uint32_t nominal_ticks);
+
+  void reset();
+  void add_report(uint32_t tow_ms, int32_t qerr_ps, bool valid);
+  // periods from PpsSampleFilter: 0 starts a new chain
+  void add_edge(uint64_t timestamp, uint32_t periods);
+  bool pop(SawtoothInterval& interval);
+
+  bool is_locked() const { return locked; }
+  uint32_t get_tow_ms() const { return last_tow; }
+  const SawtoothStats& get_stats() const { return stats; }
+
+private:
+  struct Report {
+    uint32_t tow_ms;
+    int32_t qerr_ps;
+    uint32_t edge;        // Index of the edge that followed it
+    bool valid;
+    bool used;
+  };
+
+  struct Edge {
+    uint64_t timestamp;
+    uint32_t tow_ms;
+    uint32_t periods;
+    bool timed;           // tow_ms is known (locked when it arrived)
+  };
+
+  const Report* find_report(uint32_t tow_ms) const;
+  void resolve(const Report* report);
+
+  uint32_t tick_ps;
+  Report reports[REPORTS];
+  uint8_t report_next;
+  uint32_t edge_count;
+  bool locked;
+  uint32_t last_tow;
+  uint8_t mismatches;
+  Edge pending;
+  bool has_pending;
+  bool has_previous;
+  uint64_t previous_timestamp;
+  int32_t previous_qerr_ps;
+  bool previous_matched;
+  uint32_t bridged_periods;  // Since the previous edge, over unmatched edges
+  SawtoothInterval queue[QUEUE];
+  uint8_t queue_head;
+  uint8_t queue_count;
+  SawtoothStats stats;
+};
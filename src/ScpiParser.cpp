@@ -0,0 +1,94 @@
+#include "ScpiParser.h"
+
+static bool is_space(char c) {
+  return c == ' ' || c == '\t';
+}
+
+static bool is_header_char(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == ':' || c == '*';
+}
+
+static char to_upper(char c) {
+  return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+bool ScpiLine::next(ScpiCommand& command) {
+  for (;;) {
+    const char* p = next_char;
+    while (is_space(*p)) p++;
+    if (*p == '\0') {
+      next_char = p;
+      return false;
+    }
+    const char* end = p;
+    while (*end != '\0' && *end != ';') end++;
+    next_char = *end == ';' ? end + 1 : end;
+    if (end == p) {
+      continue;  // Empty command between two ';'
+    }
+
+    if (*p == ':') p++;
+    command.header = p;
+    command.valid = true;
+    while (p < end && !is_space(*p) && *p != '?') {
+      if (!is_header_char(*p)) command.valid = false;
+      p++;
+    }
+    size_t header_length = (size_t)(p - command.header);
+    command.header_length = (uint8_t)(header_length > 255 ? 255 : header_length);
+    command.query = p < end && *p == '?';
+    if (command.query) p++;
+
+    while (p < end && is_space(*p)) p++;
+    const char* args_end = end;
+    while (args_end > p && is_space(args_end[-1])) args_end--;
+    command.args = p;
+    size_t args_length = (size_t)(args_end - p);
+    command.args_length = (uint8_t)(args_length > 255 ? 255 : args_length);
+    return true;
+  }
+}
+
+// One keyword of the pattern against one of the header: the short form (the
+// pattern's upper-case prefix) or the whole long form
+static bool keyword_match(const char* pattern, size_t pattern_length, const char* word, size_t word_length) {
+  size_t short_length = 0;
+  while (short_length < pattern_length &&
+         !(pattern[short_length] >= 'a' && pattern[short_length] <= 'z')) {
+    short_length++;
+  }
+  if (word_length != short_length && word_length != pattern_length) {
+    return false;
+  }
+  for (size_t i = 0; i < word_length; i++) {
+    if (to_upper(word[i]) != to_upper(pattern[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool scpi_match(const char* pattern, const ScpiCommand& command) {
+  if (!command.valid) {
+    return false;
+  }
+  if (*pattern == ':') pattern++;
+  const char* word = command.header;
+  const char* header_end = command.header + command.header_length;
+  for (;;) {
+    const char* pattern_end = pattern;
+    while (*pattern_end != '\0' && *pattern_end != ':') pattern_end++;
+    const char* word_end = word;
+    while (word_end < header_end && *word_end != ':') word_end++;
+    if (!keyword_match(pattern, (size_t)(pattern_end - pattern), word, (size_t)(word_end - word))) {
+      return false;
+    }
+    bool pattern_done = *pattern_end == '\0';
+    bool header_done = word_end == header_end;
+    if (pattern_done || header_done) {
+      return pattern_done && header_done;
+    }
+    pattern = pattern_end + 1;
+    word = word_end + 1;
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Tokenizer and header matching for the machine query protocol on the
+// console: SCPI-like lines such as
+//
+//   :MEAS:FREQ?;:GPS?;*IDN?
+//
+// A line holds commands separated by ';'. Each command is a header
+// (keywords joined by ':', an optional leading ':' or '*'), an optional '?'
+// making it a query, and optional arguments after whitespace. Unlike full
+// SCPI, every command carries its full path (no implied prefix after ';').
+//
+// Headers are matched against patterns written the SCPI way: the upper-case
+// part of each keyword is the short form, and either the short or the whole
+// long form is accepted, case-insensitively ("MEASure:FREQuency" matches
+// MEAS:FREQ, measure:frequency, Meas:Frequency, but not MEASU:FREQ).
+
+struct ScpiCommand {
+  const char* header;     // Without the leading ':'; not NUL-terminated
+  uint8_t header_length;
+  bool query;
+  const char* args;       // Trimmed; not NUL-terminated
+  uint8_t args_length;
+  bool valid;             // false: characters outside [A-Za-z0-9:*] in the header
+};
+
+class ScpiLine {
+public:
+  explicit ScpiLine(const char* text) : next_char(text) {}
+
+  // The next non-empty command; false at the end of the line
+  bool next(ScpiCommand& command);
+
+private:
+  const char* next_char;
+};
+
+bool scpi_match(const char* pattern, const ScpiCommand& command);
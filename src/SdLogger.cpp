@@ -0,0 +1,93 @@
+#include "SdLogger.h"
+#include <SD.h>
+#include <MTP_Teensy.h>
+#include "SectorLogWriter.h"
+
+static const uint32_t LOG_WRITE_BUDGET_US = 2000;  // Per service call, beyond the first sector
+static const uint32_t MTP_MAX_DEFER_MS = 100;      // MTP still runs at least this often
+
+static File s_log_file;
+static char s_file_name[32] = "";
+static SectorLogWriter s_writer;
+static uint32_t s_records_queued = 0;
+static bool s_card_busy = false;  // The last writer slice left the card mid-operation
+static uint32_t s_last_mtp_ms = 0;
+static uint32_t s_mtp_calls = 0;
+static uint32_t s_mtp_deferred = 0;
+static uint32_t s_max_mtp_us = 0;
+
+bool sd_logger_open(const char* filename, uint8_t pad_byte) {
+  sd_logger_close();
+  s_log_file = SD.open(filename, FILE_WRITE);
+  if (!s_log_file) {
+    return false;
+  }
+  strncpy(s_file_name, filename, sizeof(s_file_name) - 1);
+  s_file_name[sizeof(s_file_name) - 1] = '\0';
+  s_writer.begin(&s_log_file, pad_byte);
+  return true;
+}
+
+void sd_logger_close() {
+  if (!s_log_file) return;
+  s_writer.end();
+  s_log_file.close();
+  s_file_name[0] = '\0';
+}
+
+bool sd_logger_is_open() {
+  return s_writer.active();
+}
+
+const char* sd_logger_file_name() {
+  return s_file_name;
+}
+
+bool sd_logger_write(const void* data, size_t len) {
+  if (!s_writer.append(data, len)) {
+    return false;
+  }
+  s_records_queued++;
+  return true;
+}
+
+void sd_logger_service() {
+  s_card_busy = s_writer.service(millis(), LOG_WRITE_BUDGET_US);
+}
+
+void sd_logger_service_mtp() {
+  // MTP shares the card with the writer: keep the two out of the same slice,
+  // and let a log backlog drain first, but never starve the host for long
+  uint32_t now = millis();
+  bool backlog = s_writer.queued_sectors() > 0;
+  if ((s_card_busy || backlog) && (now - s_last_mtp_ms) < MTP_MAX_DEFER_MS) {
+    s_mtp_deferred++;
+    return;
+  }
+  s_card_busy = false;
+
+  uint32_t start_us = micros();
+  MTP.loop();
+  uint32_t elapsed_us = micros() - start_us;
+  if (elapsed_us > s_max_mtp_us) {
+    s_max_mtp_us = elapsed_us;
+  }
+  s_mtp_calls++;
+  s_last_mtp_ms = now;
+}
+
+void sd_logger_get_stats(SdLoggerStats& stats) {
+  stats.records_queued = s_records_queued;
+  stats.records_dropped = s_writer.records_dropped();
+  stats.bytes_queued = s_writer.bytes_appended();
+  stats.sectors_written = s_writer.sectors_written();
+  stats.pad_bytes = s_writer.pad_bytes();
+  stats.syncs = s_writer.syncs();
+  stats.write_errors = s_writer.write_errors();
+  stats.queue_high_water = s_writer.queue_high_water();
+  stats.queue_capacity = SectorLogWriter::SECTOR_COUNT - 1;
+  stats.max_write_us = s_writer.max_write_us();
+  stats.mtp_calls = s_mtp_calls;
+  stats.mtp_deferred = s_mtp_deferred;
+  stats.max_mtp_us = s_max_mtp_us;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// SD card logging subsystem.
+//
+// Owns the log file and an asynchronous SectorLogWriter. Records are queued
+// in RAM from anywhere in loop() and written in bounded time slices from
+// sd_logger_service(). sd_logger_service_mtp() runs MTP.loop(), deferring it
+// while the writer has a backlog so that MTP transfers and log writes never
+// pile up back to back. Capture and compare timing runs from the GPT2 ISR,
+// so even a 100+ ms card stall only delays logging.
+
+struct SdLoggerStats {
+  uint32_t records_queued;
+  uint32_t records_dropped;    // Queue full: the card fell too far behind
+  uint32_t bytes_queued;
+  uint32_t sectors_written;
+  uint32_t pad_bytes;
+  uint32_t syncs;
+  uint32_t write_errors;
+  uint32_t queue_high_water;   // Sectors
+  uint32_t queue_capacity;     // Sectors
+  uint32_t max_write_us;       // Slowest single sector write
+  uint32_t mtp_calls;
+  uint32_t mtp_deferred;       // Passes where MTP yielded to a log backlog
+  uint32_t max_mtp_us;         // Slowest MTP.loop()
+};
+
+bool sd_logger_open(const char* filename, uint8_t pad_byte);
+void sd_logger_close();
+bool sd_logger_is_open();
+const char* sd_logger_file_name();
+
+bool sd_logger_write(const void* data, size_t len);  // Queues one record, never blocks
+void sd_logger_service();
+void sd_logger_service_mtp();  // Only when an SD card (and so MTP) is available
+void sd_logger_get_stats(SdLoggerStats& stats);
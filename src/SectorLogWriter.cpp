@@ -0,0 +1,121 @@
+#include "SectorLogWriter.h"
+
+SectorLogWriter::SectorLogWriter()
+    : file(nullptr), fill_index(0), fill(0), ready_head(0), ready_count(0), pad(0),
+      first_pending_ms(0), last_sync_ms(0), unsynced_sectors(0), max_pending_ms(30000),
+      sectors_per_sync(8), sector_count(0), byte_count(0), padding_count(0), sync_count(0),
+      error_count(0), dropped_count(0), high_water(0), worst_write_us(0) {
+}
+
+void SectorLogWriter::begin(File* log_file, uint8_t pad_byte) {
+  file = log_file;
+  pad = pad_byte;
+  fill_index = 0;
+  fill = 0;
+  ready_head = 0;
+  ready_count = 0;
+  unsynced_sectors = 0;
+  last_sync_ms = millis();
+}
+
+void SectorLogWriter::end() {
+  if (!file) return;
+  if (fill > 0) {
+    queue_fill_sector();
+  }
+  while (ready_count > 0) {
+    write_sector();
+  }
+  file->flush();
+  sync_count++;
+  file = nullptr;
+}
+
+void SectorLogWriter::set_flush_policy(uint32_t pending_ms, uint32_t sync_sectors) {
+  max_pending_ms = pending_ms;
+  sectors_per_sync = sync_sectors > 0 ? sync_sectors : 1;
+}
+
+bool SectorLogWriter::append(const void* data, size_t len) {
+  if (!file) return false;
+
+  // Free space: the rest of the fill sector plus every sector not queued or
+  // filling. The last byte is kept back so a fill sector always exists.
+  size_t free_sectors = SECTOR_COUNT - 1 - ready_count;
+  if (len >= (BINLOG_SECTOR_SIZE - fill) + free_sectors * BINLOG_SECTOR_SIZE) {
+    dropped_count++;
+    return false;
+  }
+
+  const uint8_t* bytes = (const uint8_t*)data;
+  while (len > 0) {
+    if (fill == 0) {
+      first_pending_ms = millis();
+    }
+    size_t chunk = BINLOG_SECTOR_SIZE - fill;
+    if (chunk > len) chunk = len;
+    memcpy(sectors[fill_index] + fill, bytes, chunk);
+    fill += chunk;
+    bytes += chunk;
+    len -= chunk;
+    byte_count += chunk;
+    if (fill == BINLOG_SECTOR_SIZE) {
+      queue_fill_sector();
+    }
+  }
+  return true;
+}
+
+bool SectorLogWriter::service(uint32_t now_ms, uint32_t budget_us) {
+  if (!file) return false;
+  if (fill > 0 && (now_ms - first_pending_ms) >= max_pending_ms && ready_count < SECTOR_COUNT - 1) {
+    queue_fill_sector();  // Bounded loss: don't hold a partial sector forever
+  }
+
+  uint32_t start_us = micros();
+  bool touched = false;
+  while (ready_count > 0) {
+    if (touched && (micros() - start_us) >= budget_us) break;
+    write_sector();
+    touched = true;
+  }
+
+  if (!touched && unsynced_sectors > 0 &&
+      (unsynced_sectors >= sectors_per_sync || (now_ms - last_sync_ms) >= max_pending_ms)) {
+    file->flush();
+    sync_count++;
+    unsynced_sectors = 0;
+    last_sync_ms = now_ms;
+    touched = true;
+  }
+  return touched;
+}
+
+void SectorLogWriter::queue_fill_sector() {
+  if (fill < BINLOG_SECTOR_SIZE) {
+    // Padding keeps every later write sector-aligned
+    memset(sectors[fill_index] + fill, pad, BINLOG_SECTOR_SIZE - fill);
+    padding_count += BINLOG_SECTOR_SIZE - fill;
+  }
+  ready_count++;
+  if (ready_count > high_water) {
+    high_water = ready_count;
+  }
+  fill_index = (fill_index + 1) % SECTOR_COUNT;
+  fill = 0;
+}
+
+void SectorLogWriter::write_sector() {
+  uint32_t start_us = micros();
+  if (file->write(sectors[ready_head], BINLOG_SECTOR_SIZE) != BINLOG_SECTOR_SIZE) {
+    error_count++;
+  }
+  uint32_t elapsed_us = micros() - start_us;
+  if (elapsed_us > worst_write_us) {
+    worst_write_us = elapsed_us;
+  }
+  ready_head = (ready_head + 1) % SECTOR_COUNT;
+  ready_count--;
+  sector_count++;
+  unsynced_sectors++;
+}
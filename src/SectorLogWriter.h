@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+#include "BinaryLog.h"
+
+// Asynchronous, sector-aligned log writer.
+//
+// Producers append whole records into a pool of 512-byte sector buffers;
+// append() never touches the card and drops the record (counting it) if
+// the pool is full. service() writes queued sectors within a time budget,
+// so the card only ever sees whole, sector-aligned writes. A partially
+// filled sector is padded and queued once its oldest byte is older than the
+// flush interval, and the FAT/directory entry is only updated (File::flush)
+// every few sectors, so at most `max_pending_ms` of data can be lost on
+// power failure.
+class SectorLogWriter {
+public:
+  static const size_t SECTOR_COUNT = 8;  // 4 KB of staging: ~2 min of JSONL at 1 Hz
+
+  SectorLogWriter();
+
+  void begin(File* file, uint8_t pad_byte);
+  void end();  // Blocking: writes everything staged, then flushes the file
+  bool active() const { return file != nullptr; }
+
+  bool append(const void* data, size_t len);  // All-or-nothing, never blocks
+  // Writes queued sectors until `budget_us` is spent (at least one if any are
+  // queued), or syncs the file if nothing was written. Returns true if the
+  // card was touched.
+  bool service(uint32_t now_ms, uint32_t budget_us);
+
+  void set_flush_policy(uint32_t max_pending_ms, uint32_t sectors_per_sync);
+
+  size_t queued_sectors() const { return ready_count; }
+  uint32_t sectors_written() const { return sector_count; }
+  uint32_t bytes_appended() const { return byte_count; }
+  uint32_t pad_bytes() const { return padding_count; }
+  uint32_t syncs() const { return sync_count; }
+  uint32_t write_errors() const { return error_count; }
+  uint32_t records_dropped() const { return dropped_count; }
+  uint32_t queue_high_water() const { return high_water; }
+  uint32_t max_write_us() const { return worst_write_us; }
+
+private:
+  void queue_fill_sector();
+  void write_sector();
+
+  File* file;
+  uint8_t sectors[SECTOR_COUNT][BINLOG_SECTOR_SIZE];
+  size_t fill_index;   // Sector currently being filled
+  size_t fill;         // Bytes used in that sector
+  size_t ready_head;   // Oldest sector waiting to be written
+  size_t ready_count;
+  uint8_t pad;
+  uint32_t first_pending_ms;
+  uint32_t last_sync_ms;
+  uint32_t unsynced_sectors;
+  uint32_t max_pending_ms;
+  uint32_t sectors_per_sync;
+
+  uint32_t sector_count;
+  uint32_t byte_count;
+  uint32_t padding_count;
+  uint32_t sync_count;
+  uint32_t error_count;
+  uint32_t dropped_count;
+  uint32_t high_water;
+  uint32_t worst_write_us;
+};
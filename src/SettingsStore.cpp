@@ -0,0 +1,306 @@
+#include "SettingsStore.h"
+#include <string.h>
+
+uint32_t settings_crc32(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+SettingsStore::SettingsStore(SettingsReadByte read_byte, SettingsWriteByte write_byte, uint16_t size)
+    : read_byte(read_byte), write_byte(write_byte) {
+  memset(&stats, 0, sizeof(stats));
+  stats.bank_size = size / 2;
+  formatted = false;
+  write_offset = 0;
+  stored_length = 0;
+  staged_length = 0;
+  calibration_head = 0;
+  calibration_count = 0;
+}
+
+bool SettingsStore::read_record(uint16_t address, uint16_t limit, uint8_t& type, uint8_t& length,
+                                uint32_t& sequence) const {
+  if ((uint32_t)address + HEADER_SIZE + CRC_SIZE > limit) {
+    return false;
+  }
+  uint8_t header[HEADER_SIZE];
+  for (uint8_t i = 0; i < HEADER_SIZE; i++) {
+    header[i] = read_byte(address + i);
+  }
+  if (header[0] != MAGIC || header[3] != 0) {
+    return false;
+  }
+  type = header[1];
+  length = header[2];
+  if ((uint32_t)address + HEADER_SIZE + length + CRC_SIZE > limit) {
+    return false;
+  }
+  uint32_t crc = settings_crc32(0, header, HEADER_SIZE);
+  for (uint8_t i = 0; i < length; i++) {
+    uint8_t byte = read_byte(address + HEADER_SIZE + i);
+    crc = settings_crc32(crc, &byte, 1);
+  }
+  uint32_t stored_crc = 0;
+  for (uint8_t i = 0; i < CRC_SIZE; i++) {
+    stored_crc |= (uint32_t)read_byte(address + HEADER_SIZE + length + i) << (8 * i);
+  }
+  if (crc != stored_crc) {
+    return false;
+  }
+  memcpy(&sequence, header + 4, sizeof(sequence));
+  return true;
+}
+
+void SettingsStore::scan_bank(uint8_t bank, BankScan& scan) const {
+  memset(&scan, 0, sizeof(scan));
+  uint16_t start = bank * stats.bank_size;
+  uint16_t limit = start + stats.bank_size;
+  uint8_t type;
+  uint8_t length;
+  uint32_t sequence;
+  if (!read_record(start, limit, type, length, sequence) || type != SETTINGS_RECORD_BANK || length != 2) {
+    return;
+  }
+  uint16_t live = read_byte(start + HEADER_SIZE) | (uint16_t)(read_byte(start + HEADER_SIZE + 1) << 8);
+  uint16_t address = start + HEADER_SIZE + length + CRC_SIZE;
+  uint32_t last = sequence;
+  uint16_t records = 0;
+  while (read_record(address, limit, type, length, sequence) && sequence == last + 1) {
+    if (type == SETTINGS_RECORD_SETTINGS) {
+      scan.settings_address = address;
+    } else if (type == SETTINGS_RECORD_CALIBRATION) {
+      scan.calibrations[(scan.calibration_head + scan.calibration_count) % HISTORY] = address;
+      if (scan.calibration_count < HISTORY) {
+        scan.calibration_count++;
+      } else {
+        scan.calibration_head = (uint8_t)((scan.calibration_head + 1) % HISTORY);
+      }
+    }
+    // Other types are from newer firmware: skipped, but they keep the chain
+    last = sequence;
+    address += HEADER_SIZE + length + CRC_SIZE;
+    records++;
+  }
+  scan.valid = records >= live;
+  scan.last_sequence = last;
+  scan.end = address - start;
+}
+
+bool SettingsStore::begin() {
+  BankScan scans[2];
+  scan_bank(0, scans[0]);
+  scan_bank(1, scans[1]);
+  int8_t bank = -1;
+  for (uint8_t b = 0; b < 2; b++) {
+    if (scans[b].valid && (bank < 0 || scans[b].last_sequence > scans[bank].last_sequence)) {
+      bank = b;
+    }
+  }
+
+  stored_length = 0;
+  calibration_head = 0;
+  calibration_count = 0;
+  if (bank < 0) {
+    // Blank: the first write compacts the (empty) live set into bank 0
+    formatted = false;
+    stats.active_bank = 1;
+    stats.sequence = 0;
+    write_offset = 0;
+    stats.used = 0;
+    staged_length = 0;
+    return false;
+  }
+
+  const BankScan& scan = scans[bank];
+  formatted = true;
+  stats.active_bank = (uint8_t)bank;
+  stats.sequence = scan.last_sequence;
+  write_offset = scan.end;
+  stats.used = scan.end;
+  if (scan.settings_address != 0) {
+    stored_length = read_payload(scan.settings_address, stored, MAX_SETTINGS);
+  }
+  memcpy(staged, stored, stored_length);
+  staged_length = stored_length;
+  for (uint8_t i = 0; i < scan.calibration_count; i++) {
+    remember_calibration(scan.calibrations[(scan.calibration_head + i) % HISTORY]);
+  }
+  return true;
+}
+
+void SettingsStore::clear() {
+  stored_length = 0;
+  staged_length = 0;
+  calibration_head = 0;
+  calibration_count = 0;
+  compact(stored, stored_length);
+}
+
+uint8_t SettingsStore::read_payload(uint16_t address, uint8_t* payload, uint8_t size) const {
+  uint8_t length = read_byte(address + 2);
+  uint8_t count = length < size ? length : size;
+  for (uint8_t i = 0; i < count; i++) {
+    payload[i] = read_byte(address + HEADER_SIZE + i);
+  }
+  return count;
+}
+
+void SettingsStore::remember_calibration(uint16_t address) {
+  calibrations[(calibration_head + calibration_count) % HISTORY] = address;
+  if (calibration_count < HISTORY) {
+    calibration_count++;
+  } else {
+    calibration_head = (uint8_t)((calibration_head + 1) % HISTORY);
+  }
+}
+
+// Writes one record at an absolute address; returns its size
+static uint16_t write_record(SettingsWriteByte write_byte, uint16_t address, uint32_t sequence,
+                             uint8_t type, const uint8_t* payload, uint8_t length) {
+  uint8_t header[SettingsStore::HEADER_SIZE] = {SettingsStore::MAGIC, type, length, 0};
+  memcpy(header + 4, &sequence, sizeof(sequence));
+  uint32_t crc = settings_crc32(settings_crc32(0, header, sizeof(header)), payload, length);
+  uint16_t p = address;
+  for (uint8_t i = 0; i < sizeof(header); i++) write_byte(p++, header[i]);
+  for (uint8_t i = 0; i < length; i++) write_byte(p++, payload[i]);
+  for (uint8_t i = 0; i < SettingsStore::CRC_SIZE; i++) write_byte(p++, (uint8_t)(crc >> (8 * i)));
+  return p - address;
+}
+
+bool SettingsStore::compact(const uint8_t* settings, uint8_t settings_length) {
+  uint8_t target = stats.active_bank ^ 1;
+  uint16_t start = target * stats.bank_size;
+  uint32_t needed = HEADER_SIZE + 2 + CRC_SIZE;
+  if (settings_length > 0) {
+    needed += HEADER_SIZE + settings_length + CRC_SIZE;
+  }
+  needed += (uint32_t)calibration_count * (HEADER_SIZE + sizeof(SettingsCalibration) + CRC_SIZE);
+  if (needed > stats.bank_size) {
+    return false;
+  }
+
+  uint16_t live = (settings_length > 0 ? 1 : 0) + calibration_count;
+  uint8_t count[2] = {(uint8_t)live, (uint8_t)(live >> 8)};
+  uint16_t offset = 0;
+  offset += write_record(write_byte, start + offset, ++stats.sequence, SETTINGS_RECORD_BANK, count, 2);
+  if (settings_length > 0) {
+    offset += write_record(write_byte, start + offset, ++stats.sequence, SETTINGS_RECORD_SETTINGS,
+                           settings, settings_length);
+  }
+  uint16_t moved[HISTORY];
+  for (uint8_t i = 0; i < calibration_count; i++) {
+    uint8_t payload[sizeof(SettingsCalibration)];
+    uint16_t source = calibrations[(calibration_head + i) % HISTORY];
+    uint8_t length = read_payload(source, payload, sizeof(payload));
+    moved[i] = start + offset;
+    offset += write_record(write_byte, start + offset, ++stats.sequence, SETTINGS_RECORD_CALIBRATION,
+                           payload, length);
+  }
+
+  for (uint8_t i = 0; i < calibration_count; i++) {
+    calibrations[i] = moved[i];
+  }
+  calibration_head = 0;
+  stats.active_bank = target;
+  write_offset = offset;
+  stats.used = offset;
+  stats.bytes_written += offset;
+  stats.compactions++;
+  formatted = true;
+  return true;
+}
+
+uint16_t SettingsStore::append(uint8_t type, const uint8_t* payload, uint8_t length) {
+  uint16_t record_size = HEADER_SIZE + length + CRC_SIZE;
+  if (!formatted || write_offset + record_size > stats.bank_size) {
+    if (!compact(stored, stored_length) || write_offset + record_size > stats.bank_size) {
+      return 0;
+    }
+  }
+  uint16_t address = stats.active_bank * stats.bank_size + write_offset;
+  write_offset += write_record(write_byte, address, ++stats.sequence, type, payload, length);
+  stats.used = write_offset;
+  stats.appends++;
+  stats.bytes_written += record_size;
+  return address;
+}
+
+bool SettingsStore::get_field(uint8_t tag, void* value, uint8_t size) const {
+  for (uint8_t i = 0; i + 2 <= staged_length; i += 2 + staged[i + 1]) {
+    if (staged[i] == tag) {
+      if (staged[i + 1] != size || i + 2 + size > staged_length) {
+        return false;
+      }
+      memcpy(value, staged + i + 2, size);
+      return true;
+    }
+  }
+  return false;
+}
+
+void SettingsStore::set_field(uint8_t tag, const void* value, uint8_t size) {
+  for (uint8_t i = 0; i + 2 <= staged_length; i += 2 + staged[i + 1]) {
+    if (staged[i] != tag) {
+      continue;
+    }
+    if (staged[i + 1] == size) {
+      memcpy(staged + i + 2, value, size);
+      return;
+    }
+    // Re-encoded: drop the old field, append the new one below
+    uint8_t field = 2 + staged[i + 1];
+    memmove(staged + i, staged + i + field, staged_length - i - field);
+    staged_length -= field;
+    break;
+  }
+  if (staged_length + 2 + size > MAX_SETTINGS) {
+    return;
+  }
+  staged[staged_length] = tag;
+  staged[staged_length + 1] = size;
+  memcpy(staged + staged_length + 2, value, size);
+  staged_length += 2 + size;
+}
+
+bool SettingsStore::commit() {
+  if (staged_length == stored_length && memcmp(staged, stored, staged_length) == 0) {
+    stats.unchanged++;
+    return false;
+  }
+  bool written;
+  if (!formatted || write_offset + HEADER_SIZE + staged_length + CRC_SIZE > stats.bank_size) {
+    written = compact(staged, staged_length);  // Carries the new snapshot over
+  } else {
+    written = append(SETTINGS_RECORD_SETTINGS, staged, staged_length) != 0;
+  }
+  if (written) {
+    // Only now: a snapshot that failed must not compare as already stored
+    memcpy(stored, staged, staged_length);
+    stored_length = staged_length;
+  }
+  return written;
+}
+
+bool SettingsStore::add_calibration(const SettingsCalibration& entry) {
+  uint16_t address = append(SETTINGS_RECORD_CALIBRATION, (const uint8_t*)&entry, sizeof(entry));
+  if (address == 0) {
+    return false;
+  }
+  remember_calibration(address);
+  return true;
+}
+
+bool SettingsStore::get_calibration(uint8_t index, SettingsCalibration& entry) const {
+  if (index >= calibration_count) {
+    return false;
+  }
+  memset(&entry, 0, sizeof(entry));
+  read_payload(calibrations[(calibration_head + index) % HISTORY], (uint8_t*)&entry, sizeof(entry));
+  return true;
+}
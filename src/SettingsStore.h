@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Log-structured settings and calibration history on the emulated EEPROM.
+//
+// Nothing is rewritten in place. Every change appends a record:
+//
+//   magic 0xA5 | type | payload length | 0 | sequence (u32) | payload | CRC32
+//
+// The space is split into two banks. Records go into the active bank with
+// consecutive sequence numbers; when the next one does not fit, the live set
+// (the newest settings snapshot and the calibration history) is copied to the
+// start of the other bank behind a BANK record that counts it, and that bank
+// becomes active. A bank is only trusted if its BANK record is followed by
+// that many valid records, so a power cut during compaction falls back to the
+// untouched old bank, and one during an append loses only that record (its
+// CRC fails and the next append overwrites it). Boot reads each bank once,
+// following the chain until a record fails its magic, CRC or sequence.
+//
+// Settings are one snapshot of tag-length-value fields. A tag never changes
+// meaning: new settings get new tags, a changed encoding gets a new tag, and
+// readers skip tags they do not know and fall back to defaults for tags that
+// are missing, so old and new firmware read each other's snapshots. A
+// snapshot identical to the stored one is not written at all. Calibration
+// records are a fixed struct that only grows at its end; shorter records read
+// with the missing fields zeroed.
+//
+// On the Teensy the emulated EEPROM keeps each 68-byte slice of the address
+// space in its own flash sector and erases a sector when its slice has taken
+// about 2000 byte writes. Appending walks the writes across all slices
+// instead of hammering the one holding a fixed struct.
+
+typedef uint8_t (*SettingsReadByte)(uint16_t address);
+typedef void (*SettingsWriteByte)(uint16_t address, uint8_t value);
+
+enum SettingsRecordType : uint8_t {
+  SETTINGS_RECORD_BANK = 1,         // Starts a bank: u16 count of live records that follow
+  SETTINGS_RECORD_SETTINGS = 2,     // Snapshot of tag-length-value fields
+  SETTINGS_RECORD_CALIBRATION = 3,  // SettingsCalibration
+};
+
+struct SettingsCalibration {
+  uint32_t gps_time;      // Unix seconds from GPS (0: no fix at the time)
+  int32_t offset_cppb;    // Oscillator offset, 0.01 ppb
+  uint8_t source;         // 0 = manual (p command), 1 = disciplining loop
+  uint8_t loop_state;     // DisciplineState at the time
+  uint16_t temperature_ck; // Temperature, 0.01 K (0: not recorded)
+} __attribute__((packed));
+
+struct SettingsStoreStats {
+  uint32_t sequence;      // Of the newest record
+  uint8_t active_bank;
+  uint16_t bank_size;
+  uint16_t used;          // Bytes of the active bank holding records
+  uint32_t appends;       // Since boot
+  uint32_t bytes_written;
+  uint32_t compactions;
+  uint32_t unchanged;     // Commits skipped because the snapshot was identical
+};
+
+class SettingsStore {
+public:
+  static const uint8_t MAGIC = 0xA5;
+  static const uint8_t HEADER_SIZE = 8;
+  static const uint8_t CRC_SIZE = 4;
+  static const uint8_t MAX_SETTINGS = 96;  // Snapshot payload bytes
+  static const uint8_t HISTORY = 16;       // Calibration records kept across compactions
+
+  SettingsStore(SettingsReadByte read_byte, SettingsWriteByte write_byte, uint16_t size);
+
+  // One pass over both banks; false if neither holds a valid chain (blank or
+  // foreign data), in which case the store is empty and the first commit
+  // formats it
+  bool begin();
+  // Drops the settings and the history: the next write starts a new bank
+  void clear();
+
+  bool get_field(uint8_t tag, void* value, uint8_t size) const;  // false if absent or a different size
+  void set_field(uint8_t tag, const void* value, uint8_t size);  // Staged until commit()
+  bool commit();                                                 // true if a record was written
+
+  bool add_calibration(const SettingsCalibration& entry);
+  uint8_t get_calibration_count() const { return calibration_count; }
+  bool get_calibration(uint8_t index, SettingsCalibration& entry) const;  // 0 = oldest
+
+  bool has_settings() const { return stored_length > 0; }
+  const SettingsStoreStats& get_stats() const { return stats; }
+
+private:
+  struct BankScan {
+    bool valid;
+    uint32_t last_sequence;
+    uint16_t end;                    // Offset past the last valid record
+    uint16_t settings_address;       // 0: none
+    uint16_t calibrations[HISTORY];  // Ring of record addresses
+    uint8_t calibration_head;
+    uint8_t calibration_count;
+  };
+
+  void scan_bank(uint8_t bank, BankScan& scan) const;
+  bool read_record(uint16_t address, uint16_t limit, uint8_t& type, uint8_t& length, uint32_t& sequence) const;
+  uint16_t append(uint8_t type, const uint8_t* payload, uint8_t length);  // Record address, 0 if it failed
+  bool compact(const uint8_t* settings, uint8_t settings_length);  // The snapshot to carry over
+  uint8_t read_payload(uint16_t address, uint8_t* payload, uint8_t size) const;
+  void remember_calibration(uint16_t address);
+
+  SettingsReadByte read_byte;
+  SettingsWriteByte write_byte;
+  SettingsStoreStats stats;
+  bool formatted;                 // The active bank has its BANK record
+  uint16_t write_offset;          // Within the active bank
+  uint8_t stored[MAX_SETTINGS];   // Newest snapshot on the medium
+  uint8_t stored_length;
+  uint8_t staged[MAX_SETTINGS];
+  uint8_t staged_length;
+  uint16_t calibrations[HISTORY]; // Absolute record addresses, ring
+  uint8_t calibration_head;
+  uint8_t calibration_count;
+};
+
+uint32_t settings_crc32(uint32_t crc, const uint8_t* data, size_t len);
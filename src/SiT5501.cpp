@@ -1,7 +1,11 @@
 #include "SiT5501.h"
 
+static const uint32_t DEFAULT_VERIFY_INTERVAL_MS = 10000;
+
 SiT5501::SiT5501(uint8_t i2c_addr, TwoWire* wire_instance)
-    : _i2c_addr(i2c_addr), _wire(wire_instance) {
+    : _i2c_addr(i2c_addr), _wire(wire_instance), _shadow_valid(false),
+      _verify_interval_ms(DEFAULT_VERIFY_INTERVAL_MS), _last_verify_ms(0) {
+    resetUpdateStats();
 }
 
 bool SiT5501::begin() {
@@ -13,14 +17,13 @@ bool SiT5501::begin() {
     return isPresent();
 }
 
+// Slow path for configuration changes: rewrites every register and reads them back
 bool SiT5501::flushRegisters() {
-    bool ok = true;
     uint16_t r_shadow[N_REGISTERS];
     for (int i = 0; i < N_REGISTERS; i++) {
-        ok &= writeRegister(i, registers[i]);
         r_shadow[i] = registers[i];
     }
-    Serial.printf("\r\n");
+    bool ok = writeRegistersAutoIncrement(REG_FC_LSW, registers, N_REGISTERS);
     bool dirty = false;
     for (int i = 0; i < N_REGISTERS; i++) {
         readRegister(i, registers[i]);
@@ -38,6 +41,7 @@ bool SiT5501::flushRegisters() {
             Serial.printf("0x%08x, ", registers[i]);
         Serial.printf("\r\n");
     }
+    _shadow_valid = ok && !dirty;
     return ok;
 }
 double SiT5501::getPullRange() {
@@ -67,7 +71,7 @@ bool SiT5501::isPresent() {
     return (_wire->endTransmission() == 0);
 }
 
-bool SiT5501::setFrequencyOffsetPPM(double ppm_offset) {
+bool SiT5501::controlFromPPM(double ppm_offset, uint32_t& fc_value) {
     double pull_range = getPullRange();
     if (ppm_offset < -pull_range || ppm_offset > pull_range) {
         return false;
@@ -75,22 +79,116 @@ bool SiT5501::setFrequencyOffsetPPM(double ppm_offset) {
 
     double fc_double = 1.0 * ppm_offset * ((1<<25)-1) / pull_range;
     int32_t fc_int = (int32_t) fc_double;
-    uint32_t fc_value = (uint32_t) fc_int & ((1<<25)-1);
+    fc_value = (uint32_t) fc_int & ((1<<26)-1);  // 26-bit two's complement
     //Serial.printf("pull range = %f, fc_double = %f, fc_int = 0x%08x, fc_value = 0x%08x\r\n",
     //              pull_range, fc_double, fc_int, fc_value);
+    return true;
+}
+
+bool SiT5501::setFrequencyOffsetPPM(double ppm_offset) {
+    uint32_t fc_value;
+    if (!controlFromPPM(ppm_offset, fc_value)) {
+        return false;
+    }
     return setFrequencyControl(fc_value);
+}
 
+bool SiT5501::updateFrequencyOffsetPPM(double ppm_offset) {
+    uint32_t fc_value;
+    if (!controlFromPPM(ppm_offset, fc_value)) {
+        return false;
+    }
+    return updateFrequencyControl(fc_value);
 }
 
 bool SiT5501::setFrequencyControl(uint32_t fc_value) {
     uint16_t lsw = fc_value & 0xFFFF;
     uint16_t msw = (fc_value >> 16) & 0x3ff;
     registers[0] = lsw;
-    registers[1] &= ~0x3fff;
+    registers[1] &= ~0x3ff;  // Keep the OE bit (bit 10)
     registers[1] |= msw;
     return flushRegisters();
 }
 
+bool SiT5501::updateFrequencyControl(uint32_t fc_value) {
+    uint16_t lsw = fc_value & 0xFFFF;
+    uint16_t msw = (registers[1] & ~0x3ff) | ((fc_value >> 16) & 0x3ff);
+    bool lsw_changed = !_shadow_valid || lsw != registers[0];
+    bool msw_changed = !_shadow_valid || msw != registers[1];
+    uint32_t now_ms = millis();
+    bool verify_due = _verify_interval_ms != 0 && now_ms - _last_verify_ms >= _verify_interval_ms;
+
+    if (!lsw_changed && !msw_changed && !verify_due) {
+        _stats.unchanged++;
+        return true;
+    }
+
+    uint32_t start_us = micros();
+    registers[0] = lsw;
+    registers[1] = msw;
+    bool ok = true;
+    if (lsw_changed) {
+        ok = writeRegistersAutoIncrement(REG_FC_LSW, registers, 2);
+        _stats.words_written += 2;
+    } else if (msw_changed) {
+        ok = writeRegistersAutoIncrement(REG_FC_MSW, &registers[1], 1);
+        _stats.words_written += 1;
+    } else {
+        _stats.unchanged++;
+    }
+    if (!ok) {
+        _stats.errors++;
+        _shadow_valid = false;  // Resend both words next time
+    }
+
+    if (ok && verify_due) {
+        _last_verify_ms = now_ms;
+        ok = verifyControlWord();
+    }
+
+    if (lsw_changed || msw_changed) {
+        _stats.updates++;
+    }
+    uint32_t elapsed_us = micros() - start_us;
+    _stats.last_us = elapsed_us;
+    if (elapsed_us > _stats.max_us) {
+        _stats.max_us = elapsed_us;
+    }
+    _stats.total_us += elapsed_us;
+    return ok;
+}
+
+// Reads the control word back; on a mismatch rewrites it once from the shadow
+bool SiT5501::verifyControlWord() {
+    uint16_t lsw, msw;
+    _stats.verifies++;
+    if (!readRegister(REG_FC_LSW, lsw) || !readRegister(REG_FC_MSW, msw)) {
+        _stats.errors++;
+        _shadow_valid = false;
+        return false;
+    }
+    if (lsw == registers[0] && msw == registers[1]) {
+        return true;
+    }
+    _stats.verify_failures++;
+    _stats.words_written += 2;
+    if (!writeRegistersAutoIncrement(REG_FC_LSW, registers, 2)) {
+        _stats.errors++;
+        _shadow_valid = false;
+        return false;
+    }
+    return true;
+}
+
+void SiT5501::setVerifyInterval(uint32_t interval_ms) {
+    _verify_interval_ms = interval_ms;
+    _last_verify_ms = millis();
+}
+
+void SiT5501::resetUpdateStats() {
+    _stats = SiT5501UpdateStats();
+}
+
 bool SiT5501::getFrequencyControl(uint32_t& fc_value) {
     uint16_t lsw, msw;
 
@@ -21,6 +21,21 @@ typedef enum {
     PULL_RANGE_3200_00_PPM = 0xf
 } PULL_RANGE_t;
 
+/**
+ * @brief Counters for the frequency control fast path
+ */
+struct SiT5501UpdateStats {
+    uint32_t updates;          // Fast-path updates that went out on the bus
+    uint32_t unchanged;        // Updates skipped because the control word did not change
+    uint32_t words_written;    // 16-bit register words sent by the fast path
+    uint32_t errors;           // I2C failures (write or read-back)
+    uint32_t verifies;         // Rate-limited read-backs performed
+    uint32_t verify_failures;  // Read-backs that did not match the shadow registers
+    uint32_t last_us;          // Latency of the last update, including any read-back
+    uint32_t max_us;
+    uint64_t total_us;
+};
+
 /**
  * @brief SiT5501 MEMS Precision Oscillator Driver
  *
@@ -93,6 +108,39 @@ public:
      */
     bool setFrequencyControl(uint32_t fc_value);
 
+    /**
+     * @brief Fast-path frequency offset update for steering loops
+     *
+     * Same conversion as setFrequencyOffsetPPM(), written with
+     * updateFrequencyControl(): no console output and no read-back except
+     * the rate-limited verification.
+     * @param ppm_offset Frequency offset in parts per million
+     * @return true if successful, false if out of range or I2C error
+     */
+    bool updateFrequencyOffsetPPM(double ppm_offset);
+
+    /**
+     * @brief Fast-path frequency control update
+     *
+     * Compares the new word with the shadow registers and sends only what
+     * changed in a single auto-increment transaction. Writing the MSW is
+     * what commits a new control word, so a changed LSW always goes out
+     * together with the MSW; an unchanged word costs no bus traffic.
+     * @param fc_value 26-bit two's complement frequency control value
+     * @return true if successful, false if I2C error
+     */
+    bool updateFrequencyControl(uint32_t fc_value);
+
+    /**
+     * @brief Set how often the fast path reads the control word back
+     * @param interval_ms Minimum time between read-backs, 0 disables them
+     */
+    void setVerifyInterval(uint32_t interval_ms);
+    uint32_t getVerifyInterval() const { return _verify_interval_ms; }
+
+    void getUpdateStats(SiT5501UpdateStats& stats) const { stats = _stats; }
+    void resetUpdateStats();
+
     /**
      * @brief Get current frequency control value
      * @param fc_value Reference to store the 32-bit frequency control value
@@ -146,6 +194,10 @@ private:
     uint8_t _i2c_addr;
     TwoWire* _wire;
     uint16_t registers[N_REGISTERS];
+    bool _shadow_valid;           // registers[] is known to match the device
+    uint32_t _verify_interval_ms;
+    uint32_t _last_verify_ms;
+    SiT5501UpdateStats _stats;
     /**
      * @brief Write multiple registers using auto-increment
      * @param start_reg Starting register address
@@ -155,4 +207,6 @@ private:
      */
     bool writeRegistersAutoIncrement(uint8_t start_reg, const uint16_t* data, uint8_t num_regs);
     bool flushRegisters(void);
+    bool controlFromPPM(double ppm_offset, uint32_t& fc_value);
+    bool verifyControlWord(void);
 };
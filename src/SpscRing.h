@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Single-producer/single-consumer lock-free ring buffer.
+//
+// The producer (typically an ISR) only writes `head`, the consumer (loop())
+// only writes `tail`, so no locking is needed. Capacity must be a power of
+// two; one slot is never used so that full and empty can be told apart.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+  SpscRing() : head(0), tail(0) {}
+
+  // Producer side. Returns false (and drops the item) if the ring is full.
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t next = (h + 1) & (N - 1);
+    if (next == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots[h] = item;
+    head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty.
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = slots[t];
+    tail.store((t + 1) & (N - 1), std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Discards everything currently queued.
+  void clear() {
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  size_t size() const {
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    return (h - t) & (N - 1);
+  }
+
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N - 1; }
+
+private:
+  T slots[N];
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+};
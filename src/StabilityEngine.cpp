@@ -0,0 +1,100 @@
+#include "StabilityEngine.h"
+#include <math.h>
+
+StabilityEngine::StabilityEngine(uint32_t nominal_ticks, double tick_seconds, double tau0_seconds)
+    : nominal(nominal_ticks), tick_s(tick_seconds), tau0(tau0_seconds) {
+  reset();
+}
+
+void StabilityEngine::reset() {
+  for (uint8_t k = 0; k < MAX_LEVELS; k++) {
+    levels[k] = Level();
+  }
+  phase_ticks = 0;
+  sample_count = 0;
+  gap_count = 0;
+}
+
+void StabilityEngine::mark_gap() {
+  // Keep the sums, but never difference across the discontinuity
+  for (uint8_t k = 0; k < MAX_LEVELS; k++) {
+    levels[k].history = 0;
+    levels[k].has_pending = false;
+  }
+  phase_ticks = 0;
+  gap_count++;
+}
+
+void StabilityEngine::add_period(uint32_t ticks) {
+  if (levels[0].history == 0 && !levels[0].has_pending) {
+    feed(0, 0, 0);  // Phase origin of a new segment: the edge opening this period
+  }
+  phase_ticks += (int64_t)ticks - (int64_t)nominal;
+  sample_count++;
+  feed(0, phase_ticks, phase_ticks);
+}
+
+void StabilityEngine::feed(uint8_t k, int64_t phase, int64_t block) {
+  // Iterative cascade: each level forwards every second input upwards
+  while (k < MAX_LEVELS) {
+    Level& lv = levels[k];
+    if (lv.history == 2) {
+      double d = (double)(phase - 2 * lv.phase[1] + lv.phase[0]);
+      double e = (double)(block - 2 * lv.block[1] + lv.block[0]);
+      lv.adev_sum += d * d;
+      lv.mdev_sum += e * e;
+      lv.adev_count++;
+      lv.mdev_count++;
+      lv.phase[0] = lv.phase[1];
+      lv.block[0] = lv.block[1];
+      lv.phase[1] = phase;
+      lv.block[1] = block;
+    } else {
+      lv.phase[lv.history] = phase;
+      lv.block[lv.history] = block;
+      lv.history++;
+    }
+
+    if (!lv.has_pending) {
+      lv.pending_phase = phase;
+      lv.pending_block = block;
+      lv.has_pending = true;
+      return;
+    }
+    lv.has_pending = false;
+    phase = lv.pending_phase;          // Decimate: keep the first of each pair
+    block = lv.pending_block + block;  // Merge two adjacent blocks
+    k++;
+  }
+}
+
+uint8_t StabilityEngine::get_levels() const {
+  uint8_t n = 0;
+  while (n < MAX_LEVELS && levels[n].adev_count > 0) {
+    n++;
+  }
+  return n;
+}
+
+bool StabilityEngine::get_point(uint8_t level, StabilityPoint& point) const {
+  if (level >= MAX_LEVELS || levels[level].adev_count == 0) {
+    return false;
+  }
+  const Level& lv = levels[level];
+  double m = (double)(1UL << level);
+  double tau = m * tau0;
+  double scale = tick_s * tick_s;
+
+  // AVAR = <(x[i+2m] - 2x[i+m] + x[i])^2> / (2 tau^2)
+  double avar = lv.adev_sum * scale / (2.0 * tau * tau * lv.adev_count);
+  // MVAR = <(S[j+2] - 2S[j+1] + S[j])^2> / (2 m^2 tau^2), S = sum of m phases
+  double mvar = lv.mdev_sum * scale / (2.0 * m * m * tau * tau * lv.mdev_count);
+
+  point.tau = tau;
+  point.adev = sqrt(avar);
+  point.mdev = sqrt(mvar);
+  point.tdev = tau / sqrt(3.0) * point.mdev;
+  point.adev_count = lv.adev_count;
+  point.mdev_count = lv.mdev_count;
+  return true;
+}
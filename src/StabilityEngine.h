@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+
+// Streaming Allan / Modified Allan / Time deviation estimator.
+//
+// Each accepted PPS period is turned into a phase sample x (accumulated
+// ticks minus nominal, kept as an exact int64). Octave-spaced tau values
+// (1, 2, 4, ... tau0) are estimated with a cascade of decimators: level k
+// sees every 2^k-th phase sample for ADEV and the sum of each 2^k-sample
+// block for MDEV, and forwards every second input to level k+1. Each level
+// keeps only its last three inputs plus running sums, so memory is
+// O(levels) and the per-sample cost is O(1) amortised (two level updates on
+// average). Estimates are non-overlapping, which costs some confidence at
+// long tau compared with allantools.oadev but needs no sample history.
+//
+// A missed or rejected PPS edge breaks phase continuity; mark_gap() restarts
+// the difference history at every level while keeping the accumulated sums,
+// so days of data with occasional dropouts still contribute.
+
+struct StabilityPoint {
+  double tau;          // Seconds
+  double adev;         // Non-overlapping Allan deviation
+  double mdev;         // Modified Allan deviation
+  double tdev;         // Time deviation, seconds (tau / sqrt(3) * mdev)
+  uint32_t adev_count; // Second differences behind each estimate
+  uint32_t mdev_count;
+};
+
+class StabilityEngine {
+public:
+  static const uint8_t MAX_LEVELS = 20;  // tau up to 2^19 s (~6 days) at 1 PPS
+
+  StabilityEngine(uint32_t nominal_ticks, double tick_seconds, double tau0_seconds);
+
+  void reset();
+  void add_period(uint32_t ticks);
+  void mark_gap();
+
+  uint32_t get_sample_count() const { return sample_count; }
+  uint32_t get_gap_count() const { return gap_count; }
+  // Number of octave levels (from tau0 upwards) that have at least one estimate
+  uint8_t get_levels() const;
+  bool get_point(uint8_t level, StabilityPoint& point) const;
+
+private:
+  struct Level {
+    int64_t phase[2];     // Last two decimated phase samples (ADEV)
+    int64_t block[2];     // Last two block sums (MDEV)
+    int64_t pending_phase;
+    int64_t pending_block;
+    uint8_t history;      // Valid entries in phase[]/block[], 0..2
+    bool has_pending;     // First half of the next level's pair is held
+    double adev_sum;      // Sum of squared second differences, ticks^2
+    double mdev_sum;
+    uint32_t adev_count;
+    uint32_t mdev_count;
+  };
+
+  void feed(uint8_t level, int64_t phase, int64_t block);
+
+  uint32_t nominal;
+  double tick_s;
+  double tau0;
+  int64_t phase_ticks;
+  uint32_t sample_count;
+  uint32_t gap_count;
+  Level levels[MAX_LEVELS];
+};
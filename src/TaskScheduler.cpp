@@ -0,0 +1,129 @@
+#include "TaskScheduler.h"
+#include <Arduino.h>
+#include "Profiler.h"
+
+TaskScheduler::TaskScheduler() : task_count(0), passes(0), idle_passes(0) {
+}
+
+int8_t TaskScheduler::add_task(const char* name, TaskFunction function, uint32_t period_us,
+                               uint8_t priority, uint32_t budget_us, uint8_t profile_stage) {
+  if (task_count >= MAX_TASKS || function == nullptr) {
+    return -1;
+  }
+  Task& task = tasks[task_count];
+  task.function = function;
+  task.next_release_us = micros();
+  task.profile_stage = profile_stage;
+  task.stats = TaskStats();
+  task.stats.name = name;
+  task.stats.period_us = period_us;
+  task.stats.budget_us = budget_us;
+  task.stats.priority = priority;
+  task.stats.enabled = true;
+  return (int8_t)task_count++;
+}
+
+void TaskScheduler::set_enabled(uint8_t id, bool enabled) {
+  if (id < task_count) {
+    tasks[id].stats.enabled = enabled;
+    tasks[id].next_release_us = micros();
+  }
+}
+
+bool TaskScheduler::set_period(uint8_t id, uint32_t period_us) {
+  if (id >= task_count) {
+    return false;
+  }
+  tasks[id].stats.period_us = period_us;
+  tasks[id].next_release_us = micros();
+  return true;
+}
+
+void TaskScheduler::run_task(uint8_t id, uint32_t now_us) {
+  Task& task = tasks[id];
+  TaskStats& stats = task.stats;
+  if (stats.period_us != 0) {
+    uint32_t late = now_us - task.next_release_us;
+    if (late > stats.max_late_us) stats.max_late_us = late;
+    // Next release on the grid; every release passed over was a missed deadline
+    uint32_t periods = late / stats.period_us;
+    stats.deadline_misses += periods;
+    task.next_release_us += (periods + 1) * stats.period_us;
+  }
+
+  if (task.profile_stage != NO_PROFILE_STAGE) profiler_enter((ProfileStage)task.profile_stage);
+  task.function();
+  if (task.profile_stage != NO_PROFILE_STAGE) profiler_exit();
+
+  uint32_t elapsed = micros() - now_us;
+  stats.runs++;
+  stats.total_run_us += elapsed;
+  if (elapsed > stats.max_run_us) stats.max_run_us = elapsed;
+  if (elapsed > stats.budget_us) stats.overruns++;
+}
+
+void TaskScheduler::run() {
+  uint32_t done = 0;  // Tasks already serviced in this pass
+  bool periodic_ran = false;
+  passes++;
+  for (;;) {
+    uint32_t now = micros();
+    int8_t pick = -1;
+    for (uint8_t i = 0; i < task_count; i++) {
+      const Task& task = tasks[i];
+      if ((done & (1u << i)) || !task.stats.enabled) continue;
+      if (task.stats.period_us != 0 && (int32_t)(now - task.next_release_us) < 0) continue;
+      if (pick < 0) {
+        pick = (int8_t)i;
+        continue;
+      }
+      const Task& best = tasks[pick];
+      if (task.stats.priority < best.stats.priority ||
+          (task.stats.priority == best.stats.priority &&
+           (int32_t)(task.next_release_us - best.next_release_us) < 0)) {
+        pick = (int8_t)i;
+      }
+    }
+    if (pick < 0) {
+      break;
+    }
+
+    run_task((uint8_t)pick, now);
+    done |= 1u << pick;
+    const TaskStats& ran = tasks[pick].stats;
+    if (ran.period_us != 0) {
+      periodic_ran = true;
+      // More urgent every-pass work gets another turn before the next task
+      for (uint8_t i = 0; i < task_count; i++) {
+        if (tasks[i].stats.period_us == 0 && tasks[i].stats.priority < ran.priority) {
+          done &= ~(1u << i);
+        }
+      }
+    }
+  }
+  if (!periodic_ran) {
+    idle_passes++;
+  }
+}
+
+bool TaskScheduler::get_stats(uint8_t id, TaskStats& stats) const {
+  if (id >= task_count) {
+    return false;
+  }
+  stats = tasks[id].stats;
+  return true;
+}
+
+void TaskScheduler::reset_stats() {
+  for (uint8_t i = 0; i < task_count; i++) {
+    TaskStats& stats = tasks[i].stats;
+    stats.runs = 0;
+    stats.deadline_misses = 0;
+    stats.overruns = 0;
+    stats.max_late_us = 0;
+    stats.max_run_us = 0;
+    stats.total_run_us = 0;
+  }
+  passes = 0;
+  idle_passes = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+// Cooperative, deadline-aware scheduler for the work loop() used to do on
+// every pass.
+//
+// Each task has a period (0 = every pass), a priority (0 is the most urgent)
+// and a time budget. A task is released once per period on a fixed grid;
+// run() services the released tasks most urgent first, earliest release
+// first within a priority. An every-pass task is also serviced again between
+// any two less urgent tasks, so the timing-critical work never waits behind
+// more than one slow task.
+//
+// Per task: a deadline miss is a start more than one period after the
+// release (the releases skipped meanwhile count as misses too), an overrun is
+// a run longer than the budget. Tasks are timed with micros() and, when a
+// stage is given, recorded in the loop profiler.
+
+typedef void (*TaskFunction)();
+
+struct TaskStats {
+  const char* name;
+  uint32_t period_us;
+  uint32_t budget_us;
+  uint8_t priority;
+  bool enabled;
+  uint32_t runs;
+  uint32_t deadline_misses;
+  uint32_t overruns;
+  uint32_t max_late_us;    // Start after release
+  uint32_t max_run_us;
+  uint64_t total_run_us;
+};
+
+class TaskScheduler {
+public:
+  static const uint8_t MAX_TASKS = 8;
+  static const uint8_t NO_PROFILE_STAGE = 0xFF;
+
+  TaskScheduler();
+
+  // Returns the task id, or -1 when the table is full
+  int8_t add_task(const char* name, TaskFunction function, uint32_t period_us, uint8_t priority,
+                  uint32_t budget_us, uint8_t profile_stage = NO_PROFILE_STAGE);
+  void set_enabled(uint8_t id, bool enabled);
+  bool set_period(uint8_t id, uint32_t period_us);
+
+  void run();  // One pass: every released task at most once (every-pass tasks between the others)
+
+  uint8_t get_task_count() const { return task_count; }
+  bool get_stats(uint8_t id, TaskStats& stats) const;
+  uint32_t get_passes() const { return passes; }
+  uint32_t get_idle_passes() const { return idle_passes; }  // Passes with only every-pass work
+  void reset_stats();
+
+private:
+  struct Task {
+    TaskFunction function;
+    uint32_t next_release_us;
+    uint8_t profile_stage;
+    TaskStats stats;
+  };
+
+  void run_task(uint8_t id, uint32_t now_us);
+
+  Task tasks[MAX_TASKS];
+  uint8_t task_count;
+  uint32_t passes;
+  uint32_t idle_passes;
+};
@@ -0,0 +1,147 @@
+#include "Telemetry.h"
+#include <string.h>
+
+uint16_t telemetry_crc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+size_t telemetry_cobs_encode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t code_at = 0;
+  size_t o = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] != 0) {
+      out[o++] = in[i];
+      code++;
+    }
+    if (in[i] == 0 || code == 0xFF) {
+      out[code_at] = code;
+      code_at = o++;
+      code = 1;
+    }
+  }
+  out[code_at] = code;
+  return o;
+}
+
+size_t telemetry_cobs_decode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t o = 0;
+  size_t i = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) {
+      return 0;
+    }
+    for (uint8_t k = 1; k < code; k++) {
+      if (in[i] == 0) return 0;
+      out[o++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      out[o++] = 0;
+    }
+  }
+  return o;
+}
+
+TelemetryEncoder::TelemetryEncoder() : head(0), count(0), sequence(0), frames(0), bytes(0), dropped(0) {
+}
+
+void TelemetryEncoder::reset() {
+  head = 0;
+  count = 0;
+}
+
+bool TelemetryEncoder::send(uint8_t type, const void* body, size_t len, uint32_t ms) {
+  if (len > TELEM_MAX_BODY) {
+    return false;
+  }
+  uint8_t frame[TELEM_MAX_FRAME];
+  TelemetryHeader header = {type, TELEM_VERSION, sequence++, ms};
+  memcpy(frame, &header, sizeof(header));
+  memcpy(frame + sizeof(header), body, len);
+  size_t frame_len = sizeof(header) + len;
+  uint16_t crc = telemetry_crc16(frame, frame_len);
+  frame[frame_len++] = (uint8_t)(crc & 0xFF);
+  frame[frame_len++] = (uint8_t)(crc >> 8);
+
+  uint8_t encoded[TELEM_MAX_ENCODED];
+  size_t encoded_len = telemetry_cobs_encode(frame, frame_len, encoded);
+  encoded[encoded_len++] = 0x00;
+  if (encoded_len > BUFFER_SIZE - count) {
+    dropped++;  // The sequence gap tells the receiver
+    return false;
+  }
+
+  size_t tail = (head + count) % BUFFER_SIZE;
+  size_t first = encoded_len < BUFFER_SIZE - tail ? encoded_len : BUFFER_SIZE - tail;
+  memcpy(buffer + tail, encoded, first);
+  memcpy(buffer, encoded + first, encoded_len - first);
+  count += encoded_len;
+  frames++;
+  bytes += encoded_len;
+  return true;
+}
+
+size_t TelemetryEncoder::drain(uint8_t* out, size_t max) {
+  size_t n = max < count ? max : count;
+  size_t first = n < BUFFER_SIZE - head ? n : BUFFER_SIZE - head;
+  memcpy(out, buffer + head, first);
+  memcpy(out + first, buffer, n - first);
+  head = (head + n) % BUFFER_SIZE;
+  count -= n;
+  return n;
+}
+
+TelemetryDecoder::TelemetryDecoder()
+    : raw_len(0), overflow(false), body_len(0), have_sequence(false), next_sequence(0), frames(0),
+      crc_errors(0), framing_errors(0), lost_frames(0) {
+}
+
+bool TelemetryDecoder::push(uint8_t byte) {
+  if (byte != 0x00) {
+    if (raw_len < sizeof(raw)) {
+      raw[raw_len++] = byte;
+    } else {
+      overflow = true;
+    }
+    return false;
+  }
+
+  // Delimiter: decode what was collected since the previous one
+  size_t len = raw_len;
+  bool too_long = overflow;
+  raw_len = 0;
+  overflow = false;
+  if (len == 0) {
+    return false;  // Back-to-back delimiters, e.g. at the start of a capture
+  }
+  uint8_t decoded[TELEM_MAX_ENCODED];
+  size_t decoded_len = too_long ? 0 : telemetry_cobs_decode(raw, len, decoded);
+  if (decoded_len < sizeof(TelemetryHeader) + 2 || decoded_len > TELEM_MAX_FRAME) {
+    framing_errors++;
+    return false;
+  }
+  uint16_t crc = (uint16_t)(decoded[decoded_len - 2] | (decoded[decoded_len - 1] << 8));
+  if (crc != telemetry_crc16(decoded, decoded_len - 2)) {
+    crc_errors++;
+    return false;
+  }
+
+  memcpy(frame, decoded, decoded_len - 2);
+  body_len = decoded_len - 2 - sizeof(TelemetryHeader);
+  uint16_t sequence = header().sequence;
+  if (have_sequence && sequence != next_sequence) {
+    lost_frames += (uint16_t)(sequence - next_sequence);
+  }
+  have_sequence = true;
+  next_sequence = (uint16_t)(sequence + 1);
+  frames++;
+  return true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Framed binary telemetry stream (SerialUSB1, `q1`).
+//
+// Every frame is an 8-byte header and a little-endian record body, followed
+// by a CRC-16/CCITT-FALSE of both, COBS-encoded and terminated by a 0x00
+// byte. A receiver can therefore join the stream anywhere: it resynchronises
+// on the next zero, and a corrupted frame only costs that frame. The header
+// sequence number counts every frame sent, so gaps reveal frames dropped on
+// either side. tools/telemetry_rx.cpp is the host receiver.
+
+static const uint32_t TELEM_MAGIC = 0x4D4C4346;  // "FCLM"
+static const uint8_t TELEM_VERSION = 2;  // 2: capture records carry the input channel
+static const size_t TELEM_MAX_BODY = 128;
+static const size_t TELEM_MAX_FRAME = 8 + TELEM_MAX_BODY + 2;
+static const size_t TELEM_MAX_ENCODED = TELEM_MAX_FRAME + TELEM_MAX_FRAME / 254 + 2;  // COBS + delimiter
+
+enum TelemetryType : uint8_t {
+  TELEM_HELLO = 0,     // Stream (re)started
+  TELEM_CAPTURE = 1,   // Every raw capture timestamp
+  TELEM_SAMPLE = 2,    // Every accepted PPS period
+  TELEM_HEALTH = 3,    // Loop-health counters, once per second
+  TELEM_CONTROL = 4,   // Oscillator control change
+  TELEM_NMEA = 5,      // GPS receiver bytes (in-band while the stream replaces the passthrough)
+};
+
+struct TelemetryHeader {
+  uint8_t type;
+  uint8_t version;
+  uint16_t sequence;
+  uint32_t ms;         // millis() when the frame was queued
+} __attribute__((packed));
+
+struct TelemetryHello {
+  uint32_t magic;
+  uint32_t nominal_hz;
+} __attribute__((packed));
+
+struct TelemetryCapture {
+  uint64_t timestamp;  // 64-bit extended GPT2 timebase
+  uint32_t sequence;   // Capture sequence from the driver: a gap is a dropped edge
+  uint8_t edge;        // GptCaptureEdge of this edge (1 rising, 2 falling)
+  uint8_t channel;     // 0 = GPS PPS (pin 15), 1 = second input (pin 40)
+} __attribute__((packed));
+
+struct TelemetrySample {
+  uint32_t ticks;
+  uint32_t capture_ticks;
+  uint32_t count;              // Accepted samples since the last reset
+  int32_t fit_ppb_milli;       // Best least-squares fit, 0.001 ppb (INT32_MIN = none)
+  int32_t phase_error_dns;     // GPSDO loop phase error, 0.1 ns
+  int32_t pps_out_error_dns;   // 1 PPS output vs GPS, 0.1 ns
+  uint8_t loop_state;          // DisciplineState
+  uint8_t align_state;         // PpsAlignState
+  uint16_t fit_samples;
+} __attribute__((packed));
+
+struct TelemetryHealth {
+  uint32_t captures;
+  uint32_t compares;
+  uint32_t ring_overruns;
+  uint32_t dropped_edges;
+  uint32_t late_compares;
+  uint32_t worst_loop_us;      // Slowest loop() iteration since the last profile reset
+  uint32_t task_misses;        // Deadline misses, all tasks
+  uint32_t task_overruns;
+  uint32_t gps_overruns;       // UART overruns + receive buffer full
+  uint32_t log_dropped;        // SD log records dropped
+  uint32_t telemetry_dropped;  // Frames dropped because the USB side fell behind
+} __attribute__((packed));
+
+struct TelemetryControl {
+  int32_t offset_cppb;         // New oscillator offset, 0.01 ppb
+  uint8_t source;              // 0 = manual (p command), 1 = disciplining loop
+  uint8_t loop_state;
+  uint16_t reserved;
+} __attribute__((packed));
+
+static_assert(sizeof(TelemetryHeader) == 8, "TelemetryHeader must stay 8 bytes");
+static_assert(sizeof(TelemetryHealth) <= TELEM_MAX_BODY, "TelemetryHealth must fit one frame");
+
+uint16_t telemetry_crc16(const uint8_t* data, size_t len);
+// COBS; `out` needs len + len / 254 + 1 bytes. Returns the encoded length (no delimiter)
+size_t telemetry_cobs_encode(const uint8_t* in, size_t len, uint8_t* out);
+// Returns the decoded length, or 0 if the input is not valid COBS
+size_t telemetry_cobs_decode(const uint8_t* in, size_t len, uint8_t* out);
+
+// Firmware side: frames are queued whole into a byte ring and drained to the
+// port without blocking; a frame that does not fit is dropped and counted.
+class TelemetryEncoder {
+public:
+  static const size_t BUFFER_SIZE = 4096;
+
+  TelemetryEncoder();
+  void reset();  // Empties the queue; the sequence keeps counting
+  bool send(uint8_t type, const void* body, size_t len, uint32_t ms);
+  size_t drain(uint8_t* out, size_t max);
+  size_t pending() const { return count; }
+  uint32_t get_frames() const { return frames; }
+  uint32_t get_bytes() const { return bytes; }
+  uint32_t get_dropped() const { return dropped; }
+
+private:
+  uint8_t buffer[BUFFER_SIZE];
+  size_t head;
+  size_t count;
+  uint16_t sequence;
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t dropped;
+};
+
+// Receiver side: feed bytes as they arrive; true when a valid frame is ready
+class TelemetryDecoder {
+public:
+  TelemetryDecoder();
+  bool push(uint8_t byte);
+  const TelemetryHeader& header() const { return *(const TelemetryHeader*)frame; }
+  const uint8_t* body() const { return frame + sizeof(TelemetryHeader); }
+  size_t body_length() const { return body_len; }
+
+  uint32_t get_frames() const { return frames; }
+  uint32_t get_crc_errors() const { return crc_errors; }
+  uint32_t get_framing_errors() const { return framing_errors; }  // Bad COBS, too short or too long
+  uint32_t get_lost_frames() const { return lost_frames; }        // Sequence gaps
+
+private:
+  uint8_t raw[TELEM_MAX_ENCODED];
+  size_t raw_len;
+  bool overflow;
+  uint8_t frame[TELEM_MAX_FRAME];
+  size_t body_len;
+  bool have_sequence;
+  uint16_t next_sequence;
+  uint32_t frames;
+  uint32_t crc_errors;
+  uint32_t framing_errors;
+  uint32_t lost_frames;
+};
@@ -0,0 +1,136 @@
+#include "UbxParser.h"
+#include <string.h>
+
+UbxParser::UbxParser(UbxFrameHandler handler) : handler(handler) {
+  memset(&stats, 0, sizeof(stats));
+  reset();
+}
+
+void UbxParser::reset() {
+  state = STATE_SYNC_1;
+  length = 0;
+  received = 0;
+}
+
+void UbxParser::checksum(uint8_t byte) {
+  ck_a = (uint8_t)(ck_a + byte);
+  ck_b = (uint8_t)(ck_b + ck_a);
+}
+
+bool UbxParser::encode(uint8_t byte) {
+  switch (state) {
+    case STATE_SYNC_1:
+      if (byte != UBX_SYNC_1) {
+        return false;
+      }
+      state = STATE_SYNC_2;
+      break;
+    case STATE_SYNC_2:
+      if (byte != UBX_SYNC_2) {
+        // Not a frame after all: this byte is looked at afresh
+        state = STATE_SYNC_1;
+        return encode(byte);
+      }
+      state = STATE_CLASS;
+      ck_a = 0;
+      ck_b = 0;
+      break;
+    case STATE_CLASS:
+      msg_class = byte;
+      checksum(byte);
+      state = STATE_ID;
+      break;
+    case STATE_ID:
+      msg_id = byte;
+      checksum(byte);
+      state = STATE_LENGTH_1;
+      break;
+    case STATE_LENGTH_1:
+      length = byte;
+      checksum(byte);
+      state = STATE_LENGTH_2;
+      break;
+    case STATE_LENGTH_2:
+      length |= (uint16_t)byte << 8;
+      checksum(byte);
+      if (length > MAX_LENGTH) {
+        stats.bad_lengths++;
+        state = STATE_SYNC_1;
+        break;
+      }
+      received = 0;
+      state = length > 0 ? STATE_PAYLOAD : STATE_CK_A;
+      break;
+    case STATE_PAYLOAD:
+      if (received < MAX_PAYLOAD) {
+        payload[received] = byte;
+      }
+      checksum(byte);
+      if (++received == length) {
+        state = STATE_CK_A;
+      }
+      break;
+    case STATE_CK_A:
+      frame_ck_a = byte;
+      state = STATE_CK_B;
+      break;
+    case STATE_CK_B:
+      state = STATE_SYNC_1;
+      if (frame_ck_a != ck_a || byte != ck_b) {
+        stats.checksum_errors++;
+      } else if (length > MAX_PAYLOAD) {
+        stats.oversized++;
+      } else {
+        stats.frames++;
+        if (handler) {
+          handler(msg_class, msg_id, payload, length);
+        }
+      }
+      break;
+  }
+  stats.bytes++;
+  return true;
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool ubx_decode_time_pulse(const uint8_t* payload, uint16_t length, UbxTimePulse& pulse) {
+  if (length != 16) {
+    return false;
+  }
+  pulse.tow_ms = read_u32(payload);
+  pulse.tow_sub_ms = read_u32(payload + 4);
+  pulse.qerr_ps = (int32_t)read_u32(payload + 8);
+  pulse.week = (uint16_t)(payload[12] | (payload[13] << 8));
+  pulse.flags = payload[14];
+  pulse.ref_info = payload[15];
+  return true;
+}
+
+size_t ubx_build_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t length,
+                       uint8_t* out, size_t capacity) {
+  size_t size = (size_t)length + 8;
+  if (size > capacity) {
+    return 0;
+  }
+  out[0] = UBX_SYNC_1;
+  out[1] = UBX_SYNC_2;
+  out[2] = msg_class;
+  out[3] = msg_id;
+  out[4] = (uint8_t)length;
+  out[5] = (uint8_t)(length >> 8);
+  if (length > 0) {
+    memcpy(out + 6, payload, length);
+  }
+  uint8_t ck_a = 0;
+  uint8_t ck_b = 0;
+  for (size_t i = 2; i < size - 2; i++) {
+    ck_a = (uint8_t)(ck_a + out[i]);
+    ck_b = (uint8_t)(ck_b + ck_a);
+  }
+  out[size - 2] = ck_a;
+  out[size - 1] = ck_b;
+  return size;
+}
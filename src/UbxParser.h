@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// u-blox UBX binary protocol decoder, fed byte by byte alongside the NMEA
+// parser on the same receiver stream.
+//
+// A frame is 0xB5 0x62 | class | id | length (u16) | payload | CK_A CK_B, the
+// checksum being the 8-bit Fletcher sum over class..payload. 0xB5 never
+// occurs in NMEA text, so encode() claims every byte from a sync character to
+// the end of its frame and returns false for everything else, which goes on
+// to the NMEA parser unchanged. Frames that pass the checksum are handed to
+// the callback; payloads longer than MAX_PAYLOAD are skipped (their bytes are
+// still claimed) and counted. A length beyond MAX_LENGTH can only be a
+// corrupted header; the frame is dropped there rather than swallowing that
+// many NMEA bytes.
+
+static const uint8_t UBX_SYNC_1 = 0xB5;
+static const uint8_t UBX_SYNC_2 = 0x62;
+static const uint8_t UBX_CLASS_CFG = 0x06;
+static const uint8_t UBX_CLASS_TIM = 0x0D;
+static const uint8_t UBX_CFG_MSG = 0x01;  // Message rate: class, id, rate on the current port
+static const uint8_t UBX_TIM_TP = 0x01;   // Time pulse time and quantization error
+
+typedef void (*UbxFrameHandler)(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t length);
+
+// UBX-TIM-TP, sent ahead of the time pulse it describes
+struct UbxTimePulse {
+  uint32_t tow_ms;        // Time of week of the pulse (timeBase in flags)
+  uint32_t tow_sub_ms;    // Fraction of a millisecond, 2^-32 ms
+  int32_t qerr_ps;        // Pulse edge minus the time it stands for
+  uint16_t week;
+  uint8_t flags;          // Bit 0: UTC time base, bit 4: qErr invalid
+  uint8_t ref_info;
+};
+
+static const uint8_t UBX_TP_FLAG_QERR_INVALID = 0x10;
+
+struct UbxParserStats {
+  uint32_t frames;           // Valid checksum, handed to the callback
+  uint32_t checksum_errors;
+  uint32_t oversized;        // Longer than MAX_PAYLOAD, skipped
+  uint32_t bad_lengths;      // Longer than MAX_LENGTH, dropped at the header
+  uint32_t bytes;            // Claimed from the stream
+};
+
+class UbxParser {
+public:
+  static const uint16_t MAX_PAYLOAD = 100;    // Kept and checked; TIM-TP is 16
+  static const uint16_t MAX_LENGTH = 2048;    // Largest frame skipped over
+
+  explicit UbxParser(UbxFrameHandler handler);
+
+  // true if the byte belongs to a UBX frame (do not pass it to the NMEA parser)
+  bool encode(uint8_t byte);
+  void reset();
+
+  const UbxParserStats& get_stats() const { return stats; }
+
+private:
+  enum State : uint8_t {
+    STATE_SYNC_1,
+    STATE_SYNC_2,
+    STATE_CLASS,
+    STATE_ID,
+    STATE_LENGTH_1,
+    STATE_LENGTH_2,
+    STATE_PAYLOAD,
+    STATE_CK_A,
+    STATE_CK_B,
+  };
+
+  void checksum(uint8_t byte);
+
+  UbxFrameHandler handler;
+  UbxParserStats stats;
+  State state;
+  uint8_t msg_class;
+  uint8_t msg_id;
+  uint16_t length;
+  uint16_t received;
+  uint8_t ck_a;
+  uint8_t ck_b;
+  uint8_t frame_ck_a;
+  uint8_t payload[MAX_PAYLOAD];
+};
+
+bool ubx_decode_time_pulse(const uint8_t* payload, uint16_t length, UbxTimePulse& pulse);
+
+// Frames a message for the receiver; returns its size, 0 if it does not fit
+size_t ubx_build_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t length,
+                       uint8_t* out, size_t capacity);
@@ -9,17 +9,45 @@ static const int OLED_RESET_PIN = -1;  // shared reset
 static const uint8_t OLED_PRIMARY_ADDRESS = 0x3D;  // default for many Adafruit boards
 static const uint8_t OLED_FALLBACK_ADDRESS = 0x3C;  // alternate address (also try 0x30 if needed)
 
+// One text row of the 6x8 font per SSD1306 page
+static const uint8_t DISPLAY_ROWS = SCREEN_HEIGHT / 8;
+static const uint8_t DISPLAY_COLUMNS = SCREEN_WIDTH / 6;
+static const size_t DISPLAY_CHUNK_BYTES = 16;       // Framebuffer bytes per I2C transaction
+static const uint32_t DISPLAY_PPS_PHASE_MS = 20;    // Refresh this long after each PPS edge
+static const uint32_t DISPLAY_PPS_STALE_MS = 1500;  // Free-run when PPS is older than this
+static const uint32_t DISPLAY_CLOCK_DURING = 400000;  // Same bus clocks as Adafruit_SSD1306
+static const uint32_t DISPLAY_CLOCK_AFTER = 100000;
+
 static Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET_PIN);
 static bool display_ready = false;
+static uint8_t display_address = 0;
+
+// What is in the framebuffer, row by row; rows that differ from a new render are redrawn
+static char shown_rows[DISPLAY_ROWS][DISPLAY_COLUMNS + 2];
+
+// Page push state: dirty pages go out one small I2C transaction per display_service()
+static uint8_t dirty_pages = 0;
+static int8_t push_page = -1;
+static size_t push_offset = 0;
+
+static uint32_t refresh_interval_ms = 500;
+static uint32_t next_refresh_ms = 0;
+static uint32_t last_pps_ms = 0;
+static bool pps_seen = false;
+
+static DisplayStats stats = {};
 
 bool display_init() {
   Wire.begin();  // default pins SDA/SCL
   if (display.begin(SSD1306_SWITCHCAPVCC, OLED_PRIMARY_ADDRESS)) {
     display_ready = true;
+    display_address = OLED_PRIMARY_ADDRESS;
   } else if (display.begin(SSD1306_SWITCHCAPVCC, OLED_FALLBACK_ADDRESS)) {
     display_ready = true;
+    display_address = OLED_FALLBACK_ADDRESS;
   } else if (display.begin(SSD1306_SWITCHCAPVCC, 0x30)) {
     display_ready = true;
+    display_address = 0x30;
   } else {
     display_ready = false;
     Serial.println("OLED display not detected (addresses tried: 0x3D, 0x3C, 0x30)\r");
@@ -32,107 +60,190 @@ bool display_init() {
   display.setCursor(0, 0);
   display.println(F("Frequency Counter"));
   display.println(F("Initializing..."));
-  display.display();
+  display.display();  // Only full-frame push; everything after this goes page by page
+  display.setTextWrap(false);
+
+  // Force every row to be redrawn on the first refresh
+  for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+    shown_rows[row][0] = '\x01';
+    shown_rows[row][1] = '\0';
+  }
   return true;
 }
 
-void display_update(DisplayStatus const& status) {
-  if (!display_ready) {
-    return;
+// Lays the status out as fixed text rows. Row 7 starts with the output
+// indicator state ('*' filled, 'o' open), drawn as a circle left of the text.
+static void render_rows(DisplayStatus const& status, char rows[][DISPLAY_COLUMNS + 2]) {
+  const size_t n = DISPLAY_COLUMNS + 2;
+  for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+    rows[row][0] = '\0';
   }
 
-  display.clearDisplay();
-  display.setCursor(0, 0);
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-
   if (status.utc_valid) {
-    char buffer[32];
-    snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u %02u:%02u:%02u",
+    snprintf(rows[0], n, "%04u-%02u-%02u %02u:%02u:%02u",
              status.utc.year,
              status.utc.month,
              status.utc.day,
              status.utc.hour,
              status.utc.minute,
              status.utc.second);
-    display.println(buffer);
   } else {
-    display.println(F("UTC: --"));
+    snprintf(rows[0], n, "UTC: --");
   }
+  snprintf(rows[1], n, "Lock: %s", status.pps_locked ? "YES" : "NO");
+  snprintf(rows[2], n, "Up: %lus N=%lu", status.uptime_seconds, status.sample_count);
 
-  display.print(F("Lock: "));
-  display.println(status.pps_locked ? F("YES") : F("NO"));
+  char indicator = status.output_high ? '*' : 'o';
+  snprintf(rows[7], n, "%c", indicator);
 
-  // Show uptime since reboot in total seconds
-  display.print(F("Up: "));
-  display.print(status.uptime_seconds);
-  display.println(F("s"));
+  if (status.sample_count > 0 && status.pps_locked) {
+    // Normal operation - show PPM measurements in ppb
+    snprintf(rows[3], n, "PPB Inst:%.2f", status.ppm_error * 1000.0);
+    snprintf(rows[4], n, "PPB Avg :%.2f", status.ppm_average * 1000.0);
 
-  int16_t indicator_x = 3;
-  int16_t indicator_y = SCREEN_HEIGHT-4;
-  if (status.output_high) {
-    display.fillCircle(indicator_x, indicator_y, 3, SSD1306_WHITE);
+    // Bottom row, right of the output indicator: ADEV at the longest usable tau
+    if (status.adev_valid) {
+      snprintf(rows[7], n, "%cADEV %.1e@%lus", indicator, status.adev, status.adev_tau_seconds);
+    }
   } else {
-    display.drawCircle(indicator_x, indicator_y, 3, SSD1306_WHITE);
-  }
-
-  if (status.calibrating) {
-    // Show calibration status
-    display.print(F("CALIBRATING P"));
-    display.println(status.cal_phase);
-    
-    // Show countdown
-    uint32_t minutes = status.cal_remaining_seconds / 60;
-    uint32_t seconds = status.cal_remaining_seconds % 60;
-    display.print(F("Time: "));
-    display.print(minutes);
-    display.print(F(":"));
-    if (seconds < 10) display.print(F("0"));
-    display.println(seconds);
-    
-    // Show current average in ppb
-    display.print(F("Avg: "));
-    display.print(status.cal_current_ppm * 1000.0, 1);
-    display.println(F(" ppb"));
-    
-    display.print(F("Samples: "));
-    display.println(status.sample_count);
-  } else if (status.sample_count > 0 && status.pps_locked) {
-    // Normal operation - show PPM measurements and calibration offset
-    double ppb_inst = status.ppm_error * 1000.0;
-    double ppb_avg = status.ppm_average * 1000.0;
-    display.print(F("PPB Inst:"));
-    display.println(ppb_inst, 2);
-    display.print(F("PPB Avg :"));
-    display.println(ppb_avg, 2);
-    
-    // Show sample count
-    display.print(F("Samples: "));
-    display.println(status.sample_count);
-    
-    // Show calibration offset in ppb
-    display.print(F("CAL OFFSET: "));
-    display.print(status.cal_offset_ppm * 1000.0, 1);
-    display.println(F("ppb"));
+    snprintf(rows[3], n, "Waiting for PPS");
+  }
+
+  // GPSDO loop: state with phase error and its rms, or time in holdover
+  if (status.loop_phase_valid) {
+    snprintf(rows[5], n, "%s %.0fns rms%.0f", status.loop_state, status.phase_error_ns,
+             status.phase_rms_ns);
   } else {
-    display.println(F("Waiting for PPS"));
-    
-    // Show sample count even when waiting
-    if (status.sample_count > 0) {
-      display.print(F("Samples: "));
-      display.println(status.sample_count);
+    snprintf(rows[5], n, "%s %lus", status.loop_state, status.loop_state_seconds);
+  }
+  snprintf(rows[6], n, "OFFSET: %.2fppb", status.offset_ppm * 1000.0);
+}
+
+static void draw_row(uint8_t row, const char* text) {
+  int16_t y = row * 8;
+  display.fillRect(0, y, SCREEN_WIDTH, 8, SSD1306_BLACK);
+  if (row == DISPLAY_ROWS - 1 && text[0] != '\0') {
+    int16_t indicator_x = 3;
+    int16_t indicator_y = SCREEN_HEIGHT - 4;
+    if (text[0] == '*') {
+      display.fillCircle(indicator_x, indicator_y, 3, SSD1306_WHITE);
+    } else {
+      display.drawCircle(indicator_x, indicator_y, 3, SSD1306_WHITE);
     }
-    
-    // Show calibration offset even when waiting in ppb
-    display.print(F("CAL OFFSET: "));
-    display.print(status.cal_offset_ppm * 1000.0, 1);
-    display.println(F("ppb"));
+    display.setCursor(10, y);
+    display.print(text + 1);
+  } else {
+    display.setCursor(0, y);
+    display.print(text);
   }
+}
 
-  display.display();
+void display_set_refresh_rate(uint8_t hz) {
+  if (hz < 1) hz = 1;
+  if (hz > 10) hz = 10;
+  refresh_interval_ms = 1000 / hz;
+}
+
+uint8_t display_get_refresh_rate() {
+  return (uint8_t)(1000 / refresh_interval_ms);
+}
+
+void display_note_pps(uint32_t now_ms) {
+  last_pps_ms = now_ms;
+  pps_seen = true;
+  next_refresh_ms = now_ms + DISPLAY_PPS_PHASE_MS;
+}
+
+bool display_refresh_due(uint32_t now_ms) {
+  if (!display_ready || dirty_pages != 0 || push_page >= 0) {
+    return false;  // Still pushing the previous refresh
+  }
+  return (int32_t)(now_ms - next_refresh_ms) >= 0;
+}
+
+void display_update(DisplayStatus const& status) {
+  if (!display_ready) {
+    return;
+  }
+
+  uint32_t now_ms = millis();
+  next_refresh_ms += refresh_interval_ms;
+  if ((int32_t)(now_ms - next_refresh_ms) >= 0) {
+    next_refresh_ms = now_ms + refresh_interval_ms;  // Fell behind, don't burst
+  }
+  if (pps_seen && now_ms - last_pps_ms < DISPLAY_PPS_STALE_MS &&
+      next_refresh_ms - last_pps_ms >= 1000) {
+    next_refresh_ms = last_pps_ms + 1000 + DISPLAY_PPS_PHASE_MS;  // Re-phase on the next edge
+  }
+  stats.refreshes++;
+
+  char rows[DISPLAY_ROWS][DISPLAY_COLUMNS + 2];
+  render_rows(status, rows);
+  for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+    if (strcmp(rows[row], shown_rows[row]) != 0) {
+      draw_row(row, rows[row]);
+      strcpy(shown_rows[row], rows[row]);
+      dirty_pages |= (uint8_t)(1 << row);
+      stats.rows_redrawn++;
+    }
+  }
+}
+
+void display_service() {
+  if (!display_ready) {
+    return;
+  }
+  if (push_page < 0) {
+    if (dirty_pages == 0) {
+      return;
+    }
+    push_page = 0;
+    while (!(dirty_pages & (1 << push_page))) {
+      push_page++;
+    }
+    dirty_pages &= (uint8_t)~(1 << push_page);
+    push_offset = 0;
+  }
+
+  uint32_t start_us = micros();
+  Wire.setClock(DISPLAY_CLOCK_DURING);
+  if (push_offset == 0) {
+    // Address window: this page, all columns (horizontal addressing mode)
+    Wire.beginTransmission(display_address);
+    Wire.write((uint8_t)0x00);
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write((uint8_t)push_page);
+    Wire.write((uint8_t)push_page);
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write((uint8_t)0);
+    Wire.write((uint8_t)(SCREEN_WIDTH - 1));
+    Wire.endTransmission();
+  }
+  const uint8_t* page = display.getBuffer() + push_page * SCREEN_WIDTH;
+  Wire.beginTransmission(display_address);
+  Wire.write((uint8_t)0x40);
+  Wire.write(page + push_offset, DISPLAY_CHUNK_BYTES);
+  Wire.endTransmission();
+  Wire.setClock(DISPLAY_CLOCK_AFTER);
+
+  uint32_t elapsed_us = micros() - start_us;
+  if (elapsed_us > stats.max_chunk_us) {
+    stats.max_chunk_us = elapsed_us;
+  }
+  stats.chunks++;
+  stats.bytes_pushed += DISPLAY_CHUNK_BYTES;
+
+  push_offset += DISPLAY_CHUNK_BYTES;
+  if (push_offset >= SCREEN_WIDTH) {
+    push_page = -1;
+    stats.pages_pushed++;
+  }
+}
+
+void display_get_stats(DisplayStats& out) {
+  out = stats;
 }
 
 bool display_available() {
   return display_ready;
 }
-
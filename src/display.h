@@ -21,16 +21,41 @@ struct DisplayStatus {
   DisplayUtcTime utc;
   bool output_high;
   uint32_t uptime_seconds;  // Seconds since reboot
+
+  // Allan deviation at the longest tau with a usable estimate
+  bool adev_valid;
+  uint32_t adev_tau_seconds;
+  double adev;
   
-  // Calibration status
-  bool calibrating;
-  uint32_t cal_remaining_seconds;
-  uint32_t cal_phase;  // 1 or 2
-  double cal_current_ppm;
-  double cal_offset_ppm;  // Current calibration offset
+  // GPSDO loop status
+  const char* loop_state;       // DiscipliningLoop::state_name()
+  bool loop_phase_valid;        // ACQUIRE/TRACK: phase error is meaningful
+  double phase_error_ns;
+  double phase_rms_ns;
+  uint32_t loop_state_seconds;
+  double offset_ppm;            // Oscillator offset currently applied
+};
+
+struct DisplayStats {
+  uint32_t refreshes;      // Renders of DisplayStatus
+  uint32_t rows_redrawn;   // Text rows that actually changed
+  uint32_t pages_pushed;
+  uint32_t chunks;         // I2C data transactions
+  uint32_t bytes_pushed;
+  uint32_t max_chunk_us;   // Longest single display_service() bus hold
 };
 
+// Rendering is change-driven and never blocks for a whole frame:
+//   display_refresh_due() - true at the capped refresh rate, phased just after PPS
+//   display_update()      - renders the status, redraws only rows whose text changed
+//   display_service()     - call every loop(); pushes one small chunk of a dirty page
 bool display_init();
+bool display_refresh_due(uint32_t now_ms);
 void display_update(DisplayStatus const& status);
+void display_service();
+void display_note_pps(uint32_t now_ms);
+void display_set_refresh_rate(uint8_t hz);  // 1..10 Hz
+uint8_t display_get_refresh_rate();
+void display_get_stats(DisplayStats& stats);
 bool display_available();
 
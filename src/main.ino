@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <stdarg.h>
 #include <SD.h>
 #include <SPI.h>
 #include <EEPROM.h>
@@ -6,18 +7,48 @@
 #include "pins.h"
 #include "SiT5501.h"
 #include "display.h"
+#include "FrequencyStats.h"
+#include "StabilityEngine.h"
+#include "PhaseRegression.h"
+#include "GateCounter.h"
+#include "EdgeAnalyzer.h"
+#include "PpsComparator.h"
+#include "PpsSampleFilter.h"
+#include "Disciplining.h"
+#include "DriftModel.h"
+#include "PpsAligner.h"
+#include "Profiler.h"
+#include "TaskScheduler.h"
+#include "GpsLink.h"
+#include "UbxParser.h"
+#include "SawtoothCorrector.h"
+#include "Telemetry.h"
+#include "BinaryLog.h"
+#include "SdLogger.h"
+#include "ScpiParser.h"
+#include "SettingsStore.h"
 #include <ArduinoNmeaParser.h>
 #include <MTP_Teensy.h>
 void onRmcUpdate(nmea::RmcData const rmc);
+void on_ubx_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t length);
 
 SiT5501 oscillator(0x60);
 ArduinoNmeaParser parser(onRmcUpdate, nullptr);
+// UBX frames share Serial1 with the NMEA sentences (TIM-TP for the sawtooth correction)
+UbxParser ubx_parser(on_ubx_frame);
 // PPS/Frequency measurement data structure
 struct PpsData {
   uint32_t ticks;              // Also represents freq_hz (ticks = Hz for 1 second PPS)
-  double avg_freq_hz;          // Running average frequency
+  uint32_t capture_ticks;      // Raw GPT2 capture timestamp closing the interval
+  double avg_freq_hz;          // Average frequency over the last 1000 periods
   double ppm_instantaneous;    // Instantaneous PPM error
-  double ppm_average;          // Average PPM error
+  double ppm_average;          // Average PPM error over the last 1000 periods
+  double ppm_fit;              // Least-squares fit over the longest usable window (NAN until 3 samples)
+  double ppm_fit_sigma;        // ... and its 1-sigma error
+  uint16_t fit_samples;        // Timestamps behind that fit
+  int32_t qerr_ps;             // Receiver quantization error of the last corrected edge
+  double ticks_corrected;      // Last interval with the sawtooth taken off, ticks per second
+  bool has_corrected;          // Both set since the last log record
   bool has_data;
 };
 
@@ -30,81 +61,66 @@ struct GpsData {
   double speed;
   double course;
   double magnetic_variation;
+  uint32_t unix_time;      // GPS UTC time in seconds since 1970
+  uint8_t source_index;    // Index into rmc_source_map
   bool is_valid;
 };
 
-// Statistics class using Welford's algorithm for numerical stability
-class FrequencyStats {
-private:
-  double running_mean;
-  double running_m2;  // Sum of squares of differences from mean
-  uint32_t sample_count;
+// Exact totals plus 10/100/1000/10000-period sliding windows (~85 KB of history: RAM2)
+DMAMEM static FrequencyStats g_freq_stats(10000000);
 
-public:
-  FrequencyStats() : running_mean(0.0), running_m2(0.0), sample_count(0) {}
-  
-  void reset() {
-    running_mean = 0.0;
-    running_m2 = 0.0;
-    sample_count = 0;
-  }
-  
-  void add_sample(double value) {
-    sample_count++;
-    double delta = value - running_mean;
-    running_mean += delta / sample_count;
-    double delta2 = value - running_mean;
-    running_m2 += delta * delta2;
-  }
-  
-  double get_mean() const { return running_mean; }
-  uint32_t get_count() const { return sample_count; }
-  
-  double get_variance() const {
-    return (sample_count > 1) ? (running_m2 / (sample_count - 1)) : 0.0;
-  }
-  
-  double get_std_dev() const {
-    return sqrt(get_variance());
-  }
-  
-  bool has_samples() const {
-    return sample_count > 0;
-  }
-  
-  // Get PPM error relative to reference frequency
-  double get_ppm_error(double reference_hz) const {
-    if (!has_samples()) return 0.0;
-    return ((running_mean - reference_hz) / reference_hz) * 1e6;
-  }
-  
-  // Get PPB error relative to reference frequency  
-  double get_ppb_error(double reference_hz) const {
-    return get_ppm_error(reference_hz) * 1000.0;
-  }
-};
+// Streaming ADEV/MDEV/TDEV over every accepted PPS period (10 MHz ticks, tau0 = 1 s)
+static StabilityEngine g_stability(10000000, 1e-7, 1.0);
 
-static FrequencyStats g_freq_stats;
+// The receiver's sawtooth (UBX-TIM-TP qErr) taken off each edge, and the same
+// statistics over the corrected intervals (whole ns: 1e9 per period)
+static SawtoothCorrector g_sawtooth(10000000);
+static StabilityEngine g_stability_corrected(1000000000, 1e-9, 1.0);
+static int64_t g_corrected_residue_ps = 0;  // Below 1 ns, carried so rounding never accumulates
 
-// Calibration state
-enum CalibrationState {
-  CAL_IDLE,
-  CAL_PHASE1_AVERAGING,  // First phase of averaging
-  CAL_PHASE2_AVERAGING   // Second phase of averaging after offset applied
-};
+// Sliding least-squares fits through the PPS timestamps: sub-tick frequency resolution
+static PhaseRegression g_regression(10000000, 1e-7, 1.0);
 
-struct CalibrationData {
-  CalibrationState state;
-  uint32_t start_time;
-  double phase1_result;
-  double original_offset;
-  uint32_t duration_seconds;  // Configurable calibration duration
-  uint32_t expected_pulses;   // Expected number of pulses for current phase
-  uint32_t missed_pulses;     // Count of missed pulses during calibration
-  bool auto_started;          // True if calibration was auto-started
-};
+// Exact long-gate counts on the 64-bit extended timebase (t<seconds>)
+static GateCounter g_gate(10000000);
+static uint32_t g_gate_logged_index = 0;  // Last gate result written to the JSONL log
+
+// Per-polarity period jitter, TIE and pulse width of the PPS input (i command)
+static EdgeAnalyzer g_edges(10000000);
+
+// Second PPS input on GPT2 capture 2 (pin 40), compared with the GPS PPS on one timebase (ib command)
+static PpsComparator g_pps_compare(10000000);
+
+// Phase alignment of the generated 1 PPS to the captured GPS PPS (k command)
+static PpsAligner g_pps_align(10000000, 100.0);
+
+// GPSDO loop steering the SiT5501 from every accepted PPS period (100 ns ticks)
+static DiscipliningLoop g_discipline(10000000, 100.0);
+static const uint32_t OFFSET_SAVE_INTERVAL_MS = 3600000;  // Learned offset saved at most hourly
+static uint32_t g_last_offset_save_ms = 0;
+static bool g_offset_save_pending = false;  // Set from the capture task, done by the discipline task
+
+// Aging/temperature fit of the learned offsets (one point per hourly save),
+// fed forward into the loop and used for the start-up offset
+static DriftModel g_drift;
+static const uint32_t FEED_FORWARD_INTERVAL_MS = 10000;
+static uint32_t g_last_feed_forward_ms = 0;
+
+// Unix time for the drift model from the RTC: set from GPS, and kept running
+// on VBAT so a reboot without a fix still knows how long it was off
+static const uint32_t RTC_PLAUSIBLE_UNIX = 1704067200;  // 2024-01-01
+static bool g_rtc_from_gps = false;
 
-static CalibrationData g_calibration = {CAL_IDLE, 0, 0.0, 0.0, 300, 0, 0, false};
+// loop() work as scheduled tasks (n command): capture every pass, the rest at what it needs
+static TaskScheduler g_scheduler;
+
+// GPS receiver UART; the link itself handles 115200+ if the receiver is configured for it
+static const uint32_t GPS_BAUD = 9600;
+
+// Framed binary telemetry on SerialUSB1 (q command), in place of the GPS passthrough
+static TelemetryEncoder g_telemetry;
+static bool g_telemetry_enabled = false;
+static uint32_t g_telemetry_health_ms = 0;
 
 // Data structures
 static PpsData g_pps_data = {0};
@@ -115,15 +131,55 @@ static GpsData g_gps_data = {0};
 static bool g_sd_available = false;
 static bool g_pause_updates = false;
 static bool g_verbose_timing = false;  // Start with verbose timing off
-static char g_current_log_file[32] = "";  // Fixed-size buffer for log filename
-static File g_log_file;
+
+// Log file format: human-readable JSONL, or compact 32-byte binary records
+// (see BinaryLog.h) written a whole SD sector at a time
+enum LogFormat : uint8_t {
+  LOG_FORMAT_JSONL = 0,
+  LOG_FORMAT_BINARY = 1,
+};
+static LogFormat g_log_format = LOG_FORMAT_JSONL;
 static uint32_t g_last_pps_millis = 0;
 
+// Turns queued capture events into periods: median/MAD outlier rejection,
+// extra edges dropped and missed edges bridged
+static PpsSampleFilter g_pps_filter(10000000);
+
+// A command waiting for its y/n answer (x): the console never blocks for it,
+// the next key answers and anything else keeps running meanwhile
+struct PendingConfirmation {
+  const char* name;
+  void (*action)();
+  uint32_t deadline_ms;
+  bool active;
+};
+static PendingConfirmation g_confirmation = {nullptr, nullptr, 0, false};
+static const uint32_t CONFIRMATION_TIMEOUT_MS = 30000;
+
 
 // Persistent frequency offset (stored in EEPROM)
 static double g_frequency_offset_ppm = 0.0;  // Default 0.0 ppm (originally 15.26 ppb = 0.01526 ppm)
 
-// EEPROM data structure (version 1 - for migration)
+// Settings journal and calibration history over the whole emulated EEPROM (lh command)
+uint8_t settings_read_byte(uint16_t address);
+void settings_write_byte(uint16_t address, uint8_t value);
+static SettingsStore g_settings(settings_read_byte, settings_write_byte, E2END + 1);
+
+// Settings fields: a tag is never reused or re-encoded; new settings get new tags
+enum SettingsTag : uint8_t {
+  SETTING_FREQUENCY_OFFSET_PPM = 1,  // double
+  SETTING_DUTY_CYCLE = 2,            // uint8_t, percent
+  SETTING_LOG_FORMAT = 3,            // uint8_t, LogFormat
+  SETTING_DRIFT_FIT = 4,             // DriftFit
+  SETTING_PPS_ALIGN_OFFSET_NS = 5,   // int32_t
+  SETTING_PPS_ALIGN_ENABLED = 6,     // uint8_t, 0 or 1
+  SETTING_PPS_ALIGN_MAX_SLEW_NS = 7, // uint32_t, per second
+};
+
+static const uint16_t SETTINGS_LAYOUT_VERSION = 3;  // 1, 2: fixed EepromData structs; 3: SettingsStore
+
+// Fixed structs at address 0 written by older firmware, read once to migrate
+// EEPROM data structure (version 1)
 struct EepromDataV1 {
   uint32_t magic;              // Magic number for validity check
   uint16_t version;            // Data structure version
@@ -131,18 +187,18 @@ struct EepromDataV1 {
   uint16_t checksum;           // Simple checksum for data integrity
 };
 
-// EEPROM data structure (version 2 - current)
+// EEPROM data structure (version 2)
 struct EepromData {
   uint32_t magic;              // Magic number for validity check
   uint16_t version;            // Data structure version
   double frequency_offset_ppm; // Frequency offset in PPM
   uint8_t duty_cycle_percent;  // PPS output duty cycle percentage
-  uint8_t reserved;            // Reserved for future use (alignment)
+  uint8_t log_format;          // LogFormat (was reserved, so older data reads as JSONL)
   uint16_t checksum;           // Simple checksum for data integrity
 };
 
 static const uint32_t EEPROM_MAGIC = 0x12345678;
-static const uint16_t EEPROM_VERSION = 2;  // Incremented for new structure
+static const uint16_t EEPROM_VERSION = 2;
 static const int EEPROM_DATA_ADDR = 0;
 
 
@@ -150,6 +206,25 @@ const char* rmc_source_map[] = {
     "Unknown", "GPS", "Galileo", "GLONASS", "GNSS", "BDS"
 };
 
+// One JSONL log line, built in RAM and queued to the SD logger as a single record.
+// Sized for every field onRmcUpdate can write at once, each at its widest:
+// ,"<name>":<value> with the longest name (gps_magnetic_variation) and a value
+// filling the float_to_json_string buffer. Adding a field there means bumping
+// JSONL_FIELDS; a line that still does not fit is dropped and counted, never
+// queued without its closing brace.
+static const size_t JSONL_FIELDS = 30;
+static const size_t JSONL_MAX_NAME = 22;
+static const size_t JSONL_MAX_VALUE = 31;
+static const size_t JSONL_MAX_LINE = 1 + JSONL_FIELDS * (4 + JSONL_MAX_NAME + JSONL_MAX_VALUE) + 2;
+static_assert(JSONL_MAX_LINE >= 768, "JSONL line buffer below the steady-state record size");
+
+struct JsonLine {
+  char text[JSONL_MAX_LINE + 1];
+  size_t len;
+  bool truncated;
+};
+static uint32_t g_jsonl_truncated = 0;  // Records dropped because they did not fit
+
 // Convert float to JSON string - writes to provided buffer to avoid String allocation
 void float_to_json_string(char* buffer, size_t buffer_size, double value, int precision) {
   if (isnan(value)) {
@@ -160,28 +235,38 @@ void float_to_json_string(char* buffer, size_t buffer_size, double value, int pr
   }
 }
 
-void log_json_field(File& file, const char* name, const char* value, bool is_first = false) {
-  if (!is_first) file.print(",");
-  file.printf("\"%s\":\"%s\"", name, value);
+void json_append(JsonLine& line, const char* format, ...) {
+  if (line.truncated) return;
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(line.text + line.len, sizeof(line.text) - line.len, format, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= sizeof(line.text) - line.len) {
+    line.truncated = true;  // The caller drops the whole line
+    return;
+  }
+  line.len += (size_t)n;
+}
+
+void log_json_field(JsonLine& line, const char* name, const char* value, bool is_first = false) {
+  json_append(line, "%s\"%s\":\"%s\"", is_first ? "" : ",", name, value);
 }
 
-void log_json_field(File& file, const char* name, uint32_t value, bool is_first = false) {
-  if (!is_first) file.print(",");
-  file.printf("\"%s\":%lu", name, value);
+void log_json_field(JsonLine& line, const char* name, uint32_t value, bool is_first = false) {
+  json_append(line, "%s\"%s\":%lu", is_first ? "" : ",", name, value);
 }
 
-void log_json_field_if_valid(File& file, const char* name, double value, int precision) {
+void log_json_field_if_valid(JsonLine& line, const char* name, double value, int precision) {
   if (!isnan(value)) {
     char buffer[32];
     float_to_json_string(buffer, sizeof(buffer), value, precision);
-    file.print(",");
-    file.printf("\"%s\":%s", name, buffer);
+    json_append(line, ",\"%s\":%s", name, buffer);
   }
 }
 
-void log_json_field_if_valid(File& file, const char* name, uint32_t value) {
+void log_json_field_if_valid(JsonLine& line, const char* name, uint32_t value) {
   if (value != 0) {  // Assume 0 means invalid for uint32_t
-    log_json_field(file, name, value);
+    log_json_field(line, name, value);
   }
 }
 
@@ -203,6 +288,14 @@ void onRmcUpdate(nmea::RmcData const rmc)
 	         "%04d-%02d-%02dT%02d:%02d:%02dZ",
 	         rmc.date.year, rmc.date.month, rmc.date.day,
 	         rmc.time_utc.hour, rmc.time_utc.minute, rmc.time_utc.second);
+	g_gps_data.unix_time = binlog_unix_time(rmc.date.year, rmc.date.month, rmc.date.day,
+	                                        rmc.time_utc.hour, rmc.time_utc.minute, rmc.time_utc.second);
+	uint32_t rtc_now = rtc_get();
+	if (!g_rtc_from_gps || rtc_now + 1 < g_gps_data.unix_time || rtc_now > g_gps_data.unix_time + 1) {
+	    rtc_set(g_gps_data.unix_time);
+	    g_rtc_from_gps = true;
+	}
+	g_gps_data.source_index = (uint8_t)rmc_source_i;
 	strncpy(g_gps_data.source, rmc_source_s, sizeof(g_gps_data.source) - 1);
 	g_gps_data.source[sizeof(g_gps_data.source) - 1] = '\0';  // Ensure null termination
 	g_gps_data.latitude = rmc.latitude;
@@ -212,8 +305,10 @@ void onRmcUpdate(nmea::RmcData const rmc)
 	g_gps_data.magnetic_variation = rmc.magnetic_variation;
 	g_gps_data.is_valid = true;
 
+	ProfileScope profile(PROFILE_LOG_RECORD);
+
 	// Create log file on first GPS message using GPS timestamp
-	if (!g_log_file && g_sd_available) {
+	if (!sd_logger_is_open() && g_sd_available) {
 	    // Create filename from GPS timestamp (replace : with - for filesystem compatibility)
 	    char filename[32];
 	    strncpy(filename, g_gps_data.timestamp, sizeof(filename) - 7);  // Leave room for ".jsonl"
@@ -223,56 +318,155 @@ void onRmcUpdate(nmea::RmcData const rmc)
 	    for (int i = 0; filename[i] != '\0'; i++) {
 	        if (filename[i] == ':') filename[i] = '-';
 	    }
-	    strcat(filename, ".jsonl");
-	    
-	    strncpy(g_current_log_file, filename, sizeof(g_current_log_file) - 1);
-	    g_current_log_file[sizeof(g_current_log_file) - 1] = '\0';
-	    g_log_file = SD.open(filename, FILE_WRITE);
+	    strcat(filename, g_log_format == LOG_FORMAT_BINARY ? ".fcb" : ".jsonl");
 	    
-	    if (g_log_file) {
+	    // Binary logs pad partial sectors with empty records, JSONL with blank lines
+	    uint8_t pad_byte = g_log_format == LOG_FORMAT_BINARY ? 0x00 : '\n';
+	    if (sd_logger_open(filename, pad_byte)) {
 	        Serial.printf("Created GPS-timestamped log file: %s\r\n", filename);
+	        if (g_log_format == LOG_FORMAT_BINARY) {
+	            begin_binary_log();
+	        }
 	    } else {
 	        Serial.printf("Failed to create log file: %s\r\n", filename);
 	    }
 	}
 
+	if (g_log_format == LOG_FORMAT_BINARY) {
+	    if (sd_logger_is_open()) {
+	        log_binary_record();
+	    }
+	    return;
+	}
+
 	// Create combined log entry with both frequency and GPS data
-	if (g_pps_data.has_data && g_log_file) {
+	if (g_pps_data.has_data && sd_logger_is_open()) {
 	    // Calculate derived values
 	    double freq_hz = (double)g_pps_data.ticks;  // ticks = Hz for 1 second PPS
 	    
 	    // Start JSON object
-	    g_log_file.print("{");
+	    JsonLine line;
+	    line.len = 0;
+	    line.truncated = false;
+	    json_append(line, "{");
 	    
 	    // GPS timestamp and source (always present)
-            log_json_field(g_log_file, "gps_timestamp", g_gps_data.timestamp, true);
-            log_json_field(g_log_file, "gps_source", g_gps_data.source);
+            log_json_field(line, "gps_timestamp", g_gps_data.timestamp, true);
+            log_json_field(line, "gps_source", g_gps_data.source);
 	    
 	    // GPS data (only if valid)
-	    log_json_field_if_valid(g_log_file, "gps_lat", g_gps_data.latitude, 6);
-	    log_json_field_if_valid(g_log_file, "gps_lon", g_gps_data.longitude, 6);
-	    log_json_field_if_valid(g_log_file, "gps_speed", g_gps_data.speed, 4);
-	    log_json_field_if_valid(g_log_file, "gps_course", g_gps_data.course, 2);
-	    log_json_field_if_valid(g_log_file, "gps_magnetic_variation", g_gps_data.magnetic_variation, 4);
+	    log_json_field_if_valid(line, "gps_lat", g_gps_data.latitude, 6);
+	    log_json_field_if_valid(line, "gps_lon", g_gps_data.longitude, 6);
+	    log_json_field_if_valid(line, "gps_speed", g_gps_data.speed, 4);
+	    log_json_field_if_valid(line, "gps_course", g_gps_data.course, 2);
+	    log_json_field_if_valid(line, "gps_magnetic_variation", g_gps_data.magnetic_variation, 4);
 	    
 	    // Frequency data (only if valid)
-	    log_json_field_if_valid(g_log_file, "ticks", g_pps_data.ticks);
-	    log_json_field_if_valid(g_log_file, "freq_hz", freq_hz, 6);
-	    log_json_field_if_valid(g_log_file, "avg_freq_hz", g_pps_data.avg_freq_hz, 12);
-	    log_json_field_if_valid(g_log_file, "ppm_instantaneous", g_pps_data.ppm_instantaneous, 6);
-	    log_json_field_if_valid(g_log_file, "ppm_average", g_pps_data.ppm_average, 6);
-	    log_json_field_if_valid(g_log_file, "oscillator_offset_ppm", g_frequency_offset_ppm, 6);
+	    log_json_field_if_valid(line, "ticks", g_pps_data.ticks);
+	    if (g_pps_data.has_corrected) {
+	        // The same interval with the receiver's sawtooth taken off both edges
+	        json_append(line, ",\"qerr_ps\":%ld", (long)g_pps_data.qerr_ps);
+	        log_json_field_if_valid(line, "ticks_corrected", g_pps_data.ticks_corrected, 3);
+	    }
+	    log_json_field_if_valid(line, "freq_hz", freq_hz, 6);
+	    log_json_field_if_valid(line, "avg_freq_hz", g_pps_data.avg_freq_hz, 12);
+	    log_json_field_if_valid(line, "ppm_instantaneous", g_pps_data.ppm_instantaneous, 6);
+	    log_json_field_if_valid(line, "ppm_average", g_pps_data.ppm_average, 6);
+	    log_json_field_if_valid(line, "ppm_fit", g_pps_data.ppm_fit, 6);
+	    log_json_field_if_valid(line, "ppm_fit_sigma", g_pps_data.ppm_fit_sigma, 6);
+	    log_json_field_if_valid(line, "fit_samples", (uint32_t)g_pps_data.fit_samples);
+	    log_json_field_if_valid(line, "oscillator_offset_ppm", g_frequency_offset_ppm, 6);
+	    log_json_field(line, "loop_state", DiscipliningLoop::state_name(g_discipline.get_state()));
+	    if (g_discipline.get_state() == DISCIPLINE_ACQUIRE || g_discipline.get_state() == DISCIPLINE_TRACK) {
+	        log_json_field_if_valid(line, "phase_error_ns", g_discipline.get_phase_error_ns(), 1);
+	    }
+	    if (g_pps_align.has_measurement()) {
+	        log_json_field(line, "pps_align", PpsAligner::state_name(g_pps_align.get_state()));
+	        log_json_field_if_valid(line, "pps_out_error_ns", g_pps_align.get_phase_error_ns(), 1);
+	    }
+
+	    double pps2_ppb;
+	    if (gpt2_get_capture2_edge() != GPT_EDGE_DISABLED && g_pps_compare.get_input_ppb(1, pps2_ppb)) {
+	        log_json_field_if_valid(line, "pps2_ppb", pps2_ppb, 3);
+	        if (g_pps_compare.get_phase().pairs > 0) {
+	            json_append(line, ",\"pps2_phase_ns\":%lld", (long long)g_pps_compare.get_phase().last_ticks * 100);
+	        }
+	    }
+	    if (g_edges.has_data()) {
+	        const EdgeStreamStats& edges = g_edges.get_stream(gpt2_get_capture_edge() != GPT_EDGE_FALLING);
+	        log_json_field_if_valid(line, "jitter_rms_ns", edges.jitter_rms_ticks * 100.0, 1);
+	        json_append(line, ",\"tie_ns\":%lld", (long long)edges.tie_ticks * 100);
+	        PulseWidthStats pulse;
+	        if (g_edges.get_pulse_width(pulse)) {
+	            log_json_field_if_valid(line, "pulse_width_us", pulse.last_ticks / 10.0, 1);
+	        }
+	    }
+
+	    // Each completed gate once, as exact integers: ticks = gate_s * 1e7 + gate_error_ticks
+	    GateResult gate;
+	    if (g_gate.get_result(gate) && gate.index != g_gate_logged_index) {
+	        g_gate_logged_index = gate.index;
+	        log_json_field(line, "gate_s", gate.seconds);
+	        json_append(line, ",\"gate_error_ticks\":%lld", (long long)gate.error_ticks);
+	        log_json_field(line, "gate_edges", gate.edges);
+	    }
 	    
 	    // End JSON object
-	    g_log_file.println("}");
-	    g_log_file.flush();
+	    json_append(line, "}\n");
+	    if (line.truncated) {
+	        g_jsonl_truncated++;
+	    } else {
+	        sd_logger_write(line.text, line.len);  // Queued; written by sd_logger_service()
+	    }
 	    
 	    // Reset frequency data flag after logging
 	    g_pps_data.has_data = false;
+	    g_pps_data.has_corrected = false;
 	}
     }
 }
 
+void begin_binary_log() {
+  BinaryLogHeader header = {};
+  header.magic = BINLOG_MAGIC;
+  header.version = BINLOG_VERSION;
+  header.record_size = sizeof(BinaryLogRecord);
+  header.nominal_hz = 10000000;
+  header.created_unix = g_gps_data.unix_time;
+  sd_logger_write(&header, sizeof(header));
+}
+
+void log_binary_record() {
+  BinaryLogRecord record = {};
+  record.flags = BINLOG_FLAG_RECORD | binlog_loop_flags(g_discipline.get_state());
+  record.gps_source = g_gps_data.source_index;
+  record.gps_unix = g_gps_data.unix_time;
+  if (!isnan(g_gps_data.latitude) && !isnan(g_gps_data.longitude)) {
+    record.flags |= BINLOG_FLAG_GPS_FIX;
+    record.lat_e7 = binlog_fixed(g_gps_data.latitude, 1e7);
+    record.lon_e7 = binlog_fixed(g_gps_data.longitude, 1e7);
+  }
+  record.osc_offset_cppb = binlog_fixed(g_frequency_offset_ppm, 1e5);
+  if (g_pps_data.has_data) {
+    record.flags |= BINLOG_FLAG_PPS_DATA;
+    record.ticks = g_pps_data.ticks;
+    record.capture_ticks = g_pps_data.capture_ticks;
+    record.ppm_average_cppb = binlog_fixed(g_pps_data.ppm_average, 1e5);
+    g_pps_data.has_data = false;
+  }
+  if (g_pps_data.has_corrected) {
+    record.flags |= BINLOG_FLAG_QERR;
+    record.qerr_ns = binlog_qerr_ns(g_pps_data.qerr_ps);
+    g_pps_data.has_corrected = false;
+  }
+  sd_logger_write(&record, sizeof(record));
+}
+
+// Closes the current log file so the next RMC sentence opens a new one
+void close_log_file() {
+  sd_logger_close();
+}
+
 void check_gpt2_counter() {
   Serial.println("Checking if GPT2 counter is running...\r");
   uint32_t count1 = GPT2_CNT;
@@ -311,18 +505,37 @@ void increase_peripheral_clock() {
 void print_mode_commands() {
   Serial.println("System Control:\r");
   Serial.println("  s - Show current status\r");
-  Serial.println("  r - Reset frequency measurement statistics\r");
+  Serial.println("  r - Reset frequency measurement and stability statistics\r");
+  Serial.println("  a - Show Allan/Modified Allan/Time deviation table\r");
+  Serial.println("  w       - Show least-squares frequency fits with error bars\r");
+  Serial.println("  w<n,..> - Set fit windows in seconds (up to 4, e.g., w10,60,300,1000)\r");
+  Serial.println("  t       - Show gate time and the last exact gate count\r");
+  Serial.println("  t<s>    - Set gate time in PPS seconds (e.g., t1, t10, t100, t1000)\r");
   Serial.println("  c - Cycle GPS PPS capture edge (rising/falling/both)\r");
-  Serial.printf("  l       - Start calibration procedure (2x %lu second averaging)\r\n", g_calibration.duration_seconds);
-  Serial.println("  l<time> - Start calibration with custom duration in seconds (e.g., l60 or l600)\r");
+  Serial.println("  i       - Show PPS edge analysis: period jitter histogram, TIE, pulse width\r");
+  Serial.println("  ir      - Reset the edge analysis\r");
+  Serial.printf("  ib      - Compare the second PPS input (pin %d) with the GPS PPS\r\n", GPT2_CAPTURE2_PIN);
+  Serial.println("  ib1/ib0 - Enable / disable the second PPS input (rising edges)\r");
+  Serial.println("  ibr     - Reset the input comparison\r");
+  Serial.println("  l       - Show GPSDO loop status\r");
+  Serial.println("  lh      - Show saved calibration history and settings storage\r");
+  Serial.println("  l1      - (Re)start GPSDO disciplining from the current offset\r");
+  Serial.println("  l0      - Stop disciplining and hold the current offset\r");
+  Serial.printf("  l<tau>  - Set tracking time constant in seconds (10-100000, now %lu)\r\n",
+                g_discipline.get_config().track_time_constant_s);
 }
 
 void print_output_commands() {
   Serial.println("Output Generation (Always Active):\r");
   Serial.println("  f       - Re-arm GPT-driven 1 PPS output\r");
+  Serial.println("  f<hz>   - Set output frequency, 1-50000 Hz with up to 3 decimals (e.g., f1234.567)\r");
   Serial.println("  g0/g1   - Force PPS output low/high via GPIO\r");
   Serial.println("  d       - Show current PPS output duty cycle\r");
   Serial.println("  d<pct>  - Set PPS output duty cycle (20-80%, e.g., d20 or d50)\r");
+  Serial.println("  k       - Show PPS output alignment to the GPS PPS\r");
+  Serial.println("  k0/k1   - Disable/enable aligning the 1 PPS output to the GPS PPS\r");
+  Serial.println("  ko<ns>  - Output edge relative to the GPS edge (e.g., ko-150 leads by 150 ns)\r");
+  Serial.println("  ks<ns>  - Maximum alignment slew per second (default 10000 ns)\r");
 }
 
 void print_oscillator_commands() {
@@ -331,14 +544,28 @@ void print_oscillator_commands() {
   Serial.println("  p       - Show current frequency offset\r");
   Serial.println("  e       - Enable oscillator output\r");
   Serial.println("  z       - Disable oscillator output\r");
+  Serial.println("  y       - Show frequency update statistics (latency, read-back checks)\r");
+  Serial.println("  y<s>    - Set control word read-back interval in seconds (0 = off)\r");
 }
 
 void print_other_commands() {
   Serial.println("Other:\r");
   Serial.println("  h       - Show this help\r");
   Serial.println("  v       - Toggle verbose timing output (currently OFF)\r");
-  Serial.println("  x       - Clear EEPROM and reset all settings to defaults\r");
+  Serial.println("  u       - Show OLED refresh rate and rendering statistics\r");
+  Serial.println("  u<hz>   - Set OLED refresh rate (1-10 Hz, phased just after each PPS)\r");
+  Serial.println("  m       - Show log file format\r");
+  Serial.println("  m0/m1   - Log as JSONL / compact binary (.fcb), starts a new log file\r");
+  Serial.println("  j       - Show loop() profile: per-stage times, histograms, worst iteration\r");
+  Serial.println("  jr      - Reset the loop() profile\r");
+  Serial.println("  n       - Show scheduled tasks: runs, run times, deadline misses, overruns\r");
+  Serial.println("  nr      - Reset task statistics\r");
+  Serial.println("  q       - Show binary telemetry status\r");
+  Serial.println("  q0/q1   - Stream framed binary telemetry on SerialUSB1 (replaces GPS passthrough)\r");
+  Serial.println("  x       - Clear saved settings and calibration history (asks y/n)\r");
   Serial.println("  b       - Reboot to bootloader mode\r");
+  Serial.println("Machine queries (one JSON line per request, ';' batches, not echoed):\r");
+  Serial.println("  *IDN?  :MEAS:FREQ?  :MEAS:WIND?  :MEAS:STAB?  :MEAS:FILT?  :GPS?  :LOOP?  :SYST:HEAL?\r");
 }
 
 void print_help() {
@@ -380,6 +607,7 @@ void print_startup_info() {
 void initialize_gpt2() {
   increase_peripheral_clock();
   gpt2_begin_dual_mode(1, GPT_EDGE_RISING, true);  // 1 PPS output, rising edge capture
+  gpt2_enable_interrupts(true);  // Capture/compare serviced from the ISR, never lost to a slow loop()
   check_gpt2_counter();
 }
 
@@ -401,7 +629,8 @@ void initialize_mtp() {
 }
     
 void setup() {
-  Serial1.begin(9600);
+  gps_link_begin(GPS_BAUD);
+  enable_time_pulse_reports();
   setup_pins();
   Serial.begin(115200);
   SerialUSB1.begin(115200);
@@ -410,6 +639,7 @@ void setup() {
   print_startup_info();
   initialize_sd_card();
   initialize_mtp();
+  profiler_begin();
   initialize_gpt2();
   initialize_oscillator();
   if (display_init()) {
@@ -417,22 +647,69 @@ void setup() {
   } else {
     Serial.println("OLED display unavailable, continuing without it\r");
   }
-  load_settings();  // Load persistent settings (frequency offset and duty cycle)
+  load_settings();  // Load persistent settings (frequency offset, duty cycle, log format)
 
   print_help();
   Serial.println("System initialized. 1 PPS output active, GPS PPS monitoring enabled.\r\n");
   
+  apply_startup_prediction();
+
   // Apply the loaded frequency offset
   oscillator.setFrequencyOffsetPPM(g_frequency_offset_ppm);
   Serial.printf("Applied frequency offset: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
 
+  // Discipline from the saved offset, so a warm start locks quickly
+  if (oscillator.isPresent()) {
+    DisciplineConfig config = g_discipline.get_config();
+    config.limit_ppb = oscillator.getPullRange() * 1000.0;
+    g_discipline.set_config(config);
+    g_discipline.start(g_frequency_offset_ppm * 1000.0, millis());
+    Serial.println("GPSDO disciplining started\r");
+  }
+  initialize_scheduler();  // Last, so no task starts out late
 }
 
 
+// The saved offset is where the oscillator was at the last save; with a
+// drift fit and a running RTC, start from where the model puts it now
+void apply_startup_prediction() {
+  uint32_t unix_time;
+  double predicted;
+  double sigma;
+  if (!current_unix_time(unix_time) || !g_drift.has_fit() ||
+      unix_time < g_drift.get_fit().reference_time ||
+      unix_time - g_drift.get_fit().reference_time > 365u * 86400u ||
+      !g_drift.predict(unix_time, tempmonGetTemp(), predicted, sigma)) {
+    return;
+  }
+  double pull_range = oscillator.isPresent() ? oscillator.getPullRange() : 50.0;
+  if (fabs(predicted / 1000.0) > pull_range) {
+    return;
+  }
+  Serial.printf("Drift model: starting at %.1f +- %.1f ppb predicted for now (saved %.1f ppb, fit %.1f days old)\r\n",
+                predicted, sigma, g_frequency_offset_ppm * 1000.0,
+                (unix_time - g_drift.get_fit().reference_time) / 86400.0);
+  g_frequency_offset_ppm = predicted / 1000.0;
+}
+
 void reset_measurement_stats() {
   g_freq_stats.reset();
 }
 
+void reset_capture_tracking() {
+  g_pps_filter.reset();
+  g_sawtooth.reset();
+  g_gate.reset();
+  g_edges.reset();
+  g_pps_compare.reset();
+  g_gate_logged_index = 0;
+  g_stability.mark_gap();
+  g_stability_corrected.mark_gap();
+  g_regression.mark_gap();
+  g_discipline.mark_gap();
+  g_pps_align.mark_restart();
+}
+
 uint16_t calculate_checksum(const EepromData& data) {
   uint16_t checksum = 0;
   const uint8_t* bytes = (const uint8_t*)&data;
@@ -459,107 +736,148 @@ uint16_t calculate_checksum_v1(const EepromDataV1& data) {
   return checksum;
 }
 
-bool migrate_from_v1() {
+uint8_t settings_read_byte(uint16_t address) {
+  return EEPROM.read(address);
+}
+
+void settings_write_byte(uint16_t address, uint8_t value) {
+  EEPROM.update(address, value);  // Unchanged bytes cost no flash write
+}
+
+bool valid_frequency_offset(double offset_ppm) {
+  double pull_range = oscillator.isPresent() ? oscillator.getPullRange() : 50.0; // Default to reasonable range if oscillator not present
+  if (isnan(offset_ppm) || offset_ppm < -pull_range || offset_ppm > pull_range) {
+    Serial.printf("Saved frequency offset out of range (±%.0f ppb), using 0\r\n", pull_range * 1000.0);
+    return false;
+  }
+  return true;
+}
+
+// The V2 or V1 struct of older firmware, if present
+bool load_legacy_settings() {
+  EepromData data;
+  EEPROM.get(EEPROM_DATA_ADDR, data);
+  if (data.magic == EEPROM_MAGIC && data.version == EEPROM_VERSION && data.checksum == calculate_checksum(data)) {
+    if (!valid_frequency_offset(data.frequency_offset_ppm)) {
+      return false;
+    }
+    g_frequency_offset_ppm = data.frequency_offset_ppm;
+    bool duty_valid = data.duty_cycle_percent >= 20 && data.duty_cycle_percent <= 80;
+    gpt2_set_duty_cycle(duty_valid ? data.duty_cycle_percent : 20);
+    g_log_format = (data.log_format == LOG_FORMAT_BINARY) ? LOG_FORMAT_BINARY : LOG_FORMAT_JSONL;
+    Serial.printf("Migrated EEPROM V2 settings: frequency offset %.1f ppb, duty cycle %u%%\r\n",
+                  g_frequency_offset_ppm * 1000.0, gpt2_get_duty_cycle());
+    return true;
+  }
+
   EepromDataV1 old_data;
   EEPROM.get(EEPROM_DATA_ADDR, old_data);
-  
-  // Validate V1 data
   if (old_data.magic != EEPROM_MAGIC || old_data.version != 1) {
-    return false;  // Not valid V1 data
+    return false;
   }
-  
-  // Validate V1 checksum
-  uint16_t calculated_checksum = calculate_checksum_v1(old_data);
-  if (old_data.checksum != calculated_checksum) {
+  if (old_data.checksum != calculate_checksum_v1(old_data)) {
     Serial.println("V1 EEPROM checksum invalid, cannot migrate\r");
     return false;
   }
-  
-  // Validate frequency offset range
-  double pull_range = oscillator.isPresent() ? oscillator.getPullRange() : 50.0;
-  if (isnan(old_data.frequency_offset_ppm) || 
-      old_data.frequency_offset_ppm < -pull_range || 
-      old_data.frequency_offset_ppm > pull_range) {
-    Serial.printf("V1 frequency offset out of range (±%.0f ppb), cannot migrate\r\n", pull_range * 1000.0);
+  if (!valid_frequency_offset(old_data.frequency_offset_ppm)) {
     return false;
   }
-  
-  // Migration successful - preserve PPM offset, set default duty cycle
+  // Preserve PPM offset, set default duty cycle
   g_frequency_offset_ppm = old_data.frequency_offset_ppm;
-  gpt2_set_duty_cycle(20);  // Default duty cycle for migration
-  
-  Serial.printf("Migrated from EEPROM V1: frequency offset %.1f ppb, duty cycle set to default 20%%\r\n", 
+  gpt2_set_duty_cycle(20);
+  Serial.printf("Migrated from EEPROM V1: frequency offset %.1f ppb, duty cycle set to default 20%%\r\n",
                 g_frequency_offset_ppm * 1000.0);
-  
-  // Save as V2 format
-  save_settings();
-  
   return true;
 }
 
 void load_settings() {
-  EepromData data;
-  EEPROM.get(EEPROM_DATA_ADDR, data);
-  
-  // Validate magic number and version
-  if (data.magic != EEPROM_MAGIC || data.version != EEPROM_VERSION) {
-    // Try to migrate from V1 before using defaults
-    if (migrate_from_v1()) {
-      return;  // Migration successful, settings are now loaded and saved as V2
+  if (!g_settings.begin()) {
+    // Nothing journaled yet: take over the fixed struct of older firmware, once
+    if (!load_legacy_settings()) {
+      Serial.println("No saved settings, using defaults\r");
+      g_frequency_offset_ppm = 0.0;  // Default to 0 ppm
+      gpt2_set_duty_cycle(20);       // Default to 20% duty cycle
     }
-    
-    Serial.println("EEPROM data invalid or outdated, using defaults\r");
-    g_frequency_offset_ppm = 0.0;  // Default to 0 ppm
-    gpt2_set_duty_cycle(20);       // Default to 20% duty cycle
-    save_settings();
-    return;
-  }
-  
-  // Validate checksum
-  uint16_t calculated_checksum = calculate_checksum(data);
-  if (data.checksum != calculated_checksum) {
-    Serial.println("EEPROM checksum invalid, using defaults\r");
-    g_frequency_offset_ppm = 0.0;  // Default to 0 ppm
-    gpt2_set_duty_cycle(20);       // Default to 20% duty cycle
-    save_settings();
-    return;
-  }
-  
-  // Validate frequency offset range
-  double pull_range = oscillator.isPresent() ? oscillator.getPullRange() : 50.0; // Default to reasonable range if oscillator not present
-  if (isnan(data.frequency_offset_ppm) || data.frequency_offset_ppm < -pull_range || data.frequency_offset_ppm > pull_range) {
-    Serial.printf("EEPROM frequency offset out of range (±%.0f ppb), using defaults\r\n", pull_range * 1000.0);
-    g_frequency_offset_ppm = 0.0;  // Default to 0 ppm
-    gpt2_set_duty_cycle(20);       // Default to 20% duty cycle
     save_settings();
     return;
   }
-  
-  // Validate duty cycle range
-  if (data.duty_cycle_percent < 20 || data.duty_cycle_percent > 80) {
-    Serial.printf("EEPROM duty cycle out of range (%u%%), using default 20%%\r\n", data.duty_cycle_percent);
-    gpt2_set_duty_cycle(20);       // Default to 20% duty cycle
-  } else {
-    gpt2_set_duty_cycle(data.duty_cycle_percent);
-    Serial.printf("Loaded duty cycle: %u%%\r\n", data.duty_cycle_percent);
+
+  // Missing fields (older snapshots) keep their defaults
+  double offset_ppm = 0.0;
+  uint8_t duty_cycle = 20;
+  uint8_t log_format = LOG_FORMAT_JSONL;
+  g_settings.get_field(SETTING_FREQUENCY_OFFSET_PPM, &offset_ppm, sizeof(offset_ppm));
+  g_settings.get_field(SETTING_DUTY_CYCLE, &duty_cycle, sizeof(duty_cycle));
+  g_settings.get_field(SETTING_LOG_FORMAT, &log_format, sizeof(log_format));
+  DriftFit fit;
+  if (g_settings.get_field(SETTING_DRIFT_FIT, &fit, sizeof(fit))) {
+    g_drift.restore(fit);
+  }
+  int32_t align_offset_ns = 0;
+  uint8_t align_enabled = 0;
+  uint32_t align_slew_ns = PpsAligner::DEFAULT_MAX_SLEW_NS;
+  g_settings.get_field(SETTING_PPS_ALIGN_OFFSET_NS, &align_offset_ns, sizeof(align_offset_ns));
+  g_settings.get_field(SETTING_PPS_ALIGN_ENABLED, &align_enabled, sizeof(align_enabled));
+  g_settings.get_field(SETTING_PPS_ALIGN_MAX_SLEW_NS, &align_slew_ns, sizeof(align_slew_ns));
+
+  g_frequency_offset_ppm = valid_frequency_offset(offset_ppm) ? offset_ppm : 0.0;
+  if (duty_cycle < 20 || duty_cycle > 80) {
+    Serial.printf("Saved duty cycle out of range (%u%%), using default 20%%\r\n", duty_cycle);
+    duty_cycle = 20;
+  }
+  gpt2_set_duty_cycle(duty_cycle);
+  g_log_format = (log_format == LOG_FORMAT_BINARY) ? LOG_FORMAT_BINARY : LOG_FORMAT_JSONL;
+  if (align_offset_ns < -500000000L || align_offset_ns > 500000000L) align_offset_ns = 0;
+  if (align_slew_ns < 100 || align_slew_ns > 1000000UL) align_slew_ns = PpsAligner::DEFAULT_MAX_SLEW_NS;
+  g_pps_align.set_offset_ns(align_offset_ns);
+  g_pps_align.set_max_slew_ns(align_slew_ns);
+  g_pps_align.set_enabled(align_enabled == 1);
+
+  const SettingsStoreStats& stats = g_settings.get_stats();
+  Serial.printf("Loaded settings record %lu (bank %u, %u/%u bytes, %u calibrations)\r\n",
+                stats.sequence, stats.active_bank, stats.used, stats.bank_size,
+                g_settings.get_calibration_count());
+  Serial.printf("Loaded frequency offset: %.1f ppb, duty cycle: %u%%\r\n",
+                g_frequency_offset_ppm * 1000.0, duty_cycle);
+  if (g_pps_align.is_enabled() || align_offset_ns != 0) {
+    Serial.printf("Loaded PPS alignment: %s, offset %ld ns, slew %lu ns/s\r\n",
+                  g_pps_align.is_enabled() ? "on" : "off", (long)align_offset_ns, align_slew_ns);
   }
-  
-  g_frequency_offset_ppm = data.frequency_offset_ppm;
-  Serial.printf("Loaded frequency offset: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
 }
 
+// Appends a snapshot only if a value changed
 void save_settings() {
-  EepromData data;
-  data.magic = EEPROM_MAGIC;
-  data.version = EEPROM_VERSION;
-  data.frequency_offset_ppm = g_frequency_offset_ppm;
-  data.duty_cycle_percent = gpt2_get_duty_cycle();
-  data.reserved = 0;  // Clear reserved field
-  data.checksum = calculate_checksum(data);
-  
-  EEPROM.put(EEPROM_DATA_ADDR, data);
-  Serial.printf("Saved frequency offset: %.1f ppb, duty cycle: %u%%\r\n", 
-                g_frequency_offset_ppm * 1000.0, data.duty_cycle_percent);
+  uint8_t duty_cycle = gpt2_get_duty_cycle();
+  uint8_t log_format = (uint8_t)g_log_format;
+  g_settings.set_field(SETTING_FREQUENCY_OFFSET_PPM, &g_frequency_offset_ppm, sizeof(g_frequency_offset_ppm));
+  g_settings.set_field(SETTING_DUTY_CYCLE, &duty_cycle, sizeof(duty_cycle));
+  g_settings.set_field(SETTING_LOG_FORMAT, &log_format, sizeof(log_format));
+  if (g_drift.has_fit()) {
+    g_settings.set_field(SETTING_DRIFT_FIT, &g_drift.get_fit(), sizeof(DriftFit));
+  }
+  int32_t align_offset_ns = g_pps_align.get_offset_ns();
+  uint8_t align_enabled = g_pps_align.is_enabled() ? 1 : 0;
+  uint32_t align_slew_ns = g_pps_align.get_max_slew_ns();
+  g_settings.set_field(SETTING_PPS_ALIGN_OFFSET_NS, &align_offset_ns, sizeof(align_offset_ns));
+  g_settings.set_field(SETTING_PPS_ALIGN_ENABLED, &align_enabled, sizeof(align_enabled));
+  g_settings.set_field(SETTING_PPS_ALIGN_MAX_SLEW_NS, &align_slew_ns, sizeof(align_slew_ns));
+  if (g_settings.commit()) {
+    Serial.printf("Saved frequency offset: %.1f ppb, duty cycle: %u%%\r\n",
+                  g_frequency_offset_ppm * 1000.0, duty_cycle);
+  }
+}
+
+// Adds the current offset to the calibration history (source: 0 manual, 1 loop)
+void record_calibration(uint8_t source) {
+  SettingsCalibration entry = {};
+  entry.gps_time = g_gps_data.is_valid ? g_gps_data.unix_time : 0;
+  entry.offset_cppb = binlog_fixed(g_frequency_offset_ppm, 1e5);
+  entry.source = source;
+  entry.loop_state = (uint8_t)g_discipline.get_state();
+  entry.temperature_ck = (uint16_t)((tempmonGetTemp() + 273.15f) * 100.0f + 0.5f);
+  if (!g_settings.add_calibration(entry)) {
+    Serial.println("Error: calibration record not saved\r");
+  }
 }
 
 bool initialize_sd_card() {
@@ -579,11 +897,299 @@ bool initialize_sd_card() {
 
 void cmd_reset_measurements() {
   reset_measurement_stats();
-  Serial.println("Frequency measurement statistics reset\r");
+  g_stability.reset();
+  g_stability_corrected.reset();
+  g_regression.reset();
+  Serial.println("Frequency measurement and stability statistics reset\r");
   Serial.printf("GPS PPS input: pin %d (always monitoring)\r\n", GPT2_CAPTURE_PIN);
   Serial.printf("1 PPS output: pin %d (always active)\r\n", GPT2_COMPARE_PIN);
 }
 
+void cmd_show_stability() {
+  uint8_t levels = g_stability.get_levels();
+  Serial.printf("Stability: %lu periods, %lu gaps (non-overlapping estimates, tau0 = 1 s)\r\n",
+                g_stability.get_sample_count(), g_stability.get_gap_count());
+  if (levels == 0) {
+    Serial.println("Not enough data yet (need 3 consecutive PPS periods)\r");
+    return;
+  }
+  // With TIM-TP reports, the same estimates with the receiver's sawtooth taken off
+  bool corrected = g_sawtooth.get_stats().corrected > 0;
+  Serial.printf("     tau(s)       ADEV       MDEV    TDEV(ns)        N%s\r\n",
+                corrected ? "  ADEV(qErr)  TDEV(qErr,ns)" : "");
+  for (uint8_t k = 0; k < levels; k++) {
+    StabilityPoint point;
+    if (!g_stability.get_point(k, point)) {
+      continue;
+    }
+    Serial.printf("%11.0f  %9.3e  %9.3e  %10.3f  %7lu",
+                  point.tau, point.adev, point.mdev, point.tdev * 1e9, point.adev_count);
+    StabilityPoint clean;
+    if (corrected && g_stability_corrected.get_point(k, clean)) {
+      Serial.printf("   %9.3e  %13.3f", clean.adev, clean.tdev * 1e9);
+    }
+    Serial.println("\r");
+  }
+}
+
+void print_profile_line(const char* name, const ProfileStageStats& stats, double cycles_per_us) {
+  if (stats.count == 0) {
+    Serial.printf("  %-11s        0\r\n", name);
+    return;
+  }
+  Serial.printf("  %-11s %8lu %10.2f %10.2f %10.1f\r\n", name, stats.count,
+                stats.min_cycles / cycles_per_us,
+                (double)stats.total_cycles / stats.count / cycles_per_us,
+                stats.max_cycles / cycles_per_us);
+}
+
+void print_profile_histogram(const char* name, const ProfileStageStats& stats, double cycles_per_us) {
+  if (stats.count == 0) {
+    return;
+  }
+  // Bucket b: 2^b .. 2^(b+1) cycles, shown by its upper bound
+  Serial.printf("  %-11s", name);
+  for (uint8_t b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+    if (stats.histogram[b] != 0) {
+      Serial.printf(" <%.3gus:%lu", (double)(2ull << b) / cycles_per_us, stats.histogram[b]);
+    }
+  }
+  Serial.println("\r");
+}
+
+void cmd_profiler(const char* command) {
+  if (strcmp(command + 1, "r") == 0) {
+    profiler_reset();
+    Serial.println("Loop profile reset\r");
+    return;
+  }
+  if (command[1] != '\0') {
+    Serial.println("Usage: j (show) or jr (reset)\r");
+    return;
+  }
+
+  double cycles_per_us = profiler_cycles_per_us();
+  ProfileStageStats stats;
+  Serial.printf("Loop profile (%lu cycles/us, nested stages included in their parent)\r\n",
+                profiler_cycles_per_us());
+  Serial.println("  stage          count    min(us)   mean(us)    max(us)\r");
+  profiler_get_loop(stats);
+  print_profile_line("loop", stats, cycles_per_us);
+  for (uint8_t i = 0; i < PROFILE_STAGE_COUNT; i++) {
+    profiler_get_stage(i, stats);
+    print_profile_line(profiler_stage_name(i), stats, cycles_per_us);
+  }
+
+  Serial.println("Histograms:\r");
+  profiler_get_loop(stats);
+  print_profile_histogram("loop", stats, cycles_per_us);
+  for (uint8_t i = 0; i < PROFILE_STAGE_COUNT; i++) {
+    profiler_get_stage(i, stats);
+    print_profile_histogram(profiler_stage_name(i), stats, cycles_per_us);
+  }
+
+  ProfileWorstLoop worst;
+  if (profiler_get_worst_loop(worst)) {
+    Serial.printf("Worst iteration #%lu at %lu ms: %.1f us, mostly %s (%.1f us)\r\n",
+                  worst.iteration, worst.at_ms, worst.cycles / cycles_per_us,
+                  profiler_stage_name(worst.stage), worst.stage_cycles[worst.stage] / cycles_per_us);
+    Serial.print("  exclusive:");
+    for (uint8_t i = 0; i < PROFILE_STAGE_COUNT; i++) {
+      if (worst.stage_cycles[i] != 0) {
+        Serial.printf(" %s %.1f", profiler_stage_name(i), worst.stage_cycles[i] / cycles_per_us);
+      }
+    }
+    Serial.println(" us\r");
+  }
+  if (profiler_get_overflows() != 0) {
+    Serial.printf("Untimed (nested too deep): %lu\r\n", profiler_get_overflows());
+  }
+}
+
+void print_edge_stream(const char* name, bool rising) {
+  const EdgeStreamStats& stats = g_edges.get_stream(rising);
+  if (stats.edges == 0) {
+    return;
+  }
+  Serial.printf("%s edges: %lu, %lu periods, %lu missed, %lu spurious\r\n", name, stats.edges,
+                stats.periods, stats.missed, stats.spurious);
+  if (stats.periods > 0) {
+    Serial.printf("  period mean %.2f ticks, min %lu, max %lu, jitter %.1f ns rms\r\n", stats.mean_ticks,
+                  stats.min_ticks, stats.max_ticks, stats.jitter_rms_ticks * 100.0);
+  }
+  Serial.printf("  TIE %+lld ns, %lld ns peak-to-peak over the last %u edges, %lu restarts\r\n",
+                (long long)stats.tie_ticks * 100, (long long)g_edges.get_tie_peak_to_peak(rising) * 100,
+                EdgeAnalyzer::TIE_HISTORY, stats.tie_restarts);
+
+  const uint32_t* histogram = g_edges.get_histogram(rising);
+  Serial.print("  jitter histogram (ticks from mean):");
+  for (uint8_t b = 0; b < EdgeAnalyzer::JITTER_BINS; b++) {
+    if (histogram[b] == 0) continue;
+    int32_t deviation = (int32_t)b - EdgeAnalyzer::JITTER_HALF_RANGE;
+    const char* bound = b == 0 ? "<=" : b == EdgeAnalyzer::JITTER_BINS - 1 ? ">=" : "";
+    Serial.printf(" %s%+ld:%lu", bound, (long)deviation, histogram[b]);
+  }
+  Serial.println("\r");
+
+  int32_t tie[16];
+  uint8_t n = g_edges.get_tie_history(rising, tie, 16);
+  Serial.print("  recent TIE (ns):");
+  for (uint8_t i = 0; i < n; i++) {
+    Serial.printf(" %ld", (long)tie[i] * 100);
+  }
+  Serial.println("\r");
+}
+
+void show_input_compare_summary() {
+  const PpsPhaseStats& phase = g_pps_compare.get_phase();
+  double ppb;
+  Serial.printf("Second PPS input (pin %d): %lu edges", GPT2_CAPTURE2_PIN, g_pps_compare.get_input(1).edges);
+  if (g_pps_compare.get_input_ppb(1, ppb)) {
+    Serial.printf(", %.3f ppb vs oscillator", ppb);
+  }
+  if (phase.pairs > 0) {
+    Serial.printf(", %+lld ns from GPS PPS", (long long)phase.last_ticks * 100);
+  }
+  Serial.println("\r");
+}
+
+void cmd_input_compare(const char* command) {
+  const char* param = command + 2;  // Skip "ib"
+  if (strcmp(param, "0") == 0 || strcmp(param, "1") == 0) {
+    gpt2_set_capture2_edge(param[0] == '1' ? GPT_EDGE_RISING : GPT_EDGE_DISABLED);
+    g_pps_compare.reset();
+    Serial.printf("Second PPS input on pin %d %s\r\n", GPT2_CAPTURE2_PIN, param[0] == '1' ? "enabled" : "disabled");
+    return;
+  }
+  if (strcmp(param, "r") == 0) {
+    g_pps_compare.reset();
+    Serial.println("Input comparison reset\r");
+    return;
+  }
+  if (param[0] != '\0') {
+    Serial.println("Usage: ib, ib0/ib1 or ibr\r");
+    return;
+  }
+
+  Serial.printf("PPS input comparison (input 0: GPS PPS pin %d, input 1: pin %d, %s)\r\n", GPT2_CAPTURE_PIN,
+                GPT2_CAPTURE2_PIN, gpt2_get_capture2_edge() != GPT_EDGE_DISABLED ? "enabled" : "disabled");
+  for (uint8_t i = 0; i < PpsComparator::MAX_INPUTS; i++) {
+    const PpsInputStats& input = g_pps_compare.get_input(i);
+    double ppb;
+    Serial.printf("  input %u: %lu edges, %lu periods, %lu rejected", i, input.edges, input.periods, input.rejected);
+    if (g_pps_compare.get_input_ppb(i, ppb)) {
+      Serial.printf(", %.3f ppb vs oscillator, period %.1f ns rms", ppb, input.rms_ticks * 100.0);
+    }
+    Serial.println("\r");
+  }
+  const PpsPhaseStats& phase = g_pps_compare.get_phase();
+  if (phase.pairs == 0) {
+    Serial.println("  No paired edges yet (edges pair when within 0.5 s)\r");
+    return;
+  }
+  Serial.printf("  phase (input 1 - input 0): last %+lld ns, mean %+.1f ns, %.1f ns rms, min %+lld, max %+lld ns\r\n",
+                (long long)phase.last_ticks * 100, phase.mean_ticks * 100.0, phase.rms_ticks * 100.0,
+                (long long)phase.min_ticks * 100, (long long)phase.max_ticks * 100);
+  Serial.printf("  %lu pairs, %lu unpaired edges\r\n", phase.pairs, phase.unpaired);
+
+  const StabilityEngine& stability = g_pps_compare.get_stability();
+  uint8_t levels = stability.get_levels();
+  if (levels == 0) {
+    return;
+  }
+  Serial.printf("  Stability of the difference (%lu seconds, %lu gaps):\r\n", stability.get_sample_count(),
+                stability.get_gap_count());
+  Serial.println("      tau(s)       ADEV   TDEV(ns)        N\r");
+  for (uint8_t k = 0; k < levels; k++) {
+    StabilityPoint point;
+    if (stability.get_point(k, point)) {
+      Serial.printf("  %10.0f  %9.3e  %9.3f  %7lu\r\n", point.tau, point.adev, point.tdev * 1e9, point.adev_count);
+    }
+  }
+}
+
+void cmd_edge_analysis(const char* command) {
+  if (command[1] == 'b') {
+    cmd_input_compare(command);
+    return;
+  }
+  if (strcmp(command + 1, "r") == 0) {
+    g_edges.reset();
+    Serial.println("Edge analysis reset\r");
+    return;
+  }
+  if (command[1] != '\0') {
+    Serial.println("Usage: i (show), ir (reset) or ib... (second input)\r");
+    return;
+  }
+
+  Serial.println("PPS edge analysis (100 ns ticks; TIE against the local oscillator)\r");
+  if (g_edges.get_stream(true).edges == 0 && g_edges.get_stream(false).edges == 0) {
+    Serial.println("  No edges captured yet\r");
+    return;
+  }
+  print_edge_stream("Rising", true);
+  print_edge_stream("Falling", false);
+  PulseWidthStats pulse;
+  if (g_edges.get_pulse_width(pulse)) {
+    Serial.printf("Pulse width: last %.1f us, mean %.1f us, %.1f ns rms, min %.1f us, max %.1f us (%lu pulses)\r\n",
+                  pulse.last_ticks / 10.0, pulse.mean_ticks / 10.0, pulse.rms_ticks * 100.0,
+                  pulse.min_ticks / 10.0, pulse.max_ticks / 10.0, pulse.count);
+  } else if (gpt2_get_capture_edge() != GPT_EDGE_BOTH) {
+    Serial.println("Pulse width needs both edges: select them with c\r");
+  }
+  if (g_edges.get_out_of_turn() != 0) {
+    Serial.printf("Edges out of turn (same polarity twice): %lu\r\n", g_edges.get_out_of_turn());
+  }
+}
+
+void cmd_regression(const char* command) {
+  if (strlen(command) > 1) {
+    // w<len>[,<len>...]: up to four window lengths in seconds, shortest first
+    uint16_t lengths[PhaseRegression::MAX_WINDOWS];
+    uint8_t count = 0;
+    const char* p = command + 1;
+    while (*p != '\0' && count < PhaseRegression::MAX_WINDOWS) {
+      lengths[count++] = (uint16_t)atoi(p);
+      while (*p != '\0' && *p != ',') p++;
+      if (*p == ',') p++;
+    }
+    if (*p != '\0' || !g_regression.set_windows(lengths, count)) {
+      Serial.printf("Usage: w<len>[,<len>...] with up to %u windows of 3-%u seconds\r\n",
+                    PhaseRegression::MAX_WINDOWS, PhaseRegression::MAX_WINDOW_SAMPLES);
+      return;
+    }
+    Serial.println("Regression windows set, fits restarted\r");
+  }
+
+  Serial.printf("Least-squares frequency fits (%lu gaps)\r\n", g_regression.get_gap_count());
+  Serial.println("  window      N    freq(ppb)   +-1sigma   resid(ns)\r");
+  for (uint8_t i = 0; i < g_regression.get_window_count(); i++) {
+    RegressionFit fit;
+    if (g_regression.get_fit(i, fit)) {
+      Serial.printf("  %6u  %5u  %11.3f  %9.3f  %10.1f\r\n",
+                    fit.window, fit.samples, fit.frequency * 1e9, fit.frequency_sigma * 1e9,
+                    fit.residual_rms_ns);
+    } else {
+      Serial.printf("  %6u  %5u  (filling)\r\n", fit.window, fit.samples);
+    }
+  }
+}
+
+// Longest tau with enough second differences to be worth showing on the OLED
+bool get_display_stability(StabilityPoint& point) {
+  const uint32_t min_count = 8;
+  bool found = false;
+  for (uint8_t k = 0; k < g_stability.get_levels(); k++) {
+    StabilityPoint candidate;
+    if (g_stability.get_point(k, candidate) && candidate.adev_count >= min_count) {
+      point = candidate;
+      found = true;
+    }
+  }
+  return found;
+}
+
 void cmd_set_capture_edge() {
   // Cycle through edge detection modes
   static GptCaptureEdge current_edge = GPT_EDGE_RISING;
@@ -608,23 +1214,92 @@ void cmd_set_capture_edge() {
   }
 
   gpt2_set_capture_edge(current_edge);
+  reset_capture_tracking();  // Periods and edge streams restart with the new selection
+}
+
+// "1234.5" -> 1234500 mHz; up to three decimals, no float rounding
+bool parse_millihertz(const char* text, uint32_t& millihertz) {
+  uint32_t whole = 0;
+  uint32_t frac = 0;
+  uint8_t frac_digits = 0;
+  bool digits = false;
+  while (*text >= '0' && *text <= '9') {
+    whole = whole * 10 + (uint32_t)(*text++ - '0');
+    if (whole > GPT2_OUTPUT_MAX_HZ) return false;
+    digits = true;
+  }
+  if (*text == '.') {
+    text++;
+    while (*text >= '0' && *text <= '9') {
+      if (frac_digits < 3) {
+        frac = frac * 10 + (uint32_t)(*text - '0');
+        frac_digits++;
+      }
+      text++;
+      digits = true;
+    }
+  }
+  if (*text != '\0' || !digits) return false;
+  while (frac_digits < 3) {
+    frac *= 10;
+    frac_digits++;
+  }
+  millihertz = whole * 1000 + frac;
+  return true;
+}
+
+void show_output_status() {
+  Gpt2OutputStats stats;
+  gpt2_get_output_stats(stats);
+  Serial.printf("Output: %lu.%03lu Hz requested, %.6f Hz achieved, period %lu + %lu/%lu ticks, high %lu ticks\r\n",
+                stats.requested_mhz / 1000, stats.requested_mhz % 1000, stats.achieved_hz,
+                stats.period_ticks, stats.period_frac, stats.requested_mhz, stats.high_ticks);
+  Serial.printf("Output edges: %lu, %lu forced late (worst %lu ns), %lu missed, grid quantization %lu ns\r\n",
+                stats.edges, stats.forced_edges, stats.max_late_ns, stats.missed_edges, stats.quantization_ns);
 }
 
 void cmd_set_output_frequency(const char* command) {
-  (void)command;
+  const char* param = command + 1;  // Skip the command character
   if (pps_release_to_gpt()) {
     Serial.println("Resumed GPT2 control of PPS output.\r");
   }
-  gpt2_begin_dual_mode(1, GPT_EDGE_RISING, true);
-  Serial.println("Output frequency set to 1 Hz\r");
+
+  if (strlen(param) == 0) {
+    gpt2_begin_dual_mode(1, GPT_EDGE_RISING, true);
+    reset_capture_tracking();  // Counter restarted, previous timestamp is stale
+    Serial.println("Output frequency set to 1 Hz\r");
+  } else {
+    // Reprogrammed on the fly: the counter (and PPS capture) keeps running
+    uint32_t millihertz;
+    if (!parse_millihertz(param, millihertz) || !gpt2_set_output_frequency_mhz(millihertz)) {
+      Serial.printf("Error: Frequency must be %lu-%lu Hz, up to 3 decimals (e.g., f1000 or f1234.567)\r\n",
+                    GPT2_OUTPUT_MIN_HZ, gpt2_get_output_max_hz());
+      return;
+    }
+    g_pps_align.mark_restart();  // New output grid
+    Serial.printf("Output frequency set to %lu.%03lu Hz\r\n", millihertz / 1000, millihertz % 1000);
+  }
   Serial.printf("Signal available on pin %d\r\n", GPT2_COMPARE_PIN);
+  show_output_status();
 }
 
 
 void show_gpt2_status() {
   Serial.printf("GPS PPS samples collected: %lu\r\n", g_freq_stats.get_count());
   if (g_freq_stats.has_samples()) {
-    Serial.printf("Average measured frequency: %.6f MHz\r\n", g_freq_stats.get_mean() / 1e6);
+    Serial.printf("Average measured frequency: %.6f MHz (%.3f ppb, std %.2f ticks, all samples)\r\n",
+                  g_freq_stats.get_mean() / 1e6, g_freq_stats.get_ppb_error(10000000.0),
+                  g_freq_stats.get_std_dev());
+    Serial.println("  Window  Samples   Mean(ppb)  Std(ppb)  Min(ppb)  Max(ppb)\r");
+    for (uint8_t k = 0; k < FrequencyStats::WINDOWS; k++) {
+      FrequencyWindowStats window;
+      if (g_freq_stats.get_window(k, window)) {
+        Serial.printf("  %5lus  %7lu  %10.3f  %8.2f  %8.0f  %8.0f\r\n", window.length, window.samples,
+                      (window.mean_ticks - 10000000.0) * 100.0, window.std_ticks * 100.0,
+                      ((double)window.min_ticks - 10000000.0) * 100.0,
+                      ((double)window.max_ticks - 10000000.0) * 100.0);
+      }
+    }
   } else {
     Serial.println("No GPS PPS signals received yet\r");
   }
@@ -640,57 +1315,139 @@ void show_gpt2_status() {
   Serial.printf("  Pin %d: 1 PPS output (always active)\r\n", GPT2_COMPARE_PIN);
   
   Serial.printf("PPS Output Duty Cycle: %u%%\r\n", gpt2_get_duty_cycle());
-  Serial.printf("GPT2 Counter: %lu\r\n", GPT2_CNT);
+  show_output_status();
+  Serial.printf("GPT2 Counter: %lu (64-bit timebase: %llu ticks, epoch %lu)\r\n", GPT2_CNT,
+                (unsigned long long)gpt2_now64(), gpt2_get_rollover_epoch());
   Serial.printf("GPT2 Control: 0x%08lX\r\n", GPT2_CR);
   Serial.printf("Compare Register: %lu\r\n", GPT2_OCR1);
   if (pps_gpio_override_active()) {
     Serial.printf("PPS override: GPIO driving %s\r\n", pps_gpio_state_high() ? "HIGH" : "LOW");
   }
+
+  Gpt2EventCounters counters;
+  gpt2_get_counters(counters);
+  Serial.printf("GPT2 Servicing: %s\r\n", gpt2_interrupts_enabled() ? "interrupt" : "polled");
+  Serial.printf("GPT2 Events: %lu captures, %lu compares, %lu rollovers\r\n",
+                counters.captures, counters.compares, counters.rollovers);
+  Serial.printf("GPT2 Capture Queue: max %lu queued, %lu overruns, %lu dropped edges, %lu late compares\r\n",
+                counters.max_queued, counters.ring_overruns, counters.dropped_edges, counters.late_compares);
 }
 
 void show_oscillator_status() {
-  if (oscillator.isPresent()) {
-      // 
-  } else {
+  if (!oscillator.isPresent()) {
     Serial.println("SiT5501: Not present\r");
+    return;
+  }
+  SiT5501UpdateStats stats;
+  oscillator.getUpdateStats(stats);
+  uint32_t avg_us = stats.updates ? (uint32_t)(stats.total_us / stats.updates) : 0;
+  Serial.printf("SiT5501: %lu updates (%lu unchanged), %lu words, latency last %lu us avg %lu us max %lu us\r\n",
+                stats.updates, stats.unchanged, stats.words_written, stats.last_us, avg_us, stats.max_us);
+  if (oscillator.getVerifyInterval() == 0) {
+    Serial.printf("SiT5501 read-back: off, %lu I2C errors\r\n", stats.errors);
+  } else {
+    Serial.printf("SiT5501 read-back: every %lu s, %lu checks, %lu mismatches, %lu I2C errors\r\n",
+                  oscillator.getVerifyInterval() / 1000, stats.verifies, stats.verify_failures, stats.errors);
   }
 }
 
 
-void show_calibration_status() {
-  if (g_calibration.state == CAL_IDLE) {
-    Serial.println("Calibration: Not active\r");
+void show_discipline_status() {
+  DisciplineState state = g_discipline.get_state();
+  uint32_t now = millis();
+  Serial.printf("GPSDO loop: %s for %lu s (tracking tau %lu s), %lu locks, %lu holdovers\r\n",
+                DiscipliningLoop::state_name(state), g_discipline.get_state_seconds(now),
+                g_discipline.get_config().track_time_constant_s,
+                g_discipline.get_lock_count(), g_discipline.get_holdover_count());
+  if (state == DISCIPLINE_OFF) {
+    Serial.printf("Manual offset: %.1f ppb (l1 restarts disciplining)\r\n", g_frequency_offset_ppm * 1000.0);
     return;
   }
-  
-  uint32_t elapsed_ms = millis() - g_calibration.start_time;
-  uint32_t elapsed_seconds = elapsed_ms / 1000;
-  uint32_t remaining_seconds = g_calibration.duration_seconds - elapsed_seconds;
-  
-  double current_avg_ppm = 0.0;
-  if (g_freq_stats.has_samples()) {
-    current_avg_ppm = g_freq_stats.get_ppm_error(10000000.0);
+  Serial.printf("Control: %.3f ppb, learned frequency %.3f ppb, drift %.2f ppb/day\r\n",
+                g_discipline.get_control_ppb(), g_discipline.get_frequency_ppb(),
+                g_discipline.get_drift_ppb_per_day());
+  Serial.printf("Phase error: %.0f ns (rms %.0f ns)\r\n",
+                g_discipline.get_phase_error_ns(), g_discipline.get_phase_rms_ns());
+}
+
+void show_drift_model_status() {
+  if (!g_drift.has_fit()) {
+    Serial.printf("Drift model: %u points, no fit yet (%u hourly points over %lu h in TRACK)\r\n",
+                  g_drift.get_point_count(), DriftModel::MIN_POINTS, DriftModel::MIN_SPAN_S / 3600);
+    return;
   }
-  
-  if (g_calibration.state == CAL_PHASE1_AVERAGING) {
-    Serial.printf("Calibration Phase 1: %lu/%lu seconds (%lu remaining)\r\n", 
-                  elapsed_seconds, g_calibration.duration_seconds, remaining_seconds);
-    Serial.printf("Current average: %.1f ppb (%lu samples, %lu missed)\r\n", 
-                  current_avg_ppm * 1000.0, g_freq_stats.get_count(), g_calibration.missed_pulses);
-  } else if (g_calibration.state == CAL_PHASE2_AVERAGING) {
-    Serial.printf("Calibration Phase 2: %lu/%lu seconds (%lu remaining)\r\n", 
-                  elapsed_seconds, g_calibration.duration_seconds, remaining_seconds);
-    Serial.printf("Applied correction: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
-    Serial.printf("Current average: %.1f ppb (%lu samples, %lu missed)\r\n", 
-                  current_avg_ppm * 1000.0, g_freq_stats.get_count(), g_calibration.missed_pulses);
+  const DriftFit& fit = g_drift.get_fit();
+  Serial.printf("Drift model: aging %.3f +- %.3f ppb/day, %.3f ppb/C, residual %.2f ppb (%u points over %u h%s)\r\n",
+                fit.aging_ppb_per_day, fit.aging_sigma_ppb_per_day, fit.temperature_ppb_per_c,
+                fit.residual_ppb, fit.points, fit.span_hours, g_drift.is_restored() ? ", saved" : "");
+  uint32_t unix_time;
+  double predicted;
+  double sigma;
+  float temperature = tempmonGetTemp();
+  if (current_unix_time(unix_time) && g_drift.predict(unix_time, temperature, predicted, sigma)) {
+    Serial.printf("Model now: %.2f +- %.2f ppb at %.1f C; loop learned %.2f ppb (%+.2f), fed forward %.2f ppb\r\n",
+                  predicted, sigma, temperature, g_discipline.get_frequency_ppb(),
+                  g_discipline.get_frequency_ppb() - predicted, g_discipline.get_feed_forward_ppb());
+  }
+  const DriftPredictionStats& errors = g_drift.get_prediction_stats();
+  if (errors.count > 0) {
+    Serial.printf("Hourly prediction error: last %+.2f ppb, rms %.2f ppb, max %.2f ppb (%lu points)\r\n",
+                  errors.last_error_ppb, errors.rms_error_ppb, errors.max_error_ppb, errors.count);
+  }
+}
+
+void show_settings_store_status() {
+  const SettingsStoreStats& stats = g_settings.get_stats();
+  Serial.printf("Settings: record %lu, bank %u %u/%u bytes, %lu appends (%lu bytes), %lu compactions, %lu unchanged saves skipped\r\n",
+                stats.sequence, stats.active_bank, stats.used, stats.bank_size, stats.appends,
+                stats.bytes_written, stats.compactions, stats.unchanged);
+}
+
+void show_calibration_history() {
+  uint8_t count = g_settings.get_calibration_count();
+  show_settings_store_status();
+  if (count == 0) {
+    Serial.println("No calibrations recorded yet\r");
+    return;
+  }
+  Serial.printf("Calibration history (oldest first, last %u kept):\r\n", SettingsStore::HISTORY);
+  Serial.println("   GPS time (unix)       age      offset(ppb)      temp  source\r");
+  for (uint8_t i = 0; i < count; i++) {
+    SettingsCalibration entry;
+    if (!g_settings.get_calibration(i, entry)) {
+      continue;
+    }
+    char age[16] = "-";
+    if (entry.gps_time != 0 && g_gps_data.is_valid && g_gps_data.unix_time >= entry.gps_time) {
+      snprintf(age, sizeof(age), "%.1f h", (g_gps_data.unix_time - entry.gps_time) / 3600.0);
+    }
+    char temperature[12] = "-";
+    if (entry.temperature_ck != 0) {
+      snprintf(temperature, sizeof(temperature), "%.1f C", entry.temperature_ck / 100.0 - 273.15);
+    }
+    Serial.printf("  %16lu  %10s  %+13.2f  %8s  %s (%s)\r\n", entry.gps_time, age, entry.offset_cppb / 100.0,
+                  temperature, entry.source == 1 ? "loop" : "manual",
+                  DiscipliningLoop::state_name((DisciplineState)entry.loop_state));
   }
 }
 
 void cmd_show_status() {
   Serial.println("\r\n=== System Status ===\r");
   show_gpt2_status();
+  show_pps_filter_status();
+  show_gate_status();
+  show_pps_align_status();
+  if (gpt2_get_capture2_edge() != GPT_EDGE_DISABLED) {
+    show_input_compare_summary();
+  }
+  show_gps_link_status();
+  show_sawtooth_status();
   show_oscillator_status();
-  show_calibration_status();
+  show_discipline_status();
+  show_drift_model_status();
+  show_settings_store_status();
+  show_logger_status();
+  show_display_status();
 }
 
 void cmd_set_oscillator_ppm(const char* command) {
@@ -722,7 +1479,13 @@ void cmd_set_oscillator_ppm(const char* command) {
     // Update global variable and save to EEPROM
     g_frequency_offset_ppm = ppm;
     save_settings();
+    record_calibration(0);
+    send_telemetry_control(0);
     Serial.printf("Oscillator frequency offset set to %.1f ppb and saved to EEPROM\r\n", ppb);
+    if (g_discipline.get_state() != DISCIPLINE_OFF) {
+      g_discipline.stop();
+      Serial.println("GPSDO disciplining stopped for the manual offset (l1 restarts it)\r");
+    }
   } else {
     Serial.println("Error: Failed to set oscillator frequency offset\r");
   }
@@ -777,45 +1540,118 @@ void cmd_set_duty_cycle(const char* command) {
   Serial.printf("PPS output duty cycle set to %u%% and saved to EEPROM\r\n", gpt2_get_duty_cycle());
 }
 
+void cmd_set_log_format(const char* command) {
+  const char* param = command + 1;  // Skip the command character
+
+  if (strlen(param) > 0) {
+    if (strcmp(param, "0") == 0) {
+      g_log_format = LOG_FORMAT_JSONL;
+    } else if (strcmp(param, "1") == 0) {
+      g_log_format = LOG_FORMAT_BINARY;
+    } else {
+      Serial.println("Usage: m0 (JSONL) or m1 (binary)\r");
+      return;
+    }
+    close_log_file();  // Next GPS fix opens a file in the new format
+    save_settings();
+  }
+
+  Serial.printf("Log format: %s\r\n", g_log_format == LOG_FORMAT_BINARY ? "binary (.fcb)" : "JSONL");
+  if (sd_logger_is_open()) {
+    Serial.printf("Current log file: %s\r\n", sd_logger_file_name());
+  }
+  show_logger_status();
+}
+
+void cmd_oscillator_verify(const char* command) {
+  if (!oscillator.isPresent()) {
+    Serial.println("Error: SiT5501 oscillator not found\r");
+    return;
+  }
+  if (strlen(command) > 1) {
+    int seconds = atoi(command + 1);
+    if (seconds < 0 || seconds > 3600) {
+      Serial.println("Error: Read-back interval must be between 0 (off) and 3600 seconds\r");
+      return;
+    }
+    oscillator.setVerifyInterval((uint32_t)seconds * 1000);
+    oscillator.resetUpdateStats();
+  }
+  show_oscillator_status();
+}
+
+void cmd_set_display_rate(const char* command) {
+  if (strlen(command) > 1) {
+    int hz = atoi(command + 1);
+    if (hz < 1 || hz > 10) {
+      Serial.println("Error: OLED refresh rate must be between 1 and 10 Hz\r");
+      return;
+    }
+    display_set_refresh_rate((uint8_t)hz);
+  }
+  show_display_status();
+}
+
+void show_display_status() {
+  if (!display_available()) {
+    Serial.println("Display: (none)\r");
+    return;
+  }
+  DisplayStats stats;
+  display_get_stats(stats);
+  Serial.printf("Display: %u Hz refresh, %lu renders, %lu rows redrawn, %lu pages pushed\r\n",
+                display_get_refresh_rate(), stats.refreshes, stats.rows_redrawn, stats.pages_pushed);
+  Serial.printf("Display I2C: %lu chunks, %lu bytes, longest chunk %lu us\r\n",
+                stats.chunks, stats.bytes_pushed, stats.max_chunk_us);
+}
+
+void show_logger_status() {
+  SdLoggerStats stats;
+  sd_logger_get_stats(stats);
+  Serial.printf("Logger: %lu records queued, %lu dropped, %lu bytes, %lu sectors, %lu padding bytes\r\n",
+                stats.records_queued, stats.records_dropped, stats.bytes_queued,
+                stats.sectors_written, stats.pad_bytes);
+  Serial.printf("Logger queue: high water %lu/%lu sectors, slowest write %lu us, %lu syncs, %lu write errors\r\n",
+                stats.queue_high_water, stats.queue_capacity, stats.max_write_us,
+                stats.syncs, stats.write_errors);
+  Serial.printf("MTP: %lu calls, %lu deferred for logging, slowest %lu us\r\n",
+                stats.mtp_calls, stats.mtp_deferred, stats.max_mtp_us);
+  if (g_jsonl_truncated > 0) {
+    Serial.printf("JSONL: %lu records too long for the line buffer, dropped\r\n", g_jsonl_truncated);
+  }
+}
+
 void cmd_clear_eeprom() {
   Serial.println("\r\n=== CLEAR EEPROM ===\r");
-  Serial.println("This will erase all saved settings and reset to defaults:\r");
+  Serial.println("This will erase all saved settings and the calibration history and reset to defaults:\r");
   Serial.println("- Frequency offset: 0.0 ppb\r");
   Serial.println("- Duty cycle: 20%\r");
   Serial.println("\r");
   Serial.println("WARNING: This action cannot be undone!\r");
-  Serial.println("Type 'y' to clear EEPROM, any other key to cancel: ");
-  
-  // Wait for user confirmation
-  while (!Serial.available()) {
-    delay(10);
-  }
-  
-  char response = Serial.read();
-  Serial.println(response); // Echo the response
-  
-  // Clear any remaining characters
-  while (Serial.available()) {
-    Serial.read();
-  }
-  
-  if (response != 'y' && response != 'Y') {
-    Serial.println("EEPROM clear cancelled.\r");
-    return;
-  }
-  
+  request_confirmation("EEPROM clear", clear_eeprom_confirmed);
+}
+
+void clear_eeprom_confirmed() {
   Serial.println("Clearing EEPROM...\r");
   
   // Reset to defaults
   g_frequency_offset_ppm = 0.0;
   gpt2_set_duty_cycle(20);
+  g_pps_align.set_enabled(false);
+  g_pps_align.set_offset_ns(0);
+  g_pps_align.set_max_slew_ns(PpsAligner::DEFAULT_MAX_SLEW_NS);
   
   // Apply the defaults to hardware
   if (oscillator.isPresent()) {
     oscillator.setFrequencyOffsetPPM(0.0);
+    if (g_discipline.get_state() != DISCIPLINE_OFF) {
+      g_discipline.start(0.0, millis());
+    }
   }
   
-  // Save defaults to EEPROM (this overwrites the old data)
+  // Start a new journal bank holding only the defaults (and no drift fit)
+  g_drift.reset();
+  g_settings.clear();
   save_settings();
   
   Serial.println("EEPROM cleared and reset to defaults.\r");
@@ -851,148 +1687,384 @@ void cmd_reboot_to_bootloader() {
   }
 }
 
-void cmd_start_calibration_with_time(const char* command) {
+void cmd_discipline(const char* command) {
   const char* param = command + 1;  // Skip the command character
-  
-  // Set calibration duration
+
+  if (strcmp(param, "h") == 0) {
+    show_calibration_history();
+    return;
+  }
   if (strlen(param) > 0) {
-    uint32_t duration = atoi(param);
-    if (duration < 10 || duration > 3600) {
-      Serial.println("Error: Calibration time must be between 10 and 3600 seconds\r");
+    if (!oscillator.isPresent()) {
+      Serial.println("Error: SiT5501 oscillator not found - disciplining requires oscillator control\r");
+      return;
+    }
+    uint32_t value = atoi(param);
+    if (value == 0) {
+      g_discipline.stop();
+      Serial.printf("GPSDO disciplining stopped, holding %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
+    } else if (value == 1) {
+      g_discipline.start(g_frequency_offset_ppm * 1000.0, millis());
+      Serial.println("GPSDO disciplining restarted (acquiring)\r");
+    } else if (value >= 10 && value <= 100000) {
+      g_discipline.set_track_time_constant(value);
+      Serial.printf("Tracking time constant set to %lu seconds\r\n", value);
+    } else {
+      Serial.println("Usage: l, lh (calibration history), l0 (stop), l1 (restart) or l<tau> with tau 10-100000 seconds\r");
       return;
     }
-    g_calibration.duration_seconds = duration;
-    Serial.printf("Calibration duration set to %lu seconds per phase\r\n", duration);
-  } else {
-    // Reset to default if no parameter
-    g_calibration.duration_seconds = 300;
-    Serial.printf("Using default calibration duration: %lu seconds per phase\r\n", g_calibration.duration_seconds);
   }
-  
-  // Call the existing calibration function
-  cmd_start_calibration();
+  show_discipline_status();
+  show_drift_model_status();
 }
 
-void start_calibration_internal(bool auto_started) {
-  // Store original offset
-  g_calibration.original_offset = g_frequency_offset_ppm;
-  g_calibration.auto_started = auto_started;
-  
-  // Set PPM offset to 0
-  g_frequency_offset_ppm = 0.0;
-  oscillator.setFrequencyOffsetPPM(0.0);
-  
-  // Wait 1 millisecond as requested
-  delay(1);
-  
-  // Reset averaging
-  reset_measurement_stats();
-  
-  // Start calibration
-  g_calibration.state = CAL_PHASE1_AVERAGING;
-  g_calibration.start_time = millis();
-  g_calibration.phase1_result = 0.0;
-  g_calibration.expected_pulses = g_freq_stats.get_count();  // Track expected pulses from current count
-  g_calibration.missed_pulses = 0;
-  
-  if (auto_started) {
-    Serial.println("\r\n=== AUTO-CALIBRATION STARTED ===\r");
-    Serial.println("No calibration offset detected. Starting automatic calibration.\r");
+// Applies the loop's control value. Runs in the capture task, so the hourly
+// save is only flagged here: its EEPROM writes take milliseconds
+void apply_discipline_control() {
+  double ppm = g_discipline.get_control_ppb() / 1000.0;
+  if (!oscillator.updateFrequencyOffsetPPM(ppm)) {
+    return;
+  }
+  g_frequency_offset_ppm = ppm;
+  send_telemetry_control(1);
+
+  uint32_t now = millis();
+  if (g_discipline.get_state() == DISCIPLINE_TRACK &&
+      (g_last_offset_save_ms == 0 || now - g_last_offset_save_ms >= OFFSET_SAVE_INTERVAL_MS)) {
+    g_last_offset_save_ms = now;
+    g_offset_save_pending = true;
   }
-  
-  Serial.printf("Calibration phase 1 started. Collecting data for %lu seconds...\r\n", g_calibration.duration_seconds);
-  Serial.println("Status updates every 1 second. Use 's' command to check progress anytime.\r");
 }
 
-void cmd_start_calibration() {
-  if (g_calibration.state != CAL_IDLE) {
-    Serial.println("Calibration already in progress. Wait for completion or restart system.\r");
-    return;
+// Once locked, persists the learned offset for the next warm start and adds a drift point
+void save_discipline_offset() {
+  g_offset_save_pending = false;
+  uint32_t unix_time;
+  if (current_unix_time(unix_time)) {
+    g_drift.add_point(unix_time, g_discipline.get_frequency_ppb(), tempmonGetTemp());
   }
-  
-  if (!oscillator.isPresent()) {
-    Serial.println("Error: SiT5501 oscillator not found - calibration requires oscillator control\r");
-    return;
+  save_settings();
+  record_calibration(1);
+}
+
+void process_discipline() {
+  bool changed = g_discipline.service(millis());
+  uint32_t now = millis();
+  if (now - g_last_feed_forward_ms >= FEED_FORWARD_INTERVAL_MS) {
+    g_last_feed_forward_ms = now;
+    uint32_t unix_time;
+    double predicted;
+    double sigma;
+    bool modelled = current_unix_time(unix_time) &&
+                    g_drift.predict(unix_time, tempmonGetTemp(), predicted, sigma);
+    changed |= g_discipline.set_feed_forward(modelled ? predicted : NAN);
+  }
+  if (changed) {
+    apply_discipline_control();
+  }
+  if (g_offset_save_pending) {
+    save_discipline_offset();
+  }
+}
+
+bool current_unix_time(uint32_t& unix_time) {
+  unix_time = rtc_get();
+  return g_rtc_from_gps || unix_time >= RTC_PLAUSIBLE_UNIX;
+}
+
+void request_confirmation(const char* name, void (*action)()) {
+  g_confirmation.name = name;
+  g_confirmation.action = action;
+  g_confirmation.deadline_ms = millis() + CONFIRMATION_TIMEOUT_MS;
+  g_confirmation.active = true;
+  Serial.printf("Type 'y' to confirm %s, any other key to cancel (%lu s): ",
+                name, CONFIRMATION_TIMEOUT_MS / 1000);
+}
+
+void answer_confirmation(char c) {
+  g_confirmation.active = false;
+  Serial.println(c);
+  if (c == 'y' || c == 'Y') {
+    g_confirmation.action();
+  } else {
+    Serial.printf("%s cancelled.\r\n", g_confirmation.name);
   }
-  
-  // Show calibration information and ask for confirmation
-  Serial.println("\r\n=== CALIBRATION PROCEDURE ===\r");
-  Serial.printf("This will run a 2-phase calibration (%lu seconds each phase):\r\n", g_calibration.duration_seconds);
-  Serial.println("Phase 1: Reset offset to 0 and measure frequency error\r");
-  Serial.println("Phase 2: Apply correction and verify results\r");
-  Serial.printf("Current offset: %.1f ppb will be temporarily changed\r\n", g_frequency_offset_ppm * 1000.0);
-  Serial.println("\r");
-  uint32_t total_minutes = (g_calibration.duration_seconds * 2) / 60;
-  Serial.printf("WARNING: This will take approximately %lu minutes to complete.\r\n", total_minutes);
-  Serial.println("Make sure GPS PPS signal is stable before proceeding.\r");
   Serial.println("\r");
-  Serial.println("Type 'y' to start calibration, any other key to cancel: ");
-  
-  // Wait for user confirmation
-  while (!Serial.available()) {
-    delay(10);
+}
+
+// Machine queries: one JSON object per line, one member per query in the
+// line, plus "errors" for the commands that could not be answered
+void print_json_header(const ScpiCommand& command) {
+  Serial.print('"');
+  for (uint8_t i = 0; i < command.header_length; i++) {
+    char c = command.header[i];
+    if (c == '"' || c == '\\') Serial.print('\\');
+    Serial.print(c);
   }
-  
-  char response = Serial.read();
-  Serial.println(response); // Echo the response
-  
-  // Clear any remaining characters
-  while (Serial.available()) {
-    Serial.read();
+  Serial.print('"');
+}
+
+// ,"name":value with NaN as null
+void print_json_double(const char* name, double value, int decimals) {
+  if (isnan(value) || isinf(value)) {
+    Serial.printf(",\"%s\":null", name);
+  } else {
+    Serial.printf(",\"%s\":%.*f", name, decimals, value);
   }
-  
-  if (response != 'y' && response != 'Y') {
-    Serial.println("Calibration cancelled.\r");
-    return;
+}
+
+void query_idn() {
+  Serial.printf("\"idn\":{\"model\":\"Teensy 4.1 GPS frequency counter\",\"nominal_hz\":10000000,"
+                "\"settings_version\":%u,\"uptime_ms\":%lu}", SETTINGS_LAYOUT_VERSION, millis());
+}
+
+void query_frequency() {
+  Serial.printf("\"freq\":{\"count\":%lu,\"valid\":%s,\"ticks\":%lu,\"age_ms\":%lu",
+                g_freq_stats.get_count(), g_pps_data.has_data ? "true" : "false", g_pps_data.ticks,
+                g_pps_data.has_data ? millis() - g_last_pps_millis : 0);
+  print_json_double("ppb", g_pps_data.ppm_instantaneous * 1000.0, 1);
+  print_json_double("avg_ppb", g_pps_data.ppm_average * 1000.0, 4);
+  print_json_double("fit_ppb", g_pps_data.ppm_fit * 1000.0, 4);
+  print_json_double("fit_sigma_ppb", g_pps_data.ppm_fit_sigma * 1000.0, 4);
+  Serial.printf(",\"fit_samples\":%u}", g_pps_data.fit_samples);
+}
+
+void query_windows() {
+  Serial.print("\"windows\":[");
+  bool first = true;
+  for (uint8_t k = 0; k < FrequencyStats::WINDOWS; k++) {
+    FrequencyWindowStats window;
+    if (!g_freq_stats.get_window(k, window)) {
+      continue;
+    }
+    Serial.printf("%s{\"length\":%lu,\"samples\":%lu", first ? "" : ",", window.length, window.samples);
+    print_json_double("ppb", g_freq_stats.get_window_ppm_error(k, 10000000.0) * 1000.0, 4);
+    print_json_double("std_ticks", window.std_ticks, 3);
+    Serial.printf(",\"min_ticks\":%lu,\"max_ticks\":%lu}", window.min_ticks, window.max_ticks);
+    first = false;
   }
-  
-  Serial.println("Starting calibration procedure...\r");
-  Serial.printf("Phase 1: Setting PPM offset to 0 and averaging for %lu seconds\r\n", g_calibration.duration_seconds);
-  
-  start_calibration_internal(false);
+  Serial.print("]");
+}
+
+void query_stability() {
+  uint8_t levels = g_stability.get_levels();
+  Serial.printf("\"stability\":{\"periods\":%lu,\"gaps\":%lu",
+                g_stability.get_sample_count(), g_stability.get_gap_count());
+  static const char* const COLUMNS[] = {"tau", "adev", "mdev", "tdev_ns"};
+  for (uint8_t column = 0; column < 4; column++) {
+    Serial.printf(",\"%s\":[", COLUMNS[column]);
+    bool first = true;
+    for (uint8_t k = 0; k < levels; k++) {
+      StabilityPoint point;
+      if (!g_stability.get_point(k, point)) {
+        continue;
+      }
+      if (!first) Serial.print(",");
+      first = false;
+      switch (column) {
+        case 0: Serial.printf("%.0f", point.tau); break;
+        case 1: Serial.printf("%.4e", point.adev); break;
+        case 2: Serial.printf("%.4e", point.mdev); break;
+        default: Serial.printf("%.4f", point.tdev * 1e9); break;
+      }
+    }
+    Serial.print("]");
+  }
+  // The corrected series, once the sawtooth has been taken off any interval
+  if (g_sawtooth.get_stats().corrected > 0) {
+    Serial.print(",\"adev_qerr\":[");
+    bool first = true;
+    for (uint8_t k = 0; k < g_stability_corrected.get_levels(); k++) {
+      StabilityPoint point;
+      if (g_stability_corrected.get_point(k, point)) {
+        Serial.printf(first ? "%.4e" : ",%.4e", point.adev);
+        first = false;
+      }
+    }
+    Serial.print("]");
+  }
+  Serial.print("}");
+}
+
+void query_filter() {
+  const PpsFilterStats& stats = g_pps_filter.get_stats();
+  Serial.printf("\"filter\":{\"edges\":%lu,\"accepted\":%lu,\"merged\":%lu,\"split\":%lu,"
+                "\"missed_edges\":%lu,\"rejected\":%lu,\"restarts\":%lu,"
+                "\"median_ticks\":%ld,\"mad_ticks\":%lu,\"tolerance_ticks\":%lu}",
+                stats.edges, stats.accepted, stats.merged, stats.split, stats.missed_edges,
+                stats.rejected, stats.restarts, (long)stats.median_ticks, stats.mad_ticks,
+                stats.tolerance_ticks);
+}
+
+void query_gps() {
+  Serial.printf("\"gps\":{\"valid\":%s,\"time\":\"%s\",\"unix\":%lu,\"source\":\"%s\"",
+                g_gps_data.is_valid ? "true" : "false", g_gps_data.timestamp,
+                g_gps_data.unix_time, g_gps_data.source);
+  print_json_double("lat", g_gps_data.is_valid ? g_gps_data.latitude : NAN, 7);
+  print_json_double("lon", g_gps_data.is_valid ? g_gps_data.longitude : NAN, 7);
+  Serial.print("}");
+}
+
+void query_loop() {
+  Serial.printf("\"loop\":{\"state\":\"%s\"", DiscipliningLoop::state_name(g_discipline.get_state()));
+  print_json_double("offset_ppb", g_frequency_offset_ppm * 1000.0, 2);
+  print_json_double("control_ppb", g_discipline.get_control_ppb(), 3);
+  print_json_double("phase_error_ns", g_discipline.get_phase_error_ns(), 1);
+  const DriftFit& fit = g_drift.get_fit();
+  bool fitted = g_drift.has_fit();
+  print_json_double("aging_ppb_per_day", fitted ? fit.aging_ppb_per_day : NAN, 3);
+  print_json_double("aging_sigma_ppb_per_day", fitted ? fit.aging_sigma_ppb_per_day : NAN, 3);
+  print_json_double("feed_forward_ppb", g_discipline.get_feed_forward_ppb(), 3);
+  print_json_double("prediction_rms_ppb", g_drift.get_prediction_stats().count ?
+                    g_drift.get_prediction_stats().rms_error_ppb : NAN, 3);
+  Serial.print("}");
+}
+
+void query_health() {
+  TelemetryHealth record;
+  collect_health(record);
+  Serial.printf("\"health\":{\"captures\":%lu,\"compares\":%lu,\"ring_overruns\":%lu,"
+                "\"dropped_edges\":%lu,\"late_compares\":%lu,\"worst_loop_us\":%lu,"
+                "\"task_misses\":%lu,\"task_overruns\":%lu,\"gps_overruns\":%lu,"
+                "\"log_dropped\":%lu,\"telemetry_dropped\":%lu}",
+                record.captures, record.compares, record.ring_overruns, record.dropped_edges,
+                record.late_compares, record.worst_loop_us, record.task_misses,
+                record.task_overruns, record.gps_overruns, record.log_dropped,
+                record.telemetry_dropped);
+}
+
+struct QueryHandler {
+  const char* pattern;
+  void (*reply)();
+};
+
+static const QueryHandler QUERY_HANDLERS[] = {
+  {"*IDN", query_idn},
+  {"MEASure:FREQuency", query_frequency},
+  {"MEASure:WINDows", query_windows},
+  {"MEASure:STABility", query_stability},
+  {"MEASure:FILTer", query_filter},
+  {"GPS", query_gps},
+  {"LOOP", query_loop},
+  {"SYSTem:HEALth", query_health},
+};
+
+void process_query_line(const char* line) {
+  static const uint8_t MAX_ERRORS = 8;
+  ScpiCommand errors[MAX_ERRORS];
+  const char* reasons[MAX_ERRORS];
+  uint8_t error_count = 0;
+  bool first = true;
+
+  Serial.print("{");
+  ScpiLine commands(line);
+  ScpiCommand command;
+  while (commands.next(command)) {
+    const QueryHandler* handler = nullptr;
+    for (size_t i = 0; i < sizeof(QUERY_HANDLERS) / sizeof(QUERY_HANDLERS[0]); i++) {
+      if (scpi_match(QUERY_HANDLERS[i].pattern, command)) {
+        handler = &QUERY_HANDLERS[i];
+        break;
+      }
+    }
+    if (handler && command.query) {
+      if (!first) Serial.print(",");
+      first = false;
+      handler->reply();
+    } else if (error_count < MAX_ERRORS) {
+      errors[error_count] = command;
+      reasons[error_count] = handler ? "query only" : "undefined header";
+      error_count++;
+    }
+  }
+  if (error_count > 0) {
+    Serial.printf("%s\"errors\":[", first ? "" : ",");
+    for (uint8_t i = 0; i < error_count; i++) {
+      Serial.printf("%s{\"command\":", i ? "," : "");
+      print_json_header(errors[i]);
+      Serial.printf(",\"error\":\"%s\"}", reasons[i]);
+    }
+    Serial.print("]");
+  }
+  Serial.print("}\r\n");
 }
 
+// Console input, one state machine run per task call; nothing here waits:
+//   idle       single letters run at once, parameter letters start a line
+//   parameter  echoed, edited with backspace, run at Enter
+//   query      a line starting with ':' or '*' (machine queries): not echoed,
+//              answered with one JSON line at Enter
+// A pending confirmation takes the next key in the idle state; queries are
+// still answered while it waits.
+enum ConsoleState : uint8_t {
+  CONSOLE_IDLE = 0,
+  CONSOLE_PARAMETER,
+  CONSOLE_QUERY,
+};
+
 void handle_serial_commands() {
-  static char command_buffer[16] = "";  // Fixed-size buffer to prevent heap allocation
+  static char command_buffer[32] = "";  // Fixed-size buffers to prevent heap allocation
   static uint8_t buffer_pos = 0;
-  static bool reading_parameter_command = false;
+  static char query_buffer[256] = "";
+  static uint16_t query_pos = 0;
+  static bool query_overflow = false;
+  static ConsoleState state = CONSOLE_IDLE;
+
+  if (g_confirmation.active && (int32_t)(millis() - g_confirmation.deadline_ms) >= 0) {
+    g_confirmation.active = false;
+    Serial.printf("\r\n%s cancelled (no answer).\r\n", g_confirmation.name);
+  }
 
   while (Serial.available()) {
     char c = Serial.read();
 
-    if (!reading_parameter_command) {
-      // Convert to lowercase for consistency
-      if (c >= 'A' && c <= 'Z') {
-        c = c - 'A' + 'a';
+    if (state == CONSOLE_IDLE) {
+      if (c == ':' || c == '*') {
+        query_buffer[0] = c;
+        query_pos = 1;
+        query_overflow = false;
+        state = CONSOLE_QUERY;
+        continue;
       }
 
       // Skip whitespace and control characters for single commands
       if (c < 32 || c > 126) continue;
 
+      if (g_confirmation.active) {
+        if (c == ' ') continue;
+        answer_confirmation(c);
+        continue;
+      }
+
+      // Convert to lowercase for consistency
+      if (c >= 'A' && c <= 'Z') {
+        c = c - 'A' + 'a';
+      }
+
       // Echo the character
       Serial.print(c);
 
-        // Check if this is a parameter command that needs more input
-      if (c == 'f' || c == 'p' || c == 'd' || c == 'x' || c == 'g' || c == 'l') {
-          command_buffer[0] = c;
-          command_buffer[1] = '\0';
-          buffer_pos = 1;
-          reading_parameter_command = true;
-          continue;
+      // Check if this is a parameter command that needs more input
+      if (c == 'f' || c == 'p' || c == 'd' || c == 'g' || c == 'l' || c == 'm' || c == 'u' || c == 'w' || c == 'y' || c == 't' || c == 'k' || c == 'j' || c == 'n' || c == 'q' || c == 'i') {
+        command_buffer[0] = c;
+        command_buffer[1] = '\0';
+        buffer_pos = 1;
+        state = CONSOLE_PARAMETER;
+        continue;
       }
 
       // Process single-character commands immediately
       process_single_command(c);
-      } else {
+    } else if (state == CONSOLE_PARAMETER) {
       // Reading parameter for commands that require arguments
       if (c == '\n' || c == '\r') {
         // Echo newline
         Serial.println();
         // Process complete parameter command
+        state = CONSOLE_IDLE;
         process_parameter_command(command_buffer);
         command_buffer[0] = '\0';
         buffer_pos = 0;
-        reading_parameter_command = false;
       } else if (c == 8 || c == 127) {  // Backspace or DEL
         if (buffer_pos > 1) {  // Don't delete the command character
           buffer_pos--;
@@ -1004,6 +2076,23 @@ void handle_serial_commands() {
         command_buffer[buffer_pos] = '\0';
         Serial.print(c);  // Echo the character
       }
+    } else {
+      if (c == '\n' || c == '\r') {
+        query_buffer[query_pos] = '\0';
+        state = CONSOLE_IDLE;
+        if (query_overflow) {
+          Serial.printf("{\"errors\":[{\"error\":\"line longer than %u characters\"}]}\r\n",
+                        (unsigned)(sizeof(query_buffer) - 1));
+        } else {
+          process_query_line(query_buffer);
+        }
+      } else if (c >= 32 && c <= 126) {
+        if (query_pos < sizeof(query_buffer) - 1) {
+          query_buffer[query_pos++] = c;
+        } else {
+          query_overflow = true;
+        }
+      }
     }
   }
 }
@@ -1012,6 +2101,7 @@ void process_single_command(char cmd) {
   switch (cmd) {
     case 's': cmd_show_status(); break;
     case 'r': cmd_reset_measurements(); break;
+    case 'a': cmd_show_stability(); break;
     case 'c': cmd_set_capture_edge(); break;
     case 'o': cmd_read_oscillator(); break;
     case 'e': cmd_oscillator_output_enable(true); break;
@@ -1022,7 +2112,9 @@ void process_single_command(char cmd) {
       g_verbose_timing = !g_verbose_timing;
       Serial.printf("Verbose timing: %s\r\n", g_verbose_timing ? "ON" : "OFF");
       break;
-    case 'x': cmd_clear_eeprom(); break;
+    case 'x':
+      cmd_clear_eeprom();
+      return;  // The confirmation prompt stays on its line
     default:
       Serial.println("Unknown command. Type 'h' for help.\r");
       break;
@@ -1038,16 +2130,20 @@ void process_parameter_command(const char* command) {
   char cmd = command[0];
 
   switch (cmd) {
-    case 'f':
-      if (strlen(command) > 1) {
-        Serial.println("Usage: f\r");
-        break;
-      }
-      cmd_set_output_frequency(command);
-      break;
+    case 'f': cmd_set_output_frequency(command); break;
     case 'p': cmd_set_oscillator_ppm(command); break;
-    case 'l': cmd_start_calibration_with_time(command); break;
+    case 'l': cmd_discipline(command); break;
     case 'd': cmd_set_duty_cycle(command); break;
+    case 'm': cmd_set_log_format(command); break;
+    case 'u': cmd_set_display_rate(command); break;
+    case 'w': cmd_regression(command); break;
+    case 't': cmd_set_gate(command); break;
+    case 'k': cmd_pps_align(command); break;
+    case 'j': cmd_profiler(command); break;
+    case 'i': cmd_edge_analysis(command); break;
+    case 'n': cmd_scheduler(command); break;
+    case 'q': cmd_telemetry(command); break;
+    case 'y': cmd_oscillator_verify(command); break;
     case 'g':
       if (strlen(command) == 2) {
         char arg = command[1];
@@ -1074,39 +2170,226 @@ void process_parameter_command(const char* command) {
 }
 
 void process_frequency_measurement() {
-  if (!gpt2_capture_available()) return;
+  // Drain every capture queued since the last pass, so a slow loop() never loses a PPS edge
+  Gpt2CaptureEvent event;
+  while (gpt2_pop_capture(event)) {
+    if (g_telemetry_enabled) {
+      TelemetryCapture record = {event.timestamp64, event.sequence, event.edge, event.channel};
+      telemetry_send(TELEM_CAPTURE, &record, sizeof(record));
+    }
+    if (event.channel != 0) {
+      g_pps_compare.add_edge(1, event.timestamp64);  // Only compared against the first input
+      continue;
+    }
+    g_edges.add_edge(event.timestamp64, event.edge != GPT_EDGE_FALLING);
+    if (event.edge == GPT_EDGE_FALLING && gpt2_get_capture_edge() == GPT_EDGE_BOTH) {
+      continue;  // With both edges captured, rising edges alone mark the seconds
+    }
+    g_pps_compare.add_edge(0, event.timestamp64);
+    if (g_gate.add_edge(event.timestamp64)) {
+      report_gate_result();
+    }
+    // On the extended timebase an interval longer than one counter wrap can't alias
+    PpsSample sample = g_pps_filter.add_edge(event.timestamp64);
+    if (sample.type != PPS_SAMPLE_ACCEPTED && sample.type != PPS_SAMPLE_FIRST) {
+      report_pps_sample(sample);
+    }
+    if (sample.type != PPS_SAMPLE_REJECTED) {
+      g_sawtooth.add_edge(event.timestamp64, sample.periods);  // First and restart start a chain (0 periods)
+    }
+    if (sample.type == PPS_SAMPLE_RESTART) {
+      mark_pps_gap();  // Outage or a moved grid: phase continuity is broken
+    }
+    for (uint32_t k = 0; k < sample.periods; k++) {
+      // Bridged seconds come first; the last period ends on this edge
+      process_pps_period(PpsSampleFilter::period_ticks(sample, k), event.timestamp, k + 1 == sample.periods);
+    }
+    process_sawtooth_intervals();
+  }
+}
 
-  // Only process once per PPS pulse - read capture and immediately process
-  uint32_t ticks = gpt2_read_capture();  // This resets capture_available to false
-  double freq_hz = (double)ticks;  // Ticks = frequency in Hz (since PPS = 1 second)
-  const double ref_hz = 10000000.0;  // 10 MHz reference
+void mark_pps_gap() {
+  g_stability.mark_gap();
+  g_stability_corrected.mark_gap();
+  g_regression.mark_gap();
+  g_discipline.mark_gap();
+}
 
+void report_pps_sample(const PpsSample& sample) {
+  if (g_pause_updates || !g_verbose_timing) {
+    return;
+  }
+  switch (sample.type) {
+    case PPS_SAMPLE_MERGED:
+      Serial.printf("PPS: interval closed after dropping extra edge(s), %lu ticks\r\n", (uint32_t)sample.interval);
+      break;
+    case PPS_SAMPLE_SPLIT:
+      Serial.printf("PPS: %lu missed edge(s) bridged, %lu s in %llu ticks\r\n", sample.periods - 1,
+                    sample.periods, (unsigned long long)sample.interval);
+      break;
+    case PPS_SAMPLE_REJECTED:
+      Serial.printf("PPS: edge %+lld ticks off the expected period, ignored\r\n", (long long)sample.error);
+      break;
+    case PPS_SAMPLE_RESTART:
+      Serial.printf("PPS: continuity lost after %llu ticks, restarting\r\n", (unsigned long long)sample.interval);
+      break;
+    default:
+      break;
+  }
+}
+
+void show_pps_filter_status() {
+  const PpsFilterStats& stats = g_pps_filter.get_stats();
+  Serial.printf("PPS filter: %lu accepted, %lu merged (extra edges dropped), %lu split (%lu missed edges bridged)\r\n",
+                stats.accepted, stats.merged, stats.split, stats.missed_edges);
+  Serial.printf("  %lu edges rejected, %lu restarts; expected period %+ld ticks, MAD %lu, tolerance %lu ticks\r\n",
+                stats.rejected, stats.restarts, stats.median_ticks, stats.mad_ticks, stats.tolerance_ticks);
+}
+
+void align_pps_output(uint32_t capture_ticks) {
+  if (gpt2_get_output_frequency_mhz() != 1000) {
+    return;  // Only the 1 PPS grid lines up with the GPS edges
+  }
+  uint32_t rise;
+  int32_t pending;
+  gpt2_get_output_phase(rise, pending);
+  int32_t shift = g_pps_align.add_edge(capture_ticks, rise, pending);
+  if (shift != 0) {
+    gpt2_slew_output(shift);
+  }
+}
+
+void show_pps_align_status() {
+  Serial.printf("PPS alignment: %s, offset %ld ns, max slew %lu ns/s, %lu steps, %lu corrections\r\n",
+                PpsAligner::state_name(g_pps_align.get_state()), (long)g_pps_align.get_offset_ns(),
+                g_pps_align.get_max_slew_ns(), g_pps_align.get_steps(), g_pps_align.get_corrections());
+  if (g_pps_align.has_measurement()) {
+    Serial.printf("PPS output error: %+.0f ns (filtered %+.1f ns)\r\n",
+                  g_pps_align.get_phase_error_ns(), g_pps_align.get_filtered_error_ns());
+  }
+}
 
-  if (freq_hz < ref_hz * 0.99 || freq_hz > ref_hz * 1.01) {
-    Serial.printf("WARNING: Measured freq = %.6f Hz is outside 99-101%% of ref_hz = %.6f Hz\r\n", 
-                  freq_hz, ref_hz);
+void cmd_pps_align(const char* command) {
+  const char* param = command + 1;  // Skip the command character
+  if (strcmp(param, "0") == 0 || strcmp(param, "1") == 0) {
+    g_pps_align.set_enabled(param[0] == '1');
+    Serial.printf("PPS output alignment %s\r\n", param[0] == '1' ? "enabled" : "disabled");
+  } else if (param[0] == 'o' && param[1] != '\0') {
+    long offset = strtol(param + 1, nullptr, 10);
+    if (offset < -500000000L || offset > 500000000L) {
+      Serial.println("Error: Offset must be within +-500000000 ns\r");
+      return;
+    }
+    g_pps_align.set_offset_ns((int32_t)offset);
+    Serial.printf("PPS output offset set to %ld ns\r\n", offset);
+  } else if (param[0] == 's' && param[1] != '\0') {
+    long slew = strtol(param + 1, nullptr, 10);
+    if (slew < 100 || slew > 1000000L) {
+      Serial.println("Error: Slew must be 100-1000000 ns per second\r");
+      return;
+    }
+    g_pps_align.set_max_slew_ns((uint32_t)slew);
+    Serial.printf("PPS alignment slew limited to %ld ns/s\r\n", slew);
+  } else if (param[0] != '\0') {
+    Serial.println("Usage: k, k0/k1, ko<ns>, ks<ns>\r");
     return;
   }
+  if (param[0] != '\0') {
+    save_settings();  // Journaled only if a value changed
+  }
+  show_pps_align_status();
+}
+
+void report_gate_result() {
+  GateResult result;
+  if (!g_verbose_timing || !g_gate.get_result(result) || g_pause_updates) {
+    return;  // Otherwise only t and the log report gates
+  }
+  Serial.printf("Gate %lus #%lu: %llu ticks (%lu edges), %.6f Hz, error %+.3f ppb\r\n",
+                result.seconds, result.index, (unsigned long long)result.ticks, result.edges,
+                (double)result.ticks / result.seconds, GateCounter::result_ppb(result, 10000000));
+}
+
+void show_gate_status() {
+  Serial.printf("Gate: %lu s, %s %lu s, %lu spurious edges ignored, %lu restarts\r\n",
+                g_gate.get_gate(), g_gate.is_open() ? "open for" : "waiting for PPS,",
+                g_gate.get_elapsed_seconds(), g_gate.get_rejected_edges(), g_gate.get_restarts());
+  GateResult result;
+  if (g_gate.get_result(result)) {
+    Serial.printf("Last gate #%lu: %lu s, %llu ticks (%+lld), %.6f Hz, error %+.3f ppb\r\n",
+                  result.index, result.seconds, (unsigned long long)result.ticks,
+                  (long long)result.error_ticks, (double)result.ticks / result.seconds,
+                  GateCounter::result_ppb(result, 10000000));
+  }
+}
+
+void cmd_set_gate(const char* command) {
+  if (strlen(command) > 1) {
+    uint32_t seconds = strtoul(command + 1, nullptr, 10);
+    if (!g_gate.set_gate(seconds)) {
+      Serial.printf("Error: Gate must be 1-%lu seconds (e.g., t1, t10, t100, t1000)\r\n",
+                    GateCounter::MAX_GATE_SECONDS);
+      return;
+    }
+    g_gate_logged_index = 0;
+    Serial.printf("Gate set to %lu s, starting at the next PPS edge\r\n", seconds);
+  }
+  show_gate_status();
+}
 
-  // Update running statistics using Welford's algorithm for numerical stability
-  g_freq_stats.add_sample(freq_hz);
-  g_last_pps_millis = millis();
+// Periods arrive from g_pps_filter, within 1% of nominal. A bridged second
+// (closes_edge false) has no edge of its own: it feeds the statistics and the
+// loop so phase continuity holds, but is not aligned to or reported.
+void process_pps_period(uint32_t ticks, uint32_t capture_ticks, bool closes_edge) {
+  double freq_hz = (double)ticks;  // Ticks = frequency in Hz (since PPS = 1 second)
+  const double ref_hz = 10000000.0;  // 10 MHz reference
+
+  g_freq_stats.add_sample(ticks);
+  g_stability.add_period(ticks);
+  g_regression.add_period(ticks);
+  uint32_t now_ms = millis();
+  if (g_discipline.add_period(ticks, now_ms)) {
+    apply_discipline_control();
+  }
+  if (!closes_edge) {
+    return;
+  }
+  g_last_pps_millis = now_ms;
+  display_note_pps(g_last_pps_millis);
+  align_pps_output(capture_ticks);
 
   // Store frequency measurement data in PPS struct
   g_pps_data.ticks = ticks;  // ticks = freq_hz for 1 second PPS
-  g_pps_data.avg_freq_hz = g_freq_stats.get_mean();
+  g_pps_data.capture_ticks = capture_ticks;
+  FrequencyWindowStats average;
+  g_freq_stats.get_window(FrequencyStats::AVERAGE_WINDOW, average);
+  g_pps_data.avg_freq_hz = average.mean_ticks;
   g_pps_data.ppm_instantaneous = ((freq_hz - ref_hz) / ref_hz) * 1e6;
-  g_pps_data.ppm_average = g_freq_stats.get_ppm_error(ref_hz);
+  g_pps_data.ppm_average = g_freq_stats.get_window_ppm_error(FrequencyStats::AVERAGE_WINDOW, ref_hz);
+  RegressionFit fit;
+  if (g_regression.get_best_fit(fit)) {
+    g_pps_data.ppm_fit = fit.frequency * 1e6;
+    g_pps_data.ppm_fit_sigma = fit.frequency_sigma * 1e6;
+    g_pps_data.fit_samples = fit.samples;
+  } else {
+    g_pps_data.ppm_fit = NAN;
+    g_pps_data.ppm_fit_sigma = NAN;
+    g_pps_data.fit_samples = 0;
+  }
   g_pps_data.has_data = true;
+  if (g_telemetry_enabled) {
+    send_telemetry_sample();
+  }
   
 
   // Display results if verbose timing is enabled
   if (!g_pause_updates && g_verbose_timing) {
     double freq_mhz = g_pps_data.ticks / 1e6;  // Calculate MHz from ticks
     double avg_freq_mhz = g_pps_data.avg_freq_hz / 1e6;  // Calculate avg MHz
-    Serial.printf("t=%lus ticks=%6d latest=%.6f MHz avg=%.12f MHz ppb(lat)=%.1f ppb(avg)=%.1f\r\n",
+    Serial.printf("t=%lus ticks=%6d latest=%.6f MHz avg=%.12f MHz ppb(lat)=%.1f ppb(avg)=%.1f ppb(fit%u)=%.2f+-%.2f\r\n",
                   (unsigned long)g_freq_stats.get_count(), g_pps_data.ticks, freq_mhz, 
-                  avg_freq_mhz, g_pps_data.ppm_instantaneous * 1000.0, g_pps_data.ppm_average * 1000.0);
+                  avg_freq_mhz, g_pps_data.ppm_instantaneous * 1000.0, g_pps_data.ppm_average * 1000.0,
+                  g_pps_data.fit_samples, g_pps_data.ppm_fit * 1000.0, g_pps_data.ppm_fit_sigma * 1000.0);
   }
 }
 
@@ -1127,162 +2410,269 @@ void print_oscillator_status() {
   }
 }
 
-void process_calibration() {
-  if (g_calibration.state == CAL_IDLE) {
-    return;  // No calibration in progress
+void telemetry_send(uint8_t type, const void* body, size_t len) {
+  if (g_telemetry_enabled) {
+    g_telemetry.send(type, body, len, millis());
   }
-  
-  uint32_t elapsed_ms = millis() - g_calibration.start_time;
-  uint32_t elapsed_seconds = elapsed_ms / 1000;
-  
-  // Check for missed pulses during calibration
-  uint32_t expected_pulses_now = g_calibration.expected_pulses + elapsed_seconds;
-  if (g_freq_stats.get_count() < expected_pulses_now) {
-    uint32_t current_missed = expected_pulses_now - g_freq_stats.get_count();
-    if (current_missed > g_calibration.missed_pulses) {
-      g_calibration.missed_pulses = current_missed;
-      if (g_calibration.missed_pulses > 10) {
-        Serial.printf("\r\nCALIBRATION ABORTED: Too many missed GPS pulses (%lu missed)\r\n", g_calibration.missed_pulses);
-        Serial.println("GPS signal appears unstable. Please check GPS reception.\r");
-        
-        // Restore original offset
-        g_frequency_offset_ppm = g_calibration.original_offset;
-        oscillator.setFrequencyOffsetPPM(g_frequency_offset_ppm);
-        Serial.printf("Restored original offset: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
-        
-        g_calibration.state = CAL_IDLE;
-        return;
-      }
-    }
+}
+
+void send_telemetry_sample() {
+  TelemetrySample record = {};
+  record.ticks = g_pps_data.ticks;
+  record.capture_ticks = g_pps_data.capture_ticks;
+  record.count = g_freq_stats.get_count();
+  record.fit_ppb_milli = isnan(g_pps_data.ppm_fit) ? INT32_MIN : binlog_fixed(g_pps_data.ppm_fit, 1e6);
+  record.phase_error_dns = binlog_fixed(g_discipline.get_phase_error_ns(), 10.0);
+  record.pps_out_error_dns = binlog_fixed(g_pps_align.get_phase_error_ns(), 10.0);
+  record.loop_state = (uint8_t)g_discipline.get_state();
+  record.align_state = (uint8_t)g_pps_align.get_state();
+  record.fit_samples = g_pps_data.fit_samples;
+  telemetry_send(TELEM_SAMPLE, &record, sizeof(record));
+}
+
+void send_telemetry_control(uint8_t source) {
+  TelemetryControl record = {};
+  record.offset_cppb = binlog_fixed(g_frequency_offset_ppm, 1e5);
+  record.source = source;
+  record.loop_state = (uint8_t)g_discipline.get_state();
+  telemetry_send(TELEM_CONTROL, &record, sizeof(record));
+}
+
+void collect_health(TelemetryHealth& record) {
+  record = {};
+  Gpt2EventCounters counters;
+  gpt2_get_counters(counters);
+  record.captures = counters.captures;
+  record.compares = counters.compares;
+  record.ring_overruns = counters.ring_overruns;
+  record.dropped_edges = counters.dropped_edges;
+  record.late_compares = counters.late_compares;
+  ProfileWorstLoop worst;
+  if (profiler_get_worst_loop(worst)) {
+    record.worst_loop_us = worst.cycles / profiler_cycles_per_us();
+  }
+  for (uint8_t i = 0; i < g_scheduler.get_task_count(); i++) {
+    TaskStats stats;
+    g_scheduler.get_stats(i, stats);
+    record.task_misses += stats.deadline_misses;
+    record.task_overruns += stats.overruns;
+  }
+  GpsLinkStats link;
+  gps_link_get_stats(link);
+  record.gps_overruns = link.rx_overruns + link.rx_buffer_full;
+  SdLoggerStats logger;
+  sd_logger_get_stats(logger);
+  record.log_dropped = logger.records_dropped;
+  record.telemetry_dropped = g_telemetry.get_dropped();
+}
+
+void send_telemetry_health() {
+  TelemetryHealth record;
+  collect_health(record);
+  telemetry_send(TELEM_HEALTH, &record, sizeof(record));
+}
+
+// Health once per second, then as much of the queue as the USB buffer takes without blocking
+void task_telemetry() {
+  if (!g_telemetry_enabled) {
+    return;
   }
-  
-  // Progress reporting every 10 seconds during calibration
-  static uint32_t last_progress_report = 0;
-  if (elapsed_seconds >= last_progress_report + 1) {
-    last_progress_report = elapsed_seconds;
-    uint32_t remaining_seconds = g_calibration.duration_seconds - elapsed_seconds;
-    
-    if (g_calibration.state == CAL_PHASE1_AVERAGING) {
-      double current_avg_ppm = 0.0;
-      if (g_freq_stats.get_count() > 0) {
-        double current_avg_hz = g_freq_stats.get_mean();
-        current_avg_ppm = ((current_avg_hz - 10000000.0) / 10000000.0) * 1e6;
-      }
-      Serial.printf("Calibration Phase 1: %lu seconds remaining, current avg: %.1f ppb (%lu samples)\r\n", 
-                    remaining_seconds, current_avg_ppm * 1000.0, g_freq_stats.get_count());
-    } else if (g_calibration.state == CAL_PHASE2_AVERAGING) {
-      double current_avg_ppm = 0.0;
-      if (g_freq_stats.get_count() > 0) {
-        double current_avg_hz = g_freq_stats.get_mean();
-        current_avg_ppm = ((current_avg_hz - 10000000.0) / 10000000.0) * 1e6;
-      }
-      Serial.printf("Calibration Phase 2: %lu seconds remaining, current avg: %.1f ppb (%lu samples)\r\n", 
-                    remaining_seconds, current_avg_ppm * 1000.0, g_freq_stats.get_count());
+  uint32_t now = millis();
+  if (now - g_telemetry_health_ms >= 1000) {
+    g_telemetry_health_ms = now;
+    send_telemetry_health();
+  }
+  uint8_t chunk[512];
+  while (g_telemetry.pending() > 0 && SerialUSB1) {
+    int room = SerialUSB1.availableForWrite();
+    if (room <= 0) break;
+    size_t count = g_telemetry.drain(chunk, (size_t)room < sizeof(chunk) ? (size_t)room : sizeof(chunk));
+    SerialUSB1.write(chunk, count);
+  }
+}
+
+void cmd_telemetry(const char* command) {
+  const char* param = command + 1;  // Skip the command character
+  if (strcmp(param, "1") == 0) {
+    if (!g_telemetry_enabled) {
+      gps_link_set_passthrough(false);
+      g_telemetry.reset();
+      g_telemetry_enabled = true;
+      TelemetryHello hello = {TELEM_MAGIC, 10000000};
+      telemetry_send(TELEM_HELLO, &hello, sizeof(hello));
     }
+    Serial.println("Telemetry on SerialUSB1 enabled (GPS bytes now travel in-band)\r");
+  } else if (strcmp(param, "0") == 0) {
+    g_telemetry_enabled = false;
+    g_telemetry.reset();
+    gps_link_set_passthrough(true);
+    Serial.println("Telemetry disabled, SerialUSB1 back to GPS passthrough\r");
+  } else if (param[0] != '\0') {
+    Serial.println("Usage: q, q0 or q1\r");
+    return;
   }
-  
-  if (elapsed_seconds >= g_calibration.duration_seconds) {  // Duration completed
-    if (g_calibration.state == CAL_PHASE1_AVERAGING) {
-      // Phase 1 complete - calculate average and start phase 2
-      if (g_freq_stats.has_samples()) {
-        g_calibration.phase1_result = g_freq_stats.get_mean();
-        double avg_ppm = g_freq_stats.get_ppm_error(10000000.0);
-        
-        Serial.printf("Phase 1 complete. Average frequency: %.12f Hz (%.1f ppb error)\r\n", 
-                      g_calibration.phase1_result, avg_ppm * 1000.0);
-        
-        // Set new PPM offset based on phase 1 results
-        g_frequency_offset_ppm = -avg_ppm;  // Negative to correct the error
-        oscillator.setFrequencyOffsetPPM(g_frequency_offset_ppm);
-        
-        Serial.printf("Applied correction: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
-        Serial.printf("Phase 2: Averaging for another %lu seconds with correction applied\r\n", g_calibration.duration_seconds);
-        
-        // Reset for phase 2
-        reset_measurement_stats();
-        g_calibration.state = CAL_PHASE2_AVERAGING;
-        g_calibration.start_time = millis();
-        g_calibration.expected_pulses = g_freq_stats.get_count();  // Reset expected pulse count for phase 2
-        g_calibration.missed_pulses = 0;  // Reset missed pulse count for phase 2
-        last_progress_report = 0;
-      } else {
-        Serial.println("Calibration failed: No GPS PPS data received during phase 1\r");
-        g_calibration.state = CAL_IDLE;
+  Serial.printf("Telemetry: %s, %lu frames, %lu bytes, %lu dropped, %u bytes queued\r\n",
+                g_telemetry_enabled ? "ON" : "OFF", g_telemetry.get_frames(), g_telemetry.get_bytes(),
+                g_telemetry.get_dropped(), (unsigned)g_telemetry.pending());
+}
+
+void process_nmea_messages(void) {
+  // Whole blocks: one UART drain and one USB write, then parse from the buffer.
+  // Bounded per run so a flood cannot hold up the other tasks
+  uint8_t block[GPS_LINK_BLOCK];
+  for (uint8_t i = 0; i < 4; i++) {
+    size_t count = gps_link_read(block, sizeof(block));
+    if (count == 0) break;
+    if (g_telemetry_enabled) {
+      // The port carries telemetry: the receiver's bytes travel in-band
+      for (size_t offset = 0; offset < count; offset += TELEM_MAX_BODY) {
+        size_t len = count - offset < TELEM_MAX_BODY ? count - offset : TELEM_MAX_BODY;
+        telemetry_send(TELEM_NMEA, block + offset, len);
       }
-    } else if (g_calibration.state == CAL_PHASE2_AVERAGING) {
-      // Phase 2 complete - report final results
-      if (g_freq_stats.has_samples()) {
-        double phase2_avg = g_freq_stats.get_mean();
-        double phase2_ppm = g_freq_stats.get_ppm_error(10000000.0);
-        
-        Serial.println("\r\n=== CALIBRATION COMPLETE ===\r");
-        Serial.printf("Phase 1 average: %.12f Hz (%.1f ppb error)\r\n", 
-                      g_calibration.phase1_result, 
-                      ((g_calibration.phase1_result - 10000000.0) / 10000000.0) * 1e6 * 1000.0);
-        Serial.printf("Applied correction: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
-        Serial.printf("Phase 2 average: %.12f Hz (%.1f ppb residual error)\r\n", 
-                      phase2_avg, phase2_ppm * 1000.0);
-        Serial.printf("Final oscillator offset: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
-        
-        // Save the new offset to EEPROM
-        save_settings();
-        Serial.println("Calibration offset saved to EEPROM\r");
-      } else {
-        Serial.println("Calibration failed: No GPS PPS data received during phase 2\r");
-        // Restore original offset
-        g_frequency_offset_ppm = g_calibration.original_offset;
-        oscillator.setFrequencyOffsetPPM(g_frequency_offset_ppm);
-        Serial.printf("Restored original offset: %.1f ppb\r\n", g_frequency_offset_ppm * 1000.0);
+    }
+    for (size_t j = 0; j < count; j++) {
+      if (!ubx_parser.encode(block[j])) {
+        parser.encode((char)block[j]);
       }
-      
-      g_calibration.state = CAL_IDLE;
-      Serial.println("Calibration procedure finished.\r\n");
     }
   }
+  gps_link_forward_host();
+}
+
+void show_gps_link_status() {
+  GpsLinkStats stats;
+  gps_link_get_stats(stats);
+  Serial.printf("GPS link: %lu baud, %lu bytes in %lu blocks (max backlog %lu), %lu overruns, %lu buffer full\r\n",
+                stats.baud, stats.rx_bytes, stats.rx_blocks, stats.rx_max_backlog, stats.rx_overruns,
+                stats.rx_buffer_full);
+  Serial.printf("GPS passthrough: %lu bytes to host (%lu dropped), %lu bytes from host\r\n",
+                stats.forwarded_bytes, stats.forward_dropped, stats.host_bytes);
 }
 
-void check_auto_calibration() {
-  // Only check if not already calibrating and oscillator is present
-  if (g_calibration.state != CAL_IDLE || !oscillator.isPresent()) {
+// UBX-CFG-MSG: TIM-TP once per navigation solution on the port we listen on.
+// Receivers that only take CFG-VALSET (M10) need it enabled from the host.
+void enable_time_pulse_reports() {
+  const uint8_t rate[] = {UBX_CLASS_TIM, UBX_TIM_TP, 1};
+  uint8_t frame[16];
+  size_t size = ubx_build_frame(UBX_CLASS_CFG, UBX_CFG_MSG, rate, sizeof(rate), frame, sizeof(frame));
+  gps_link_write(frame, size);
+}
+
+void on_ubx_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t length) {
+  UbxTimePulse pulse;
+  if (msg_class != UBX_CLASS_TIM || msg_id != UBX_TIM_TP || !ubx_decode_time_pulse(payload, length, pulse)) {
     return;
   }
-  
-  // Check if we have no calibration offset (indicating no previous calibration)
-  // and we have received more than 10 GPS PPS pulses
-  if (g_frequency_offset_ppm == 0.0 && g_freq_stats.get_count() > 10) {
-    Serial.println("\r\nAuto-calibration trigger: No calibration offset detected after 10+ GPS pulses.\r");
-    start_calibration_internal(true);
-  }
+  g_sawtooth.add_report(pulse.tow_ms, pulse.qerr_ps, (pulse.flags & UBX_TP_FLAG_QERR_INVALID) == 0);
+  process_sawtooth_intervals();  // An edge may have been waiting for this report
 }
 
-void process_nmea_messages(void) {
-    while (Serial1.available()) {
-      int c = Serial1.read();
-	    parser.encode((char)c);
-      SerialUSB1.write(c);
+// Intervals from g_sawtooth (raw only while there is no report to correct
+// from) feed the corrected stability series in whole ns that add up exactly
+void process_sawtooth_intervals() {
+  SawtoothInterval interval;
+  while (g_sawtooth.pop(interval)) {
+    g_corrected_residue_ps += interval.corrected_ps;
+    int64_t total_ns = g_corrected_residue_ps / 1000;
+    g_corrected_residue_ps -= total_ns * 1000;
+    for (uint32_t k = 0; k < interval.periods; k++) {
+      uint32_t ns = (uint32_t)(total_ns / interval.periods + (k < (uint32_t)(total_ns % interval.periods) ? 1 : 0));
+      g_stability_corrected.add_period(ns);
     }
-    while (SerialUSB1.available()) {
-      int c = SerialUSB1.read();
-      Serial1.write(c);
+    // Logged with the interval it belongs to (a late report leaves that record without it)
+    if (interval.corrected && (uint32_t)interval.timestamp == g_pps_data.capture_ticks) {
+      g_pps_data.qerr_ps = interval.qerr_ps;
+      g_pps_data.ticks_corrected = interval.corrected_ps / 1e5 / interval.periods;
+      g_pps_data.has_corrected = true;
     }
+  }
+}
+
+void show_sawtooth_status() {
+  const SawtoothStats& stats = g_sawtooth.get_stats();
+  const UbxParserStats& ubx = ubx_parser.get_stats();
+  Serial.printf("UBX: %lu frames, %lu checksum errors, %lu oversized, %lu bad lengths\r\n",
+                ubx.frames, ubx.checksum_errors, ubx.oversized, ubx.bad_lengths);
+  if (stats.reports == 0) {
+    Serial.println("GPS sawtooth: no UBX-TIM-TP reports (uncorrected)\r");
+    return;
+  }
+  Serial.printf("GPS sawtooth: %lu TIM-TP (%lu invalid), TOW %s %lu ms, %lu locks, %lu lost\r\n",
+                stats.reports, stats.invalid, g_sawtooth.is_locked() ? "locked at" : "unlocked, last",
+                g_sawtooth.get_tow_ms(), stats.locks, stats.lock_losses);
+  Serial.printf("  %lu of %lu edges matched (%lu bridged), %lu intervals corrected; qErr %+.3f ns (%+.3f .. %+.3f)\r\n",
+                stats.matched, stats.edges, stats.bridged, stats.corrected, stats.last_qerr_ps / 1000.0,
+                stats.min_qerr_ps / 1000.0, stats.max_qerr_ps / 1000.0);
 }
 
 void loop() {
-  handle_serial_commands();
+  profiler_loop_start();
+  g_scheduler.run();
+  profiler_loop_end();
+}
 
-  // Always poll GPT2 for both capture and compare events
+// Service GPT2 capture/compare events (poll is a no-op when the ISR is enabled)
+// and process every queued PPS edge
+void task_capture() {
+  profiler_enter(PROFILE_GPT2_POLL);
   gpt2_poll_capture();
-  
-  // Always process GPS PPS measurements (if available)
+  profiler_exit();
   process_frequency_measurement();
-  
-  // Check for auto-calibration start condition
-  check_auto_calibration();
-  
-  process_calibration();
-  process_nmea_messages();
+}
+
+// OLED: render at the capped refresh rate, then push dirty pages a chunk per run
+void task_display() {
+  if (display_refresh_due(millis())) {
+    DisplayStatus status;
+    build_display_status(status);
+    display_update(status);
+  }
+  display_service();
+}
 
-  DisplayStatus status;
+void initialize_scheduler() {
+  // Every pass, most urgent: PPS edges feed the measurement and the loop
+  g_scheduler.add_task("capture", task_capture, 0, 0, 200, PROFILE_PPS_PROCESSING);
+  // The enlarged UART buffer holds ~90 ms at 115200 baud
+  g_scheduler.add_task("nmea", process_nmea_messages, 10000, 1, 1000, PROFILE_NMEA);
+  // Holdover entry/extrapolation when PPS stops arriving
+  g_scheduler.add_task("discipline", process_discipline, 100000, 1, 500, PROFILE_DISCIPLINE);
+  // Queued log sectors in bounded slices (2 ms write budget per slice)
+  g_scheduler.add_task("logging", sd_logger_service, 5000, 2, 3000, PROFILE_SD_SERVICE);
+  g_scheduler.add_task("console", handle_serial_commands, 20000, 2, 5000, PROFILE_SERIAL_COMMANDS);
+  if (g_sd_available) {
+    g_scheduler.add_task("mtp", sd_logger_service_mtp, 5000, 3, 10000, PROFILE_MTP);
+  }
+  // Frames queued by the other tasks, drained without blocking
+  g_scheduler.add_task("telemetry", task_telemetry, 2000, 2, 500, PROFILE_TELEMETRY);
+  // One 16-byte chunk per run: a full 8-page redraw takes 64 runs
+  g_scheduler.add_task("display", task_display, 1000, 3, 500, PROFILE_DISPLAY);
+}
+
+void cmd_scheduler(const char* command) {
+  if (strcmp(command + 1, "r") == 0) {
+    g_scheduler.reset_stats();
+    Serial.println("Task statistics reset\r");
+    return;
+  }
+  if (command[1] != '\0') {
+    Serial.println("Usage: n (show) or nr (reset)\r");
+    return;
+  }
+  Serial.printf("Scheduler: %lu passes, %lu with only every-pass work\r\n",
+                g_scheduler.get_passes(), g_scheduler.get_idle_passes());
+  Serial.println("  task        prio  period(us) budget(us)       runs   mean(us)    max(us)  late max(us)   misses  overruns\r");
+  for (uint8_t i = 0; i < g_scheduler.get_task_count(); i++) {
+    TaskStats stats;
+    g_scheduler.get_stats(i, stats);
+    double mean_us = stats.runs ? (double)stats.total_run_us / stats.runs : 0.0;
+    Serial.printf("  %-11s %4u  %10lu %10lu %10lu %10.1f %10lu %13lu %8lu %9lu\r\n",
+                  stats.name, stats.priority, stats.period_us, stats.budget_us, stats.runs, mean_us,
+                  stats.max_run_us, stats.max_late_us, stats.deadline_misses, stats.overruns);
+  }
+}
+
+void build_display_status(DisplayStatus& status) {
   bool pps_recent = (g_last_pps_millis != 0) && ((millis() - g_last_pps_millis) <= 10000);
   status.pps_locked = pps_recent;
   status.sample_count = g_freq_stats.get_count();
@@ -1304,32 +2694,19 @@ void loop() {
       status.utc_valid = false;
     }
   }
-  if (g_sd_available)
-      MTP.loop();
   status.output_high = gpt2_is_output_high();
-  
-  // Calibration status for display
-  status.calibrating = (g_calibration.state != CAL_IDLE);
-  status.cal_offset_ppm = g_frequency_offset_ppm;
-  
-  if (status.calibrating) {
-    uint32_t elapsed_ms = millis() - g_calibration.start_time;
-    uint32_t elapsed_seconds = elapsed_ms / 1000;
-    status.cal_remaining_seconds = (elapsed_seconds < g_calibration.duration_seconds) ? 
-                                   (g_calibration.duration_seconds - elapsed_seconds) : 0;
-    status.cal_phase = (g_calibration.state == CAL_PHASE1_AVERAGING) ? 1 : 2;
-    
-    // Calculate current average PPM
-    if (g_freq_stats.has_samples()) {
-      status.cal_current_ppm = g_freq_stats.get_ppm_error(10000000.0);
-    } else {
-      status.cal_current_ppm = 0.0;
-    }
-  } else {
-    status.cal_remaining_seconds = 0;
-    status.cal_phase = 0;
-    status.cal_current_ppm = 0.0;
-  }
-  
-  display_update(status);
+
+  StabilityPoint stability;
+  status.adev_valid = get_display_stability(stability);
+  status.adev_tau_seconds = status.adev_valid ? (uint32_t)stability.tau : 0;
+  status.adev = status.adev_valid ? stability.adev : 0.0;
+  
+  // GPSDO loop state for display
+  DisciplineState loop_state = g_discipline.get_state();
+  status.loop_state = DiscipliningLoop::state_name(loop_state);
+  status.loop_phase_valid = loop_state == DISCIPLINE_ACQUIRE || loop_state == DISCIPLINE_TRACK;
+  status.phase_error_ns = g_discipline.get_phase_error_ns();
+  status.phase_rms_ns = g_discipline.get_phase_rms_ns();
+  status.loop_state_seconds = g_discipline.get_state_seconds(millis());
+  status.offset_ppm = g_frequency_offset_ppm;
 }
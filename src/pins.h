@@ -7,6 +7,7 @@
 // GPT2 pins
 #define GPT2_EXTCLK_PIN 14    // External clock input (GPIO_AD_B1_02)
 #define GPT2_CAPTURE_PIN 15   // Input capture pin (GPIO_AD_B1_03)
+#define GPT2_CAPTURE2_PIN 40  // Second input capture pin (GPIO_AD_B1_04)
 #define GPT2_COMPARE_PIN 41   // Output compare pin (GPIO_AD_B1_05)
 
 extern void setup_pins(void);
@@ -0,0 +1,787 @@
+// Offline analysis of long SD card archives (JSONL and binary .fcb logs).
+//
+// plot.py parses every JSONL line with json.loads and runs allantools on the
+// result, which is fine for a day of data but not for months of logs from
+// several units. This tool memory-maps each file and splits it into one
+// chunk per thread; a scanner picks gps_timestamp, ticks, oscillator_offset_ppm
+// and gps_lat/gps_lon out of each line in place, without building a document
+// or allocating. Binary logs are read straight from their 32-byte records.
+//
+// The samples (sorted by GPS time when several files are given, ticks within
+// --max-dev of nominal as in plot.py) are then reduced to:
+//   - the per-second frequency error in ppb, and the same series low-pass
+//     filtered exactly as plot.py does it (Butterworth, second-order sections,
+//     forward-backward over a mean-padded copy)
+//   - overlapping ADEV, MDEV and TDEV at octave taus. The phase is the running
+//     sum of (ticks - nominal), kept as exact integers; every tau is split
+//     across the threads, and the inner loops are plain independent lanes the
+//     compiler vectorizes
+//   - a summary per UTC day
+//
+// Output goes to a directory: one .npy file per column (numpy.load reads them
+// memory-mapped; plot.py accepts the directory in place of log files),
+// stability.csv and daily.csv.
+//
+//   g++ -std=c++17 -O3 -march=native -pthread -Isrc tools/loganalyzer.cpp -o loganalyzer
+//   ./loganalyzer -o run.d [--cutoff 0.001] [--no-filter] [--threads N] logs/*.jsonl logs/*.fcb
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <complex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BinaryLog.h"
+
+static const uint32_t DEFAULT_NOMINAL_HZ = 10000000;
+
+struct Options {
+  const char* out_dir = nullptr;
+  uint32_t nominal = DEFAULT_NOMINAL_HZ;
+  uint32_t max_dev = 1;          // Ticks from nominal kept (plot.py keeps +-1)
+  double cutoff = 0.001;         // Hz, plot.py --cutoff default
+  int order = 8;
+  size_t pad = 2000;             // Mean-value padding on each side, as plot.py
+  bool filter = true;
+  unsigned threads = 0;          // 0: one per core
+};
+
+struct Sample {
+  int64_t time;                  // GPS UTC seconds; -1 when the record had none
+  uint32_t ticks;
+  double offset_ppm;             // NaN when not logged
+  double lat;
+  double lon;
+};
+
+struct ParseCounts {
+  uint64_t lines = 0;
+  uint64_t kept = 0;
+  uint64_t out_of_range = 0;     // ticks further than max_dev from nominal
+  uint64_t no_ticks = 0;         // Lines without a ticks field (no PPS data yet)
+  uint64_t malformed = 0;
+
+  void add(const ParseCounts& o) {
+    lines += o.lines;
+    kept += o.kept;
+    out_of_range += o.out_of_range;
+    no_ticks += o.no_ticks;
+    malformed += o.malformed;
+  }
+};
+
+template <typename Fn>
+static void parallel_for(size_t count, unsigned threads, Fn fn) {
+  if (threads <= 1 || count < threads) {
+    fn(0, count, 0u);
+    return;
+  }
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++) {
+    size_t begin = count * t / threads;
+    size_t end = count * (t + 1) / threads;
+    pool.emplace_back([=, &fn]() { fn(begin, end, t); });
+  }
+  for (std::thread& thread : pool) thread.join();
+}
+
+// ---------------------------------------------------------------------------
+// Input
+
+class MappedFile {
+public:
+  ~MappedFile() {
+    if (data_ && size_) munmap((void*)data_, size_);
+  }
+
+  bool open(const char* path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      return false;
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+      void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        close(fd);
+        return false;
+      }
+      madvise(p, size_, MADV_SEQUENTIAL);
+      data_ = (const char*)p;
+    }
+    close(fd);
+    return true;
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Numbers are parsed in place: the mapping is not NUL-terminated, so strtod
+// and friends cannot be used safely at the end of a file.
+static bool parse_int(const char*& p, const char* end, int64_t& value) {
+  bool negative = p < end && *p == '-';
+  if (negative) p++;
+  if (p >= end || *p < '0' || *p > '9') return false;
+  int64_t v = 0;
+  while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+  value = negative ? -v : v;
+  return true;
+}
+
+static bool parse_double(const char*& p, const char* end, double& value) {
+  bool negative = p < end && *p == '-';
+  if (negative) p++;
+  uint64_t mantissa = 0;
+  int exponent = 0;
+  int digits = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + (*p - '0');
+    else exponent++;
+    p++;
+    digits++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (mantissa < 100000000000000000ull) {
+        mantissa = mantissa * 10 + (*p - '0');
+        exponent--;
+      }
+      p++;
+      digits++;
+    }
+  }
+  if (digits == 0) return false;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    int64_t e = 0;
+    if (p < end && *p == '+') p++;
+    if (!parse_int(p, end, e)) return false;
+    exponent += (int)e;
+  }
+  double v = (double)mantissa;
+  if (exponent != 0) v *= pow(10.0, exponent);
+  value = negative ? -v : v;
+  return true;
+}
+
+// "2025-01-31T12:34:56Z" (the firmware's fixed format)
+static bool parse_timestamp(const char* p, const char* end, int64_t& unix_time) {
+  if (end - p < 19 || p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':') {
+    return false;
+  }
+  int f[6];
+  static const uint8_t offsets[6] = {0, 5, 8, 11, 14, 17};
+  static const uint8_t widths[6] = {4, 2, 2, 2, 2, 2};
+  for (int i = 0; i < 6; i++) {
+    int v = 0;
+    for (int k = 0; k < widths[i]; k++) {
+      char c = p[offsets[i] + k];
+      if (c < '0' || c > '9') return false;
+      v = v * 10 + (c - '0');
+    }
+    f[i] = v;
+  }
+  unix_time = (int64_t)binlog_days_from_civil(f[0], f[1], f[2]) * 86400 + f[3] * 3600 + f[4] * 60 + f[5];
+  return true;
+}
+
+static const char* skip_space(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+  return p;
+}
+
+// Past one JSON value of any kind (the firmware writes flat objects, but
+// nested ones are stepped over by depth)
+static const char* skip_value(const char* p, const char* end) {
+  int depth = 0;
+  bool in_string = false;
+  for (; p < end; p++) {
+    char c = *p;
+    if (in_string) {
+      if (c == '\\') p++;
+      else if (c == '"') {
+        in_string = false;
+        if (depth == 0) return p + 1;
+      }
+    } else if (c == '"') {
+      in_string = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0) return p;
+      if (--depth == 0) return p + 1;
+    } else if (c == ',' && depth == 0) {
+      return p;
+    }
+  }
+  return p;
+}
+
+static bool key_is(const char* key, size_t length, const char* name) {
+  return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+enum LineResult { LINE_EMPTY, LINE_KEPT, LINE_OUT_OF_RANGE, LINE_NO_TICKS, LINE_MALFORMED };
+
+static LineResult scan_line(const char* p, const char* end, const Options& options, Sample& sample) {
+  p = skip_space(p, end);
+  if (p == end) return LINE_EMPTY;  // Sector padding
+  if (*p != '{') return LINE_MALFORMED;
+  p++;
+
+  sample.time = -1;
+  sample.offset_ppm = NAN;
+  sample.lat = NAN;
+  sample.lon = NAN;
+  int64_t ticks = -1;
+
+  for (;;) {
+    p = skip_space(p, end);
+    if (p < end && *p == ',') p = skip_space(p + 1, end);
+    if (p >= end) return LINE_MALFORMED;
+    if (*p == '}') break;
+    if (*p != '"') return LINE_MALFORMED;
+    const char* key = ++p;
+    while (p < end && *p != '"') p++;
+    if (p >= end) return LINE_MALFORMED;
+    size_t key_length = (size_t)(p - key);
+    p = skip_space(p + 1, end);
+    if (p >= end || *p != ':') return LINE_MALFORMED;
+    p = skip_space(p + 1, end);
+
+    const char* value = p;
+    bool parsed = true;
+    if (key_is(key, key_length, "ticks")) {
+      parsed = parse_int(p, end, ticks);
+    } else if (key_is(key, key_length, "gps_timestamp")) {
+      parsed = *p == '"' && parse_timestamp(p + 1, end, sample.time);
+      p = skip_value(value, end);
+    } else if (key_is(key, key_length, "oscillator_offset_ppm")) {
+      parsed = parse_double(p, end, sample.offset_ppm);
+    } else if (key_is(key, key_length, "gps_lat")) {
+      parsed = parse_double(p, end, sample.lat);
+    } else if (key_is(key, key_length, "gps_lon")) {
+      parsed = parse_double(p, end, sample.lon);
+    } else {
+      p = skip_value(p, end);
+    }
+    if (!parsed) {
+      p = skip_value(value, end);  // e.g. null; the field is treated as absent
+    }
+  }
+
+  if (ticks < 0) return LINE_NO_TICKS;
+  int64_t deviation = ticks - (int64_t)options.nominal;
+  if (deviation > (int64_t)options.max_dev || deviation < -(int64_t)options.max_dev) {
+    return LINE_OUT_OF_RANGE;
+  }
+  sample.ticks = (uint32_t)ticks;
+  return LINE_KEPT;
+}
+
+static void count_line(LineResult result, ParseCounts& counts) {
+  if (result == LINE_EMPTY) return;
+  counts.lines++;
+  switch (result) {
+    case LINE_KEPT: counts.kept++; break;
+    case LINE_OUT_OF_RANGE: counts.out_of_range++; break;
+    case LINE_NO_TICKS: counts.no_ticks++; break;
+    default: counts.malformed++; break;
+  }
+}
+
+static void parse_jsonl(const MappedFile& file, const Options& options, unsigned threads,
+                        std::vector<Sample>& samples, ParseCounts& counts) {
+  const char* base = file.data();
+  const size_t size = file.size();
+
+  // Chunk boundaries moved forward to the next line start
+  std::vector<size_t> bounds(threads + 1, size);
+  bounds[0] = 0;
+  for (unsigned t = 1; t < threads; t++) {
+    size_t b = std::max(size * t / threads, bounds[t - 1]);
+    const char* nl = b < size ? (const char*)memchr(base + b, '\n', size - b) : nullptr;
+    bounds[t] = nl ? (size_t)(nl - base) + 1 : size;
+  }
+
+  std::vector<std::vector<Sample>> parts(threads);
+  std::vector<ParseCounts> part_counts(threads);
+  parallel_for(threads, threads, [&](size_t first, size_t last, unsigned) {
+    for (size_t t = first; t < last; t++) {
+      const char* p = base + bounds[t];
+      const char* end = base + bounds[t + 1];
+      std::vector<Sample>& out = parts[t];
+      out.reserve((size_t)(end - p) / 256);
+      while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = nl ? nl : end;
+        Sample sample;
+        LineResult result = scan_line(p, line_end, options, sample);
+        count_line(result, part_counts[t]);
+        if (result == LINE_KEPT) out.push_back(sample);
+        p = line_end + 1;
+      }
+    }
+  });
+
+  for (unsigned t = 0; t < threads; t++) {
+    samples.insert(samples.end(), parts[t].begin(), parts[t].end());
+    counts.add(part_counts[t]);
+  }
+}
+
+static void parse_binlog(const MappedFile& file, const Options& options, unsigned threads,
+                         std::vector<Sample>& samples, ParseCounts& counts) {
+  size_t records = (file.size() - sizeof(BinaryLogHeader)) / sizeof(BinaryLogRecord);
+  const char* first = file.data() + sizeof(BinaryLogHeader);
+
+  std::vector<std::vector<Sample>> parts(threads);
+  std::vector<ParseCounts> part_counts(threads);
+  parallel_for(records, threads, [&](size_t begin, size_t end, unsigned t) {
+    std::vector<Sample>& out = parts[t];
+    out.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+      BinaryLogRecord r;
+      memcpy(&r, first + i * sizeof(BinaryLogRecord), sizeof(r));
+      if (!(r.flags & BINLOG_FLAG_RECORD)) {
+        continue;  // Sector padding
+      }
+      Sample sample;
+      sample.time = r.gps_unix ? (int64_t)r.gps_unix : -1;
+      sample.ticks = r.ticks;
+      sample.offset_ppm = r.osc_offset_cppb / 100000.0;
+      sample.lat = (r.flags & BINLOG_FLAG_GPS_FIX) ? r.lat_e7 / 1e7 : NAN;
+      sample.lon = (r.flags & BINLOG_FLAG_GPS_FIX) ? r.lon_e7 / 1e7 : NAN;
+      LineResult result = LINE_KEPT;
+      int64_t deviation = (int64_t)r.ticks - (int64_t)options.nominal;
+      if (!(r.flags & BINLOG_FLAG_PPS_DATA)) {
+        result = LINE_NO_TICKS;
+      } else if (deviation > (int64_t)options.max_dev || deviation < -(int64_t)options.max_dev) {
+        result = LINE_OUT_OF_RANGE;
+      }
+      count_line(result, part_counts[t]);
+      if (result == LINE_KEPT) out.push_back(sample);
+    }
+  });
+
+  for (unsigned t = 0; t < threads; t++) {
+    samples.insert(samples.end(), parts[t].begin(), parts[t].end());
+    counts.add(part_counts[t]);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Low-pass filter: scipy.signal.butter(order, cutoff / (fs / 2), output='sos')
+// followed by sosfiltfilt, as apply_lowpass_filter() in plot.py
+
+struct Biquad {
+  double b0, b1, b2, a1, a2;
+};
+
+static std::vector<Biquad> design_butterworth(int order, double cutoff_hz, double sample_hz) {
+  const double pi = 3.14159265358979323846;
+  const double fs2 = 2.0 * sample_hz;
+  const double warped = fs2 * tan(pi * cutoff_hz / sample_hz);  // Pre-warped analog cutoff
+  std::vector<Biquad> sections;
+  for (int k = 0; k < order / 2; k++) {
+    // Analog pole in the upper half of the left half-plane; its conjugate is the pair
+    std::complex<double> s = warped * std::polar(1.0, pi * (2.0 * k + order + 1) / (2.0 * order));
+    std::complex<double> z = (fs2 + s) / (fs2 - s);  // Bilinear transform
+    Biquad q;
+    q.a1 = -2.0 * z.real();
+    q.a2 = std::norm(z);
+    double gain = (1.0 + q.a1 + q.a2) / 4.0;  // Zeros at z = -1; unity gain at DC
+    q.b0 = gain;
+    q.b1 = 2.0 * gain;
+    q.b2 = gain;
+    sections.push_back(q);
+  }
+  if (order % 2) {
+    double p = (fs2 - warped) / (fs2 + warped);
+    double gain = (1.0 - p) / 2.0;
+    sections.push_back({gain, gain, 0.0, -p, 0.0});
+  }
+  return sections;
+}
+
+// One pass of the cascade (transposed direct form II), every section started
+// in its steady state for the first input value, as sosfilt_zi does
+static void run_sections(const std::vector<Biquad>& sections, double* data, size_t n, bool reverse) {
+  if (n == 0) return;
+  double start = reverse ? data[n - 1] : data[0];
+  for (const Biquad& q : sections) {
+    double z2 = (q.b2 - q.a2) * start;  // DC gain is one: output equals input
+    double z1 = (q.b1 - q.a1) * start + z2;
+    for (size_t k = 0; k < n; k++) {
+      double& v = data[reverse ? n - 1 - k : k];
+      double x = v;
+      double y = q.b0 * x + z1;
+      z1 = q.b1 * x - q.a1 * y + z2;
+      z2 = q.b2 * x - q.a2 * y;
+      v = y;
+    }
+  }
+}
+
+static std::vector<double> lowpass(const std::vector<double>& data, const Options& options) {
+  double sum = 0.0;
+  for (double v : data) sum += v;
+  double mean = data.empty() ? 0.0 : sum / data.size();
+  std::vector<double> padded(data.size() + 2 * options.pad, mean);
+  std::copy(data.begin(), data.end(), padded.begin() + options.pad);
+
+  std::vector<Biquad> sections = design_butterworth(options.order, options.cutoff, 1.0);
+  run_sections(sections, padded.data(), padded.size(), false);
+  run_sections(sections, padded.data(), padded.size(), true);
+  return std::vector<double>(padded.begin() + options.pad, padded.end() - options.pad);
+}
+
+// ---------------------------------------------------------------------------
+// Stability
+
+struct StabilityPoint {
+  uint64_t m;
+  uint64_t adev_terms;
+  double adev_ppb;
+  uint64_t mdev_terms;           // 0: tau too long for MDEV/TDEV
+  double mdev_ppb;
+  double tdev_ns;
+};
+
+// Sum of squares of n int64 values produced by value(i); four independent
+// lanes so the loop vectorizes without reassociation flags
+template <typename Fn>
+static double sum_squares(size_t begin, size_t end, Fn value) {
+  double lane[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    for (int k = 0; k < 4; k++) {
+      double d = (double)value(i + k);
+      lane[k] += d * d;
+    }
+  }
+  for (; i < end; i++) {
+    double d = (double)value(i);
+    lane[0] += d * d;
+  }
+  return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+template <typename Fn>
+static double parallel_sum_squares(size_t count, unsigned threads, Fn value) {
+  std::vector<double> partial(threads, 0.0);
+  parallel_for(count, threads, [&](size_t begin, size_t end, unsigned t) {
+    partial[t] = sum_squares(begin, end, value);
+  });
+  double total = 0.0;
+  for (double p : partial) total += p;
+  return total;
+}
+
+// Overlapping estimators on phase x (ticks, N + 1 points for N periods).
+// With P the prefix sum of x, the inner MDEV sum over m second differences
+// collapses to P[j+3m] - 3 P[j+2m] + 3 P[j+m] - P[j], so every tau is one
+// pass over the data.
+static std::vector<StabilityPoint> compute_stability(const std::vector<uint32_t>& ticks, uint32_t nominal,
+                                                     unsigned threads) {
+  const size_t n = ticks.size() + 1;
+  std::vector<int64_t> x(n);
+  std::vector<int64_t> prefix(n + 1);
+  x[0] = 0;
+  prefix[0] = 0;
+  for (size_t i = 1; i < n; i++) {
+    x[i] = x[i - 1] + ((int64_t)ticks[i - 1] - (int64_t)nominal);
+  }
+  for (size_t i = 0; i < n; i++) {
+    prefix[i + 1] = prefix[i] + x[i];
+  }
+  const int64_t* xp = x.data();
+  const int64_t* pp = prefix.data();
+
+  std::vector<StabilityPoint> points;
+  for (size_t m = 1; 2 * m < n; m *= 2) {
+    StabilityPoint point = {};
+    point.m = m;
+    point.adev_terms = n - 2 * m;
+    double adev_sum = parallel_sum_squares(point.adev_terms, threads, [=](size_t i) {
+      return xp[i + 2 * m] - 2 * xp[i + m] + xp[i];
+    });
+    double tau = (double)m;  // tau0 = 1 s
+    point.adev_ppb = sqrt(adev_sum / (2.0 * point.adev_terms)) / tau / nominal * 1e9;
+
+    if (3 * m <= n) {
+      point.mdev_terms = n - 3 * m + 1;
+      double mdev_sum = parallel_sum_squares(point.mdev_terms, threads, [=](size_t j) {
+        return pp[j + 3 * m] - 3 * pp[j + 2 * m] + 3 * pp[j + m] - pp[j];
+      });
+      double mdev = sqrt(mdev_sum / (2.0 * point.mdev_terms)) / (tau * m) / nominal;
+      point.mdev_ppb = mdev * 1e9;
+      point.tdev_ns = tau * mdev / sqrt(3.0) * 1e9;
+    }
+    points.push_back(point);
+  }
+  return points;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+
+static bool write_npy(const std::string& dir, const char* name, const char* descr, const void* data,
+                      size_t count, size_t element_size) {
+  std::string path = dir + "/" + name;
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  // Format 1.0: magic, version, header length, then a dict padded to a multiple of 64
+  char dict[128];
+  int length = snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%zu,), }",
+                        descr, count);
+  size_t total = 10 + (size_t)length + 1;
+  size_t padding = (64 - total % 64) % 64;
+  uint16_t header_length = (uint16_t)(length + padding + 1);
+  fwrite("\x93NUMPY\x01\x00", 1, 8, f);
+  fwrite(&header_length, 2, 1, f);
+  fwrite(dict, 1, (size_t)length, f);
+  for (size_t i = 0; i < padding; i++) fputc(' ', f);
+  fputc('\n', f);
+  bool ok = fwrite(data, element_size, count, f) == count;
+  ok = fclose(f) == 0 && ok;
+  if (!ok) fprintf(stderr, "Short write on %s\n", path.c_str());
+  return ok;
+}
+
+static void format_utc(int64_t t, char* out, size_t size) {
+  if (t < 0) {
+    out[0] = '\0';
+    return;
+  }
+  time_t tt = (time_t)t;
+  struct tm tm;
+  gmtime_r(&tt, &tm);
+  strftime(out, size, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+static bool write_daily(const std::string& dir, const std::vector<Sample>& samples, const std::vector<double>& ppb) {
+  std::string path = dir + "/daily.csv";
+  FILE* f = fopen(path.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  fprintf(f, "date,samples,missing,first_utc,last_utc,mean_ppb,std_ppb,min_ppb,max_ppb,mean_offset_ppm\n");
+
+  size_t i = 0;
+  while (i < samples.size()) {
+    if (samples[i].time < 0) {
+      i++;
+      continue;
+    }
+    int64_t day = samples[i].time / 86400;
+    int64_t first = samples[i].time;
+    int64_t last = first;
+    uint64_t count = 0;
+    uint64_t offsets = 0;
+    double mean = 0.0, m2 = 0.0, lo = ppb[i], hi = ppb[i], offset_sum = 0.0;
+    for (; i < samples.size() && samples[i].time >= 0 && samples[i].time / 86400 == day; i++) {
+      double v = ppb[i];
+      count++;
+      double delta = v - mean;
+      mean += delta / count;
+      m2 += delta * (v - mean);
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+      if (samples[i].offset_ppm == samples[i].offset_ppm) {
+        offset_sum += samples[i].offset_ppm;
+        offsets++;
+      }
+      last = samples[i].time;
+    }
+    char date[32], first_utc[32], last_utc[32];
+    format_utc(day * 86400, date, sizeof(date));
+    date[10] = '\0';
+    format_utc(first, first_utc, sizeof(first_utc));
+    format_utc(last, last_utc, sizeof(last_utc));
+    // Seconds in the covered span with no sample (overlapping files can make it negative)
+    int64_t missing = (last - first + 1) - (int64_t)count;
+    fprintf(f, "%s,%" PRIu64 ",%" PRId64 ",%s,%s,%.4f,%.4f,%.4f,%.4f,", date, count, missing, first_utc, last_utc,
+            mean, count > 1 ? sqrt(m2 / (count - 1)) : 0.0, lo, hi);
+    if (offsets) fprintf(f, "%.6f\n", offset_sum / offsets);
+    else fprintf(f, "\n");
+  }
+  return fclose(f) == 0;
+}
+
+static bool write_stability(const std::string& dir, const std::vector<StabilityPoint>& points) {
+  std::string path = dir + "/stability.csv";
+  FILE* f = fopen(path.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  fprintf(f, "tau_s,adev_ppb,adev_terms,mdev_ppb,tdev_ns,mdev_terms\n");
+  for (const StabilityPoint& p : points) {
+    fprintf(f, "%" PRIu64 ",%.6e,%" PRIu64 ",", p.m, p.adev_ppb, p.adev_terms);
+    if (p.mdev_terms) fprintf(f, "%.6e,%.6e,%" PRIu64 "\n", p.mdev_ppb, p.tdev_ns, p.mdev_terms);
+    else fprintf(f, ",,0\n");
+  }
+  return fclose(f) == 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s -o <out_dir> [--cutoff HZ] [--order N] [--pad N] [--no-filter]\n"
+          "          [--nominal HZ] [--max-dev TICKS] [--threads N] <log.jsonl|log.fcb>...\n", name);
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  std::vector<const char*> inputs;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (has_value && strcmp(arg, "-o") == 0) {
+      options.out_dir = argv[++i];
+    } else if (has_value && strcmp(arg, "--cutoff") == 0) {
+      options.cutoff = atof(argv[++i]);
+    } else if (has_value && strcmp(arg, "--order") == 0) {
+      options.order = atoi(argv[++i]);
+    } else if (has_value && strcmp(arg, "--pad") == 0) {
+      options.pad = (size_t)atol(argv[++i]);
+    } else if (has_value && strcmp(arg, "--nominal") == 0) {
+      options.nominal = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (has_value && strcmp(arg, "--max-dev") == 0) {
+      options.max_dev = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (has_value && strcmp(arg, "--threads") == 0) {
+      options.threads = (unsigned)atoi(argv[++i]);
+    } else if (strcmp(arg, "--no-filter") == 0) {
+      options.filter = false;
+    } else if (arg[0] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+  if (!options.out_dir || inputs.empty() || options.nominal == 0 || options.order < 1 ||
+      !(options.cutoff > 0.0 && options.cutoff < 0.5)) {
+    usage(argv[0]);
+    return 2;
+  }
+  unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+  // Parse
+  std::vector<Sample> samples;
+  ParseCounts totals;
+  for (const char* path : inputs) {
+    MappedFile file;
+    if (!file.open(path)) {
+      fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+      return 1;
+    }
+    ParseCounts counts;
+    BinaryLogHeader header;
+    bool binary = file.size() >= sizeof(header);
+    if (binary) {
+      memcpy(&header, file.data(), sizeof(header));
+      binary = header.magic == BINLOG_MAGIC && header.record_size == sizeof(BinaryLogRecord);
+    }
+    if (binary) {
+      if (header.nominal_hz && header.nominal_hz != options.nominal) {
+        fprintf(stderr, "%s: logged at %" PRIu32 " Hz, analysing against %" PRIu32 " Hz\n", path,
+                header.nominal_hz, options.nominal);
+      }
+      parse_binlog(file, options, threads, samples, counts);
+    } else {
+      parse_jsonl(file, options, threads, samples, counts);
+    }
+    fprintf(stderr, "%s: %" PRIu64 " records, %" PRIu64 " kept, %" PRIu64 " out of range, %" PRIu64
+            " without ticks, %" PRIu64 " malformed\n", path, counts.lines, counts.kept, counts.out_of_range,
+            counts.no_ticks, counts.malformed);
+    totals.add(counts);
+  }
+  if (samples.empty()) {
+    fprintf(stderr, "No samples\n");
+    return 1;
+  }
+  if (inputs.size() > 1) {
+    std::stable_sort(samples.begin(), samples.end(),
+                     [](const Sample& a, const Sample& b) { return a.time < b.time; });
+  }
+
+  // Columns
+  const size_t n = samples.size();
+  std::vector<int64_t> time(n);
+  std::vector<uint32_t> ticks(n);
+  std::vector<double> ppb(n), offset(n), lat(n), lon(n);
+  parallel_for(n, threads, [&](size_t begin, size_t end, unsigned) {
+    for (size_t i = begin; i < end; i++) {
+      const Sample& s = samples[i];
+      time[i] = s.time;
+      ticks[i] = s.ticks;
+      ppb[i] = ((double)s.ticks - options.nominal) / options.nominal * 1e9;
+      offset[i] = s.offset_ppm;
+      lat[i] = s.lat;
+      lon[i] = s.lon;
+    }
+  });
+
+  // The filter is a sequential recursion: run it beside the (threaded) stability passes
+  std::vector<double> filtered;
+  std::thread filter_thread;
+  if (options.filter) {
+    filter_thread = std::thread([&]() { filtered = lowpass(ppb, options); });
+  }
+  std::vector<StabilityPoint> stability = compute_stability(ticks, options.nominal, threads);
+  if (filter_thread.joinable()) filter_thread.join();
+
+  // Write
+  if (mkdir(options.out_dir, 0777) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Cannot create %s: %s\n", options.out_dir, strerror(errno));
+    return 1;
+  }
+  std::string dir = options.out_dir;
+  bool ok = write_npy(dir, "time_unix.npy", "<i8", time.data(), n, sizeof(int64_t)) &&
+            write_npy(dir, "ticks.npy", "<u4", ticks.data(), n, sizeof(uint32_t)) &&
+            write_npy(dir, "ppb.npy", "<f8", ppb.data(), n, sizeof(double)) &&
+            write_npy(dir, "offset_ppm.npy", "<f8", offset.data(), n, sizeof(double)) &&
+            write_npy(dir, "gps_lat.npy", "<f8", lat.data(), n, sizeof(double)) &&
+            write_npy(dir, "gps_lon.npy", "<f8", lon.data(), n, sizeof(double)) &&
+            (!options.filter || write_npy(dir, "ppb_filtered.npy", "<f8", filtered.data(), n, sizeof(double))) &&
+            write_stability(dir, stability) && write_daily(dir, samples, ppb);
+  if (!ok) {
+    return 1;
+  }
+
+  double mean = 0.0;
+  for (double v : ppb) mean += v;
+  mean /= n;
+  fprintf(stderr, "%" PRIu64 " records, %zu samples analysed: mean %.3f ppb", totals.lines, n, mean);
+  if (!stability.empty()) {
+    fprintf(stderr, ", ADEV(1 s) %.3e ppb, ADEV(%" PRIu64 " s) %.3e ppb", stability.front().adev_ppb,
+            stability.back().m, stability.back().adev_ppb);
+  }
+  fprintf(stderr, "\nWritten to %s/\n", options.out_dir);
+  return 0;
+}
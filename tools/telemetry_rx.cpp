@@ -0,0 +1,187 @@
+// Host receiver for the firmware's binary telemetry stream (q1 on SerialUSB1).
+//
+// Reads the COBS/CRC framed stream from the serial device (or a file holding
+// a raw capture), checks every frame and writes one JSONL line per record.
+// GPS bytes carried in-band can go to a separate file, and the raw bytes can
+// be kept as well for later re-decoding. Frame layouts are in src/Telemetry.h.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/telemetry_rx.cpp src/Telemetry.cpp -o telemetry_rx
+//   ./telemetry_rx /dev/ttyACM1 -o run.jsonl [-n gps.nmea] [-r raw.fct]
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "Telemetry.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int) {
+  stop_requested = 1;
+}
+
+static bool configure_tty(int fd) {
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cc[VMIN] = 1;
+  tio.c_cc[VTIME] = 0;
+  cfsetspeed(&tio, B115200);  // CDC ignores it; set for completeness
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+template <typename T>
+static bool body_as(const TelemetryDecoder& decoder, T& record) {
+  if (decoder.body_length() < sizeof(T)) {
+    return false;
+  }
+  memcpy(&record, decoder.body(), sizeof(T));
+  return true;
+}
+
+static void write_record(FILE* out, FILE* nmea, const TelemetryDecoder& decoder) {
+  const TelemetryHeader& header = decoder.header();
+  char prefix[64];
+  snprintf(prefix, sizeof(prefix), "{\"seq\":%u,\"ms\":%" PRIu32, header.sequence, header.ms);
+
+  switch (header.type) {
+    case TELEM_HELLO: {
+      TelemetryHello r;
+      if (body_as(decoder, r)) {
+        fprintf(out, "%s,\"type\":\"hello\",\"magic_ok\":%s,\"nominal_hz\":%" PRIu32 "}\n", prefix,
+                r.magic == TELEM_MAGIC ? "true" : "false", r.nominal_hz);
+      }
+      break;
+    }
+    case TELEM_CAPTURE: {
+      TelemetryCapture r;
+      if (body_as(decoder, r)) {
+        fprintf(out, "%s,\"type\":\"capture\",\"timestamp\":%" PRIu64 ",\"capture_seq\":%" PRIu32
+                ",\"edge\":%u,\"channel\":%u}\n", prefix, r.timestamp, r.sequence, r.edge, r.channel);
+      }
+      break;
+    }
+    case TELEM_SAMPLE: {
+      TelemetrySample r;
+      if (body_as(decoder, r)) {
+        fprintf(out, "%s,\"type\":\"sample\",\"ticks\":%" PRIu32 ",\"capture_ticks\":%" PRIu32
+                ",\"count\":%" PRIu32, prefix, r.ticks, r.capture_ticks, r.count);
+        if (r.fit_ppb_milli != INT32_MIN) {
+          fprintf(out, ",\"fit_ppb\":%.3f,\"fit_samples\":%u", r.fit_ppb_milli / 1000.0, r.fit_samples);
+        }
+        fprintf(out, ",\"phase_error_ns\":%.1f,\"pps_out_error_ns\":%.1f,\"loop_state\":%u,\"align_state\":%u}\n",
+                r.phase_error_dns / 10.0, r.pps_out_error_dns / 10.0, r.loop_state, r.align_state);
+      }
+      break;
+    }
+    case TELEM_HEALTH: {
+      TelemetryHealth r;
+      if (body_as(decoder, r)) {
+        fprintf(out, "%s,\"type\":\"health\",\"captures\":%" PRIu32 ",\"compares\":%" PRIu32
+                ",\"ring_overruns\":%" PRIu32 ",\"dropped_edges\":%" PRIu32 ",\"late_compares\":%" PRIu32
+                ",\"worst_loop_us\":%" PRIu32 ",\"task_misses\":%" PRIu32 ",\"task_overruns\":%" PRIu32
+                ",\"gps_overruns\":%" PRIu32 ",\"log_dropped\":%" PRIu32 ",\"telemetry_dropped\":%" PRIu32 "}\n",
+                prefix, r.captures, r.compares, r.ring_overruns, r.dropped_edges, r.late_compares,
+                r.worst_loop_us, r.task_misses, r.task_overruns, r.gps_overruns, r.log_dropped,
+                r.telemetry_dropped);
+      }
+      break;
+    }
+    case TELEM_CONTROL: {
+      TelemetryControl r;
+      if (body_as(decoder, r)) {
+        fprintf(out, "%s,\"type\":\"control\",\"offset_ppb\":%.2f,\"source\":\"%s\",\"loop_state\":%u}\n",
+                prefix, r.offset_cppb / 100.0, r.source ? "loop" : "manual", r.loop_state);
+      }
+      break;
+    }
+    case TELEM_NMEA:
+      if (nmea) {
+        fwrite(decoder.body(), 1, decoder.body_length(), nmea);
+      }
+      break;
+    default:
+      fprintf(out, "%s,\"type\":\"unknown\",\"id\":%u,\"length\":%zu}\n", prefix, header.type,
+              decoder.body_length());
+      break;
+  }
+}
+
+static void usage(const char* name) {
+  fprintf(stderr, "Usage: %s <device|file> [-o out.jsonl] [-n gps.nmea] [-r raw.fct]\n", name);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage(argv[0]);
+    return 2;
+  }
+  const char* input_path = argv[1];
+  const char* out_path = nullptr;
+  const char* nmea_path = nullptr;
+  const char* raw_path = nullptr;
+  for (int i = 2; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+      out_path = argv[++i];
+    } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+      nmea_path = argv[++i];
+    } else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+      raw_path = argv[++i];
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  int fd = open(input_path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    fprintf(stderr, "Cannot open %s: %s\n", input_path, strerror(errno));
+    return 1;
+  }
+  if (isatty(fd) && !configure_tty(fd)) {
+    fprintf(stderr, "Cannot configure %s: %s\n", input_path, strerror(errno));
+    return 1;
+  }
+  FILE* out = out_path ? fopen(out_path, "w") : stdout;
+  FILE* nmea = nmea_path ? fopen(nmea_path, "wb") : nullptr;
+  FILE* raw = raw_path ? fopen(raw_path, "wb") : nullptr;
+  if (!out || (nmea_path && !nmea) || (raw_path && !raw)) {
+    fprintf(stderr, "Cannot open an output file: %s\n", strerror(errno));
+    return 1;
+  }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  TelemetryDecoder decoder;
+  uint8_t buffer[4096];
+  while (!stop_requested) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n == 0) break;  // End of file (or the device went away)
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "Read error: %s\n", strerror(errno));
+      break;
+    }
+    if (raw) fwrite(buffer, 1, (size_t)n, raw);
+    for (ssize_t i = 0; i < n; i++) {
+      if (decoder.push(buffer[i])) {
+        write_record(out, nmea, decoder);
+      }
+    }
+  }
+
+  fprintf(stderr, "%" PRIu32 " frames, %" PRIu32 " lost (sequence gaps), %" PRIu32 " CRC errors, %" PRIu32
+          " framing errors\n", decoder.get_frames(), decoder.get_lost_frames(), decoder.get_crc_errors(),
+          decoder.get_framing_errors());
+  if (out != stdout) fclose(out);
+  if (nmea) fclose(nmea);
+  if (raw) fclose(raw);
+  close(fd);
+  return 0;
+}